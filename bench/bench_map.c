@@ -0,0 +1,99 @@
+/*
+ * map benchmarks: lookup cost across load factors.
+ *
+ * Build twice - once with the compile-time selected group probe (SSE2/AVX2/NEON) and once with RCFG__MAP_NO_SIMD
+ * for the portable SWAR path - and compare. Both targets set RCFG__MAP_MAX_LOAD=95 so the table can be filled past
+ * the default 87% limit without growing.
+ */
+
+#include "../src/map.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef uint64_t u64;
+
+#define K u64
+#define V u64
+#include "../src/map.h"
+#undef K
+#undef V
+
+// Table capacity used for every load factor (slots, power of two)
+static constexpr size_t BENCH_CAPACITY = (size_t)1 << 21;
+
+// Lookups timed per load factor and query kind
+static constexpr size_t BENCH_LOOKUPS = (size_t)1 << 22;
+
+// splitmix64 - distinct, well-mixed keys from a counter
+static u64 bench_key(const u64 i) {
+    u64 z = i + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Time BENCH_LOOKUPS lookups of keys drawn from [base, base + span) with stride 2; returns ns per lookup
+static double bench_lookups(const MAP(u64, u64) * m, const u64 base, const size_t span, u64 * sink) {
+    u64 acc = 0;
+    const double start = bench_now_ns();
+    for (size_t i = 0; i < BENCH_LOOKUPS; i++) {
+        const u64 * v = map_get(m, bench_key(base + 2 * (i % span)));
+        acc += v != nullptr ? *v : 1;
+    }
+    const double elapsed = bench_now_ns() - start;
+    *sink += acc;
+    return elapsed / (double)BENCH_LOOKUPS;
+}
+
+int main(void) {
+    static const unsigned load_factors[] = {50, 60, 70, 80, 90};
+
+#if defined(R_MAP_AVX2)
+    const char * probe = "avx2";
+#elif defined(R_MAP_SSE2)
+    const char * probe = "sse2";
+#elif defined(R_MAP_NEON)
+    const char * probe = "neon";
+#else
+    const char * probe = "swar";
+#endif
+
+    printf("map lookup (%s, group width %zu, capacity %zu)\n", probe, R_MAP_GROUP_WIDTH, BENCH_CAPACITY);
+    printf("%-6s %12s %12s %12s\n", "load", "size", "hit ns/op", "miss ns/op");
+
+    u64 sink = 0;
+    for (size_t l = 0; l < sizeof(load_factors) / sizeof(load_factors[0]); l++) {
+        const size_t n = BENCH_CAPACITY / 100 * load_factors[l];
+
+        MAP(u64, u64) m = map(u64, u64);
+        map_reserve(&m, n);
+        // Present keys are the even counters, absent keys are the odd ones
+        for (size_t i = 0; i < n; i++) {
+            map_put(&m, bench_key(2 * i), i);
+        }
+        if (map_capacity(&m) != BENCH_CAPACITY) {
+            fprintf(stderr, "unexpected capacity %zu at load %u%%\n", map_capacity(&m), load_factors[l]);
+            map_free(&m);
+            return EXIT_FAILURE;
+        }
+
+        const double hit = bench_lookups(&m, 0, n, &sink);
+        const double miss = bench_lookups(&m, 1, n, &sink);
+        printf("%-5u%% %12zu %12.2f %12.2f\n", load_factors[l], map_size(&m), hit, miss);
+
+        map_free(&m);
+    }
+
+    // Keep the lookups observable so they are not optimized away
+    fprintf(stderr, "checksum %llu\n", (unsigned long long)sink);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,1001 @@
+/*
+ * rune_bench: hot-path benchmarks for str, hash, coll, tree, map and task.
+ *
+ * Every case runs a fixed batch of operations per sample, once untimed to warm caches and then BENCH_SAMPLES times.
+ * Reported per case: mean ns/op, the p50/p90/p99 of the per-sample ns/op, bytes/sec for cases with a payload size,
+ * and allocations per op, counted by an allocator pushed around the timed region (only the calling thread's
+ * allocations are seen - the queue cases do not allocate while timed).
+ *
+ * Usage: rune_bench [--json] [--quick] [filter]
+ *   --json   print one JSON document on stdout instead of the table
+ *   --quick  fewer samples and smaller batches (smoke run)
+ *   filter   only run cases whose name contains this substring
+ */
+
+#include "../src/coll.h"
+#include "../src/hash.h"
+#include "../src/map.h"
+#include "../src/str.h"
+#include "../src/task.h"
+#include "../src/tree.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef uint64_t u64;
+
+static int bench_u64_cmp(const u64 a, const u64 b) {
+    return (a > b) - (a < b);
+}
+
+#define T u64
+#define T_CMP bench_u64_cmp
+#include "../src/coll.h"
+#include "../src/tree.h"
+#undef T_CMP
+#undef T
+
+#define K u64
+#define V u64
+#include "../src/map.h"
+#undef K
+#undef V
+
+// Timed samples per case (the first, untimed run is extra)
+static constexpr size_t BENCH_SAMPLES = 51;
+
+// Samples per case with --quick
+static constexpr size_t BENCH_SAMPLES_QUICK = 5;
+
+// --quick divides every batch size by this
+static constexpr size_t BENCH_QUICK_DIV = 16;
+
+// Upper bound on registered results
+static constexpr size_t BENCH_RESULTS_MAX = 128;
+
+// Producer / consumer threads per side in the MPMC case
+static constexpr int BENCH_MPMC_THREADS = 4;
+
+// =====================================================================================================================
+// Harness
+// =====================================================================================================================
+
+// splitmix64 - distinct, well-mixed keys from a counter
+static u64 bench_key(const u64 i) {
+    u64 z = i + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// ------------------------------------------------ Counting allocator -------------------------------------------------
+
+typedef struct {
+    size_t allocs;
+    size_t bytes;
+} bench_alloc_stats;
+
+static void * bench_count_alloc(void * ctx, const size_t size) {
+    bench_alloc_stats * stats = ctx;
+    stats->allocs++;
+    stats->bytes += size;
+    void * ptr = malloc(size);
+    if (ptr == nullptr) {
+        err_set(R_ERR_OUT_OF_MEMORY, nullptr);
+    }
+    return ptr;
+}
+
+// A growing realloc counts as one allocation of the added bytes; shrinking is free
+static void * bench_count_realloc(void * ctx, void * ptr, const size_t old_size, const size_t new_size) {
+    bench_alloc_stats * stats = ctx;
+    stats->allocs++;
+    stats->bytes += new_size > old_size ? new_size - old_size : 0;
+    void * new_ptr = realloc(ptr, new_size);
+    if (new_ptr == nullptr) {
+        err_set(R_ERR_OUT_OF_MEMORY, nullptr);
+    }
+    return new_ptr;
+}
+
+static void bench_count_free(void * ctx, void * ptr, const size_t size) {
+    (void)ctx;
+    (void)size;
+    free(ptr);
+}
+
+// ------------------------------------------------------ Cases -------------------------------------------------------
+
+/**
+ * One benchmark case. run performs ops operations and returns a checksum that keeps them observable; reset (optional)
+ * restores the starting state between samples and is not timed.
+ */
+typedef struct {
+    const char * name;
+    size_t ops;
+    size_t bytes_per_op;
+    u64 (*run)(void * arg, size_t ops);
+    void (*reset)(void * arg);
+    void * arg;
+} bench_case;
+
+typedef struct {
+    char name[48];
+    size_t ops;
+    size_t bytes_per_op;
+    double mean;
+    double p50;
+    double p90;
+    double p99;
+    double allocs_per_op;
+    double alloc_bytes_per_op;
+} bench_result;
+
+static struct {
+    size_t samples;
+    size_t quick_div;
+    const char * filter;
+    bench_result results[BENCH_RESULTS_MAX];
+    size_t count;
+    u64 sink;
+} bench = {.samples = BENCH_SAMPLES, .quick_div = 1};
+
+static int bench_cmp_double(const void * a, const void * b) {
+    const double x = *(const double *)a;
+    const double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted values
+static double bench_percentile(const double * sorted, const size_t n, const unsigned pct) {
+    size_t rank = (pct * n + 99) / 100;
+    rank = rank == 0 ? 1 : rank;
+    return sorted[rank - 1];
+}
+
+static void bench_measure(const bench_case * c) {
+    if (bench.filter != nullptr && strstr(c->name, bench.filter) == nullptr) {
+        return;
+    }
+    if (bench.count == BENCH_RESULTS_MAX) {
+        fprintf(stderr, "rune_bench: more than %zu cases, %s skipped\n", BENCH_RESULTS_MAX, c->name);
+        return;
+    }
+    const size_t ops = c->ops;
+
+    bench.sink += c->run(c->arg, ops);
+    if (c->reset != nullptr) {
+        c->reset(c->arg);
+    }
+
+    double ns[BENCH_SAMPLES];
+    double total = 0;
+    bench_alloc_stats stats = {0};
+    const allocator counting = {
+        .alloc = bench_count_alloc,
+        .realloc = bench_count_realloc,
+        .free = bench_count_free,
+        .ctx = &stats,
+    };
+    for (size_t s = 0; s < bench.samples; s++) {
+        double elapsed = 0;
+        alloc_scope(counting) {
+            const double start = bench_now_ns();
+            bench.sink += c->run(c->arg, ops);
+            elapsed = bench_now_ns() - start;
+        }
+        if (c->reset != nullptr) {
+            c->reset(c->arg);
+        }
+        ns[s] = elapsed / (double)ops;
+        total += elapsed;
+    }
+    qsort(ns, bench.samples, sizeof(ns[0]), bench_cmp_double);
+
+    const double n_ops = (double)ops * (double)bench.samples;
+    bench_result * r = &bench.results[bench.count++];
+    *r = (bench_result){
+        .ops = ops,
+        .bytes_per_op = c->bytes_per_op,
+        .mean = total / n_ops,
+        .p50 = bench_percentile(ns, bench.samples, 50),
+        .p90 = bench_percentile(ns, bench.samples, 90),
+        .p99 = bench_percentile(ns, bench.samples, 99),
+        .allocs_per_op = (double)stats.allocs / n_ops,
+        .alloc_bytes_per_op = (double)stats.bytes / n_ops,
+    };
+    snprintf(r->name, sizeof(r->name), "%s", c->name);
+}
+
+// Batch size for a case: n operations, n / BENCH_QUICK_DIV with --quick
+static size_t bench_ops(const size_t n) {
+    return n / bench.quick_div > 0 ? n / bench.quick_div : 1;
+}
+
+// Throughput from the median, 0 when the case has no payload
+static double bench_bytes_per_sec(const bench_result * r) {
+    return r->bytes_per_op > 0 && r->p50 > 0 ? (double)r->bytes_per_op * 1e9 / r->p50 : 0;
+}
+
+static void bench_print_table(FILE * out) {
+    fprintf(out, "%-28s %8s %10s %10s %10s %10s %10s %10s %10s\n", "case", "ops", "mean ns", "p50 ns", "p90 ns",
+            "p99 ns", "MB/s", "allocs/op", "B/op");
+    for (size_t i = 0; i < bench.count; i++) {
+        const bench_result * r = &bench.results[i];
+        const double bps = bench_bytes_per_sec(r);
+        char mbps[32] = "-";
+        if (bps > 0) {
+            snprintf(mbps, sizeof(mbps), "%.1f", bps / 1e6);
+        }
+        fprintf(out, "%-28s %8zu %10.2f %10.2f %10.2f %10.2f %10s %10.3f %10.1f\n", r->name, r->ops, r->mean, r->p50,
+                r->p90, r->p99, mbps, r->allocs_per_op, r->alloc_bytes_per_op);
+    }
+}
+
+// Case names are plain ASCII identifiers with '/' and never need escaping
+static void bench_print_json(FILE * out) {
+    fprintf(out, "{\n  \"benchmark\": \"rune_bench\",\n  \"samples\": %zu,\n  \"results\": [", bench.samples);
+    for (size_t i = 0; i < bench.count; i++) {
+        const bench_result * r = &bench.results[i];
+        fprintf(out, "%s\n    {\"name\": \"%s\", \"ops_per_sample\": %zu, \"ns_per_op\": %.3f, ", i > 0 ? "," : "",
+                r->name, r->ops, r->mean);
+        fprintf(out, "\"p50_ns\": %.3f, \"p90_ns\": %.3f, \"p99_ns\": %.3f, ", r->p50, r->p90, r->p99);
+        const double bps = bench_bytes_per_sec(r);
+        if (bps > 0) {
+            fprintf(out, "\"bytes_per_sec\": %.0f, ", bps);
+        } else {
+            fprintf(out, "\"bytes_per_sec\": null, ");
+        }
+        fprintf(out, "\"allocs_per_op\": %.4f, \"alloc_bytes_per_op\": %.2f}", r->allocs_per_op,
+                r->alloc_bytes_per_op);
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+// Buffer of n pseudo-random lowercase letters (no delimiters, so searches only match where planted)
+static char * bench_text(const size_t n, const u64 seed) {
+    char * s = malloc(n + 1);
+    for (size_t i = 0; i < n; i++) {
+        s[i] = (char)('a' + bench_key(seed + i) % 26);
+    }
+    s[n] = '\0';
+    return s;
+}
+
+// =====================================================================================================================
+// str
+// =====================================================================================================================
+
+typedef struct {
+    char * parts[3];
+} bench_str_cat_arg;
+
+static u64 bench_str_cat(void * arg, const size_t ops) {
+    const bench_str_cat_arg * a = arg;
+    u64 acc = 0;
+    for (size_t i = 0; i < ops; i++) {
+        char * s = str_cat(a->parts[0], a->parts[1], a->parts[2], nullptr);
+        acc += (unsigned char)s[0];
+        str_free(s);
+    }
+    return acc;
+}
+
+// Response-body accumulation: BENCH_BODY_PIECES appends of one piece per op, by repeated str_cat or by strbuf
+static constexpr size_t BENCH_BODY_PIECES = 64;
+static const str_opt bench_body_opt = {.max_len = 1 << 20};
+
+static u64 bench_str_cat_accumulate(void * arg, const size_t ops) {
+    const char * piece = arg;
+    u64 acc = 0;
+    for (size_t i = 0; i < ops; i++) {
+        char * body = str("", &bench_body_opt);
+        for (size_t p = 0; p < BENCH_BODY_PIECES; p++) {
+            char * next = str_cat(&bench_body_opt, body, piece, nullptr);
+            str_free(body);
+            body = next;
+        }
+        acc += str_len(body, &bench_body_opt);
+        str_free(body);
+    }
+    return acc;
+}
+
+static u64 bench_strbuf_accumulate(void * arg, const size_t ops) {
+    const char * piece = arg;
+    const strview v = str_view(piece);
+    u64 acc = 0;
+    for (size_t i = 0; i < ops; i++) {
+        strbuf b = strbuf(&bench_body_opt);
+        for (size_t p = 0; p < BENCH_BODY_PIECES; p++) {
+            strbuf_add(&b, v);
+        }
+        char * body = strbuf_finish(&b);
+        acc += str_len(body, &bench_body_opt);
+        str_free(body);
+    }
+    return acc;
+}
+
+static u64 bench_str_split(void * arg, const size_t ops) {
+    const char * line = arg;
+    u64 acc = 0;
+    for (size_t i = 0; i < ops; i++) {
+        char ** fields = str_split(line, ",");
+        for (char ** f = fields; *f != nullptr; f++) {
+            acc++;
+        }
+        str_free_arr(fields);
+    }
+    return acc;
+}
+
+typedef struct {
+    const char * haystack;
+    const char * needle;
+} bench_str_find_arg;
+
+static u64 bench_str_find(void * arg, const size_t ops) {
+    const bench_str_find_arg * a = arg;
+    u64 acc = 0;
+    for (size_t i = 0; i < ops; i++) {
+        const char * hit = str_find(a->haystack, a->needle);
+        acc += hit != nullptr ? (u64)(hit - a->haystack) : 1;
+    }
+    return acc;
+}
+
+static void bench_str(void) {
+    // str_cat: three equal pieces per result
+    static const size_t cat_sizes[] = {16, 256, 4096};
+    for (size_t i = 0; i < sizeof(cat_sizes) / sizeof(cat_sizes[0]); i++) {
+        const size_t total = cat_sizes[i];
+        bench_str_cat_arg arg = {0};
+        for (size_t p = 0; p < 3; p++) {
+            arg.parts[p] = bench_text(p < 2 ? total / 3 : total - 2 * (total / 3), p * 1000);
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "str_cat/%zu", total);
+        bench_measure(&(bench_case){
+            .name = name, .ops = bench_ops(8192), .bytes_per_op = total, .run = bench_str_cat, .arg = &arg});
+        for (size_t p = 0; p < 3; p++) {
+            free(arg.parts[p]);
+        }
+    }
+
+    // Body of 64 pieces: quadratic copying through str_cat versus in-place appends
+    static const size_t piece_sizes[] = {16, 256};
+    for (size_t i = 0; i < sizeof(piece_sizes) / sizeof(piece_sizes[0]); i++) {
+        const size_t n = piece_sizes[i];
+        char * piece = bench_text(n, 3);
+        char name[64];
+        snprintf(name, sizeof(name), "str_cat/accumulate/%zu", n * BENCH_BODY_PIECES);
+        bench_measure(&(bench_case){
+            .name = name,
+            .ops = bench_ops(512),
+            .bytes_per_op = n * BENCH_BODY_PIECES,
+            .run = bench_str_cat_accumulate,
+            .arg = piece,
+        });
+        snprintf(name, sizeof(name), "strbuf/accumulate/%zu", n * BENCH_BODY_PIECES);
+        bench_measure(&(bench_case){
+            .name = name,
+            .ops = bench_ops(512),
+            .bytes_per_op = n * BENCH_BODY_PIECES,
+            .run = bench_strbuf_accumulate,
+            .arg = piece,
+        });
+        free(piece);
+    }
+
+    // str_split: fields of 7 letters plus a comma
+    static const size_t split_fields[] = {8, 64};
+    for (size_t i = 0; i < sizeof(split_fields) / sizeof(split_fields[0]); i++) {
+        const size_t fields = split_fields[i];
+        char * line = bench_text(fields * 8, 7);
+        for (size_t f = 0; f < fields; f++) {
+            line[f * 8 + 7] = ',';
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "str_split/%zu_fields", fields);
+        bench_measure(&(bench_case){
+            .name = name, .ops = bench_ops(2048), .bytes_per_op = fields * 8, .run = bench_str_split, .arg = line});
+        free(line);
+    }
+
+    // str_find: a needle planted at the end of the haystack (hit) or nowhere (miss)
+    static const size_t find_sizes[] = {64, 4096, 65536};
+    for (size_t i = 0; i < sizeof(find_sizes) / sizeof(find_sizes[0]); i++) {
+        const size_t n = find_sizes[i];
+        char * haystack = bench_text(n, 99);
+        memcpy(haystack + n - 8, "NEEDLE!!", 8);
+        const size_t ops = bench_ops(((size_t)1 << 24) / n);
+
+        char name[64];
+        snprintf(name, sizeof(name), "str_find/hit/%zu", n);
+        bench_measure(&(bench_case){
+            .name = name,
+            .ops = ops,
+            .bytes_per_op = n,
+            .run = bench_str_find,
+            .arg = &(bench_str_find_arg){haystack, "NEEDLE!!"},
+        });
+        snprintf(name, sizeof(name), "str_find/miss/%zu", n);
+        bench_measure(&(bench_case){
+            .name = name,
+            .ops = ops,
+            .bytes_per_op = n,
+            .run = bench_str_find,
+            .arg = &(bench_str_find_arg){haystack, "NEEDLE??"},
+        });
+        free(haystack);
+    }
+}
+
+// =====================================================================================================================
+// hash
+// =====================================================================================================================
+
+typedef struct {
+    const unsigned char * data;
+    size_t size;
+} bench_hash_arg;
+
+// One run function per hash so the call is direct; the input is offset by the counter to defeat hoisting
+#define BENCH_HASH_RUN(fn, expr)                                                                                       \
+    static u64 bench_hash_##fn(void * arg, const size_t ops) {                                                         \
+        const bench_hash_arg * a = arg;                                                                                \
+        u64 acc = 0;                                                                                                   \
+        for (size_t i = 0; i < ops; i++) {                                                                             \
+            const unsigned char * data = a->data + (i & 7);                                                            \
+            const size_t size = a->size;                                                                               \
+            acc += (expr);                                                                                             \
+        }                                                                                                              \
+        return acc;                                                                                                    \
+    }
+
+BENCH_HASH_RUN(murmur32, murmur32(data, size, 0))
+BENCH_HASH_RUN(murmur64, murmur64(data, size, 0))
+BENCH_HASH_RUN(murmur128, murmur128(data, size, 0).h1)
+BENCH_HASH_RUN(xxhash64, xxhash64(data, size, 0))
+BENCH_HASH_RUN(crchash64, crchash64(data, size, 0))
+BENCH_HASH_RUN(crc32c, crc32c(data, size, 0))
+
+#undef BENCH_HASH_RUN
+
+static void bench_hash(void) {
+    static const struct {
+        const char * name;
+        u64 (*run)(void * arg, size_t ops);
+    } fns[] = {
+        {"murmur32", bench_hash_murmur32},   {"murmur64", bench_hash_murmur64},
+        {"murmur128", bench_hash_murmur128}, {"xxhash64", bench_hash_xxhash64},
+        {"crchash64", bench_hash_crchash64}, {"crc32c", bench_hash_crc32c},
+    };
+    static const size_t sizes[] = {8, 16, 64, 256, 4096, 65536};
+
+    unsigned char * buf = (unsigned char *)bench_text(sizes[sizeof(sizes) / sizeof(sizes[0]) - 1] + 8, 3);
+    for (size_t f = 0; f < sizeof(fns) / sizeof(fns[0]); f++) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            char name[64];
+            snprintf(name, sizeof(name), "%s/%zu", fns[f].name, sizes[s]);
+            // Same bytes hashed per sample for every size, at least 256 calls
+            const size_t ops = bench_ops(((size_t)1 << 20) / sizes[s] > 256 ? ((size_t)1 << 20) / sizes[s] : 256);
+            bench_measure(&(bench_case){
+                .name = name,
+                .ops = ops,
+                .bytes_per_op = sizes[s],
+                .run = fns[f].run,
+                .arg = &(bench_hash_arg){buf, sizes[s]},
+            });
+        }
+    }
+    free(buf);
+}
+
+// =====================================================================================================================
+// coll
+// =====================================================================================================================
+
+static u64 bench_list_add(void * arg, const size_t ops) {
+    LIST(u64) * lst = arg;
+    for (size_t i = 0; i < ops; i++) {
+        list_add(lst, (u64)i);
+    }
+    return lst->size;
+}
+
+// Same appends after one list_reserve for the whole batch
+static u64 bench_list_add_reserved(void * arg, const size_t ops) {
+    LIST(u64) * lst = arg;
+    list_reserve(lst, ops);
+    for (size_t i = 0; i < ops; i++) {
+        list_add(lst, (u64)i);
+    }
+    return lst->size;
+}
+
+// Bulk append in chunks of 64 elements (ops counts elements)
+static u64 bench_list_add_n(void * arg, const size_t ops) {
+    LIST(u64) * lst = arg;
+    u64 chunk[64];
+    for (size_t i = 0; i < 64; i++) {
+        chunk[i] = i;
+    }
+    for (size_t i = 0; i + 64 <= ops; i += 64) {
+        list_add_n(lst, chunk, 64);
+    }
+    return lst->size;
+}
+
+static u64 bench_list_insert_front(void * arg, const size_t ops) {
+    LIST(u64) * lst = arg;
+    for (size_t i = 0; i < ops; i++) {
+        list_insert(lst, 0, (u64)i);
+    }
+    return lst->size;
+}
+
+static void bench_list_reset(void * arg) {
+    LIST(u64) * lst = arg;
+    list_free(lst);
+    *lst = list(u64);
+}
+
+// Push and pop on one thread: the uncontended cost of a round trip
+static u64 bench_lfq_roundtrip(void * arg, const size_t ops) {
+    LFQ(u64) * q = arg;
+    u64 acc = 0;
+    for (size_t i = 0; i < ops; i++) {
+        lfq_push(q, (u64)i + 1);
+        acc += lfq_pop(q);
+    }
+    return acc;
+}
+
+typedef struct {
+    LFQ(u64) * q;
+    size_t ops;
+} bench_lfq_job;
+
+static void * bench_lfq_producer(void * arg) {
+    const bench_lfq_job * job = arg;
+    for (size_t i = 1; i <= job->ops; i++) {
+        while (lfq_push(job->q, (u64)i) == 0) {
+            err_clear();
+            sched_yield();
+        }
+    }
+    return nullptr;
+}
+
+// A producer thread feeds the calling thread through a small queue, so both ends keep hitting full / empty. A side
+// that finds the queue full / empty yields, so the case also completes when there are fewer cores than threads.
+static u64 bench_lfq_contended(void * arg, const size_t ops) {
+    bench_lfq_job job = {.q = arg, .ops = ops};
+    pthread_t producer;
+    pthread_create(&producer, nullptr, bench_lfq_producer, &job);
+    u64 acc = 0;
+    for (size_t got = 0; got < ops;) {
+        const u64 item = lfq_pop(job.q);
+        if (item == 0) {
+            err_clear();
+            sched_yield();
+            continue;
+        }
+        acc += item;
+        got++;
+    }
+    pthread_join(producer, nullptr);
+    return acc;
+}
+
+typedef struct {
+    MPMC(u64) * q;
+    size_t ops;
+    u64 acc;
+} bench_mpmc_job;
+
+static void * bench_mpmc_producer(void * arg) {
+    const bench_mpmc_job * job = arg;
+    for (size_t i = 1; i <= job->ops; i++) {
+        while (mpmc_push(job->q, (u64)i) == 0) {
+            err_clear();
+            sched_yield();
+        }
+    }
+    return nullptr;
+}
+
+static void * bench_mpmc_consumer(void * arg) {
+    bench_mpmc_job * job = arg;
+    for (size_t got = 0; got < job->ops;) {
+        const u64 item = mpmc_pop(job->q);
+        if (item == 0) {
+            err_clear();
+            sched_yield();
+            continue;
+        }
+        job->acc += item;
+        got++;
+    }
+    return nullptr;
+}
+
+// BENCH_MPMC_THREADS producers and as many consumers; ops counts items moved through the queue
+static u64 bench_mpmc_contended(void * arg, const size_t ops) {
+    pthread_t producers[BENCH_MPMC_THREADS];
+    pthread_t consumers[BENCH_MPMC_THREADS];
+    bench_mpmc_job jobs[BENCH_MPMC_THREADS];
+    const size_t per_thread = ops / BENCH_MPMC_THREADS;
+    for (int t = 0; t < BENCH_MPMC_THREADS; t++) {
+        jobs[t] = (bench_mpmc_job){.q = arg, .ops = per_thread};
+        pthread_create(&consumers[t], nullptr, bench_mpmc_consumer, &jobs[t]);
+        pthread_create(&producers[t], nullptr, bench_mpmc_producer, &jobs[t]);
+    }
+    u64 acc = 0;
+    for (int t = 0; t < BENCH_MPMC_THREADS; t++) {
+        pthread_join(producers[t], nullptr);
+        pthread_join(consumers[t], nullptr);
+        acc += jobs[t].acc;
+    }
+    return acc;
+}
+
+static void bench_coll(void) {
+    LIST(u64) lst = list(u64);
+    bench_measure(&(bench_case){
+        .name = "list_add", .ops = bench_ops(1 << 16), .run = bench_list_add, .reset = bench_list_reset, .arg = &lst});
+    bench_measure(&(bench_case){
+        .name = "list_add/reserved",
+        .ops = bench_ops(1 << 16),
+        .run = bench_list_add_reserved,
+        .reset = bench_list_reset,
+        .arg = &lst,
+    });
+    bench_measure(&(bench_case){
+        .name = "list_add_n/64",
+        .ops = bench_ops(1 << 16),
+        .bytes_per_op = sizeof(u64),
+        .run = bench_list_add_n,
+        .reset = bench_list_reset,
+        .arg = &lst,
+    });
+    bench_measure(&(bench_case){
+        .name = "list_insert/front",
+        .ops = bench_ops(1 << 12),
+        .run = bench_list_insert_front,
+        .reset = bench_list_reset,
+        .arg = &lst,
+    });
+    list_free(&lst);
+
+    LFQ(u64) q = lfq(u64, 1024);
+    bench_measure(&(bench_case){
+        .name = "lfq_push+pop/1thread", .ops = bench_ops(1 << 18), .run = bench_lfq_roundtrip, .arg = &q});
+    lfq_free(&q);
+
+    LFQ(u64) small = lfq(u64, 64);
+    bench_measure(&(bench_case){
+        .name = "lfq_push+pop/2threads", .ops = bench_ops(1 << 16), .run = bench_lfq_contended, .arg = &small});
+    lfq_free(&small);
+
+    MPMC(u64) mq = mpmc(u64, 256);
+    bench_measure(&(bench_case){
+        .name = "mpmc_push+pop/4p4c", .ops = bench_ops(1 << 16), .run = bench_mpmc_contended, .arg = &mq});
+    mpmc_free(&mq);
+}
+
+// =====================================================================================================================
+// tree
+// =====================================================================================================================
+
+typedef struct {
+    RBT(u64) rbt;
+    BTREE(u64) btree;
+    u64 * keys;
+    size_t n;
+} bench_tree_arg;
+
+static u64 bench_rbt_insert(void * arg, const size_t ops) {
+    bench_tree_arg * a = arg;
+    for (size_t i = 0; i < ops; i++) {
+        rbt_insert(&a->rbt, a->keys[i % a->n]);
+    }
+    return a->rbt.size;
+}
+
+static u64 bench_rbt_contains(void * arg, const size_t ops) {
+    bench_tree_arg * a = arg;
+    u64 acc = 0;
+    for (size_t i = 0; i < ops; i++) {
+        acc += rbt_contains(&a->rbt, a->keys[(i * 7919) % a->n]);
+    }
+    return acc;
+}
+
+static u64 bench_rbt_remove(void * arg, const size_t ops) {
+    bench_tree_arg * a = arg;
+    for (size_t i = 0; i < ops; i++) {
+        rbt_remove(&a->rbt, a->keys[(i * 7919) % a->n]);
+    }
+    return a->rbt.size;
+}
+
+static void bench_rbt_clear(void * arg) {
+    bench_tree_arg * a = arg;
+    rbt_clear(&a->rbt);
+}
+
+static void bench_rbt_fill(void * arg) {
+    bench_tree_arg * a = arg;
+    rbt_clear(&a->rbt);
+    for (size_t i = 0; i < a->n; i++) {
+        rbt_insert(&a->rbt, a->keys[i]);
+    }
+}
+
+static u64 bench_btree_insert(void * arg, const size_t ops) {
+    bench_tree_arg * a = arg;
+    for (size_t i = 0; i < ops; i++) {
+        btree_insert(&a->btree, a->keys[i % a->n]);
+    }
+    return a->btree.size;
+}
+
+static u64 bench_btree_contains(void * arg, const size_t ops) {
+    bench_tree_arg * a = arg;
+    u64 acc = 0;
+    for (size_t i = 0; i < ops; i++) {
+        acc += btree_contains(&a->btree, a->keys[(i * 7919) % a->n]);
+    }
+    return acc;
+}
+
+static void bench_btree_clear(void * arg) {
+    bench_tree_arg * a = arg;
+    btree_clear(&a->btree);
+}
+
+static void bench_tree(void) {
+    // 7919 is prime, so the strided lookups and removals visit every key of a power-of-two key set exactly once
+    static const size_t sizes[] = {1 << 10, 1 << 16};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        const size_t n = bench_ops(sizes[s]);
+        bench_tree_arg arg = {.rbt = rbt(u64), .btree = btree(u64), .keys = malloc(n * sizeof(u64)), .n = n};
+        for (size_t i = 0; i < n; i++) {
+            arg.keys[i] = bench_key(i);
+        }
+        const size_t ops = n;
+        char name[64];
+
+        snprintf(name, sizeof(name), "rbt_insert/%zu", sizes[s]);
+        bench_measure(&(bench_case){
+            .name = name, .ops = ops, .run = bench_rbt_insert, .reset = bench_rbt_clear, .arg = &arg});
+
+        snprintf(name, sizeof(name), "rbt_remove/%zu", sizes[s]);
+        bench_rbt_fill(&arg);
+        bench_measure(&(bench_case){
+            .name = name, .ops = ops, .run = bench_rbt_remove, .reset = bench_rbt_fill, .arg = &arg});
+
+        snprintf(name, sizeof(name), "rbt_contains/%zu", sizes[s]);
+        bench_measure(&(bench_case){.name = name, .ops = ops, .run = bench_rbt_contains, .arg = &arg});
+        rbt_clear(&arg.rbt);
+
+        snprintf(name, sizeof(name), "btree_insert/%zu", sizes[s]);
+        bench_measure(&(bench_case){
+            .name = name, .ops = ops, .run = bench_btree_insert, .reset = bench_btree_clear, .arg = &arg});
+
+        snprintf(name, sizeof(name), "btree_contains/%zu", sizes[s]);
+        bench_btree_insert(&arg, n);
+        bench_measure(&(bench_case){.name = name, .ops = ops, .run = bench_btree_contains, .arg = &arg});
+        btree_clear(&arg.btree);
+
+        free(arg.keys);
+    }
+}
+
+// =====================================================================================================================
+// main
+// =====================================================================================================================
+
+// =====================================================================================================================
+// task
+// =====================================================================================================================
+
+static constexpr size_t BENCH_TASK_BLOCK = 16 * 1024;
+static constexpr size_t BENCH_TASK_BLOCKS = 64;
+
+typedef struct {
+    task_pool * pool;
+    const char * data;
+    u64 digests[BENCH_TASK_BLOCKS];
+} bench_task_arg;
+
+static void bench_task_nothing(void * arg) {
+    (void)arg;
+}
+
+// Scheduling overhead: spawn a group of empty tasks from outside the pool and wait for it
+static u64 bench_task_spawn_wait(void * arg, const size_t ops) {
+    const bench_task_arg * a = arg;
+    task_group g = task_group(a->pool);
+    for (size_t i = 0; i < ops; i++) {
+        task_spawn(&g, bench_task_nothing, nullptr);
+    }
+    return task_wait(&g);
+}
+
+static void bench_task_hash_range(void * arg, const size_t begin, const size_t end) {
+    bench_task_arg * a = arg;
+    for (size_t i = begin; i < end; i++) {
+        a->digests[i] = xxhash64(a->data + i * BENCH_TASK_BLOCK, BENCH_TASK_BLOCK, 0);
+    }
+}
+
+// Bulk hashing: one 16 KiB block per index across the pool
+static u64 bench_task_for_hash(void * arg, const size_t ops) {
+    bench_task_arg * a = arg;
+    u64 acc = 0;
+    for (size_t i = 0; i < ops; i++) {
+        task_for(a->pool, BENCH_TASK_BLOCKS, 1, bench_task_hash_range, a);
+        acc += a->digests[i % BENCH_TASK_BLOCKS];
+    }
+    return acc;
+}
+
+static void bench_task(void) {
+    // Created outside the timed region so the workers allocate from the default allocator
+    bench_task_arg arg = {.pool = task_pool(), .data = bench_text(BENCH_TASK_BLOCK * BENCH_TASK_BLOCKS, 11)};
+
+    char name[64];
+    snprintf(name, sizeof(name), "task_spawn+wait/%zu_workers", task_pool_workers(arg.pool));
+    bench_measure(&(bench_case){.name = name, .ops = bench_ops(1 << 14), .run = bench_task_spawn_wait, .arg = &arg});
+    snprintf(name, sizeof(name), "task_for/xxhash64/%zu_workers", task_pool_workers(arg.pool));
+    bench_measure(&(bench_case){
+        .name = name,
+        .ops = bench_ops(64),
+        .bytes_per_op = BENCH_TASK_BLOCK * BENCH_TASK_BLOCKS,
+        .run = bench_task_for_hash,
+        .arg = &arg,
+    });
+
+    task_pool_free(arg.pool);
+    free((void *)arg.data);
+}
+
+// =====================================================================================================================
+// bulk
+// =====================================================================================================================
+
+// Bulk builds: sorting and map construction over the same pseudo-random keys, on one thread and on the pool
+typedef struct {
+    task_pool * pool;
+    const u64 * keys;
+    const u64 * vals;
+    LIST(u64) lst;
+    MAP(u64, u64) m;
+} bench_bulk_arg;
+
+static int bench_qsort_u64(const void * a, const void * b) {
+    return bench_u64_cmp(*(const u64 *)a, *(const u64 *)b);
+}
+
+static u64 bench_bulk_qsort(void * arg, const size_t ops) {
+    bench_bulk_arg * a = arg;
+    qsort(a->lst.data, ops, sizeof(u64), bench_qsort_u64);
+    return a->lst.data[ops / 2];
+}
+
+static u64 bench_bulk_list_sort(void * arg, const size_t ops) {
+    bench_bulk_arg * a = arg;
+    list_sort(&a->lst);
+    return a->lst.data[ops / 2];
+}
+
+static u64 bench_bulk_list_par_sort(void * arg, const size_t ops) {
+    bench_bulk_arg * a = arg;
+    list_par_sort(u64, &a->lst, a->pool);
+    return a->lst.data[ops / 2];
+}
+
+static void bench_bulk_unsort(void * arg) {
+    bench_bulk_arg * a = arg;
+    memcpy(a->lst.data, a->keys, a->lst.size * sizeof(u64));
+}
+
+static u64 bench_bulk_map_put(void * arg, const size_t ops) {
+    bench_bulk_arg * a = arg;
+    for (size_t i = 0; i < ops; i++) {
+        map_put(&a->m, a->keys[i], (u64)i);
+    }
+    return map_size(&a->m);
+}
+
+static u64 bench_bulk_map_put_all(void * arg, const size_t ops) {
+    bench_bulk_arg * a = arg;
+    map_put_all(u64, u64, &a->m, a->pool, a->keys, a->vals, ops);
+    return map_size(&a->m);
+}
+
+static void bench_bulk_map_reset(void * arg) {
+    bench_bulk_arg * a = arg;
+    map_free(&a->m);
+}
+
+static void bench_bulk(void) {
+    const size_t n = bench_ops(1 << 20);
+    u64 * keys = malloc(n * sizeof(u64));
+    u64 * vals = malloc(n * sizeof(u64));
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = bench_key(i);
+        vals[i] = i;
+    }
+    bench_bulk_arg arg = {.pool = task_pool(), .keys = keys, .vals = vals, .lst = list(u64), .m = map(u64, u64)};
+    list_add_n(&arg.lst, keys, n);
+
+    char name[64];
+    bench_measure(&(bench_case){
+        .name = "qsort/u64", .ops = n, .run = bench_bulk_qsort, .reset = bench_bulk_unsort, .arg = &arg});
+    bench_measure(&(bench_case){
+        .name = "list_sort/u64", .ops = n, .run = bench_bulk_list_sort, .reset = bench_bulk_unsort, .arg = &arg});
+    snprintf(name, sizeof(name), "list_par_sort/u64/%zu_workers", task_pool_workers(arg.pool));
+    bench_measure(&(bench_case){
+        .name = name, .ops = n, .run = bench_bulk_list_par_sort, .reset = bench_bulk_unsort, .arg = &arg});
+    bench_measure(&(bench_case){
+        .name = "map_put/build", .ops = n, .run = bench_bulk_map_put, .reset = bench_bulk_map_reset, .arg = &arg});
+    snprintf(name, sizeof(name), "map_put_all/build/%zu_workers", task_pool_workers(arg.pool));
+    bench_measure(&(bench_case){
+        .name = name, .ops = n, .run = bench_bulk_map_put_all, .reset = bench_bulk_map_reset, .arg = &arg});
+
+    list_free(&arg.lst);
+    map_free(&arg.m);
+    task_pool_free(arg.pool);
+    free(keys);
+    free(vals);
+}
+
+int main(const int argc, char ** argv) {
+    bool json = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--quick") == 0) {
+            bench.samples = BENCH_SAMPLES_QUICK;
+            bench.quick_div = BENCH_QUICK_DIV;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: %s [--json] [--quick] [filter]\n", argv[0]);
+            return EXIT_FAILURE;
+        } else {
+            bench.filter = argv[i];
+        }
+    }
+
+    bench_str();
+    bench_hash();
+    bench_coll();
+    bench_tree();
+    bench_task();
+    bench_bulk();
+
+    if (json) {
+        bench_print_json(stdout);
+    } else {
+        bench_print_table(stdout);
+    }
+
+    // Keep the results observable so the work is not optimized away
+    fprintf(stderr, "checksum %llu\n", (unsigned long long)bench.sink);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,265 @@
+/*
+ * Bloom module implementation - split-block filter over 64-byte blocks.
+ *
+ * Block layout: Putze, Sanders and Singler, "Cache-, Hash- and Space-Efficient Bloom Filters" (WEA 2007); the
+ * one-bit-per-word split follows the Impala / Parquet split block Bloom filter. Bit positions use the double hashing
+ * of Kirsch and Mitzenmacher, "Less Hashing, Same Performance" (ESA 2006).
+ */
+
+#include "bloom.h"
+
+// Filter instruction set, selected at compile time (RCFG__BLOOM_NO_SIMD forces the portable path)
+#if !defined(RCFG__BLOOM_NO_SIMD) && defined(__AVX2__)
+#define R_BLOOM_AVX2
+#include <immintrin.h>
+#endif
+
+// =====================================================================================================================
+// Internal: Filter structure
+// =====================================================================================================================
+
+static constexpr size_t R_BLOOM_WORDS = 8; // 64-bit words per block (one cache line)
+static constexpr size_t R_BLOOM_BLOCK_BITS = R_BLOOM_WORDS * 64;
+
+struct r_bloom {
+    allocator alloc; // allocator current at bloom_new / bloom_read
+    uint64_t * words;
+    size_t blocks;
+    size_t count;
+};
+
+/**
+ * False positive rate by bits per key (index 0 is 4 bits per key, the last 40): the chance that all eight words of a
+ * block have the probed bit set, averaged over the Poisson-distributed number of keys in the block.
+ */
+static const double R_BLOOM_FPP[] = {
+    3.191e-01, 1.720e-01, 9.293e-02, 5.140e-02, 2.931e-02, 1.726e-02, 1.049e-02, 6.565e-03, 4.222e-03, 2.784e-03,
+    1.879e-03, 1.294e-03, 9.089e-04, 6.495e-04, 4.716e-04, 3.476e-04, 2.596e-04, 1.964e-04, 1.503e-04, 1.163e-04,
+    9.086e-05, 7.166e-05, 5.702e-05, 4.574e-05, 3.697e-05, 3.010e-05, 2.467e-05, 2.035e-05, 1.689e-05, 1.409e-05,
+    1.183e-05, 9.973e-06, 8.452e-06, 7.195e-06, 6.152e-06, 5.282e-06, 4.553e-06,
+};
+static constexpr size_t R_BLOOM_MIN_BITS_PER_KEY = 4;
+static constexpr size_t R_BLOOM_FPP_LEN = sizeof(R_BLOOM_FPP) / sizeof(R_BLOOM_FPP[0]);
+
+// First word of the block for a hash: the high half of h1 scaled onto the block count (no modulo)
+static const uint64_t * bloom_block(const bloom * b, const hash128_t h) {
+    return b->words + (size_t)(((h.h1 >> 32) * (uint64_t)b->blocks) >> 32) * R_BLOOM_WORDS;
+}
+
+/*
+ * Bit i of a key's block sits in word i at position g_i >> 26 of g_i = h2.lo + i * h2.hi (32-bit arithmetic). The
+ * AVX2 path computes the same positions, so filters do not depend on the build.
+ */
+#if defined(R_BLOOM_AVX2)
+
+// Masks of the key's bit in words 0-3 and 4-7
+static void bloom_masks(const hash128_t h, __m256i * lo, __m256i * hi) {
+    const __m256i base = _mm256_set1_epi32((int)(uint32_t)h.h2);
+    const __m256i step = _mm256_set1_epi32((int)(uint32_t)(h.h2 >> 32));
+    const __m256i g = _mm256_add_epi32(base, _mm256_mullo_epi32(step, _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+    const __m256i pos = _mm256_srli_epi32(g, 26);
+    const __m256i one = _mm256_set1_epi64x(1);
+    *lo = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(pos)));
+    *hi = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(pos, 1)));
+}
+
+#endif
+
+// =====================================================================================================================
+// Public API: Lifecycle
+// =====================================================================================================================
+
+static bloom * bloom_alloc(const size_t blocks) {
+    bloom * b = mem_alloc(sizeof(bloom));
+    if (b == nullptr) {
+        err_set(R_ERR_ALLOC_FAILED, nullptr);
+        return nullptr;
+    }
+    *b = (bloom){.alloc = alloc_current(), .blocks = blocks};
+    b->words = mem_alloc(blocks * R_BLOOM_WORDS * sizeof(uint64_t));
+    if (b->words == nullptr) {
+        mem_free(b, sizeof(bloom));
+        err_set(R_ERR_ALLOC_FAILED, nullptr);
+        return nullptr;
+    }
+    memset(b->words, 0, blocks * R_BLOOM_WORDS * sizeof(uint64_t));
+    return b;
+}
+
+extern bloom * bloom_new(const size_t n, const double fpp) {
+    if (!(fpp > 0.0 && fpp < 1.0)) {
+        err_set(R_ERR_INVALID_ARGUMENT, "false positive rate must be in (0, 1)");
+        return nullptr;
+    }
+    size_t i = 0;
+    while (i + 1 < R_BLOOM_FPP_LEN && R_BLOOM_FPP[i] > fpp)
+        i++;
+    const size_t bits_per_key = R_BLOOM_MIN_BITS_PER_KEY + i;
+    if (n > SIZE_MAX / bits_per_key / sizeof(uint64_t)) {
+        err_set(R_ERR_OVERFLOW, "bloom filter too large");
+        return nullptr;
+    }
+    const size_t blocks = (n * bits_per_key + R_BLOOM_BLOCK_BITS - 1) / R_BLOOM_BLOCK_BITS;
+    return bloom_alloc(blocks > 0 ? blocks : 1);
+}
+
+extern void bloom_free(bloom * b) {
+    if (b == nullptr)
+        return;
+    alloc_push(b->alloc);
+    mem_free(b->words, b->blocks * R_BLOOM_WORDS * sizeof(uint64_t));
+    mem_free(b, sizeof(bloom));
+    alloc_pop();
+}
+
+extern void bloom_clear(bloom * b) {
+    if (b == nullptr)
+        return;
+    memset(b->words, 0, b->blocks * R_BLOOM_WORDS * sizeof(uint64_t));
+    b->count = 0;
+}
+
+// =====================================================================================================================
+// Public API: Keys
+// =====================================================================================================================
+
+extern void bloom_add_hash(bloom * b, const hash128_t h) {
+    if (err_null(b))
+        return;
+    uint64_t * block = (uint64_t *)bloom_block(b, h);
+#if defined(R_BLOOM_AVX2)
+    __m256i lo, hi;
+    bloom_masks(h, &lo, &hi);
+    __m256i * lower = (__m256i *)block;
+    __m256i * upper = (__m256i *)(block + 4);
+    _mm256_storeu_si256(lower, _mm256_or_si256(_mm256_loadu_si256(lower), lo));
+    _mm256_storeu_si256(upper, _mm256_or_si256(_mm256_loadu_si256(upper), hi));
+#else
+    const uint32_t base = (uint32_t)h.h2;
+    const uint32_t step = (uint32_t)(h.h2 >> 32);
+    for (uint32_t i = 0; i < R_BLOOM_WORDS; i++)
+        block[i] |= 1ULL << ((base + i * step) >> 26);
+#endif
+    b->count++;
+}
+
+extern bool bloom_has_hash(const bloom * b, const hash128_t h) {
+    if (b == nullptr)
+        return false;
+    const uint64_t * block = bloom_block(b, h);
+#if defined(R_BLOOM_AVX2)
+    __m256i lo, hi;
+    bloom_masks(h, &lo, &hi);
+    // testc: every bit of the mask is set in the block
+    return _mm256_testc_si256(_mm256_loadu_si256((const __m256i *)block), lo) &
+           _mm256_testc_si256(_mm256_loadu_si256((const __m256i *)(block + 4)), hi);
+#else
+    const uint32_t base = (uint32_t)h.h2;
+    const uint32_t step = (uint32_t)(h.h2 >> 32);
+    uint64_t missing = 0;
+    for (uint32_t i = 0; i < R_BLOOM_WORDS; i++)
+        missing |= ~block[i] & (1ULL << ((base + i * step) >> 26));
+    return missing == 0;
+#endif
+}
+
+// =====================================================================================================================
+// Public API: Whole filters
+// =====================================================================================================================
+
+extern bool bloom_merge(bloom * dst, const bloom * src) {
+    if (err_null(dst) || err_null(src))
+        return false;
+    if (dst->blocks != src->blocks) {
+        err_set(R_ERR_INVALID_ARGUMENT, "bloom filters differ in size");
+        return false;
+    }
+    // A filter merged into itself is unchanged: its keys must not be counted twice
+    if (dst == src)
+        return true;
+    const size_t words = dst->blocks * R_BLOOM_WORDS;
+    for (size_t i = 0; i < words; i++)
+        dst->words[i] |= src->words[i];
+    dst->count += src->count;
+    return true;
+}
+
+extern size_t bloom_count(const bloom * b) {
+    return b ? b->count : 0;
+}
+
+extern size_t bloom_bytes(const bloom * b) {
+    return b ? b->blocks * R_BLOOM_WORDS * sizeof(uint64_t) : 0;
+}
+
+extern double bloom_fpp(const bloom * b) {
+    if (b == nullptr || b->count == 0)
+        return 0.0;
+    // Interpolate the rate curve at the current bits per key (beyond its ends: its end values)
+    const double bits = (double)b->blocks * (double)R_BLOOM_BLOCK_BITS / (double)b->count;
+    if (bits <= (double)R_BLOOM_MIN_BITS_PER_KEY)
+        return R_BLOOM_FPP[0];
+    const double at = bits - (double)R_BLOOM_MIN_BITS_PER_KEY;
+    const size_t i = (size_t)at;
+    if (i + 1 >= R_BLOOM_FPP_LEN)
+        return R_BLOOM_FPP[R_BLOOM_FPP_LEN - 1];
+    const double t = at - (double)i;
+    return R_BLOOM_FPP[i] + (R_BLOOM_FPP[i + 1] - R_BLOOM_FPP[i]) * t;
+}
+
+// ===== Serialization =====
+
+static const char R_BLOOM_MAGIC[8] = "RUNEBLM";
+static constexpr uint32_t R_BLOOM_VERSION = 1;
+static constexpr uint32_t R_BLOOM_BYTE_ORDER = 0x01020304;
+
+typedef struct {
+    char magic[8];       // R_BLOOM_MAGIC
+    uint32_t version;    // R_BLOOM_VERSION
+    uint32_t byte_order; // R_BLOOM_BYTE_ORDER as written
+    uint64_t hash_seed;  // R_HASH_DEFAULT_SEED (keys are hashed with it)
+    uint64_t blocks;
+    uint64_t count;
+} r_bloom_header;
+
+extern bool bloom_write(const bloom * b, FILE * stream) {
+    if (err_null(b) || err_null(stream))
+        return false;
+    r_bloom_header h = {
+        .version = R_BLOOM_VERSION,
+        .byte_order = R_BLOOM_BYTE_ORDER,
+        .hash_seed = R_HASH_DEFAULT_SEED,
+        .blocks = b->blocks,
+        .count = b->count,
+    };
+    memcpy(h.magic, R_BLOOM_MAGIC, sizeof(h.magic));
+    const size_t bytes = bloom_bytes(b);
+    if (fwrite(&h, sizeof(h), 1, stream) != 1 || fwrite(b->words, 1, bytes, stream) != bytes) {
+        err_set(R_ERR_FORMAT_FAILED, "bloom filter write failed");
+        return false;
+    }
+    return true;
+}
+
+extern bloom * bloom_read(FILE * stream) {
+    if (err_null(stream))
+        return nullptr;
+    r_bloom_header h;
+    if (fread(&h, sizeof(h), 1, stream) != 1 || memcmp(h.magic, R_BLOOM_MAGIC, sizeof(h.magic)) != 0 ||
+        h.version != R_BLOOM_VERSION || h.byte_order != R_BLOOM_BYTE_ORDER || h.hash_seed != R_HASH_DEFAULT_SEED ||
+        h.blocks == 0 || h.blocks > SIZE_MAX / (R_BLOOM_WORDS * sizeof(uint64_t))) {
+        err_set(R_ERR_PARSE_FAILED, "not a bloom filter, or written by an incompatible build");
+        return nullptr;
+    }
+    bloom * b = bloom_alloc((size_t)h.blocks);
+    if (b == nullptr)
+        return nullptr;
+    const size_t bytes = bloom_bytes(b);
+    if (fread(b->words, 1, bytes, stream) != bytes) {
+        bloom_free(b);
+        err_set(R_ERR_PARSE_FAILED, "truncated bloom filter");
+        return nullptr;
+    }
+    b->count = (size_t)h.count;
+    return b;
+}
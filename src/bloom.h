@@ -0,0 +1,152 @@
+/**
+ * Bloom module - Cache-line blocked Bloom filter for fast negative lookups.
+ *
+ * Provides:
+ *   - A split-block Bloom filter: each key maps to one 64-byte block and sets one bit in each of its eight 64-bit
+ *     words, so an insert or query touches a single cache line and tests eight registers (two AVX2 vectors when
+ *     compiled in; RCFG__BLOOM_NO_SIMD forces the portable path, which gives identical filters)
+ *   - Double hashing from one MurmurHash3 128-bit hash per key (hash.h): the high half of h1 picks the block, the
+ *     two halves of h2 generate the eight bit positions
+ *   - Sizing from an expected key count and a target false positive rate
+ *   - Merging (union) of filters with the same geometry, and a portable binary format
+ *
+ * Quick Reference:
+ *
+ *   Lifecycle
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   bloom_new(n, fpp)          Filter for about n keys at false positive rate fpp (0 < fpp < 1)
+ *   bloom_free(b)              Free a filter (nullptr-safe)
+ *   bloom_clear(b)             Remove all keys, keep the size
+ *
+ *   Keys
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   bloom_add(b, key, ...)     Add a key (optional hash: hash128_t fn(key))
+ *   bloom_has(b, key, ...)     false if the key was never added; true if it probably was
+ *   bloom_add_bytes(b, p, n)   Add n bytes at p as a key
+ *   bloom_has_bytes(b, p, n)   Query n bytes at p
+ *   bloom_add_hash(b, h)       Add by a precomputed 128-bit hash
+ *   bloom_has_hash(b, h)       Query by a precomputed 128-bit hash
+ *
+ *   Whole filters
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   bloom_merge(dst, src)      Add every key of src to dst (same bloom_bytes required)
+ *   bloom_count(b)             Keys added (a merge adds the counts)
+ *   bloom_bytes(b)             Size of the bit array
+ *   bloom_fpp(b)               Expected false positive rate at the current count
+ *   bloom_write(b, stream)     Write the filter
+ *   bloom_read(stream)         Read a filter written by bloom_write
+ *
+ * Example:
+ *   // In front of a map whose misses are expensive
+ *   bloom * seen = bloom_new(1'000'000, 0.01);
+ *   map_foreach(&users, e) bloom_add(seen, e->key);
+ *
+ *   if (bloom_has(seen, name)) {                 // ~1% of absent names get here
+ *       const user * u = map_get(&users, name);
+ *       ...
+ *   }
+ *   bloom_free(seen);
+ *
+ * Keys are hashed like map.h keys: char pointers by their contents, everything else by its bytes (so struct keys
+ * must not contain padding or pointers, or need a custom hash). A filter never gives a false negative, and keys
+ * cannot be removed - rebuild the filter, or bloom_clear it, instead.
+ *
+ * Eight bits per key in one cache line costs some accuracy against an unblocked filter of the same size: about 10
+ * bits per key reach 1%, 16 bits 0.1% and 26 bits 0.01%. bloom_new sizes the filter from that curve.
+ */
+
+// ReSharper disable CppInconsistentNaming
+#ifndef RUNE_BLOOM_H
+#define RUNE_BLOOM_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "hash.h"
+#include "r.h"
+
+// =====================================================================================================================
+// Types
+// =====================================================================================================================
+
+typedef struct r_bloom bloom;
+
+// =====================================================================================================================
+// Lifecycle
+// =====================================================================================================================
+
+/**
+ * Create a filter sized for n keys (at least one block) at false positive rate fpp. Rates below the curve's end
+ * (about 4.5e-6, 40 bits per key) are clamped to it. Fails with R_ERR_INVALID_ARGUMENT unless 0 < fpp < 1.
+ * The filter allocates from the allocator current at creation.
+ */
+[[nodiscard]]
+extern bloom * bloom_new(size_t n, double fpp);
+extern void bloom_free(bloom * b);
+extern void bloom_clear(bloom * b);
+
+// =====================================================================================================================
+// Keys
+// =====================================================================================================================
+
+extern void bloom_add_hash(bloom * b, hash128_t h);
+extern bool bloom_has_hash(const bloom * b, hash128_t h);
+
+#define bloom_add_bytes(b, data, len) bloom_add_hash((b), hash128((data), (len)))
+#define bloom_has_bytes(b, data, len) bloom_has_hash((b), hash128((data), (len)))
+
+[[maybe_unused]]
+static hash128_t R_(bloom_hash_bytes)(const void * key, const size_t size) {
+    return hash128(key, size);
+}
+
+[[maybe_unused]]
+static hash128_t R_(bloom_hash_str)(const void * key, const size_t size) {
+    (void)size;
+    const char * s;
+    memcpy(&s, key, sizeof(s));
+    return s != nullptr ? hash128(s, strlen(s)) : (hash128_t){0, 0};
+}
+
+/* R_BLOOM_HASH with optional hash function - same convention as R_MAP_HASH in map.h */
+#define R_BLOOM_HASH_DEFAULT(k)                                                                                        \
+    _Generic((k), char *: R_(bloom_hash_str), const char *: R_(bloom_hash_str), default: R_(bloom_hash_bytes))(        \
+        &(k),                                                                                                          \
+        sizeof(k)                                                                                                      \
+    )
+#define R_BLOOM_HASH_CUSTOM(k, hash) ((hash128_t)(hash)((k)))
+#define R_BLOOM_HASH_SELECT(_1, _2, N, ...) N
+#define R_BLOOM_HASH(...) R_BLOOM_HASH_SELECT(__VA_ARGS__, R_BLOOM_HASH_CUSTOM, R_BLOOM_HASH_DEFAULT)(__VA_ARGS__)
+
+#define bloom_add(b, key, ...)                                                                                         \
+    ({                                                                                                                 \
+        auto R_UNIQUE(_bla_key) = (key);                                                                               \
+        bloom_add_hash((b), R_BLOOM_HASH(R_UNIQUE(_bla_key) __VA_OPT__(, ) __VA_ARGS__));                              \
+    })
+
+#define bloom_has(b, key, ...)                                                                                         \
+    ({                                                                                                                 \
+        auto R_UNIQUE(_blh_key) = (key);                                                                               \
+        /* return */ bloom_has_hash((b), R_BLOOM_HASH(R_UNIQUE(_blh_key) __VA_OPT__(, ) __VA_ARGS__));                 \
+    })
+
+// =====================================================================================================================
+// Whole filters
+// =====================================================================================================================
+
+// false (R_ERR_INVALID_ARGUMENT) if the filters differ in size; dst may be src
+extern bool bloom_merge(bloom * dst, const bloom * src);
+extern size_t bloom_count(const bloom * b);
+extern size_t bloom_bytes(const bloom * b);
+extern double bloom_fpp(const bloom * b);
+
+/**
+ * The format is a 40-byte header (magic, version, byte order, hash seed, block count, key count) followed by the bit
+ * array. bloom_read rejects a filter from a build with another byte order or default hash seed (R_ERR_PARSE_FAILED).
+ */
+extern bool bloom_write(const bloom * b, FILE * stream);
+[[nodiscard]]
+extern bloom * bloom_read(FILE * stream);
+
+#endif // RUNE_BLOOM_H
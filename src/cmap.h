@@ -0,0 +1,604 @@
+/**
+ * Concurrent hash map: map.h tables split into shards, with seqlock-protected optimistic reads.
+ *
+ * Provides:
+ *   - A fixed power-of-two number of shards, each a plain MAP(K, V); the high bits of the key hash pick the shard
+ *     (map.h itself uses the low bits for the control byte and the home slot, so both stay well distributed)
+ *   - One sequence counter per shard that serves as the writers' spinlock and as the readers' seqlock: a reader
+ *     copies the shard's table header, probes it and copies the value out without writing shared memory, and
+ *     retries (at most R_CMAP_READ_RETRIES times, then it takes the shard lock) if a writer got in between
+ *   - Epoch-based reclamation of the tables a rehash replaces: they are freed once no reader that might still be
+ *     probing them remains, so a reader never touches freed memory
+ *   - Default and custom hashing per operation, as in map.h
+ *
+ * Quick Reference:
+ *
+ *   Concurrent Map API
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   cmap_init(m, shards)         Initialize with a number of shards (0: R_CMAP_SHARDS), false on allocation failure
+ *   cmap_free(m)                 Free the map (no other thread may use it)
+ *   cmap_put(m, k, v, ...)       Insert or overwrite, returns true if key was new (optional hash, eq)
+ *   cmap_get(m, k, out, ...)     Copy the value to *out (out may be nullptr), returns true if found (optional hash, eq)
+ *   cmap_contains(m, k, ...)     Check if key exists (optional hash, eq)
+ *   cmap_remove(m, k, ...)       Remove key, returns true if it existed (optional hash, eq)
+ *   cmap_size(m)                 Number of entries (a snapshot while writers run)
+ *   cmap_shards(m)               Number of shards
+ *
+ * Example:
+ *   #define K int
+ *   #define V double
+ *   #include "map.h"
+ *   #include "cmap.h"
+ *   #undef K
+ *   #undef V
+ *
+ *   CMAP(int, double) m;
+ *   cmap_init(&m, 0);
+ *   cmap_put(&m, 1, 0.5);           // any thread
+ *   double d;
+ *   if (cmap_get(&m, 1, &d)) ...    // any thread, usually without a lock
+ *   cmap_free(&m);
+ *
+ * Note: CMAP(K, V) wraps MAP(K, V), so map.h must be instantiated with the same K and V first. Values are returned
+ * by copy, never by pointer: the slot may be moved by the next write.
+ *
+ * The optimistic read probes a table that a writer may be changing in place. Both sides access the control bytes,
+ * keys and values of a published table with relaxed atomic byte loads and stores (so the race is between atomics,
+ * which is defined and which ThreadSanitizer accepts), and the reader throws its result away unless the sequence
+ * counter did not move, so a torn key or value is never returned - but a custom equality function must likewise not
+ * follow pointers inside keys. Keys of pointer-to-char type are compared by content, so reads on such maps always
+ * take the shard lock.
+ *
+ * Reads need a reader slot for the reclamation epochs (R_CMAP_READERS per map); a read that finds none free takes
+ * the shard lock instead. Writers to the same shard spin, so keep values small and writes short.
+ */
+
+// ReSharper disable once CppMissingIncludeGuard
+// ReSharper disable CppInconsistentNaming
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "r.h"
+
+// =====================================================================================================================
+// Concurrent Map
+// =====================================================================================================================
+
+// Generic implementation
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifndef RUNE_CMAP_API
+#define RUNE_CMAP_API
+
+// ---------------------------------------------------- Configuration --------------------------------------------------
+
+#ifdef RCFG__CMAP_SHARDS
+static constexpr size_t R_CMAP_SHARDS = RCFG__CMAP_SHARDS;
+#else
+// Shards used when cmap_init is given 0
+static constexpr size_t R_CMAP_SHARDS = 64;
+#endif // RCFG__CMAP_SHARDS
+
+#ifdef RCFG__CMAP_READERS
+static constexpr size_t R_CMAP_READERS = RCFG__CMAP_READERS;
+#else
+// Reader slots per map (a power of two): concurrent optimistic reads beyond this take the shard lock
+static constexpr size_t R_CMAP_READERS = 128;
+#endif // RCFG__CMAP_READERS
+
+#ifdef RCFG__CMAP_READ_RETRIES
+static constexpr size_t R_CMAP_READ_RETRIES = RCFG__CMAP_READ_RETRIES;
+#else
+// Optimistic attempts of a read before it takes the shard lock
+static constexpr size_t R_CMAP_READ_RETRIES = 8;
+#endif // RCFG__CMAP_READ_RETRIES
+
+static_assert((R_CMAP_READERS & (R_CMAP_READERS - 1)) == 0, "R_CMAP_READERS must be a power of two");
+
+// -------------------------------------------------- Internal helpers -------------------------------------------------
+
+#if defined(__x86_64__) || defined(__i386__)
+#define R_CMAP_PAUSE() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define R_CMAP_PAUSE() __asm__ volatile("yield")
+#else
+#define R_CMAP_PAUSE() ((void)0)
+#endif
+
+// A reader slot: 0 while idle, else 1 + the map epoch the reader saw when it started
+typedef struct {
+    R_Atomic(uint64_t) epoch;
+    char R_(cmap_pad0)[R_CACHE_LINE - sizeof(uint64_t)];
+} r_cmap_reader;
+
+// A table freed by a rehash, kept until no reader can still see it. The header sits in front of the table (see
+// cmap_mem_alloc), so retiring a table writes nothing a reader may still be probing
+typedef struct r_cmap_block {
+    struct r_cmap_block * next;
+    size_t size;    // of the whole block, header included
+    uint64_t epoch; // map epoch when it was retired
+} r_cmap_block;
+
+// Bytes in front of every table: the block header, rounded up so the table stays maximally aligned
+static constexpr size_t R_CMAP_BLOCK_HEAD =
+    (sizeof(r_cmap_block) + alignof(max_align_t) - 1) / alignof(max_align_t) * alignof(max_align_t);
+
+// Per-shard memory state, used as the context of the allocator that writers push around map operations
+typedef struct {
+    allocator parent;       // allocator of the map
+    r_cmap_block * pending; // tables freed by the write in progress
+    r_cmap_block * retired; // tables waiting for readers to move on
+} r_cmap_mem;
+
+[[maybe_unused]]
+static void * R_(cmap_mem_alloc)(void * ctx, const size_t size) {
+    const r_cmap_mem * mem = ctx;
+    char * block = mem->parent.alloc(mem->parent.ctx, R_CMAP_BLOCK_HEAD + size);
+    return block != nullptr ? block + R_CMAP_BLOCK_HEAD : nullptr;
+}
+
+[[maybe_unused]]
+static void R_(cmap_mem_retire)(void * ctx, void * ptr, const size_t size) {
+    r_cmap_mem * mem = ctx;
+    if (ptr == nullptr)
+        return;
+    r_cmap_block * b = (r_cmap_block *)((char *)ptr - R_CMAP_BLOCK_HEAD);
+    b->next = mem->pending;
+    b->size = R_CMAP_BLOCK_HEAD + size;
+    mem->pending = b;
+}
+
+[[maybe_unused]]
+static void * R_(cmap_mem_realloc)(void * ctx, void * ptr, const size_t old_size, const size_t new_size) {
+    void * p = R_(cmap_mem_alloc)(ctx, new_size);
+    if (p != nullptr && ptr != nullptr) {
+        memcpy(p, ptr, old_size < new_size ? old_size : new_size);
+        R_(cmap_mem_retire)(ctx, ptr, old_size);
+    }
+    return p;
+}
+
+#define R_CMAP_RETIRE(mem)                                                                                             \
+    ((allocator){                                                                                                      \
+        .alloc = R_(cmap_mem_alloc), .realloc = R_(cmap_mem_realloc), .free = R_(cmap_mem_retire), .ctx = (mem)        \
+    })
+
+[[maybe_unused]]
+static void R_(cmap_mem_release)(r_cmap_block * b) {
+    while (b != nullptr) {
+        r_cmap_block * next = b->next;
+        mem_free(b, b->size);
+        b = next;
+    }
+}
+
+/**
+ * Stamp the tables freed by the current write with the map epoch and advance it, then free every retired table
+ * older than the oldest active reader. A reader registers epoch e + 1 before it loads a table pointer, so a table
+ * stamped before e can no longer be reached by it.
+ */
+[[maybe_unused]]
+static void R_(cmap_reclaim)(r_cmap_mem * mem, r_cmap_reader * readers, R_Atomic(uint64_t) * epoch) {
+    if (mem->pending != nullptr) {
+        const uint64_t e = atomic_fetch_add(epoch, 1);
+        while (mem->pending != nullptr) {
+            r_cmap_block * b = mem->pending;
+            mem->pending = b->next;
+            b->epoch = e;
+            b->next = mem->retired;
+            mem->retired = b;
+        }
+    }
+    if (mem->retired == nullptr)
+        return;
+    uint64_t oldest = UINT64_MAX;
+    for (size_t i = 0; i < R_CMAP_READERS; i++) {
+        const uint64_t v = atomic_load(&readers[i].epoch);
+        if (v != 0 && v - 1 < oldest)
+            oldest = v - 1;
+    }
+    r_cmap_block ** link = &mem->retired;
+    alloc_push(mem->parent);
+    while (*link != nullptr) {
+        r_cmap_block * b = *link;
+        if (b->epoch < oldest) {
+            *link = b->next;
+            mem_free(b, b->size);
+        } else {
+            link = &b->next;
+        }
+    }
+    alloc_pop();
+}
+
+// Claim a reader slot (SIZE_MAX if all are taken); the seq_cst CAS orders it before the reader's table loads
+[[maybe_unused]]
+static size_t R_(cmap_enter)(r_cmap_reader * readers, R_Atomic(uint64_t) * epoch) {
+    static _Thread_local size_t hint = SIZE_MAX;
+    static R_Atomic(size_t) next = 0;
+    if (hint == SIZE_MAX)
+        hint = atomic_fetch_add_explicit(&next, 1, memory_order_relaxed) & (R_CMAP_READERS - 1);
+    const uint64_t e = atomic_load(epoch) + 1;
+    for (size_t n = 0, i = hint; n < R_CMAP_READERS; n++, i = (i + 1) & (R_CMAP_READERS - 1)) {
+        uint64_t idle = 0;
+        if (atomic_load_explicit(&readers[i].epoch, memory_order_relaxed) == 0 &&
+            atomic_compare_exchange_strong(&readers[i].epoch, &idle, e)) {
+            hint = i;
+            return i;
+        }
+    }
+    return SIZE_MAX;
+}
+
+[[maybe_unused]]
+static void R_(cmap_leave)(r_cmap_reader * readers, const size_t slot) {
+    atomic_store_explicit(&readers[slot].epoch, 0, memory_order_release);
+}
+
+// Make the counter odd; the fence keeps the writer's table stores after it (see the reader in cmap_get)
+[[maybe_unused]]
+static void R_(cmap_lock)(R_Atomic(uint64_t) * seq) {
+    uint64_t s = atomic_load_explicit(seq, memory_order_relaxed);
+    for (;;) {
+        if ((s & 1) == 0 &&
+            atomic_compare_exchange_weak_explicit(seq, &s, s + 1, memory_order_acquire, memory_order_relaxed)) {
+            break;
+        }
+        R_CMAP_PAUSE();
+        s = atomic_load_explicit(seq, memory_order_relaxed);
+    }
+    atomic_thread_fence(memory_order_release);
+}
+
+[[maybe_unused]]
+static void R_(cmap_unlock)(R_Atomic(uint64_t) * seq) {
+    atomic_fetch_add_explicit(seq, 1, memory_order_release);
+}
+
+// Relaxed atomic byte copies: the optimistic reader's loads from a published table and the writer's stores into it
+[[maybe_unused]]
+static void R_(cmap_load_bytes)(void * dst, const void * src, const size_t n) {
+    uint8_t * d = dst;
+    const uint8_t * s = src;
+    for (size_t i = 0; i < n; i++)
+        d[i] = __atomic_load_n(&s[i], __ATOMIC_RELAXED);
+}
+
+[[maybe_unused]]
+static void R_(cmap_store_bytes)(void * dst, const void * src, const size_t n) {
+    uint8_t * d = dst;
+    const uint8_t * s = src;
+    for (size_t i = 0; i < n; i++)
+        __atomic_store_n(&d[i], s[i], __ATOMIC_RELAXED);
+}
+
+// R_(map_set_ctrl) with relaxed atomic stores
+[[maybe_unused]]
+static void R_(cmap_set_ctrl)(uint8_t * ctrl, const size_t capacity, const size_t pos, const uint8_t value) {
+    __atomic_store_n(&ctrl[pos], value, __ATOMIC_RELAXED);
+    if (pos < R_MAP_GROUP_WIDTH)
+        __atomic_store_n(&ctrl[capacity + pos], value, __ATOMIC_RELAXED);
+}
+
+// Shard count for a requested n: the next power of two, R_CMAP_SHARDS for 0
+[[maybe_unused]]
+static size_t R_(cmap_shard_count)(const size_t n) {
+    size_t count = 1;
+    while (count < (n == 0 ? R_CMAP_SHARDS : n))
+        count <<= 1;
+    return count;
+}
+
+// Hash shift that leaves the top log2(count) bits (0 for one shard, whose mask is 0)
+[[maybe_unused]]
+static unsigned R_(cmap_shift)(size_t count) {
+    unsigned bits = 0;
+    while (count > 1) {
+        count >>= 1;
+        bits++;
+    }
+    return bits == 0 ? 0 : 64 - bits;
+}
+
+// Whether reads may probe optimistically: not for keys compared through the pointer (char * and const char *)
+#define R_CMAP_OPTIMISTIC(k) _Generic((k), char *: false, const char *: false, default: true)
+
+#define R_CMAP_SHARD_OF(m, hash) (&(m)->shards[((hash) >> (m)->shift) & (m)->mask])
+
+// Republish a shard's table after a write (under its lock): the release store of slots pairs with the readers'
+// acquire load, so the contents a rehash wrote into a new table with plain stores are visible to whoever reaches it
+#define R_CMAP_PUBLISH(s)                                                                                              \
+    ({                                                                                                                 \
+        atomic_store_explicit(&(s)->capacity, (s)->map.capacity, memory_order_relaxed);                                \
+        atomic_store_explicit(&(s)->slots, (s)->map.slots, memory_order_release);                                      \
+        atomic_store_explicit(&(s)->size, (s)->map.size, memory_order_relaxed);                                        \
+    })
+
+// R_MAP_FIND on a published table, reading control bytes and keys through R_(cmap_load_bytes)
+#define R_CMAP_FIND(slots, capacity, k, hash, ...)                                                                     \
+    ({                                                                                                                 \
+        size_t R_UNIQUE(_cfd_idx) = SIZE_MAX;                                                                          \
+        if ((capacity) > 0) {                                                                                          \
+            const uint8_t * R_UNIQUE(_cfd_ctrl) = (const uint8_t *)((slots) + (capacity));                             \
+            const size_t R_UNIQUE(_cfd_mask) = (capacity) - 1;                                                         \
+            const uint8_t R_UNIQUE(_cfd_h2) = R_MAP_H2((hash));                                                        \
+            size_t R_UNIQUE(_cfd_pos) = R_MAP_H1((hash)) & R_UNIQUE(_cfd_mask);                                        \
+            uint8_t R_UNIQUE(_cfd_group)[R_MAP_GROUP_WIDTH];                                                           \
+            for (size_t R_UNIQUE(_cfd_n) = 0; R_UNIQUE(_cfd_n) < (capacity); R_UNIQUE(_cfd_n) += R_MAP_GROUP_WIDTH) {  \
+                R_(cmap_load_bytes)(R_UNIQUE(_cfd_group), R_UNIQUE(_cfd_ctrl) + R_UNIQUE(_cfd_pos), R_MAP_GROUP_WIDTH);\
+                uint64_t R_UNIQUE(_cfd_match) = R_(map_group_match)(R_UNIQUE(_cfd_group), R_UNIQUE(_cfd_h2));          \
+                while (R_UNIQUE(_cfd_match) != 0) {                                                                    \
+                    const size_t R_UNIQUE(_cfd_slot) =                                                                 \
+                        (R_UNIQUE(_cfd_pos) + R_MAP_MASK_NEXT(R_UNIQUE(_cfd_match))) & R_UNIQUE(_cfd_mask);            \
+                    typeof(k) R_UNIQUE(_cfd_key);                                                                      \
+                    R_(cmap_load_bytes)(                                                                               \
+                        &R_UNIQUE(_cfd_key), &(slots)[R_UNIQUE(_cfd_slot)].key, sizeof(R_UNIQUE(_cfd_key))             \
+                    );                                                                                                 \
+                    if (R_MAP_EQ(R_UNIQUE(_cfd_key), (k) __VA_OPT__(, ) __VA_ARGS__)) {                                \
+                        R_UNIQUE(_cfd_idx) = R_UNIQUE(_cfd_slot);                                                      \
+                        break;                                                                                         \
+                    }                                                                                                  \
+                    R_UNIQUE(_cfd_match) &= R_UNIQUE(_cfd_match) - 1;                                                  \
+                }                                                                                                      \
+                if (R_UNIQUE(_cfd_idx) != SIZE_MAX || R_(map_group_match_empty)(R_UNIQUE(_cfd_group)) != 0) {          \
+                    break;                                                                                             \
+                }                                                                                                      \
+                R_UNIQUE(_cfd_pos) = (R_UNIQUE(_cfd_pos) + R_MAP_GROUP_WIDTH) & R_UNIQUE(_cfd_mask);                   \
+            }                                                                                                          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_cfd_idx);                                                                               \
+    })
+
+// --------------------------------------------------- Public macros ---------------------------------------------------
+
+#define CMAP(key_t, val_t) R_GLUE(cmap_, R_JOIN(key_t, val_t, _))
+#define CMAP_SHARD(key_t, val_t) R_GLUE(CMAP(key_t, val_t), _shard)
+
+#define cmap_shards(m) ((m)->mask + 1)
+
+#define cmap_init(m, n)                                                                                                \
+    ({                                                                                                                 \
+        typeof(m) R_UNIQUE(_cin_m) = (m);                                                                              \
+        const size_t R_UNIQUE(_cin_n) = R_(cmap_shard_count)((n));                                                     \
+        R_UNIQUE(_cin_m)->alloc = alloc_current();                                                                     \
+        R_UNIQUE(_cin_m)->shards = mem_alloc(R_UNIQUE(_cin_n) * sizeof(*R_UNIQUE(_cin_m)->shards));                    \
+        R_UNIQUE(_cin_m)->readers = mem_alloc(R_CMAP_READERS * sizeof(r_cmap_reader));                                 \
+        const bool R_UNIQUE(_cin_ok) = R_UNIQUE(_cin_m)->shards != nullptr && R_UNIQUE(_cin_m)->readers != nullptr;    \
+        if (R_UNIQUE(_cin_ok)) {                                                                                       \
+            for (size_t R_UNIQUE(_cin_i) = 0; R_UNIQUE(_cin_i) < R_UNIQUE(_cin_n); R_UNIQUE(_cin_i)++) {               \
+                typeof(R_UNIQUE(_cin_m)->shards) R_UNIQUE(_cin_s) = &R_UNIQUE(_cin_m)->shards[R_UNIQUE(_cin_i)];       \
+                memset(R_UNIQUE(_cin_s), 0, sizeof(*R_UNIQUE(_cin_s)));                                                \
+                atomic_init(&R_UNIQUE(_cin_s)->seq, 0);                                                                \
+                atomic_init(&R_UNIQUE(_cin_s)->slots, nullptr);                                                        \
+                atomic_init(&R_UNIQUE(_cin_s)->capacity, 0);                                                           \
+                atomic_init(&R_UNIQUE(_cin_s)->size, 0);                                                               \
+                R_UNIQUE(_cin_s)->mem.parent = R_UNIQUE(_cin_m)->alloc;                                                \
+            }                                                                                                          \
+            for (size_t R_UNIQUE(_cin_i) = 0; R_UNIQUE(_cin_i) < R_CMAP_READERS; R_UNIQUE(_cin_i)++) {                 \
+                atomic_init(&R_UNIQUE(_cin_m)->readers[R_UNIQUE(_cin_i)].epoch, 0);                                    \
+            }                                                                                                          \
+            R_UNIQUE(_cin_m)->mask = R_UNIQUE(_cin_n) - 1;                                                             \
+            R_UNIQUE(_cin_m)->shift = R_(cmap_shift)(R_UNIQUE(_cin_n));                                                \
+            atomic_init(&R_UNIQUE(_cin_m)->epoch, 0);                                                                  \
+        } else {                                                                                                       \
+            if (R_UNIQUE(_cin_m)->shards != nullptr) {                                                                 \
+                mem_free(R_UNIQUE(_cin_m)->shards, R_UNIQUE(_cin_n) * sizeof(*R_UNIQUE(_cin_m)->shards));              \
+            }                                                                                                          \
+            if (R_UNIQUE(_cin_m)->readers != nullptr) {                                                                \
+                mem_free(R_UNIQUE(_cin_m)->readers, R_CMAP_READERS * sizeof(r_cmap_reader));                           \
+            }                                                                                                          \
+            R_UNIQUE(_cin_m)->shards = nullptr;                                                                        \
+            R_UNIQUE(_cin_m)->readers = nullptr;                                                                       \
+            err_set(R_ERR_ALLOC_FAILED, nullptr);                                                                      \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_cin_ok);                                                                                \
+    })
+
+#define cmap_free(m)                                                                                                   \
+    ({                                                                                                                 \
+        typeof(m) R_UNIQUE(_cfr_m) = (m);                                                                              \
+        if (R_UNIQUE(_cfr_m) != nullptr && R_UNIQUE(_cfr_m)->shards != nullptr) {                                      \
+            alloc_push(R_UNIQUE(_cfr_m)->alloc);                                                                       \
+            for (size_t R_UNIQUE(_cfr_i) = 0; R_UNIQUE(_cfr_i) <= R_UNIQUE(_cfr_m)->mask; R_UNIQUE(_cfr_i)++) {        \
+                typeof(R_UNIQUE(_cfr_m)->shards) R_UNIQUE(_cfr_s) = &R_UNIQUE(_cfr_m)->shards[R_UNIQUE(_cfr_i)];       \
+                alloc_push(R_CMAP_RETIRE(&R_UNIQUE(_cfr_s)->mem));                                                     \
+                map_free(&R_UNIQUE(_cfr_s)->map);                                                                      \
+                alloc_pop();                                                                                           \
+                R_(cmap_mem_release)(R_UNIQUE(_cfr_s)->mem.pending);                                                   \
+                R_(cmap_mem_release)(R_UNIQUE(_cfr_s)->mem.retired);                                                   \
+            }                                                                                                          \
+            mem_free(R_UNIQUE(_cfr_m)->shards, cmap_shards(R_UNIQUE(_cfr_m)) * sizeof(*R_UNIQUE(_cfr_m)->shards));     \
+            mem_free(R_UNIQUE(_cfr_m)->readers, R_CMAP_READERS * sizeof(r_cmap_reader));                               \
+            alloc_pop();                                                                                               \
+            R_UNIQUE(_cfr_m)->shards = nullptr;                                                                        \
+            R_UNIQUE(_cfr_m)->readers = nullptr;                                                                       \
+            R_UNIQUE(_cfr_m)->mask = 0;                                                                                \
+        }                                                                                                              \
+    })
+
+#define cmap_size(m)                                                                                                   \
+    ({                                                                                                                 \
+        typeof(m) R_UNIQUE(_csz_m) = (m);                                                                              \
+        size_t R_UNIQUE(_csz_n) = 0;                                                                                   \
+        for (size_t R_UNIQUE(_csz_i) = 0; R_UNIQUE(_csz_i) <= R_UNIQUE(_csz_m)->mask; R_UNIQUE(_csz_i)++) {            \
+            R_UNIQUE(_csz_n) +=                                                                                        \
+                atomic_load_explicit(&R_UNIQUE(_csz_m)->shards[R_UNIQUE(_csz_i)].size, memory_order_relaxed);          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_csz_n);                                                                                 \
+    })
+
+/**
+ * Writers lock the key's shard and change its map like the map.h operation, with the shard's retiring allocator
+ * pushed, so the table a rehash replaces goes to the shard's pending list instead of being freed under a reader.
+ * Stores into the published table go through R_(cmap_store_bytes) and R_(cmap_set_ctrl); the table is republished
+ * before the lock is released.
+ */
+#define cmap_put(m, k, v, ...)                                                                                         \
+    ({                                                                                                                 \
+        typeof(m) R_UNIQUE(_cpt_m) = (m);                                                                              \
+        map_key_type(&R_UNIQUE(_cpt_m)->shards->map) R_UNIQUE(_cpt_key) = (k);                                         \
+        typeof(R_UNIQUE(_cpt_m)->shards->map.slots->val) R_UNIQUE(_cpt_val) = (v);                                     \
+        const uint64_t R_UNIQUE(_cpt_hash) = R_MAP_HASH(R_UNIQUE(_cpt_key) __VA_OPT__(, ) __VA_ARGS__);                \
+        typeof(R_UNIQUE(_cpt_m)->shards) R_UNIQUE(_cpt_s) = R_CMAP_SHARD_OF(R_UNIQUE(_cpt_m), R_UNIQUE(_cpt_hash));    \
+        typeof(&R_UNIQUE(_cpt_s)->map) R_UNIQUE(_cpt_map) = &R_UNIQUE(_cpt_s)->map;                                    \
+        R_(cmap_lock)(&R_UNIQUE(_cpt_s)->seq);                                                                         \
+        alloc_push(R_CMAP_RETIRE(&R_UNIQUE(_cpt_s)->mem));                                                             \
+        size_t R_UNIQUE(_cpt_idx) =                                                                                    \
+            R_MAP_FIND(R_UNIQUE(_cpt_map), R_UNIQUE(_cpt_key), R_UNIQUE(_cpt_hash) __VA_OPT__(, ) __VA_ARGS__);        \
+        bool R_UNIQUE(_cpt_new) = R_UNIQUE(_cpt_idx) == SIZE_MAX;                                                      \
+        if (R_UNIQUE(_cpt_new)) {                                                                                      \
+            R_MAP_MAKE_ROOM(R_UNIQUE(_cpt_map)__VA_OPT__(, ) __VA_ARGS__);                                             \
+            if (R_UNIQUE(_cpt_map)->ctrl == nullptr) {                                                                 \
+                /* no first table: the rehash failed with R_ERR_ALLOC_FAILED */                                        \
+                R_UNIQUE(_cpt_new) = false;                                                                            \
+            } else {                                                                                                   \
+                R_UNIQUE(_cpt_idx) =                                                                                   \
+                    R_(map_find_free)(R_UNIQUE(_cpt_map)->ctrl, R_UNIQUE(_cpt_map)->capacity, R_UNIQUE(_cpt_hash));    \
+                if (R_UNIQUE(_cpt_map)->ctrl[R_UNIQUE(_cpt_idx)] == R_MAP_DELETED) {                                   \
+                    R_UNIQUE(_cpt_map)->tombstones--;                                                                  \
+                }                                                                                                      \
+                R_(cmap_store_bytes)(                                                                                  \
+                    &R_UNIQUE(_cpt_map)->slots[R_UNIQUE(_cpt_idx)].key, &R_UNIQUE(_cpt_key), sizeof(R_UNIQUE(_cpt_key))\
+                );                                                                                                     \
+                R_(cmap_set_ctrl)(                                                                                     \
+                    R_UNIQUE(_cpt_map)->ctrl,                                                                          \
+                    R_UNIQUE(_cpt_map)->capacity,                                                                      \
+                    R_UNIQUE(_cpt_idx),                                                                                \
+                    R_MAP_H2(R_UNIQUE(_cpt_hash))                                                                      \
+                );                                                                                                     \
+                R_UNIQUE(_cpt_map)->size++;                                                                            \
+            }                                                                                                          \
+        }                                                                                                              \
+        if (R_UNIQUE(_cpt_idx) != SIZE_MAX) {                                                                          \
+            R_(cmap_store_bytes)(                                                                                      \
+                &R_UNIQUE(_cpt_map)->slots[R_UNIQUE(_cpt_idx)].val, &R_UNIQUE(_cpt_val), sizeof(R_UNIQUE(_cpt_val))    \
+            );                                                                                                         \
+        }                                                                                                              \
+        alloc_pop();                                                                                                   \
+        R_CMAP_PUBLISH(R_UNIQUE(_cpt_s));                                                                              \
+        R_(cmap_reclaim)(&R_UNIQUE(_cpt_s)->mem, R_UNIQUE(_cpt_m)->readers, &R_UNIQUE(_cpt_m)->epoch);                 \
+        R_(cmap_unlock)(&R_UNIQUE(_cpt_s)->seq);                                                                       \
+        /* return */ R_UNIQUE(_cpt_new);                                                                               \
+    })
+
+#define cmap_remove(m, k, ...)                                                                                         \
+    ({                                                                                                                 \
+        typeof(m) R_UNIQUE(_crm_m) = (m);                                                                              \
+        map_key_type(&R_UNIQUE(_crm_m)->shards->map) R_UNIQUE(_crm_key) = (k);                                         \
+        const uint64_t R_UNIQUE(_crm_hash) = R_MAP_HASH(R_UNIQUE(_crm_key) __VA_OPT__(, ) __VA_ARGS__);                \
+        typeof(R_UNIQUE(_crm_m)->shards) R_UNIQUE(_crm_s) = R_CMAP_SHARD_OF(R_UNIQUE(_crm_m), R_UNIQUE(_crm_hash));    \
+        R_(cmap_lock)(&R_UNIQUE(_crm_s)->seq);                                                                         \
+        const size_t R_UNIQUE(_crm_idx) =                                                                              \
+            R_MAP_FIND(&R_UNIQUE(_crm_s)->map, R_UNIQUE(_crm_key), R_UNIQUE(_crm_hash) __VA_OPT__(, ) __VA_ARGS__);    \
+        if (R_UNIQUE(_crm_idx) != SIZE_MAX) {                                                                          \
+            R_MAP_ERASE_WITH(&R_UNIQUE(_crm_s)->map, R_UNIQUE(_crm_idx), R_(cmap_set_ctrl));                           \
+        }                                                                                                              \
+        R_CMAP_PUBLISH(R_UNIQUE(_crm_s));                                                                              \
+        R_(cmap_reclaim)(&R_UNIQUE(_crm_s)->mem, R_UNIQUE(_crm_m)->readers, &R_UNIQUE(_crm_m)->epoch);                 \
+        R_(cmap_unlock)(&R_UNIQUE(_crm_s)->seq);                                                                       \
+        /* return */ R_UNIQUE(_crm_idx) != SIZE_MAX;                                                                   \
+    })
+
+/**
+ * The optimistic read: with an even counter s, load the published table, check s again (slots and capacity are
+ * consistent and the table is protected by the reader slot), probe and copy the value with atomic loads, and accept
+ * the result only if the counter is still s. After R_CMAP_READ_RETRIES failed attempts, or without a free reader
+ * slot, the read locks the shard.
+ */
+#define cmap_get(m, k, out, ...)                                                                                       \
+    ({                                                                                                                 \
+        typeof(m) R_UNIQUE(_cgt_m) = (m);                                                                              \
+        map_key_type(&R_UNIQUE(_cgt_m)->shards->map) R_UNIQUE(_cgt_key) = (k);                                         \
+        typeof(R_UNIQUE(_cgt_m)->shards->map.slots->val) * R_UNIQUE(_cgt_out) = (out);                                 \
+        const uint64_t R_UNIQUE(_cgt_hash) = R_MAP_HASH(R_UNIQUE(_cgt_key) __VA_OPT__(, ) __VA_ARGS__);                \
+        typeof(R_UNIQUE(_cgt_m)->shards) R_UNIQUE(_cgt_s) = R_CMAP_SHARD_OF(R_UNIQUE(_cgt_m), R_UNIQUE(_cgt_hash));    \
+        bool R_UNIQUE(_cgt_found) = false;                                                                             \
+        bool R_UNIQUE(_cgt_done) = false;                                                                              \
+        const size_t R_UNIQUE(_cgt_slot) = R_CMAP_OPTIMISTIC(R_UNIQUE(_cgt_key))                                       \
+                                               ? R_(cmap_enter)(R_UNIQUE(_cgt_m)->readers, &R_UNIQUE(_cgt_m)->epoch)   \
+                                               : SIZE_MAX;                                                             \
+        if (R_UNIQUE(_cgt_slot) != SIZE_MAX) {                                                                         \
+            for (size_t R_UNIQUE(_cgt_try) = 0; R_UNIQUE(_cgt_try) < R_CMAP_READ_RETRIES && !R_UNIQUE(_cgt_done);      \
+                 R_UNIQUE(_cgt_try)++) {                                                                               \
+                const uint64_t R_UNIQUE(_cgt_seq) = atomic_load_explicit(&R_UNIQUE(_cgt_s)->seq, memory_order_acquire);\
+                if ((R_UNIQUE(_cgt_seq) & 1) != 0) {                                                                   \
+                    R_CMAP_PAUSE();                                                                                    \
+                    continue;                                                                                          \
+                }                                                                                                      \
+                typeof(R_UNIQUE(_cgt_s)->map.slots) R_UNIQUE(_cgt_slots) =                                             \
+                    atomic_load_explicit(&R_UNIQUE(_cgt_s)->slots, memory_order_acquire);                              \
+                const size_t R_UNIQUE(_cgt_cap) =                                                                      \
+                    atomic_load_explicit(&R_UNIQUE(_cgt_s)->capacity, memory_order_relaxed);                           \
+                atomic_thread_fence(memory_order_acquire);                                                             \
+                if (atomic_load_explicit(&R_UNIQUE(_cgt_s)->seq, memory_order_relaxed) != R_UNIQUE(_cgt_seq)) {        \
+                    continue;                                                                                          \
+                }                                                                                                      \
+                const size_t R_UNIQUE(_cgt_idx) = R_CMAP_FIND(                                                         \
+                    R_UNIQUE(_cgt_slots), R_UNIQUE(_cgt_cap), R_UNIQUE(_cgt_key), R_UNIQUE(_cgt_hash)                  \
+                    __VA_OPT__(, ) __VA_ARGS__                                                                         \
+                );                                                                                                     \
+                typeof(*R_UNIQUE(_cgt_out)) R_UNIQUE(_cgt_val);                                                        \
+                if (R_UNIQUE(_cgt_idx) != SIZE_MAX) {                                                                  \
+                    R_(cmap_load_bytes)(                                                                               \
+                        &R_UNIQUE(_cgt_val), &R_UNIQUE(_cgt_slots)[R_UNIQUE(_cgt_idx)].val, sizeof(R_UNIQUE(_cgt_val)) \
+                    );                                                                                                 \
+                }                                                                                                      \
+                atomic_thread_fence(memory_order_acquire);                                                             \
+                if (atomic_load_explicit(&R_UNIQUE(_cgt_s)->seq, memory_order_relaxed) == R_UNIQUE(_cgt_seq)) {        \
+                    R_UNIQUE(_cgt_done) = true;                                                                        \
+                    R_UNIQUE(_cgt_found) = R_UNIQUE(_cgt_idx) != SIZE_MAX;                                             \
+                    if (R_UNIQUE(_cgt_found) && R_UNIQUE(_cgt_out) != nullptr) {                                       \
+                        *R_UNIQUE(_cgt_out) = R_UNIQUE(_cgt_val);                                                      \
+                    }                                                                                                  \
+                }                                                                                                      \
+            }                                                                                                          \
+            R_(cmap_leave)(R_UNIQUE(_cgt_m)->readers, R_UNIQUE(_cgt_slot));                                            \
+        }                                                                                                              \
+        if (!R_UNIQUE(_cgt_done)) {                                                                                    \
+            R_(cmap_lock)(&R_UNIQUE(_cgt_s)->seq);                                                                     \
+            const typeof(*R_UNIQUE(_cgt_out)) * R_UNIQUE(_cgt_ptr) =                                                   \
+                map_get(&R_UNIQUE(_cgt_s)->map, R_UNIQUE(_cgt_key) __VA_OPT__(, ) __VA_ARGS__);                        \
+            R_UNIQUE(_cgt_found) = R_UNIQUE(_cgt_ptr) != nullptr;                                                      \
+            if (R_UNIQUE(_cgt_found) && R_UNIQUE(_cgt_out) != nullptr) {                                               \
+                *R_UNIQUE(_cgt_out) = *R_UNIQUE(_cgt_ptr);                                                             \
+            }                                                                                                          \
+            R_(cmap_unlock)(&R_UNIQUE(_cgt_s)->seq);                                                                   \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_cgt_found);                                                                             \
+    })
+
+#define cmap_contains(m, k, ...)                                                                                       \
+    cmap_get((m), (k), (typeof((m)->shards->map.slots->val) *)nullptr __VA_OPT__(, ) __VA_ARGS__)
+
+#endif // RUNE_CMAP_API
+
+// Type definition
+// ---------------------------------------------------------------------------------------------------------------------
+
+#if defined(K) && defined(V)
+
+// The padding rounds a shard up to whole cache lines, so writers to neighbouring shards don't false-share
+typedef struct {
+    R_Atomic(uint64_t) seq;                 // odd while a writer holds the shard
+    R_Atomic(MAP_ENTRY(K, V) *) slots;      // the table readers probe, republished by every write (R_CMAP_PUBLISH)
+    R_Atomic(size_t) capacity;              // of that table
+    R_Atomic(size_t) size;                  // entries, for cmap_size
+    MAP(K, V) map;                          // written by map.h with plain stores, so only read under the lock
+    r_cmap_mem mem;
+    char R_(cmap_pad1)[R_CACHE_LINE - (sizeof(uint64_t) + sizeof(void *) + 2 * sizeof(size_t) + sizeof(MAP(K, V)) +
+                                       sizeof(r_cmap_mem)) %
+                                          R_CACHE_LINE];
+} CMAP_SHARD(K, V);
+
+typedef struct {
+    CMAP_SHARD(K, V) * shards;
+    size_t mask;               // shard count - 1
+    unsigned shift;            // the shard index is (hash >> shift) & mask
+    r_cmap_reader * readers;   // R_CMAP_READERS slots
+    R_Atomic(uint64_t) epoch;  // advanced whenever a write retires a table
+    allocator alloc;           // allocator current at cmap_init
+} CMAP(K, V);
+
+#endif // K && V
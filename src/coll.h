@@ -1,9 +1,12 @@
 /**
- * Generic collections: dynamic array and lock-free queue.
+ * Generic collections: dynamic array and lock-free queues.
  *
  * Provides:
  *   - Dynamically-sized list with grow/shrink semantics
- *   - Lock-free bounded queue for concurrent access
+ *   - In-place introsort with an inlined comparator, and a parallel merge sort on a task pool (task.h)
+ *   - Lock-free bounded single-producer / single-consumer queue (LFQ) with acquire/release ordering
+ *   - Unbounded single-producer / single-consumer queue (SEGQ) that grows by linking larger rings, without copying
+ *   - Lock-free bounded multi-producer / multi-consumer queue (MPMC) with per-slot sequence numbers
  *   - Generic type support via macro-based template expansion
  *   - Sentinel type checking via #define guard macros
  *
@@ -20,14 +23,23 @@
  *      idx,
  *      item
  *   )                        Insert item at index
+ *   list_add_n(lst, p, n)    Append n items copied from array p (single grow, single memcpy)
+ *   list_extend(dst, src)    Append all items of another list
  *   list_remove(lst, idx)    Remove item at index
+ *   list_reserve(lst, n)     Ensure capacity for n items in total (single allocation)
  *   list_grow(lst)           Ensure capacity for next item
  *   list_shrink(lst)         Reduce capacity if sparse
  *   list_resize(lst, cap)    Set exact capacity
+ *   list_sort(lst, ...)      Sort in place (optional comparator, int cmp(T a, T b) as for R_BST_CMP)
+ *   list_par_sort(
+ *      type,
+ *      lst,
+ *      pool
+ *   )                        Sort on a task pool (type instantiated with T_CMP), false if it could not run
  *
- *   Lock-Free Queue API
+ *   Lock-Free Queue API (one producer thread, one consumer thread)
  *   -------------------------------------------------------------------------------------------------------------------
- *   lfq(type, cap, ...)      Create queue with initial values
+ *   lfq(type, cap, ...)      Create queue with initial values (power-of-two cap wraps with a mask)
  *   lfq_free(q)              Free queue memory
  *   lfq_capacity(q)          Get max capacity
  *   lfq_depth(q)             Get number of items in queue
@@ -36,8 +48,28 @@
  *   lfq_peek(q)              Get front item without removing
  *   lfq_push(q, item)        Add item to back
  *   lfq_pop(q)               Remove and return front item
+ *   lfq_push_n(q, items, n)  Add up to n items from an array, returns count pushed
+ *   lfq_pop_n(q, out, n)     Remove up to n items into an array, returns count popped
  *   lfq_clear(q)             Remove all items
  *
+ *   Segmented Queue API (one producer thread, one consumer thread, grows without bound)
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   segq(type, cap, ...)     Create queue with initial values (first ring rounded up to a power of two)
+ *   segq_free(q)             Free every ring
+ *   segq_empty(q)            Check if queue is empty (consumer side)
+ *   segq_push(q, item)       Add item to back, linking a larger ring when full; false if that allocation failed
+ *   segq_pop(q)              Remove and return front item, freeing rings the consumer has left
+ *
+ *   MPMC Queue API (any number of producer and consumer threads)
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   mpmc(type, cap, ...)     Create queue (capacity rounded up to a power of two) with initial values
+ *   mpmc_free(q)             Free queue memory
+ *   mpmc_capacity(q)         Get max capacity
+ *   mpmc_depth(q)            Get number of items in queue (snapshot)
+ *   mpmc_empty(q)            Check if queue is empty (snapshot)
+ *   mpmc_push(q, item)       Add item to back (any thread)
+ *   mpmc_pop(q)              Remove and return front item (any thread)
+ *
  * Example:
  *   // List usage
  *   typedef struct { int x; } Point;
@@ -45,20 +77,45 @@
  *   list_add(&lst, (Point){1, 2});
  *   list_add(&lst, (Point){3, 4});
  *   Point p = list_get(&lst, 0);  // {1, 2}
+ *   list_sort(&lst, point_cmp);   // int point_cmp(Point a, Point b)
  *   list_free(&lst);
  *
+ *   // Parallel sort: T_CMP picks the comparator compiled into list_par_sort for this type
+ *   #define T u64
+ *   #define T_CMP u64_cmp
+ *   #include "coll.h"
+ *   #undef T_CMP
+ *   #undef T
+ *   list_par_sort(u64, &ids, pool);
+ *
  *   // Lock-free queue usage
  *   LFQ(int) q = lfq(int, 10);
  *   lfq_push(&q, 42);
  *   int val = lfq_pop(&q);
  *   lfq_free(&q);
  *
- * Note: List and LFQ require complete type definitions. For red-black trees, see tree.h.
+ *   // Bursty producer: no capacity to pick, no full queue to handle
+ *   SEGQ(int) events = segq(int, 256);
+ *   segq_push(&events, 42);
+ *   int ev = segq_pop(&events);
+ *   segq_free(&events);
+ *
+ *   // Shared between worker threads
+ *   MPMC(int) jobs = mpmc(int, 1024);
+ *   mpmc_push(&jobs, 7);          // from any producer
+ *   int job = mpmc_pop(&jobs);    // from any consumer
+ *   mpmc_free(&jobs);
+ *
+ * Note: List, LFQ, SEGQ and MPMC require complete type definitions. For red-black trees, see tree.h; for hash maps,
+ * see map.h.
+ * list_sort expands at the call site and works on any list; list_par_sort runs its work in pool tasks, so its
+ * functions are generated once per element type, only when T_CMP is defined (which also includes task.h).
  */
 
 // ReSharper disable once CppMissingIncludeGuard
 // ReSharper disable CppInconsistentNaming
 #include <stdatomic.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -77,6 +134,46 @@
 #ifndef RUNE_LIST_API
 #define RUNE_LIST_API
 
+#ifdef RCFG__LIST_MIN_CAPACITY
+static constexpr size_t R_LIST_MIN_CAPACITY = RCFG__LIST_MIN_CAPACITY;
+#else  // Capacity of the first allocation; list_shrink never goes below it
+static constexpr size_t R_LIST_MIN_CAPACITY = 4;
+#endif // RCFG__LIST_MIN_CAPACITY
+
+#ifdef RCFG__LIST_GROWTH
+static constexpr size_t R_LIST_GROWTH = RCFG__LIST_GROWTH;
+#else  // Capacity after a grow, in percent of the old capacity (200 doubles, 150 grows by half)
+static constexpr size_t R_LIST_GROWTH = 200;
+#endif // RCFG__LIST_GROWTH
+
+#ifdef RCFG__LIST_NO_AUTO_SHRINK
+static constexpr bool R_LIST_AUTO_SHRINK = false;
+#else  // list_remove calls list_shrink; define RCFG__LIST_NO_AUTO_SHRINK to keep capacity until list_shrink/free
+static constexpr bool R_LIST_AUTO_SHRINK = true;
+#endif // RCFG__LIST_NO_AUTO_SHRINK
+
+#ifdef RCFG__LIST_SORT_INSERTION
+static constexpr size_t R_LIST_SORT_INSERTION = RCFG__LIST_SORT_INSERTION;
+#else  // list_sort finishes ranges of at most this many elements with insertion sort
+static constexpr size_t R_LIST_SORT_INSERTION = 16;
+#endif // RCFG__LIST_SORT_INSERTION
+
+#ifdef RCFG__LIST_PAR_SORT_MIN
+static constexpr size_t R_LIST_PAR_SORT_MIN = RCFG__LIST_PAR_SORT_MIN;
+#else  // list_par_sort sorts shorter lists on the calling thread
+static constexpr size_t R_LIST_PAR_SORT_MIN = 1 << 14;
+#endif // RCFG__LIST_PAR_SORT_MIN
+
+// Smallest capacity reached by growing cap by R_LIST_GROWTH (at least one slot per step) that holds needed elements
+static inline size_t R_(list_grown_capacity)(size_t cap, const size_t needed) {
+    cap = cap < R_LIST_MIN_CAPACITY ? R_LIST_MIN_CAPACITY : cap;
+    while (cap < needed) {
+        const size_t grown = cap / 100 * R_LIST_GROWTH + cap % 100 * R_LIST_GROWTH / 100;
+        cap = grown > cap ? grown : cap + 1;
+    }
+    return cap;
+}
+
 #define LIST(type) R_GLUE(list_, type)
 #define R_LIST_OF(type) R_GLUE(LIST(type), _of)
 
@@ -96,43 +193,91 @@
 
 #define list_get(lst, idx) ((lst)->data[(idx)])
 
+/**
+ * Set the capacity to exactly new_capacity elements (the first allocation goes through mem_alloc). Elements past the
+ * new capacity are dropped: shrinking below size is the caller's responsibility.
+ */
 #define list_resize(lst, new_capacity)                                                                                 \
     ({                                                                                                                 \
-        void * data =                                                                                                  \
-            mem_realloc((lst)->data, (lst)->capacity * list_type_size(lst), (new_capacity) * list_type_size(lst));     \
-        (lst)->capacity = new_capacity;                                                                                \
-        (lst)->data = data;                                                                                            \
+        const size_t R_UNIQUE(_rs_cap) = (new_capacity);                                                               \
+        const size_t R_UNIQUE(_rs_new) = R_UNIQUE(_rs_cap) * list_type_size(lst);                                      \
+        void * R_UNIQUE(_rs_data) = nullptr;                                                                           \
+        if ((lst)->data == nullptr) {                                                                                  \
+            R_UNIQUE(_rs_data) = mem_alloc(R_UNIQUE(_rs_new));                                                         \
+        } else {                                                                                                       \
+            R_UNIQUE(_rs_data) = mem_realloc((lst)->data, (lst)->capacity * list_type_size(lst), R_UNIQUE(_rs_new));   \
+        }                                                                                                              \
+        (lst)->capacity = R_UNIQUE(_rs_cap);                                                                           \
+        (lst)->data = R_UNIQUE(_rs_data);                                                                              \
     })
 
-#define list_grow(lst)                                                                                                 \
+// Make room for at least n elements in total with a single allocation; never shrinks
+#define list_reserve(lst, n)                                                                                           \
     ({                                                                                                                 \
-        if ((lst)->capacity == 0) {                                                                                    \
-            (lst)->capacity = 4;                                                                                       \
-            (lst)->data = mem_alloc_zero((lst)->capacity * list_type_size(lst));                                       \
+        const size_t R_UNIQUE(_rv_n) = (n);                                                                            \
+        if (R_UNIQUE(_rv_n) > (lst)->capacity) {                                                                       \
+            list_resize((lst), R_UNIQUE(_rv_n));                                                                       \
         }                                                                                                              \
-        while ((lst)->size >= (lst)->capacity) {                                                                       \
-            list_resize((lst), (lst)->capacity << 1);                                                                  \
+    })
+
+// Make room for the next item, growing by R_LIST_GROWTH (first allocation: R_LIST_MIN_CAPACITY)
+#define list_grow(lst)                                                                                                 \
+    ({                                                                                                                 \
+        if ((lst)->size >= (lst)->capacity) {                                                                          \
+            list_resize((lst), R_(list_grown_capacity)((lst)->capacity, (lst)->size + 1));                             \
         }                                                                                                              \
     })
 
+/**
+ * Halve the capacity (in one reallocation) while fewer than a quarter of the slots are used, but not below
+ * R_LIST_MIN_CAPACITY. Growth happens at full and shrinking at a quarter, so alternating adds and removes around
+ * either point do not reallocate every time.
+ */
 #define list_shrink(lst)                                                                                               \
     ({                                                                                                                 \
-        while ((lst)->size < (lst)->capacity >> 2) {                                                                   \
-            list_resize((lst), (lst)->capacity >> 1);                                                                  \
+        size_t R_UNIQUE(_sh_cap) = (lst)->capacity;                                                                    \
+        while ((lst)->size < R_UNIQUE(_sh_cap) >> 2 && R_UNIQUE(_sh_cap) >> 1 >= R_LIST_MIN_CAPACITY) {                \
+            R_UNIQUE(_sh_cap) >>= 1;                                                                                   \
+        }                                                                                                              \
+        if (R_UNIQUE(_sh_cap) != (lst)->capacity) {                                                                    \
+            list_resize((lst), R_UNIQUE(_sh_cap));                                                                     \
         }                                                                                                              \
     })
 
 #define list_add(lst, item)                                                                                            \
     ({                                                                                                                 \
-        const size_t idx = (lst)->size;                                                                                \
-        (lst)->size++;                                                                                                 \
         list_grow((lst));                                                                                              \
-        (lst)->data[idx] = (item);                                                                                     \
+        (lst)->data[(lst)->size++] = (item);                                                                           \
+    })
+
+/**
+ * Append n elements copied from items with one capacity check and one memcpy. items may point into the list itself
+ * (e.g. to duplicate its contents): the source is rebased if the buffer moves.
+ */
+#define list_add_n(lst, items, n)                                                                                      \
+    ({                                                                                                                 \
+        const size_t R_UNIQUE(_an_n) = (n);                                                                            \
+        const typeof_unqual(*(lst)->data) * R_UNIQUE(_an_src) = (items);                                               \
+        if (R_UNIQUE(_an_n) > 0) {                                                                                     \
+            if ((lst)->size + R_UNIQUE(_an_n) > (lst)->capacity) {                                                     \
+                const uintptr_t R_UNIQUE(_an_off) = (uintptr_t)R_UNIQUE(_an_src) - (uintptr_t)(lst)->data;             \
+                const bool R_UNIQUE(_an_self) =                                                                        \
+                    (lst)->data != nullptr && R_UNIQUE(_an_off) < (lst)->size * list_type_size(lst);                   \
+                list_resize((lst), R_(list_grown_capacity)((lst)->capacity, (lst)->size + R_UNIQUE(_an_n)));           \
+                if (R_UNIQUE(_an_self)) {                                                                              \
+                    R_UNIQUE(_an_src) = (lst)->data + R_UNIQUE(_an_off) / list_type_size(lst);                         \
+                }                                                                                                      \
+            }                                                                                                          \
+            memcpy(&(lst)->data[(lst)->size], R_UNIQUE(_an_src), R_UNIQUE(_an_n) * list_type_size(lst));               \
+            (lst)->size += R_UNIQUE(_an_n);                                                                            \
+        }                                                                                                              \
     })
 
+// Append every element of another list of the same type (src may be dst)
+#define list_extend(dst, src) list_add_n((dst), (src)->data, (src)->size)
+
 #define list_insert(lst, idx, item)                                                                                    \
     ({                                                                                                                 \
-        (lst)->size++;                                                                                                 \
         list_grow((lst));                                                                                              \
         const size_t tail = (lst)->size - (idx);                                                                       \
         if (tail > 0) {                                                                                                \
@@ -141,6 +286,7 @@
             memmove(dst, src, tail * list_type_size(lst));                                                             \
         }                                                                                                              \
         (lst)->data[(idx)] = (item);                                                                                   \
+        (lst)->size++;                                                                                                 \
     })
 
 #define list_remove(lst, idx)                                                                                          \
@@ -153,10 +299,168 @@
             memmove(dst, src, tail * list_type_size(lst));                                                             \
         }                                                                                                              \
         (lst)->size--;                                                                                                 \
-        list_shrink((lst));                                                                                            \
+        if (R_LIST_AUTO_SHRINK) {                                                                                      \
+            list_shrink((lst));                                                                                        \
+        }                                                                                                              \
         R_UNIQUE(removed);                                                                                             \
     })
 
+/* R_LIST_CMP with optional comparator - same convention as R_BST_CMP in tree.h (three-way result) */
+#define R_LIST_CMP_DEFAULT(a, b) (((a) > (b)) - ((a) < (b)))
+#define R_LIST_CMP_CUSTOM(a, b, cmp) ((cmp)((a), (b)))
+#define R_LIST_CMP_SELECT(_1, _2, _3, N, ...) N
+#define R_LIST_CMP(...) R_LIST_CMP_SELECT(__VA_ARGS__, R_LIST_CMP_CUSTOM, R_LIST_CMP_DEFAULT)(__VA_ARGS__)
+#define R_LIST_LESS(a, b, ...) (R_LIST_CMP((a), (b) __VA_OPT__(, ) __VA_ARGS__) < 0)
+
+#define R_LIST_SWAP(a, b)                                                                                              \
+    ({                                                                                                                 \
+        auto R_UNIQUE(_swp_tmp) = (a);                                                                                 \
+        (a) = (b);                                                                                                     \
+        (b) = R_UNIQUE(_swp_tmp);                                                                                      \
+    })
+
+/**
+ * Introsort of the n elements at base, expanded in place so the comparison inlines (optional comparator as for
+ * R_LIST_CMP). Quicksort with a median-of-three pivot and Hoare partitioning; the larger side of each split waits on
+ * a fixed stack while the smaller one is sorted first, so 64 entries cover any size_t n. A range that needs more than
+ * 2 * log2(n) splits falls back to heapsort (O(n log n) on any input), and short ranges finish with insertion sort.
+ * Not stable.
+ */
+#define R_LIST_SORT(base, n, ...)                                                                                      \
+    ({                                                                                                                 \
+        typeof_unqual(*(base)) * R_UNIQUE(_srt_a) = (base);                                                            \
+        size_t R_UNIQUE(_srt_lo) = 0;                                                                                  \
+        size_t R_UNIQUE(_srt_hi) = (n);                                                                                \
+        size_t R_UNIQUE(_srt_dep) = 0;                                                                                 \
+        for (size_t R_UNIQUE(_srt_m) = R_UNIQUE(_srt_hi); R_UNIQUE(_srt_m) > 1; R_UNIQUE(_srt_m) >>= 1) {              \
+            R_UNIQUE(_srt_dep) += 2;                                                                                   \
+        }                                                                                                              \
+        size_t R_UNIQUE(_srt_stk)[64][3];                                                                              \
+        size_t R_UNIQUE(_srt_top) = 0;                                                                                 \
+        for (;;) {                                                                                                     \
+            const size_t R_UNIQUE(_srt_len) = R_UNIQUE(_srt_hi) - R_UNIQUE(_srt_lo);                                   \
+            if (R_UNIQUE(_srt_len) <= R_LIST_SORT_INSERTION) {                                                         \
+                for (size_t R_UNIQUE(_srt_i) = R_UNIQUE(_srt_lo) + 1; R_UNIQUE(_srt_i) < R_UNIQUE(_srt_hi);            \
+                     R_UNIQUE(_srt_i)++) {                                                                             \
+                    auto R_UNIQUE(_srt_v) = R_UNIQUE(_srt_a)[R_UNIQUE(_srt_i)];                                        \
+                    size_t R_UNIQUE(_srt_k) = R_UNIQUE(_srt_i);                                                        \
+                    while (R_UNIQUE(_srt_k) > R_UNIQUE(_srt_lo) &&                                                     \
+                           R_LIST_LESS(                                                                                \
+                               R_UNIQUE(_srt_v), R_UNIQUE(_srt_a)[R_UNIQUE(_srt_k) - 1] __VA_OPT__(, ) __VA_ARGS__     \
+                           )) {                                                                                        \
+                        R_UNIQUE(_srt_a)[R_UNIQUE(_srt_k)] = R_UNIQUE(_srt_a)[R_UNIQUE(_srt_k) - 1];                   \
+                        R_UNIQUE(_srt_k)--;                                                                            \
+                    }                                                                                                  \
+                    R_UNIQUE(_srt_a)[R_UNIQUE(_srt_k)] = R_UNIQUE(_srt_v);                                             \
+                }                                                                                                      \
+            } else if (R_UNIQUE(_srt_dep) == 0) {                                                                      \
+                /* heapify from the last parent down, then move the max behind the heap; one sift loop for both */     \
+                typeof_unqual(*(base)) * R_UNIQUE(_srt_h) = R_UNIQUE(_srt_a) + R_UNIQUE(_srt_lo);                      \
+                size_t R_UNIQUE(_srt_start) = R_UNIQUE(_srt_len) / 2;                                                  \
+                size_t R_UNIQUE(_srt_end) = R_UNIQUE(_srt_len);                                                        \
+                for (;;) {                                                                                             \
+                    if (R_UNIQUE(_srt_start) > 0) {                                                                    \
+                        R_UNIQUE(_srt_start)--;                                                                        \
+                    } else {                                                                                           \
+                        if (--R_UNIQUE(_srt_end) == 0) {                                                               \
+                            break;                                                                                     \
+                        }                                                                                              \
+                        R_LIST_SWAP(R_UNIQUE(_srt_h)[0], R_UNIQUE(_srt_h)[R_UNIQUE(_srt_end)]);                        \
+                    }                                                                                                  \
+                    size_t R_UNIQUE(_srt_root) = R_UNIQUE(_srt_start);                                                 \
+                    for (;;) {                                                                                         \
+                        size_t R_UNIQUE(_srt_child) = 2 * R_UNIQUE(_srt_root) + 1;                                     \
+                        if (R_UNIQUE(_srt_child) >= R_UNIQUE(_srt_end)) {                                              \
+                            break;                                                                                     \
+                        }                                                                                              \
+                        if (R_UNIQUE(_srt_child) + 1 < R_UNIQUE(_srt_end) &&                                           \
+                            R_LIST_LESS(                                                                               \
+                                R_UNIQUE(_srt_h)[R_UNIQUE(_srt_child)],                                                \
+                                R_UNIQUE(_srt_h)[R_UNIQUE(_srt_child) + 1] __VA_OPT__(, ) __VA_ARGS__                  \
+                            )) {                                                                                       \
+                            R_UNIQUE(_srt_child)++;                                                                    \
+                        }                                                                                              \
+                        if (!R_LIST_LESS(                                                                              \
+                                R_UNIQUE(_srt_h)[R_UNIQUE(_srt_root)],                                                 \
+                                R_UNIQUE(_srt_h)[R_UNIQUE(_srt_child)] __VA_OPT__(, ) __VA_ARGS__                      \
+                            )) {                                                                                       \
+                            break;                                                                                     \
+                        }                                                                                              \
+                        R_LIST_SWAP(R_UNIQUE(_srt_h)[R_UNIQUE(_srt_root)], R_UNIQUE(_srt_h)[R_UNIQUE(_srt_child)]);    \
+                        R_UNIQUE(_srt_root) = R_UNIQUE(_srt_child);                                                    \
+                    }                                                                                                  \
+                }                                                                                                      \
+            } else {                                                                                                   \
+                R_UNIQUE(_srt_dep)--;                                                                                  \
+                /* order lo, mid, hi - 1 so the pivot (the median) has a bound on either side for both scans */        \
+                const size_t R_UNIQUE(_srt_mid) = R_UNIQUE(_srt_lo) + R_UNIQUE(_srt_len) / 2;                          \
+                typeof_unqual(*(base)) * R_UNIQUE(_srt_first) = &R_UNIQUE(_srt_a)[R_UNIQUE(_srt_lo)];                  \
+                typeof_unqual(*(base)) * R_UNIQUE(_srt_mp) = &R_UNIQUE(_srt_a)[R_UNIQUE(_srt_mid)];                    \
+                typeof_unqual(*(base)) * R_UNIQUE(_srt_last) = &R_UNIQUE(_srt_a)[R_UNIQUE(_srt_hi) - 1];               \
+                if (R_LIST_LESS(*R_UNIQUE(_srt_mp), *R_UNIQUE(_srt_first) __VA_OPT__(, ) __VA_ARGS__)) {               \
+                    R_LIST_SWAP(*R_UNIQUE(_srt_mp), *R_UNIQUE(_srt_first));                                            \
+                }                                                                                                      \
+                if (R_LIST_LESS(*R_UNIQUE(_srt_last), *R_UNIQUE(_srt_mp) __VA_OPT__(, ) __VA_ARGS__)) {                \
+                    R_LIST_SWAP(*R_UNIQUE(_srt_last), *R_UNIQUE(_srt_mp));                                             \
+                    if (R_LIST_LESS(*R_UNIQUE(_srt_mp), *R_UNIQUE(_srt_first) __VA_OPT__(, ) __VA_ARGS__)) {           \
+                        R_LIST_SWAP(*R_UNIQUE(_srt_mp), *R_UNIQUE(_srt_first));                                        \
+                    }                                                                                                  \
+                }                                                                                                      \
+                const auto R_UNIQUE(_srt_piv) = *R_UNIQUE(_srt_mp);                                                    \
+                size_t R_UNIQUE(_srt_i) = R_UNIQUE(_srt_lo) - 1;                                                       \
+                size_t R_UNIQUE(_srt_j) = R_UNIQUE(_srt_hi);                                                           \
+                for (;;) {                                                                                             \
+                    do {                                                                                               \
+                        R_UNIQUE(_srt_i)++;                                                                            \
+                    } while (R_LIST_LESS(                                                                              \
+                        R_UNIQUE(_srt_a)[R_UNIQUE(_srt_i)], R_UNIQUE(_srt_piv) __VA_OPT__(, ) __VA_ARGS__              \
+                    ));                                                                                                \
+                    do {                                                                                               \
+                        R_UNIQUE(_srt_j)--;                                                                            \
+                    } while (R_LIST_LESS(                                                                              \
+                        R_UNIQUE(_srt_piv), R_UNIQUE(_srt_a)[R_UNIQUE(_srt_j)] __VA_OPT__(, ) __VA_ARGS__              \
+                    ));                                                                                                \
+                    if (R_UNIQUE(_srt_i) >= R_UNIQUE(_srt_j)) {                                                        \
+                        break;                                                                                         \
+                    }                                                                                                  \
+                    R_LIST_SWAP(R_UNIQUE(_srt_a)[R_UNIQUE(_srt_i)], R_UNIQUE(_srt_a)[R_UNIQUE(_srt_j)]);               \
+                }                                                                                                      \
+                /* [lo, split) <= pivot <= [split, hi), both sides non-empty */                                        \
+                const size_t R_UNIQUE(_srt_split) = R_UNIQUE(_srt_j) + 1;                                              \
+                size_t * R_UNIQUE(_srt_push) = R_UNIQUE(_srt_stk)[R_UNIQUE(_srt_top)++];                               \
+                R_UNIQUE(_srt_push)[2] = R_UNIQUE(_srt_dep);                                                           \
+                if (R_UNIQUE(_srt_split) - R_UNIQUE(_srt_lo) < R_UNIQUE(_srt_hi) - R_UNIQUE(_srt_split)) {             \
+                    R_UNIQUE(_srt_push)[0] = R_UNIQUE(_srt_split);                                                     \
+                    R_UNIQUE(_srt_push)[1] = R_UNIQUE(_srt_hi);                                                        \
+                    R_UNIQUE(_srt_hi) = R_UNIQUE(_srt_split);                                                          \
+                } else {                                                                                               \
+                    R_UNIQUE(_srt_push)[0] = R_UNIQUE(_srt_lo);                                                        \
+                    R_UNIQUE(_srt_push)[1] = R_UNIQUE(_srt_split);                                                     \
+                    R_UNIQUE(_srt_lo) = R_UNIQUE(_srt_split);                                                          \
+                }                                                                                                      \
+                continue;                                                                                              \
+            }                                                                                                          \
+            if (R_UNIQUE(_srt_top) == 0) {                                                                             \
+                break;                                                                                                 \
+            }                                                                                                          \
+            const size_t * R_UNIQUE(_srt_pop) = R_UNIQUE(_srt_stk)[--R_UNIQUE(_srt_top)];                              \
+            R_UNIQUE(_srt_lo) = R_UNIQUE(_srt_pop)[0];                                                                 \
+            R_UNIQUE(_srt_hi) = R_UNIQUE(_srt_pop)[1];                                                                 \
+            R_UNIQUE(_srt_dep) = R_UNIQUE(_srt_pop)[2];                                                                \
+        }                                                                                                              \
+    })
+
+// Sort the list in place, ascending by R_LIST_CMP (optional comparator: int cmp(T a, T b), negative when a < b)
+#define list_sort(lst, ...) R_LIST_SORT((lst)->data, (lst)->size __VA_OPT__(, ) __VA_ARGS__)
+
+/**
+ * Sort the list on a task pool (element type instantiated with T_CMP, see the header comment). Lists shorter than
+ * R_LIST_PAR_SORT_MIN are sorted on the calling thread. Returns false, leaving the list unchanged, if pool is null or
+ * the scratch buffer (one more copy of the elements) cannot be allocated. A task that fails later also returns false:
+ * the list then holds the same elements, only partly sorted.
+ */
+#define list_par_sort(type, lst, pool) R_GLUE(LIST(type), _par_sort)((lst), (pool))
+
 #endif // RUNE_LIST_API
 
 // Type definition and implementation
@@ -170,19 +474,136 @@ typedef struct {
     size_t capacity;
 } LIST(T);
 
+[[maybe_unused]]
 static LIST(T) R_LIST_OF(T)(const T * items, size_t count) {
     LIST(T) lst = {.data = nullptr, .size = 0, .capacity = 0};
-    for (size_t i = 0; i < count; i++) {
-        list_add(&lst, items[i]);
-    }
+    list_add_n(&lst, items, count);
     return lst;
 }
 
+#ifdef T_CMP
+#include "task.h"
+
+/**
+ * list_par_sort: the list is cut into a power of four chunks (at least two per worker) sorted in parallel with
+ * R_LIST_SORT, then merged pairwise in rounds between the list and a scratch buffer. Every round is split into as
+ * many tasks as there are chunks: each task writes one equal slice of a merged run, finding where that slice starts
+ * in both inputs by binary search (merge path), so the last rounds keep every worker busy. An even number of rounds
+ * leaves the result in the list itself.
+ */
+typedef struct {
+    T * src;
+    T * dst;
+    size_t n;
+    size_t chunks;
+    size_t width;
+} R_GLUE(LIST(T), _sort_job);
+
+// First element of chunk c (of job->chunks) in a list of job->n elements
+#define R_LIST_CHUNK_AT(job, c) ((c) * (job)->n / (job)->chunks)
+
+[[maybe_unused]]
+static void R_GLUE(LIST(T), _sort_chunks)(void * arg, const size_t begin, const size_t end) {
+    const R_GLUE(LIST(T), _sort_job) * job = arg;
+    for (size_t c = begin; c < end; c++) {
+        const size_t lo = R_LIST_CHUNK_AT(job, c);
+        R_LIST_SORT(job->src + lo, R_LIST_CHUNK_AT(job, c + 1) - lo, T_CMP);
+    }
+}
+
+// Elements of a taken among the first k of merge(a, b), where ties take from a first
+[[maybe_unused]]
+static size_t R_GLUE(LIST(T), _merge_rank)(const T * a, const size_t na, const T * b, const size_t nb, const size_t k) {
+    size_t lo = k > nb ? k - nb : 0;
+    size_t hi = k < na ? k : na;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (R_LIST_LESS(b[k - mid - 1], a[mid], T_CMP)) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+// Task t writes slice t % (2 * width) of the merge of the two width-chunk runs starting at chunk t - t % (2 * width)
+[[maybe_unused]]
+static void R_GLUE(LIST(T), _merge_slices)(void * arg, const size_t begin, const size_t end) {
+    const R_GLUE(LIST(T), _sort_job) * job = arg;
+    const size_t slices = 2 * job->width;
+    for (size_t t = begin; t < end; t++) {
+        const size_t pair = t - t % slices;
+        const size_t lo = R_LIST_CHUNK_AT(job, pair);
+        const size_t mid = R_LIST_CHUNK_AT(job, pair + job->width);
+        const size_t hi = R_LIST_CHUNK_AT(job, pair + slices);
+        const T * a = job->src + lo;
+        const T * b = job->src + mid;
+        const size_t na = mid - lo;
+        const size_t nb = hi - mid;
+        const size_t k0 = (hi - lo) * (t % slices) / slices;
+        const size_t k1 = (hi - lo) * (t % slices + 1) / slices;
+
+        size_t i = R_GLUE(LIST(T), _merge_rank)(a, na, b, nb, k0);
+        size_t j = k0 - i;
+        const size_t i_end = R_GLUE(LIST(T), _merge_rank)(a, na, b, nb, k1);
+        const size_t j_end = k1 - i_end;
+        T * out = job->dst + lo + k0;
+        while (i < i_end && j < j_end) {
+            *out++ = R_LIST_LESS(b[j], a[i], T_CMP) ? b[j++] : a[i++];
+        }
+        memcpy(out, a + i, (i_end - i) * sizeof(T));
+        memcpy(out + (i_end - i), b + j, (j_end - j) * sizeof(T));
+    }
+}
+
+#undef R_LIST_CHUNK_AT
+
+[[maybe_unused]]
+static bool R_GLUE(LIST(T), _par_sort)(LIST(T) * lst, task_pool * pool) {
+    if (err_null(pool)) {
+        return false;
+    }
+    if (lst->size < R_LIST_PAR_SORT_MIN) {
+        list_sort(lst, T_CMP);
+        return true;
+    }
+    R_GLUE(LIST(T), _sort_job) job = {.src = lst->data, .n = lst->size, .chunks = 4, .width = 1};
+    while (job.chunks < 2 * task_pool_workers(pool)) {
+        job.chunks *= 4;
+    }
+    T * scratch = mem_alloc(lst->size * sizeof(T));
+    if (scratch == nullptr) {
+        return false;
+    }
+    job.dst = scratch;
+
+    bool ok = task_for(pool, job.chunks, 1, R_GLUE(LIST(T), _sort_chunks), &job);
+    for (; ok && job.width < job.chunks; job.width *= 2) {
+        ok = task_for(pool, job.chunks, 1, R_GLUE(LIST(T), _merge_slices), &job);
+        if (ok) {
+            T * merged = job.dst;
+            job.dst = job.src;
+            job.src = merged;
+        }
+    }
+    // A failed round only wrote its destination: the last complete round is in src, which may be the scratch buffer
+    if (job.src != lst->data) {
+        memcpy(lst->data, job.src, lst->size * sizeof(T));
+    }
+    mem_free(scratch, lst->size * sizeof(T));
+    return ok;
+}
+
+#endif // T_CMP
+
 #endif // T
 
 // =====================================================================================================================
 // Lock-Free Queue
 // =====================================================================================================================
+// Single-producer / single-consumer ring buffer: only the producer writes tail, only the consumer writes head, and
+// each side reads the other's index with acquire ordering against the release store that published it.
 
 // API
 // ---------------------------------------------------------------------------------------------------------------------
@@ -195,6 +616,11 @@ static LIST(T) R_LIST_OF(T)(const T * items, size_t count) {
 
 #define lfq(type, cap, ...) R_LFQ_OF(type)((cap), (type[]){__VA_ARGS__}, sizeof((type[]){__VA_ARGS__}) / sizeof(type))
 
+// Mask for power-of-two capacities (wrapping is a single AND), 0 for any other capacity (wrapping falls back to modulo)
+#define R_LFQ_MASK_FOR(capacity) (((capacity) > 1 && ((capacity) & ((capacity) - 1)) == 0) ? (capacity) - 1 : 0)
+
+#define R_LFQ_WRAP(q, idx) ((q)->mask != 0 ? (idx) & (q)->mask : (idx) % (q)->capacity)
+
 #define lfq_free(q)                                                                                                    \
     ({                                                                                                                 \
         if ((q) != nullptr) {                                                                                          \
@@ -204,6 +630,7 @@ static LIST(T) R_LIST_OF(T)(const T * items, size_t count) {
             }                                                                                                          \
                                                                                                                        \
             (q)->capacity = 0;                                                                                         \
+            (q)->mask = 0;                                                                                             \
             (q)->head = 0;                                                                                             \
             (q)->tail = 0;                                                                                             \
         }                                                                                                              \
@@ -213,17 +640,25 @@ static LIST(T) R_LIST_OF(T)(const T * items, size_t count) {
 
 #define lfq_capacity(q) (q)->capacity
 
-#define lfq_depth(q) ((atomic_load(&(q)->tail) - atomic_load(&(q)->head)) % (q)->capacity)
+#define lfq_depth(q)                                                                                                   \
+    R_LFQ_WRAP(                                                                                                        \
+        (q),                                                                                                           \
+        atomic_load_explicit(&(q)->tail, memory_order_acquire) + (q)->capacity -                                       \
+            atomic_load_explicit(&(q)->head, memory_order_acquire)                                                     \
+    )
 
-#define lfq_empty(q) (atomic_load(&(q)->head) == atomic_load(&(q)->tail))
+#define lfq_empty(q)                                                                                                   \
+    (atomic_load_explicit(&(q)->head, memory_order_acquire) == atomic_load_explicit(&(q)->tail, memory_order_acquire))
 
-#define lfq_full(q) (((atomic_load(&(q)->tail) + 1) % (q)->capacity) == atomic_load(&(q)->head))
+#define lfq_full(q)                                                                                                    \
+    (R_LFQ_WRAP((q), atomic_load_explicit(&(q)->tail, memory_order_acquire) + 1) ==                                    \
+     atomic_load_explicit(&(q)->head, memory_order_acquire))
 
 #define lfq_peek(q)                                                                                                    \
     ({                                                                                                                 \
-        const size_t head = atomic_load(&(q)->head);                                                                   \
+        const size_t head = atomic_load_explicit(&(q)->head, memory_order_relaxed);                                    \
         typeof((q)->data[0]) result = (typeof((q)->data[0])){0};                                                       \
-        if (head != atomic_load(&(q)->tail)) {                                                                         \
+        if (head != atomic_load_explicit(&(q)->tail, memory_order_acquire)) {                                          \
             result = (q)->data[head];                                                                                  \
         }                                                                                                              \
         result;                                                                                                        \
@@ -237,47 +672,114 @@ static LIST(T) R_LIST_OF(T)(const T * items, size_t count) {
 
 #define lfq_push(q, item)                                                                                              \
     ({                                                                                                                 \
-        const size_t tail = atomic_load(&(q)->tail);                                                                   \
-        const size_t next_tail = (tail + 1) % (q)->capacity;                                                           \
+        const size_t tail = atomic_load_explicit(&(q)->tail, memory_order_relaxed);                                    \
+        const size_t next_tail = R_LFQ_WRAP((q), tail + 1);                                                            \
         auto R_UNIQUE(result) = item;                                                                                  \
-        if (next_tail == atomic_load(&(q)->head)) {                                                                    \
+        if (next_tail == atomic_load_explicit(&(q)->head, memory_order_acquire)) {                                     \
             err_set(R_ERR_QUEUE_FULL, nullptr);                                                                        \
+            R_TRACE_ADD(R_TRACE_LFQ_FULL, 1);                                                                          \
             R_UNIQUE(result) = (typeof(item)){0};                                                                      \
         } else {                                                                                                       \
             (q)->data[tail] = (item);                                                                                  \
-            atomic_store(&(q)->tail, next_tail);                                                                       \
+            atomic_store_explicit(&(q)->tail, next_tail, memory_order_release);                                        \
         }                                                                                                              \
         R_UNIQUE(result);                                                                                              \
     })
 
 #define lfq_pop(q)                                                                                                     \
     ({                                                                                                                 \
-        const size_t head = atomic_load(&(q)->head);                                                                   \
+        const size_t head = atomic_load_explicit(&(q)->head, memory_order_relaxed);                                    \
         typeof((q)->data[0]) item = (typeof((q)->data[0])){0};                                                         \
-        if (head != atomic_load(&(q)->tail)) {                                                                         \
+        if (head != atomic_load_explicit(&(q)->tail, memory_order_acquire)) {                                          \
             item = (q)->data[head];                                                                                    \
-            atomic_store(&(q)->head, (head + 1) % (q)->capacity);                                                      \
+            atomic_store_explicit(&(q)->head, R_LFQ_WRAP((q), head + 1), memory_order_release);                        \
         } else {                                                                                                       \
             err_set(R_ERR_QUEUE_EMPTY, nullptr);                                                                       \
+            R_TRACE_ADD(R_TRACE_LFQ_EMPTY, 1);                                                                         \
         }                                                                                                              \
         item;                                                                                                          \
     })
 
+/**
+ * Push up to n items from the array items in one step: free space is filled by at most two memcpy calls (before
+ * and after the wrap point) and tail is published once. Producer side only.
+ * Returns the number of items pushed; sets R_ERR_QUEUE_FULL if none could be.
+ */
+#define lfq_push_n(q, items, n)                                                                                        \
+    ({                                                                                                                 \
+        const size_t R_UNIQUE(_pn_tail) = atomic_load_explicit(&(q)->tail, memory_order_relaxed);                      \
+        const size_t R_UNIQUE(_pn_head) = atomic_load_explicit(&(q)->head, memory_order_acquire);                      \
+        const size_t R_UNIQUE(_pn_free) =                                                                              \
+            (q)->capacity - 1 - R_LFQ_WRAP((q), R_UNIQUE(_pn_tail) + (q)->capacity - R_UNIQUE(_pn_head));              \
+        const size_t R_UNIQUE(_pn_count) = (n) < R_UNIQUE(_pn_free) ? (n) : R_UNIQUE(_pn_free);                        \
+        const size_t R_UNIQUE(_pn_first) = (q)->capacity - R_UNIQUE(_pn_tail) < R_UNIQUE(_pn_count)                    \
+                                               ? (q)->capacity - R_UNIQUE(_pn_tail)                                    \
+                                               : R_UNIQUE(_pn_count);                                                  \
+        if (R_UNIQUE(_pn_count) > 0) {                                                                                 \
+            memcpy(&(q)->data[R_UNIQUE(_pn_tail)], (items), R_UNIQUE(_pn_first) * lfq_type_size(q));                   \
+            memcpy(                                                                                                    \
+                &(q)->data[0],                                                                                         \
+                &(items)[R_UNIQUE(_pn_first)],                                                                         \
+                (R_UNIQUE(_pn_count) - R_UNIQUE(_pn_first)) * lfq_type_size(q)                                         \
+            );                                                                                                         \
+            atomic_store_explicit(                                                                                     \
+                &(q)->tail, R_LFQ_WRAP((q), R_UNIQUE(_pn_tail) + R_UNIQUE(_pn_count)), memory_order_release            \
+            );                                                                                                         \
+        } else if ((n) > 0) {                                                                                          \
+            err_set(R_ERR_QUEUE_FULL, nullptr);                                                                        \
+            R_TRACE_ADD(R_TRACE_LFQ_FULL, 1);                                                                          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_pn_count);                                                                              \
+    })
+
+/**
+ * Pop up to n items into the array out in one step: at most two memcpy calls and a single head publish.
+ * Consumer side only.
+ * Returns the number of items popped; sets R_ERR_QUEUE_EMPTY if none were available.
+ */
+#define lfq_pop_n(q, out, n)                                                                                           \
+    ({                                                                                                                 \
+        const size_t R_UNIQUE(_pp_head) = atomic_load_explicit(&(q)->head, memory_order_relaxed);                      \
+        const size_t R_UNIQUE(_pp_tail) = atomic_load_explicit(&(q)->tail, memory_order_acquire);                      \
+        const size_t R_UNIQUE(_pp_depth) = R_LFQ_WRAP((q), R_UNIQUE(_pp_tail) + (q)->capacity - R_UNIQUE(_pp_head));   \
+        const size_t R_UNIQUE(_pp_count) = (n) < R_UNIQUE(_pp_depth) ? (n) : R_UNIQUE(_pp_depth);                      \
+        const size_t R_UNIQUE(_pp_first) = (q)->capacity - R_UNIQUE(_pp_head) < R_UNIQUE(_pp_count)                    \
+                                               ? (q)->capacity - R_UNIQUE(_pp_head)                                    \
+                                               : R_UNIQUE(_pp_count);                                                  \
+        if (R_UNIQUE(_pp_count) > 0) {                                                                                 \
+            memcpy((out), &(q)->data[R_UNIQUE(_pp_head)], R_UNIQUE(_pp_first) * lfq_type_size(q));                     \
+            memcpy(                                                                                                    \
+                &(out)[R_UNIQUE(_pp_first)],                                                                           \
+                &(q)->data[0],                                                                                         \
+                (R_UNIQUE(_pp_count) - R_UNIQUE(_pp_first)) * lfq_type_size(q)                                         \
+            );                                                                                                         \
+            atomic_store_explicit(                                                                                     \
+                &(q)->head, R_LFQ_WRAP((q), R_UNIQUE(_pp_head) + R_UNIQUE(_pp_count)), memory_order_release            \
+            );                                                                                                         \
+        } else if ((n) > 0) {                                                                                          \
+            err_set(R_ERR_QUEUE_EMPTY, nullptr);                                                                       \
+            R_TRACE_ADD(R_TRACE_LFQ_EMPTY, 1);                                                                         \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_pp_count);                                                                              \
+    })
+
+// Not thread safe: neither side may run concurrently with a resize (SEGQ grows while both run)
 #define lfq_resize(q, new_capacity)                                                                                    \
     ({                                                                                                                 \
-        const size_t old_capacity = (q)->capacity;                                                                     \
-        const size_t head = (q)->head;                                                                                 \
-        const size_t tail = (q)->tail;                                                                                 \
-        const size_t type_size = lfq_type_size(q);                                                                     \
-        void * new_data = mem_realloc((q)->data, old_capacity * type_size, new_capacity * type_size);                  \
-        if (tail < head) {                                                                                             \
-            const size_t first = old_capacity - head;                                                                  \
-            memmove((char *)new_data + first * type_size, new_data, tail * type_size);                                 \
+        const size_t R_UNIQUE(_rs_depth) = lfq_depth((q));                                                             \
+        const size_t R_UNIQUE(_rs_cap) = (new_capacity);                                                               \
+        typeof((q)->data) R_UNIQUE(_rs_data) = mem_alloc_zero(R_UNIQUE(_rs_cap) * lfq_type_size(q));                   \
+        const size_t R_UNIQUE(_rs_keep) =                                                                              \
+            R_UNIQUE(_rs_depth) < R_UNIQUE(_rs_cap) ? R_UNIQUE(_rs_depth) : R_UNIQUE(_rs_cap) - 1;                     \
+        if (R_UNIQUE(_rs_keep) > 0) {                                                                                  \
+            lfq_pop_n((q), R_UNIQUE(_rs_data), R_UNIQUE(_rs_keep));                                                    \
         }                                                                                                              \
-        (q)->data = new_data;                                                                                          \
-        (q)->capacity = new_capacity;                                                                                  \
-        (q)->head = 0;                                                                                                 \
-        (q)->tail = (tail >= head) ? (tail - head) : (old_capacity - head + tail);                                     \
+        mem_free((q)->data, (q)->capacity * lfq_type_size(q));                                                         \
+        (q)->data = R_UNIQUE(_rs_data);                                                                                \
+        (q)->capacity = R_UNIQUE(_rs_cap);                                                                             \
+        (q)->mask = R_LFQ_MASK_FOR(R_UNIQUE(_rs_cap));                                                                 \
+        atomic_store(&(q)->head, 0);                                                                                   \
+        atomic_store(&(q)->tail, R_UNIQUE(_rs_keep));                                                                  \
     })
 
 #endif // RUNE_LFQ_API
@@ -287,17 +789,27 @@ static LIST(T) R_LIST_OF(T)(const T * items, size_t count) {
 
 #ifdef T
 
+// head (consumer) and tail (producer) sit on separate cache lines so the two threads don't false-share
 typedef struct {
     T * data;
     size_t capacity;
+    size_t mask;
+    char R_(lfq_pad0)[R_CACHE_LINE - 3 * sizeof(size_t)];
     R_Atomic(size_t) head;
+    char R_(lfq_pad1)[R_CACHE_LINE - sizeof(size_t)];
     R_Atomic(size_t) tail;
+    char R_(lfq_pad2)[R_CACHE_LINE - sizeof(size_t)];
 } LFQ(T);
 
 [[maybe_unused]]
 static LFQ(T) R_LFQ_OF(T)(size_t capacity, const T * items, size_t count) {
-    LFQ(T)
-    q = {.data = mem_alloc_zero(capacity * sizeof(T)), .capacity = capacity, .head = 0, .tail = 0};
+    LFQ(T) q = {
+        .data = mem_alloc_zero(capacity * sizeof(T)),
+        .capacity = capacity,
+        .mask = R_LFQ_MASK_FOR(capacity),
+        .head = 0,
+        .tail = 0,
+    };
     for (size_t i = 0; i < count && i < capacity - 1; i++) {
         lfq_push(&q, items[i]);
     }
@@ -307,23 +819,371 @@ static LFQ(T) R_LFQ_OF(T)(size_t capacity, const T * items, size_t count) {
 #endif // T
 
 // =====================================================================================================================
-// Hash Map
+// Segmented Lock-Free Queue
 // =====================================================================================================================
+// Unbounded single-producer / single-consumer queue made of LFQ-style rings. When the producer's ring is full it links
+// a new ring of twice the size (up to R_SEGQ_MAX_SEGMENT slots) and carries on there; the consumer drains each ring in
+// turn and frees it once it has moved on to the next. Growing never copies queued items and neither side waits for
+// the other, unlike lfq_resize, which stops both. Rings come from the allocator current when the queue was created,
+// so that allocator must be thread safe when the producer and the consumer are different threads.
 
 // API
 // ---------------------------------------------------------------------------------------------------------------------
 
-#ifndef RUNE_MAP_API
-#define RUNE_MAP_API
+#ifndef RUNE_SEGQ_API
+#define RUNE_SEGQ_API
+
+#ifdef RCFG__SEGQ_MAX_SEGMENT
+static constexpr size_t R_SEGQ_MAX_SEGMENT = RCFG__SEGQ_MAX_SEGMENT;
+#else  // Slots of the largest ring a growing queue links; rings stop doubling there
+static constexpr size_t R_SEGQ_MAX_SEGMENT = 1 << 16;
+#endif // RCFG__SEGQ_MAX_SEGMENT
 
-#define MAP(key_t, val_t) R_GLUE(map_, R_JOIN(key_t, val_t, _))
+#define SEGQ(type) R_GLUE(segq_, type)
+#define SEGQ_SEG(type) R_GLUE(SEGQ(type), _seg)
+#define R_SEGQ_OF(type) R_GLUE(SEGQ(type), _of)
 
-#endif // RUNE_MAP_API
+#define segq(type, cap, ...)                                                                                           \
+    R_SEGQ_OF(type)((cap), (type[]){__VA_ARGS__}, sizeof((type[]){__VA_ARGS__}) / sizeof(type))
 
-#if defined(K) && defined(V)
+#define R_SEGQ_SEG_BYTES(q, slots) (sizeof(*(q)->tail) + (slots) * sizeof((q)->tail->data[0]))
+
+// Empty ring of slots entries (a power of two) from the queue's allocator, nullptr if the allocation failed
+#define R_SEGQ_SEG_NEW(q, slots)                                                                                       \
+    ({                                                                                                                 \
+        const size_t R_UNIQUE(_sgn_slots) = (slots);                                                                   \
+        alloc_push((q)->alloc);                                                                                        \
+        typeof((q)->tail) R_UNIQUE(_sgn_seg) = mem_alloc(R_SEGQ_SEG_BYTES((q), R_UNIQUE(_sgn_slots)));                 \
+        alloc_pop();                                                                                                   \
+        if (R_UNIQUE(_sgn_seg) != nullptr) {                                                                           \
+            R_UNIQUE(_sgn_seg)->mask = R_UNIQUE(_sgn_slots) - 1;                                                       \
+            atomic_init(&R_UNIQUE(_sgn_seg)->next, nullptr);                                                           \
+            atomic_init(&R_UNIQUE(_sgn_seg)->head, 0);                                                                 \
+            atomic_init(&R_UNIQUE(_sgn_seg)->tail, 0);                                                                 \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_sgn_seg);                                                                               \
+    })
+
+#define R_SEGQ_SEG_FREE(q, seg)                                                                                        \
+    ({                                                                                                                 \
+        alloc_push((q)->alloc);                                                                                        \
+        mem_free((seg), R_SEGQ_SEG_BYTES((q), (seg)->mask + 1));                                                       \
+        alloc_pop();                                                                                                   \
+    })
+
+#define segq_free(q)                                                                                                   \
+    ({                                                                                                                 \
+        if ((q) != nullptr) {                                                                                          \
+            typeof((q)->head) R_UNIQUE(_sgf_seg) = (q)->head;                                                          \
+            while (R_UNIQUE(_sgf_seg) != nullptr) {                                                                    \
+                typeof((q)->head) R_UNIQUE(_sgf_next) = atomic_load(&R_UNIQUE(_sgf_seg)->next);                        \
+                R_SEGQ_SEG_FREE((q), R_UNIQUE(_sgf_seg));                                                              \
+                R_UNIQUE(_sgf_seg) = R_UNIQUE(_sgf_next);                                                              \
+            }                                                                                                          \
+            (q)->head = nullptr;                                                                                       \
+            (q)->tail = nullptr;                                                                                       \
+        }                                                                                                              \
+    })
+
+// Consumer side; a snapshot when the producer is running
+#define segq_empty(q)                                                                                                  \
+    ({                                                                                                                 \
+        bool R_UNIQUE(_sge_empty) = true;                                                                              \
+        for (typeof((q)->head) R_UNIQUE(_sge_seg) = (q)->head;                                                         \
+             R_UNIQUE(_sge_seg) != nullptr && R_UNIQUE(_sge_empty);                                                    \
+             R_UNIQUE(_sge_seg) = atomic_load_explicit(&R_UNIQUE(_sge_seg)->next, memory_order_acquire)) {             \
+            R_UNIQUE(_sge_empty) = atomic_load_explicit(&R_UNIQUE(_sge_seg)->head, memory_order_relaxed) ==            \
+                                   atomic_load_explicit(&R_UNIQUE(_sge_seg)->tail, memory_order_acquire);              \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_sge_empty);                                                                             \
+    })
+
+/**
+ * Producer side. A full ring is never waited on: the item goes first into a new ring, which is then published through
+ * the old ring's next pointer (release), so the consumer that sees the link (acquire) also sees the item. Returns false
+ * if that ring, or the first one at creation, could not be allocated (R_ERR_ALLOC_FAILED); the item is dropped.
+ */
+#define segq_push(q, item)                                                                                             \
+    ({                                                                                                                 \
+        typeof((q)->tail) R_UNIQUE(_sgp_seg) = (q)->tail;                                                              \
+        bool R_UNIQUE(_sgp_ok) = true;                                                                                 \
+        if (R_UNIQUE(_sgp_seg) == nullptr) {                                                                           \
+            err_set(R_ERR_ALLOC_FAILED, nullptr);                                                                      \
+            R_UNIQUE(_sgp_ok) = false;                                                                                 \
+        } else {                                                                                                       \
+            const size_t R_UNIQUE(_sgp_tail) = atomic_load_explicit(&R_UNIQUE(_sgp_seg)->tail, memory_order_relaxed);  \
+            const size_t R_UNIQUE(_sgp_next) = (R_UNIQUE(_sgp_tail) + 1) & R_UNIQUE(_sgp_seg)->mask;                   \
+            if (R_UNIQUE(_sgp_next) != atomic_load_explicit(&R_UNIQUE(_sgp_seg)->head, memory_order_acquire)) {        \
+                R_UNIQUE(_sgp_seg)->data[R_UNIQUE(_sgp_tail)] = (item);                                                \
+                atomic_store_explicit(&R_UNIQUE(_sgp_seg)->tail, R_UNIQUE(_sgp_next), memory_order_release);           \
+            } else {                                                                                                   \
+                const size_t R_UNIQUE(_sgp_slots) = R_UNIQUE(_sgp_seg)->mask + 1;                                      \
+                typeof(R_UNIQUE(_sgp_seg)) R_UNIQUE(_sgp_new) = R_SEGQ_SEG_NEW(                                        \
+                    (q), R_UNIQUE(_sgp_slots) < R_SEGQ_MAX_SEGMENT ? 2 * R_UNIQUE(_sgp_slots) : R_UNIQUE(_sgp_slots)   \
+                );                                                                                                     \
+                if (R_UNIQUE(_sgp_new) != nullptr) {                                                                   \
+                    R_UNIQUE(_sgp_new)->data[0] = (item);                                                              \
+                    atomic_init(&R_UNIQUE(_sgp_new)->tail, 1);                                                         \
+                    atomic_store_explicit(&R_UNIQUE(_sgp_seg)->next, R_UNIQUE(_sgp_new), memory_order_release);        \
+                    (q)->tail = R_UNIQUE(_sgp_new);                                                                    \
+                } else {                                                                                               \
+                    err_set(R_ERR_ALLOC_FAILED, nullptr);                                                              \
+                    R_UNIQUE(_sgp_ok) = false;                                                                         \
+                }                                                                                                      \
+            }                                                                                                          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_sgp_ok);                                                                                \
+    })
+
+/**
+ * Consumer side. An empty ring with a successor is finished: the producer linked the successor only after its last
+ * push there, but that push may not have been seen by the first check, so the ring is checked once more after the
+ * link is read, then freed. Returns a zero item when the queue is empty (R_ERR_QUEUE_EMPTY).
+ */
+#define segq_pop(q)                                                                                                    \
+    ({                                                                                                                 \
+        typeof((q)->head->data[0]) R_UNIQUE(_sgq_item) = (typeof((q)->head->data[0])){0};                              \
+        bool R_UNIQUE(_sgq_found) = false;                                                                             \
+        while ((q)->head != nullptr) {                                                                                 \
+            typeof((q)->head) R_UNIQUE(_sgq_seg) = (q)->head;                                                          \
+            const size_t R_UNIQUE(_sgq_head) = atomic_load_explicit(&R_UNIQUE(_sgq_seg)->head, memory_order_relaxed);  \
+            size_t R_UNIQUE(_sgq_tail) = atomic_load_explicit(&R_UNIQUE(_sgq_seg)->tail, memory_order_acquire);        \
+            typeof((q)->head) R_UNIQUE(_sgq_next) = nullptr;                                                           \
+            if (R_UNIQUE(_sgq_head) == R_UNIQUE(_sgq_tail)) {                                                          \
+                R_UNIQUE(_sgq_next) = atomic_load_explicit(&R_UNIQUE(_sgq_seg)->next, memory_order_acquire);           \
+                if (R_UNIQUE(_sgq_next) == nullptr) {                                                                  \
+                    break;                                                                                             \
+                }                                                                                                      \
+                R_UNIQUE(_sgq_tail) = atomic_load_explicit(&R_UNIQUE(_sgq_seg)->tail, memory_order_acquire);           \
+            }                                                                                                          \
+            if (R_UNIQUE(_sgq_head) != R_UNIQUE(_sgq_tail)) {                                                          \
+                R_UNIQUE(_sgq_item) = R_UNIQUE(_sgq_seg)->data[R_UNIQUE(_sgq_head)];                                   \
+                const size_t R_UNIQUE(_sgq_after) = (R_UNIQUE(_sgq_head) + 1) & R_UNIQUE(_sgq_seg)->mask;              \
+                atomic_store_explicit(&R_UNIQUE(_sgq_seg)->head, R_UNIQUE(_sgq_after), memory_order_release);          \
+                R_UNIQUE(_sgq_found) = true;                                                                           \
+                break;                                                                                                 \
+            }                                                                                                          \
+            (q)->head = R_UNIQUE(_sgq_next);                                                                           \
+            R_SEGQ_SEG_FREE((q), R_UNIQUE(_sgq_seg));                                                                  \
+        }                                                                                                              \
+        if (!R_UNIQUE(_sgq_found)) {                                                                                   \
+            err_set(R_ERR_QUEUE_EMPTY, nullptr);                                                                       \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_sgq_item);                                                                              \
+    })
+
+#endif // RUNE_SEGQ_API
+
+// Type definition and implementation
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef T
+
+// One ring: head (consumer) and tail (producer) sit on separate cache lines, as in LFQ
+typedef struct SEGQ_SEG(T) {
+    R_Atomic(struct SEGQ_SEG(T) *) next; // ring linked after this one, written once by the producer
+    size_t mask;
+    char R_(segq_pad0)[R_CACHE_LINE - (sizeof(void *) + sizeof(size_t)) % R_CACHE_LINE];
+    R_Atomic(size_t) head;
+    char R_(segq_pad1)[R_CACHE_LINE - sizeof(size_t) % R_CACHE_LINE];
+    R_Atomic(size_t) tail;
+    char R_(segq_pad2)[R_CACHE_LINE - sizeof(size_t) % R_CACHE_LINE];
+    T data[];
+} SEGQ_SEG(T);
 
 typedef struct {
+    allocator alloc;    // allocator current at creation, for every ring
+    SEGQ_SEG(T) * head; // oldest ring, owned by the consumer
+    char R_(segq_pad0)[R_CACHE_LINE - (sizeof(allocator) + sizeof(void *)) % R_CACHE_LINE];
+    SEGQ_SEG(T) * tail; // newest ring, owned by the producer
+    char R_(segq_pad1)[R_CACHE_LINE - sizeof(void *) % R_CACHE_LINE];
+} SEGQ(T);
+
+// Capacity of the first ring is rounded up to a power of two (at least 2); one slot of each ring stays free
+[[maybe_unused]]
+static SEGQ(T) R_SEGQ_OF(T)(size_t capacity, const T * items, size_t count) {
+    size_t slots = 2;
+    while (slots < capacity) {
+        slots <<= 1;
+    }
+    SEGQ(T) q = {.alloc = alloc_current()};
+    q.head = q.tail = R_SEGQ_SEG_NEW(&q, slots);
+    if (q.head == nullptr) {
+        err_set(R_ERR_ALLOC_FAILED, nullptr);
+        return q;
+    }
+    for (size_t i = 0; i < count; i++) {
+        segq_push(&q, items[i]);
+    }
+    return q;
+}
 
-} MAP(K, V);
+#endif // T
+
+// =====================================================================================================================
+// MPMC Queue
+// =====================================================================================================================
+
+// API
+// ---------------------------------------------------------------------------------------------------------------------
 
-#endif // K and V
+#ifndef RUNE_MPMC_API
+#define RUNE_MPMC_API
+
+#define MPMC(type) R_GLUE(mpmc_, type)
+#define MPMC_SLOT(type) R_GLUE(MPMC(type), _slot)
+#define R_MPMC_OF(type) R_GLUE(MPMC(type), _of)
+
+#define mpmc(type, cap, ...)                                                                                           \
+    R_MPMC_OF(type)((cap), (type[]){__VA_ARGS__}, sizeof((type[]){__VA_ARGS__}) / sizeof(type))
+
+#define mpmc_free(q)                                                                                                   \
+    ({                                                                                                                 \
+        if ((q) != nullptr) {                                                                                          \
+            if ((q)->slots != nullptr) {                                                                               \
+                mem_free((q)->slots, ((q)->mask + 1) * sizeof((q)->slots[0]));                                         \
+                (q)->slots = nullptr;                                                                                  \
+            }                                                                                                          \
+                                                                                                                       \
+            (q)->mask = 0;                                                                                             \
+            (q)->head = 0;                                                                                             \
+            (q)->tail = 0;                                                                                             \
+        }                                                                                                              \
+    })
+
+#define mpmc_capacity(q) ((q)->mask + 1)
+
+// Snapshot only: other threads may push or pop between the two loads
+#define mpmc_depth(q)                                                                                                  \
+    ({                                                                                                                 \
+        const size_t R_UNIQUE(_dep_head) = atomic_load_explicit(&(q)->head, memory_order_acquire);                     \
+        const size_t R_UNIQUE(_dep_tail) = atomic_load_explicit(&(q)->tail, memory_order_acquire);                     \
+        /* return */ R_UNIQUE(_dep_tail) > R_UNIQUE(_dep_head) ? R_UNIQUE(_dep_tail) - R_UNIQUE(_dep_head) : 0;        \
+    })
+
+#define mpmc_empty(q) (mpmc_depth(q) == 0)
+
+/**
+ * Vyukov bounded MPMC queue. Every slot carries a sequence number:
+ *   seq == pos      slot is free for the producer that claims position pos
+ *   seq == pos + 1  slot holds the item written at pos, ready for the consumer that claims pos
+ * Producers and consumers claim positions with a CAS on tail / head, then publish through the slot's sequence
+ * number (release), so the data write is visible to whoever observes the new sequence (acquire).
+ */
+#define mpmc_push(q, item)                                                                                             \
+    ({                                                                                                                 \
+        auto R_UNIQUE(_push_item) = (item);                                                                            \
+        typeof((q)->slots) R_UNIQUE(_push_slot) = nullptr;                                                             \
+        size_t R_UNIQUE(_push_pos) = atomic_load_explicit(&(q)->tail, memory_order_relaxed);                           \
+        for (;;) {                                                                                                     \
+            R_UNIQUE(_push_slot) = &(q)->slots[R_UNIQUE(_push_pos) & (q)->mask];                                       \
+            const size_t R_UNIQUE(_push_seq) = atomic_load_explicit(&R_UNIQUE(_push_slot)->seq, memory_order_acquire); \
+            const intptr_t R_UNIQUE(_push_dif) = (intptr_t)R_UNIQUE(_push_seq) - (intptr_t)R_UNIQUE(_push_pos);        \
+            if (R_UNIQUE(_push_dif) == 0) {                                                                            \
+                if (atomic_compare_exchange_weak_explicit(                                                             \
+                        &(q)->tail,                                                                                    \
+                        &R_UNIQUE(_push_pos),                                                                          \
+                        R_UNIQUE(_push_pos) + 1,                                                                       \
+                        memory_order_relaxed,                                                                          \
+                        memory_order_relaxed                                                                           \
+                    )) {                                                                                               \
+                    break;                                                                                             \
+                }                                                                                                      \
+            } else if (R_UNIQUE(_push_dif) < 0) {                                                                      \
+                R_UNIQUE(_push_slot) = nullptr;                                                                        \
+                break;                                                                                                 \
+            } else {                                                                                                   \
+                R_UNIQUE(_push_pos) = atomic_load_explicit(&(q)->tail, memory_order_relaxed);                          \
+            }                                                                                                          \
+        }                                                                                                              \
+        if (R_UNIQUE(_push_slot) != nullptr) {                                                                         \
+            R_UNIQUE(_push_slot)->data = R_UNIQUE(_push_item);                                                         \
+            atomic_store_explicit(&R_UNIQUE(_push_slot)->seq, R_UNIQUE(_push_pos) + 1, memory_order_release);          \
+        } else {                                                                                                       \
+            err_set(R_ERR_QUEUE_FULL, nullptr);                                                                        \
+            R_TRACE_ADD(R_TRACE_MPMC_FULL, 1);                                                                         \
+            R_UNIQUE(_push_item) = (typeof(R_UNIQUE(_push_item))){0};                                                  \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_push_item);                                                                             \
+    })
+
+#define mpmc_pop(q)                                                                                                    \
+    ({                                                                                                                 \
+        typeof((q)->slots[0].data) R_UNIQUE(_pop_item) = (typeof((q)->slots[0].data)){0};                              \
+        typeof((q)->slots) R_UNIQUE(_pop_slot) = nullptr;                                                              \
+        size_t R_UNIQUE(_pop_pos) = atomic_load_explicit(&(q)->head, memory_order_relaxed);                            \
+        for (;;) {                                                                                                     \
+            R_UNIQUE(_pop_slot) = &(q)->slots[R_UNIQUE(_pop_pos) & (q)->mask];                                         \
+            const size_t R_UNIQUE(_pop_seq) = atomic_load_explicit(&R_UNIQUE(_pop_slot)->seq, memory_order_acquire);   \
+            const intptr_t R_UNIQUE(_pop_dif) = (intptr_t)R_UNIQUE(_pop_seq) - (intptr_t)(R_UNIQUE(_pop_pos) + 1);     \
+            if (R_UNIQUE(_pop_dif) == 0) {                                                                             \
+                if (atomic_compare_exchange_weak_explicit(                                                             \
+                        &(q)->head,                                                                                    \
+                        &R_UNIQUE(_pop_pos),                                                                           \
+                        R_UNIQUE(_pop_pos) + 1,                                                                        \
+                        memory_order_relaxed,                                                                          \
+                        memory_order_relaxed                                                                           \
+                    )) {                                                                                               \
+                    break;                                                                                             \
+                }                                                                                                      \
+            } else if (R_UNIQUE(_pop_dif) < 0) {                                                                       \
+                R_UNIQUE(_pop_slot) = nullptr;                                                                         \
+                break;                                                                                                 \
+            } else {                                                                                                   \
+                R_UNIQUE(_pop_pos) = atomic_load_explicit(&(q)->head, memory_order_relaxed);                           \
+            }                                                                                                          \
+        }                                                                                                              \
+        if (R_UNIQUE(_pop_slot) != nullptr) {                                                                          \
+            R_UNIQUE(_pop_item) = R_UNIQUE(_pop_slot)->data;                                                           \
+            atomic_store_explicit(                                                                                     \
+                &R_UNIQUE(_pop_slot)->seq, R_UNIQUE(_pop_pos) + (q)->mask + 1, memory_order_release                    \
+            );                                                                                                         \
+        } else {                                                                                                       \
+            err_set(R_ERR_QUEUE_EMPTY, nullptr);                                                                       \
+            R_TRACE_ADD(R_TRACE_MPMC_EMPTY, 1);                                                                        \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_pop_item);                                                                              \
+    })
+
+#endif // RUNE_MPMC_API
+
+// Type definition and implementation
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef T
+
+typedef struct {
+    R_Atomic(size_t) seq;
+    T data;
+} MPMC_SLOT(T);
+
+// head (consumers) and tail (producers) sit on separate cache lines so the two sides don't false-share
+typedef struct {
+    MPMC_SLOT(T) * slots;
+    size_t mask;
+    char R_(mpmc_pad0)[R_CACHE_LINE - 2 * sizeof(size_t)];
+    R_Atomic(size_t) head;
+    char R_(mpmc_pad1)[R_CACHE_LINE - sizeof(size_t)];
+    R_Atomic(size_t) tail;
+    char R_(mpmc_pad2)[R_CACHE_LINE - sizeof(size_t)];
+} MPMC(T);
+
+// Capacity is rounded up to a power of two (at least 2); all of it is usable
+[[maybe_unused]]
+static MPMC(T) R_MPMC_OF(T)(size_t capacity, const T * items, size_t count) {
+    size_t slots = 2;
+    while (slots < capacity) {
+        slots <<= 1;
+    }
+    MPMC(T) q = {.slots = mem_alloc(slots * sizeof(MPMC_SLOT(T))), .mask = slots - 1, .head = 0, .tail = 0};
+    for (size_t i = 0; i < slots; i++) {
+        atomic_init(&q.slots[i].seq, i);
+        q.slots[i].data = (T){0};
+    }
+    for (size_t i = 0; i < count && i < slots; i++) {
+        mpmc_push(&q, items[i]);
+    }
+    return q;
+}
+
+#endif // T
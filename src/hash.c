@@ -1,5 +1,5 @@
 /*
- * Hash module implementation - MurmurHash variants.
+ * Hash module implementation - MurmurHash variants and xxHash64.
  *
  * Based on the public domain MurmurHash implementations by Austin Appleby.
  * https://github.com/aappleby/smhasher
@@ -10,6 +10,24 @@
 
 #include <string.h>
 
+// Batch hashing instruction set, selected at compile time (RCFG__HASH_NO_SIMD forces the scalar path)
+#if !defined(RCFG__HASH_NO_SIMD) && defined(__AVX512F__) && defined(__AVX512DQ__)
+#define R_HASH_AVX512
+#include <immintrin.h>
+#elif !defined(RCFG__HASH_NO_SIMD) && defined(__AVX2__)
+#define R_HASH_AVX2
+#include <immintrin.h>
+#endif
+
+// CRC32C instruction, selected at compile time (-msse4.2, -march=armv8-a+crc); RCFG__HASH_NO_SIMD forces the table
+#if !defined(RCFG__HASH_NO_SIMD) && defined(__SSE4_2__) && (defined(__x86_64__) || defined(_M_X64))
+#define R_HASH_CRC_SSE42
+#include <nmmintrin.h>
+#elif !defined(RCFG__HASH_NO_SIMD) && defined(__ARM_FEATURE_CRC32) && defined(__aarch64__)
+#define R_HASH_CRC_ARM
+#include <arm_acle.h>
+#endif
+
 // =====================================================================================================================
 // Internal: Rotation and mixing helpers
 // =====================================================================================================================
@@ -211,34 +229,26 @@ extern uint64_t murmur64(const void * data, size_t size, uint64_t seed) {
 // Public API: MurmurHash3 128-bit (x64)
 // =====================================================================================================================
 
-extern hash128_t murmur128(const void * data, size_t size, uint64_t seed) {
-    const uint8_t * bytes = (const uint8_t *)data;
-    const size_t nblocks = size / 16;
-
-    uint64_t h1 = seed;
-    uint64_t h2 = seed;
-
-    // Body: process 16-byte blocks
-    const uint8_t * blocks = bytes;
-    for (size_t i = 0; i < nblocks; i++) {
-        uint64_t k1 = read_u64(blocks + i * 16);
-        uint64_t k2 = read_u64(blocks + i * 16 + 8);
-
-        k1 = m3_128_mix_k1(k1);
-        h1 ^= k1;
-        h1 = rotl64(h1, 27);
-        h1 += h2;
-        h1 = h1 * 5 + 0x52DCE729;
-
-        k2 = m3_128_mix_k2(k2);
-        h2 ^= k2;
-        h2 = rotl64(h2, 31);
-        h2 += h1;
-        h2 = h2 * 5 + 0x38495AB5;
-    }
+// One 16-byte block into (h1, h2)
+static void m3_128_block(uint64_t * h1, uint64_t * h2, const uint8_t * block) {
+    uint64_t k1 = read_u64(block);
+    uint64_t k2 = read_u64(block + 8);
+
+    k1 = m3_128_mix_k1(k1);
+    *h1 ^= k1;
+    *h1 = rotl64(*h1, 27);
+    *h1 += *h2;
+    *h1 = *h1 * 5 + 0x52DCE729;
+
+    k2 = m3_128_mix_k2(k2);
+    *h2 ^= k2;
+    *h2 = rotl64(*h2, 31);
+    *h2 += *h1;
+    *h2 = *h2 * 5 + 0x38495AB5;
+}
 
-    // Tail: process remaining bytes
-    const uint8_t * tail = bytes + nblocks * 16;
+// Final 0-15 bytes and length mixing; size is the total number of bytes hashed
+static hash128_t m3_128_finish(uint64_t h1, uint64_t h2, const uint8_t * tail, const size_t size) {
     uint64_t k1 = 0;
     uint64_t k2 = 0;
 
@@ -311,13 +321,62 @@ extern hash128_t murmur128(const void * data, size_t size, uint64_t seed) {
     return (hash128_t){.h1 = h1, .h2 = h2};
 }
 
+extern hash128_t murmur128(const void * data, size_t size, uint64_t seed) {
+    const uint8_t * bytes = (const uint8_t *)data;
+    const size_t nblocks = size / 16;
+
+    uint64_t h1 = seed;
+    uint64_t h2 = seed;
+
+    // Body: process 16-byte blocks
+    for (size_t i = 0; i < nblocks; i++) {
+        m3_128_block(&h1, &h2, bytes + i * 16);
+    }
+
+    // Tail: process remaining bytes
+    return m3_128_finish(h1, h2, bytes + nblocks * 16, size);
+}
+
+extern void murmur128_init(murmur128_state * state, const uint64_t seed) {
+    *state = (murmur128_state){.h1 = seed, .h2 = seed};
+}
+
+extern void murmur128_update(murmur128_state * state, const void * data, size_t size) {
+    const uint8_t * bytes = (const uint8_t *)data;
+    state->total += size;
+
+    // Complete a block left over from the previous update
+    if (state->buf_len > 0) {
+        const size_t fill = size < 16 - state->buf_len ? size : 16 - state->buf_len;
+        memcpy(state->buf + state->buf_len, bytes, fill);
+        state->buf_len += fill;
+        bytes += fill;
+        size -= fill;
+        if (state->buf_len < 16)
+            return;
+        m3_128_block(&state->h1, &state->h2, state->buf);
+        state->buf_len = 0;
+    }
+
+    for (; size >= 16; bytes += 16, size -= 16) {
+        m3_128_block(&state->h1, &state->h2, bytes);
+    }
+
+    memcpy(state->buf, bytes, size);
+    state->buf_len = size;
+}
+
+extern hash128_t murmur128_final(const murmur128_state * state) {
+    return m3_128_finish(state->h1, state->h2, state->buf, (size_t)state->total);
+}
+
 // =====================================================================================================================
 // Public API: xxHash64
 // =====================================================================================================================
 
 // xxHash64 prime constants
 static constexpr uint64_t XX64_PRIME1 = 11400714785074694791ULL;
-static constexpr uint64_t XX64_PRIME2 = 14029467366386228027ULL;
+static constexpr uint64_t XX64_PRIME2 = 14029467366897019727ULL;
 static constexpr uint64_t XX64_PRIME3 = 1609587929392839161ULL;
 static constexpr uint64_t XX64_PRIME4 = 9650029242287828579ULL;
 static constexpr uint64_t XX64_PRIME5 = 2870177450012600261ULL;
@@ -338,45 +397,41 @@ static uint64_t xx64_avalanche(uint64_t h64) {
     return h64;
 }
 
-extern uint64_t xxhash64(const void * data, size_t size, uint64_t seed) {
-    const uint8_t * bytes = (const uint8_t *)data;
-    uint64_t h64;
-
-    // Process by 8-byte blocks if we have enough data
-    if (size >= 32) {
-        const uint8_t * start = bytes;
-        const uint8_t * limit = bytes + size - 32;
-        uint64_t v1 = seed + XX64_PRIME1 + XX64_PRIME2;
-        uint64_t v2 = seed + XX64_PRIME2;
-        uint64_t v3 = seed;
-        uint64_t v4 = seed - XX64_PRIME1;
-
-        do {
-            v1 = xx64_round(v1, read_u64(bytes));
-            v2 = xx64_round(v2, read_u64(bytes + 8));
-            v3 = xx64_round(v3, read_u64(bytes + 16));
-            v4 = xx64_round(v4, read_u64(bytes + 24));
-            bytes += 32;
-        } while (bytes <= limit);
+static uint64_t xx64_merge(uint64_t h64, const uint64_t v) {
+    return (h64 ^ xx64_round(0, v)) * XX64_PRIME1 + XX64_PRIME4;
+}
 
-        h64 = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+// One 32-byte stripe into the four lanes
+static void xx64_stripe(uint64_t v[4], const uint8_t * p) {
+    v[0] = xx64_round(v[0], read_u64(p));
+    v[1] = xx64_round(v[1], read_u64(p + 8));
+    v[2] = xx64_round(v[2], read_u64(p + 16));
+    v[3] = xx64_round(v[3], read_u64(p + 24));
+}
 
-        h64 = (h64 ^ xx64_round(0, v1)) * XX64_PRIME1 + XX64_PRIME4;
-        h64 = (h64 ^ xx64_round(0, v2)) * XX64_PRIME1 + XX64_PRIME4;
-        h64 = (h64 ^ xx64_round(0, v3)) * XX64_PRIME1 + XX64_PRIME4;
-        h64 = (h64 ^ xx64_round(0, v4)) * XX64_PRIME1 + XX64_PRIME4;
+static void xx64_lanes_init(uint64_t v[4], const uint64_t seed) {
+    v[0] = seed + XX64_PRIME1 + XX64_PRIME2;
+    v[1] = seed + XX64_PRIME2;
+    v[2] = seed;
+    v[3] = seed - XX64_PRIME1;
+}
 
-        size -= (bytes - start);
-    } else {
-        h64 = seed + XX64_PRIME5;
-    }
+static uint64_t xx64_converge(const uint64_t v[4]) {
+    uint64_t h64 = rotl64(v[0], 1) + rotl64(v[1], 7) + rotl64(v[2], 12) + rotl64(v[3], 18);
+    h64 = xx64_merge(h64, v[0]);
+    h64 = xx64_merge(h64, v[1]);
+    h64 = xx64_merge(h64, v[2]);
+    h64 = xx64_merge(h64, v[3]);
+    return h64;
+}
 
-    h64 += (uint64_t)size;
+// Total length, the final 0-31 bytes and the avalanche
+static uint64_t xx64_finish(uint64_t h64, const uint64_t total, const uint8_t * bytes, size_t size) {
+    h64 += total;
 
     // Process remaining 8-byte blocks
     while (size >= 8) {
-        uint64_t k1 = read_u64(bytes);
-        h64 ^= xx64_round(0, k1);
+        h64 ^= xx64_round(0, read_u64(bytes));
         h64 = rotl64(h64, 27) * XX64_PRIME1 + XX64_PRIME4;
         bytes += 8;
         size -= 8;
@@ -400,3 +455,239 @@ extern uint64_t xxhash64(const void * data, size_t size, uint64_t seed) {
 
     return xx64_avalanche(h64);
 }
+
+extern uint64_t xxhash64(const void * data, size_t size, uint64_t seed) {
+    const uint8_t * bytes = (const uint8_t *)data;
+    const size_t total = size;
+    uint64_t h64;
+
+    // Process 32-byte stripes in four independent lanes if we have enough data
+    if (size >= 32) {
+        uint64_t v[4];
+        xx64_lanes_init(v, seed);
+        do {
+            xx64_stripe(v, bytes);
+            bytes += 32;
+            size -= 32;
+        } while (size >= 32);
+        h64 = xx64_converge(v);
+    } else {
+        h64 = seed + XX64_PRIME5;
+    }
+
+    return xx64_finish(h64, total, bytes, size);
+}
+
+extern void xxhash64_init(xxhash64_state * state, const uint64_t seed) {
+    *state = (xxhash64_state){.seed = seed};
+    xx64_lanes_init(state->v, seed);
+}
+
+extern void xxhash64_update(xxhash64_state * state, const void * data, size_t size) {
+    const uint8_t * bytes = (const uint8_t *)data;
+    state->total += size;
+
+    // Complete a stripe left over from the previous update
+    if (state->buf_len > 0) {
+        const size_t fill = size < 32 - state->buf_len ? size : 32 - state->buf_len;
+        memcpy(state->buf + state->buf_len, bytes, fill);
+        state->buf_len += fill;
+        bytes += fill;
+        size -= fill;
+        if (state->buf_len < 32)
+            return;
+        xx64_stripe(state->v, state->buf);
+        state->buf_len = 0;
+    }
+
+    for (; size >= 32; bytes += 32, size -= 32) {
+        xx64_stripe(state->v, bytes);
+    }
+
+    memcpy(state->buf, bytes, size);
+    state->buf_len = size;
+}
+
+extern uint64_t xxhash64_final(const xxhash64_state * state) {
+    const uint64_t h64 = state->total >= 32 ? xx64_converge(state->v) : state->seed + XX64_PRIME5;
+    return xx64_finish(h64, state->total, state->buf, state->buf_len);
+}
+
+// =====================================================================================================================
+// Public API: Batch hashing
+// =====================================================================================================================
+
+// xxHash64 of a key shorter than one stripe (inlined so that the batch loop interleaves several of them)
+static inline uint64_t xx64_short(const uint8_t * bytes, const size_t size, const uint64_t seed) {
+    return xx64_finish(seed + XX64_PRIME5, size, bytes, size);
+}
+
+extern void hash64_batch(const void * const * keys, const size_t * lens, const size_t n, uint64_t * out) {
+    // Four independent chains per iteration keep the multipliers busy while each waits on its previous product
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        if ((lens[i] | lens[i + 1] | lens[i + 2] | lens[i + 3]) < 32) {
+            const uint64_t h0 = xx64_short(keys[i], lens[i], R_HASH_DEFAULT_SEED);
+            const uint64_t h1 = xx64_short(keys[i + 1], lens[i + 1], R_HASH_DEFAULT_SEED);
+            const uint64_t h2 = xx64_short(keys[i + 2], lens[i + 2], R_HASH_DEFAULT_SEED);
+            const uint64_t h3 = xx64_short(keys[i + 3], lens[i + 3], R_HASH_DEFAULT_SEED);
+            out[i] = h0;
+            out[i + 1] = h1;
+            out[i + 2] = h2;
+            out[i + 3] = h3;
+        } else {
+            for (size_t j = i; j < i + 4; j++) {
+                out[j] = xxhash64(keys[j], lens[j], R_HASH_DEFAULT_SEED);
+            }
+        }
+    }
+    for (; i < n; i++) {
+        out[i] = xxhash64(keys[i], lens[i], R_HASH_DEFAULT_SEED);
+    }
+}
+
+#if defined(R_HASH_AVX2)
+// 64-bit lane multiply by a constant from 32-bit partial products (AVX2 has no 64-bit mullo)
+static inline __m256i hash_mul64_avx2(const __m256i a, const uint64_t c) {
+    const __m256i b = _mm256_set1_epi64x((long long)c);
+    const __m256i b_hi = _mm256_set1_epi64x((long long)(c >> 32));
+    const __m256i lo = _mm256_mul_epu32(a, b);
+    const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b), _mm256_mul_epu32(a, b_hi));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+static inline __m256i hash_mix_avx2(__m256i x) {
+    x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+    x = hash_mul64_avx2(x, 0xFF51AFD7ED558CCDULL);
+    x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+    x = hash_mul64_avx2(x, 0xC4CEB9FE1A85EC53ULL);
+    x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+    return x;
+}
+#endif
+
+#if defined(R_HASH_AVX512)
+static inline __m512i hash_mix_avx512(__m512i x) {
+    x = _mm512_xor_si512(x, _mm512_srli_epi64(x, 33));
+    x = _mm512_mullo_epi64(x, _mm512_set1_epi64((long long)0xFF51AFD7ED558CCDULL));
+    x = _mm512_xor_si512(x, _mm512_srli_epi64(x, 33));
+    x = _mm512_mullo_epi64(x, _mm512_set1_epi64((long long)0xC4CEB9FE1A85EC53ULL));
+    x = _mm512_xor_si512(x, _mm512_srli_epi64(x, 33));
+    return x;
+}
+#endif
+
+extern void hash_mix_batch(const uint64_t * keys, const size_t n, uint64_t * out) {
+    size_t i = 0;
+#if defined(R_HASH_AVX512)
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_si512((void *)(out + i), hash_mix_avx512(_mm512_loadu_si512((const void *)(keys + i))));
+    }
+#elif defined(R_HASH_AVX2)
+    for (; i + 4 <= n; i += 4) {
+        const __m256i x = _mm256_loadu_si256((const __m256i *)(const void *)(keys + i));
+        _mm256_storeu_si256((__m256i *)(void *)(out + i), hash_mix_avx2(x));
+    }
+#else
+    // Four independent chains per iteration, as in hash64_batch
+    for (; i + 4 <= n; i += 4) {
+        const uint64_t h0 = hash_mix(keys[i]);
+        const uint64_t h1 = hash_mix(keys[i + 1]);
+        const uint64_t h2 = hash_mix(keys[i + 2]);
+        const uint64_t h3 = hash_mix(keys[i + 3]);
+        out[i] = h0;
+        out[i + 1] = h1;
+        out[i + 2] = h2;
+        out[i + 3] = h3;
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = hash_mix(keys[i]);
+    }
+}
+
+// =====================================================================================================================
+// Public API: CRC32C and CRC-based hashing
+// =====================================================================================================================
+
+#if !defined(R_HASH_CRC_SSE42) && !defined(R_HASH_CRC_ARM)
+// CRC32C (Castagnoli, reflected 0x82F63B78) of one nibble - two lookups per byte for the portable path
+static const uint32_t CRC32C_NIBBLE[16] = {
+    0x00000000, 0x105EC76F, 0x20BD8EDE, 0x30E349B1, 0x417B1DBC, 0x5125DAD3, 0x61C69362, 0x7198540D,
+    0x82F63B78, 0x92A8FC17, 0xA24BB5A6, 0xB21572C9, 0xC38D26C4, 0xD3D3E1AB, 0xE330A81A, 0xF36E6F75,
+};
+#endif
+
+static inline uint32_t crc32c_u8(uint32_t crc, const uint8_t byte) {
+#if defined(R_HASH_CRC_SSE42)
+    return _mm_crc32_u8(crc, byte);
+#elif defined(R_HASH_CRC_ARM)
+    return __crc32cb(crc, byte);
+#else
+    crc ^= byte;
+    crc = (crc >> 4) ^ CRC32C_NIBBLE[crc & 15];
+    crc = (crc >> 4) ^ CRC32C_NIBBLE[crc & 15];
+    return crc;
+#endif
+}
+
+// Raw CRC32C update over the 8 little-endian bytes of v (no pre/post inversion)
+static inline uint32_t crc32c_u64(const uint32_t crc, const uint64_t v) {
+#if defined(R_HASH_CRC_SSE42)
+    return (uint32_t)_mm_crc32_u64(crc, v);
+#elif defined(R_HASH_CRC_ARM)
+    return __crc32cd(crc, v);
+#else
+    uint32_t c = crc;
+    for (int i = 0; i < 8; i++) {
+        c = crc32c_u8(c, (uint8_t)(v >> (8 * i)));
+    }
+    return c;
+#endif
+}
+
+extern uint32_t crc32c(const void * data, size_t size, const uint32_t crc) {
+    const uint8_t * bytes = (const uint8_t *)data;
+    uint32_t c = ~crc;
+    for (; size >= 8; bytes += 8, size -= 8) {
+        c = crc32c_u64(c, read_u64(bytes));
+    }
+    while (size-- > 0) {
+        c = crc32c_u8(c, *bytes++);
+    }
+    return ~c;
+}
+
+extern uint64_t crchash64(const void * data, size_t size, const uint64_t seed) {
+    const uint8_t * bytes = (const uint8_t *)data;
+    const size_t total = size;
+
+    // Two CRC chains see each word untouched and rotated by 32 bits, so they are independent linear maps of the
+    // input; hash_mix then removes the linearity from the combined 64 bits
+    uint32_t lo = (uint32_t)seed;
+    uint32_t hi = (uint32_t)(seed >> 32) ^ 0x9E3779B9u;
+    for (; size >= 16; bytes += 16, size -= 16) {
+        const uint64_t w0 = read_u64(bytes);
+        const uint64_t w1 = read_u64(bytes + 8);
+        lo = crc32c_u64(lo, w0);
+        hi = crc32c_u64(hi, rotl64(w0, 32));
+        lo = crc32c_u64(lo, w1);
+        hi = crc32c_u64(hi, rotl64(w1, 32));
+    }
+    if (size >= 8) {
+        const uint64_t w = read_u64(bytes);
+        lo = crc32c_u64(lo, w);
+        hi = crc32c_u64(hi, rotl64(w, 32));
+        bytes += 8;
+        size -= 8;
+    }
+    if (size > 0) {
+        // Zero-padded tail word; the length below tells "a" from "a\0"
+        uint64_t w = 0;
+        memcpy(&w, bytes, size);
+        lo = crc32c_u64(lo, w);
+        hi = crc32c_u64(hi, rotl64(w, 32));
+    }
+
+    return hash_mix(((uint64_t)hi << 32 | lo) ^ ((uint64_t)total * XX64_PRIME1));
+}
@@ -6,6 +6,8 @@
  *   - MurmurHash2 64-bit hash (64A variant)
  *   - MurmurHash3 128-bit hash optimized for x64
  *   - xxHash64 ultra-fast 64-bit hash
+ *   - CRC32C checksum and a CRC32C-based 64-bit hash (SSE4.2 / ARMv8 CRC instructions when compiled in)
+ *   - Streaming (init/update/final) xxHash64 and MurmurHash3 128-bit with the same digests as the one-shot calls
  *   - Primitive value hashing (integers, floats, doubles)
  *   - Convenience macros for common use cases
  *
@@ -17,10 +19,24 @@
  *   murmur64(data, len, seed)         64-bit MurmurHash2 (64A)
  *   murmur128(data, len, seed)        128-bit MurmurHash3 (x64), returns hash128
  *   xxhash64(data, len, seed)         64-bit xxHash64 (ultra-fast)
+ *   crchash64(data, len, seed)        64-bit CRC32C-based hash (fastest for 8-64 byte keys with hardware CRC)
+ *   crc32c(data, len, crc)            CRC32C checksum (chainable: pass the previous result, 0 to start)
  *   hash32(data, len)                 32-bit hash with default seed (MurmurHash3)
  *   hash64(data, len)                 64-bit hash with default seed (xxHash64)
  *   hash128(data, len)                128-bit hash with default seed (MurmurHash3)
  *
+ *   Streaming
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   xxhash64_init(state, seed)        Start an incremental xxHash64
+ *   xxhash64_update(state, data, len) Feed the next chunk (any size)
+ *   xxhash64_final(state)             Digest of everything fed so far (state stays usable)
+ *   murmur128_init/update/final       Same for MurmurHash3 128-bit
+ *
+ *   Batch Hashing
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   hash64_batch(keys, lens, n, out)  out[i] = hash64(keys[i], lens[i]), several keys in flight
+ *   hash_mix_batch(keys, n, out)      out[i] = hash_mix(keys[i]), AVX-512/AVX2 lanes when available
+ *
  *   Value Hashing
  *   -------------------------------------------------------------------------------------------------------------------
  *   hash_mix(x)                       64-bit integer mixing (for ints, longs, pointers)
@@ -30,11 +46,15 @@
  *   Types
  *   -------------------------------------------------------------------------------------------------------------------
  *   hash128_t                         128-bit hash result (two uint64_t values)
+ *   xxhash64_state                    Incremental xxHash64 state
+ *   murmur128_state                   Incremental MurmurHash3 128-bit state
  *
  * Performance Notes:
  *   - xxHash64 is fastest for large buffers (1KB+), especially on 64-bit systems
  *   - MurmurHash64 offers good balance across all sizes
  *   - MurmurHash128 best for fingerprinting and collision-sensitive use
+ *   - crchash64 spends two crc32 instructions per 8 bytes; it is only fast when built with -msse4.2 or
+ *     -march=armv8-a+crc (the portable table path gives identical digests, much slower)
  *   - Primitive hashing uses inline bit mixing with zero function call overhead
  *
  * Example:
@@ -45,6 +65,12 @@
  *   uint64_t hxx = xxhash64(key, 5, 42);          // xxHash64 with custom seed
  *   hash128_t h128 = hash128(key, 5);             // MurmurHash3 128-bit
  *
+ *   // Streaming: equals xxhash64(whole, total, 0)
+ *   xxhash64_state st;
+ *   xxhash64_init(&st, 0);
+ *   while ((n = read(fd, buf, sizeof(buf))) > 0) xxhash64_update(&st, buf, n);
+ *   uint64_t digest = xxhash64_final(&st);
+ *
  *   // Value hashing
  *   uint64_t hi = hash_mix(42);
  *   uint64_t hf = hash_float(3.14f);
@@ -97,6 +123,29 @@ typedef struct {
     uint64_t h2;
 } hash128_t;
 
+// ------------------------------------------------- Streaming states --------------------------------------------------
+
+/**
+ * Incremental hash states. Chunks may have any size; input is buffered only up to one stripe (32 bytes for
+ * xxHash64, 16 for MurmurHash3), so the final digest equals the one-shot hash of the concatenated chunks.
+ * MurmurHash2 64A (murmur64) mixes the total length in before the first block and cannot be streamed.
+ */
+typedef struct {
+    uint64_t v[4];
+    uint64_t total;
+    uint64_t seed;
+    uint8_t buf[32];
+    size_t buf_len;
+} xxhash64_state;
+
+typedef struct {
+    uint64_t h1;
+    uint64_t h2;
+    uint64_t total;
+    uint8_t buf[16];
+    size_t buf_len;
+} murmur128_state;
+
 /*
  * =====================================================================================================================
  * HASHING FUNCTIONS
@@ -109,6 +158,28 @@ extern uint32_t murmur32(const void * data, size_t size, uint32_t seed);
 extern uint64_t murmur64(const void * data, size_t size, uint64_t seed);
 extern hash128_t murmur128(const void * data, size_t size, uint64_t seed);
 extern uint64_t xxhash64(const void * data, size_t size, uint64_t seed);
+extern uint64_t crchash64(const void * data, size_t size, uint64_t seed);
+extern uint32_t crc32c(const void * data, size_t size, uint32_t crc);
+
+// ------------------------------------------------- Streaming hashing -------------------------------------------------
+
+extern void xxhash64_init(xxhash64_state * state, uint64_t seed);
+extern void xxhash64_update(xxhash64_state * state, const void * data, size_t size);
+extern uint64_t xxhash64_final(const xxhash64_state * state);
+
+extern void murmur128_init(murmur128_state * state, uint64_t seed);
+extern void murmur128_update(murmur128_state * state, const void * data, size_t size);
+extern hash128_t murmur128_final(const murmur128_state * state);
+
+// -------------------------------------------------- Batch hashing ----------------------------------------------------
+
+/**
+ * Hash many independent keys per call. Results equal the single-key functions; the batch form interleaves the
+ * keys' dependency chains (and uses SIMD lanes for hash_mix_batch) so multiply latency overlaps across keys.
+ * out may alias keys for hash_mix_batch.
+ */
+extern void hash64_batch(const void * const * keys, const size_t * lens, size_t n, uint64_t * out);
+extern void hash_mix_batch(const uint64_t * keys, size_t n, uint64_t * out);
 
 // ------------------------------------------------ Convenience macros -------------------------------------------------
 
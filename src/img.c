@@ -0,0 +1,565 @@
+/*
+ * Image module implementation - writer buffers, layout and checksum, and the mmap-based reader.
+ *
+ * Layout (every offset is from the start of the image):
+ *
+ *   header            128 bytes (r_img_header)
+ *   section table     section_count r_img_section entries
+ *   sections          each at a multiple of R_IMG_ALIGN, in the order they were added
+ *   strings           placed managed strings (str_place), each at a multiple of the string header's alignment
+ *   string index      index_cap img_ref slots (a power of two, at most half full, 0 = empty), probed linearly from
+ *                     the string's hash
+ *
+ * Padding between the parts is zero, so the image only depends on what was added. The checksum covers everything
+ * after the header.
+ */
+
+#include "img.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hash.h"
+
+// =====================================================================================================================
+// Internal: Image header
+// =====================================================================================================================
+
+static const char R_IMG_MAGIC[8] = "RUNEIMG";
+static constexpr uint32_t R_IMG_VERSION = 2; // 2: placed strings carry their UTF-8 state
+static constexpr uint32_t R_IMG_BYTE_ORDER = 0x01020304;
+
+// Header flags: build settings that change the stored bytes
+static constexpr uint32_t R_IMG_FLAG_STR_BLOCK_HASH = 1;
+
+typedef struct {
+    char magic[8];          // R_IMG_MAGIC
+    uint32_t version;       // R_IMG_VERSION
+    uint32_t byte_order;    // R_IMG_BYTE_ORDER as written (detects the other byte order)
+    uint32_t word_size;     // sizeof(size_t) (map and string headers hold size_t fields)
+    uint32_t flags;         // R_IMG_FLAG_*
+    uint64_t hash_seed;     // R_HASH_DEFAULT_SEED (map sections are laid out by the default hashes)
+    uint64_t size;          // total size of the image
+    uint32_t crc;           // crc32c of bytes [sizeof(r_img_header), size)
+    uint32_t section_count; // entries in the section table
+    uint64_t strings;       // offset of the string section
+    uint64_t strings_len;   // bytes in the string section
+    uint64_t string_count;  // strings in the string section
+    uint64_t index;         // offset of the string index
+    uint64_t index_cap;     // slots in the string index
+    uint8_t reserved[40];   // zero
+} r_img_header;
+
+static_assert(sizeof(r_img_header) == 128, "image header layout");
+static_assert(sizeof(r_img_section) == 64, "image section layout");
+
+static uint32_t img_flags(void) {
+    return R_STR_BLOCK_HASH ? R_IMG_FLAG_STR_BLOCK_HASH : 0;
+}
+
+static bool img_pow2(const uint64_t n) {
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+// =====================================================================================================================
+// Internal: Writer structure
+// =====================================================================================================================
+
+typedef struct {
+    r_img_section head; // offset is assigned by img_write
+    uint8_t * data;
+    size_t bytes;
+} r_img_pending;
+
+struct r_img_writer {
+    allocator alloc;        // allocator current at img_writer_new
+    r_img_pending * sections;
+    size_t section_count;
+    size_t section_cap;
+    uint8_t * strings;      // string section as written
+    size_t strings_len;
+    size_t strings_cap;
+    size_t string_count;
+    img_ref * index;        // string index as written
+    size_t index_cap;
+};
+
+// Bytes a section's data occupies, or SIZE_MAX if it cannot be represented
+static size_t img_section_bytes(
+    const r_img_kind kind, const uint64_t elem_size, const uint64_t count, const uint64_t capacity
+) {
+    const uint64_t slots = kind == R_IMG_MAP ? capacity : count;
+    if (elem_size > 0 && slots > (SIZE_MAX - R_IMG_ALIGN * 2) / elem_size)
+        return SIZE_MAX;
+    const size_t ctrl = kind == R_IMG_MAP ? R_IMG_MAP_CTRL_SIZE((size_t)capacity) : 0;
+    return ctrl + (size_t)(slots * elem_size);
+}
+
+// Slot holding s in an index, else the empty slot where it would go (cap if the index is full, which only a corrupt
+// image can cause)
+static size_t img_index_slot(
+    const img_ref * index, const size_t cap, const uint8_t * strings, const size_t strings_len, const strview s,
+    const uint64_t hash
+) {
+    size_t i = hash & (cap - 1);
+    for (size_t probes = 0; probes < cap && index[i] != 0; probes++) {
+        const char * placed = str_placed(strings, strings_len, index[i]);
+        if (placed != nullptr && R_(str_eq)(R_(str_view)(placed, &R_IMG_STR_OPT), s, &R_IMG_STR_OPT))
+            return i;
+        i = (i + 1) & (cap - 1);
+    }
+    return index[i] == 0 ? i : cap;
+}
+
+// Double the string index (first allocation: 16 slots), reinserting every reference
+static bool img_index_grow(img_writer * w) {
+    const size_t cap = w->index_cap == 0 ? 16 : w->index_cap * 2;
+    img_ref * index = mem_alloc(cap * sizeof(img_ref));
+    if (index == nullptr) {
+        err_set(R_ERR_ALLOC_FAILED, nullptr);
+        return false;
+    }
+    memset(index, 0, cap * sizeof(img_ref));
+    for (size_t i = 0; i < w->index_cap; i++) {
+        const img_ref ref = w->index[i];
+        if (ref == 0)
+            continue;
+        const strview placed = R_(str_view)((const char *)w->strings + ref, &R_IMG_STR_OPT);
+        size_t j = R_(str_hash)(placed, &R_IMG_STR_OPT) & (cap - 1);
+        while (index[j] != 0)
+            j = (j + 1) & (cap - 1);
+        index[j] = ref;
+    }
+    if (w->index != nullptr)
+        mem_free(w->index, w->index_cap * sizeof(img_ref));
+    w->index = index;
+    w->index_cap = cap;
+    return true;
+}
+
+// =====================================================================================================================
+// Public API: Writer
+// =====================================================================================================================
+
+extern img_writer * img_writer_new(void) {
+    img_writer * w = mem_alloc(sizeof(img_writer));
+    if (w == nullptr) {
+        err_set(R_ERR_ALLOC_FAILED, nullptr);
+        return nullptr;
+    }
+    *w = (img_writer){.alloc = alloc_current()};
+    return w;
+}
+
+extern void img_writer_free(img_writer * w) {
+    if (w == nullptr)
+        return;
+
+    alloc_push(w->alloc);
+    for (size_t i = 0; i < w->section_count; i++)
+        mem_free(w->sections[i].data, w->sections[i].bytes > 0 ? w->sections[i].bytes : 1);
+    if (w->sections != nullptr)
+        mem_free(w->sections, w->section_cap * sizeof(r_img_pending));
+    if (w->strings != nullptr)
+        mem_free(w->strings, w->strings_cap);
+    if (w->index != nullptr)
+        mem_free(w->index, w->index_cap * sizeof(img_ref));
+    mem_free(w, sizeof(img_writer));
+    alloc_pop();
+}
+
+extern void * R_(img_reserve)(
+    img_writer * w, const char * name, const r_img_kind kind, const size_t elem_size, const size_t count,
+    const size_t capacity, const size_t bytes
+) {
+    if (err_null(w) || err_null(name))
+        return nullptr;
+    if (strnlen(name, R_IMG_NAME_MAX) >= R_IMG_NAME_MAX) {
+        err_set(R_ERR_LENGTH_EXCEEDED, "image section name too long");
+        return nullptr;
+    }
+    if (name[0] == '\0' || elem_size == 0 || elem_size > UINT32_MAX ||
+        (kind == R_IMG_MAP && ((capacity != 0 && !img_pow2(capacity)) || count > capacity)) ||
+        img_section_bytes(kind, elem_size, count, capacity) != bytes) {
+        err_set(R_ERR_INVALID_ARGUMENT, "invalid image section");
+        return nullptr;
+    }
+    for (size_t i = 0; i < w->section_count; i++) {
+        if (strcmp(w->sections[i].head.name, name) == 0) {
+            err_set(R_ERR_INVALID_ARGUMENT, "duplicate image section name");
+            return nullptr;
+        }
+    }
+
+    alloc_push(w->alloc);
+    if (w->section_count == w->section_cap) {
+        const size_t cap = w->section_cap == 0 ? 8 : w->section_cap * 2;
+        r_img_pending * sections = w->sections == nullptr
+            ? mem_alloc(cap * sizeof(r_img_pending))
+            : mem_realloc(w->sections, w->section_cap * sizeof(r_img_pending), cap * sizeof(r_img_pending));
+        if (sections == nullptr) {
+            alloc_pop();
+            err_set(R_ERR_ALLOC_FAILED, nullptr);
+            return nullptr;
+        }
+        w->sections = sections;
+        w->section_cap = cap;
+    }
+    uint8_t * data = mem_alloc(bytes > 0 ? bytes : 1);
+    alloc_pop();
+    if (data == nullptr) {
+        err_set(R_ERR_ALLOC_FAILED, nullptr);
+        return nullptr;
+    }
+    memset(data, 0, bytes > 0 ? bytes : 1);
+
+    r_img_pending * p = &w->sections[w->section_count++];
+    *p = (r_img_pending){
+        .head = {.kind = kind, .elem_size = (uint32_t)elem_size, .count = count, .capacity = capacity},
+        .data = data,
+        .bytes = bytes,
+    };
+    strcpy(p->head.name, name);
+    return data;
+}
+
+extern bool R_(img_add)(
+    img_writer * w, const char * name, const r_img_kind kind, const void * data, const size_t elem_size,
+    const size_t count
+) {
+    if (kind == R_IMG_MAP) {
+        err_set(R_ERR_INVALID_ARGUMENT, "map sections are added with img_add_map");
+        return false;
+    }
+    if (count > 0 && err_null(data))
+        return false;
+    const size_t bytes = img_section_bytes(kind, elem_size, count, 0);
+    void * dst = R_(img_reserve)(w, name, kind, elem_size, count, 0, bytes);
+    if (dst == nullptr)
+        return false;
+    if (bytes > 0)
+        memcpy(dst, data, bytes);
+    return true;
+}
+
+extern img_ref R_(img_add_str)(img_writer * w, const strview s) {
+    if (err_null(w) || (s.len > 0 && err_null(s.data)))
+        return 0;
+
+    const uint64_t hash = R_(str_hash)(s, &R_IMG_STR_OPT);
+    if (w->index_cap > 0) {
+        const size_t slot = img_index_slot(w->index, w->index_cap, w->strings, w->strings_len, s, hash);
+        if (w->index[slot] != 0)
+            return w->index[slot];
+    }
+
+    alloc_push(w->alloc);
+    const size_t need = str_place_size(s.len);
+    if (w->strings_len + need > w->strings_cap) {
+        size_t cap = w->strings_cap == 0 ? 256 : w->strings_cap;
+        while (cap < w->strings_len + need)
+            cap *= 2;
+        uint8_t * strings = w->strings == nullptr ? mem_alloc(cap) : mem_realloc(w->strings, w->strings_cap, cap);
+        if (strings == nullptr) {
+            alloc_pop();
+            err_set(R_ERR_ALLOC_FAILED, nullptr);
+            return 0;
+        }
+        w->strings = strings;
+        w->strings_cap = cap;
+    }
+    // Keep the index at most half full
+    if ((w->string_count + 1) * 2 > w->index_cap && !img_index_grow(w)) {
+        alloc_pop();
+        return 0;
+    }
+    alloc_pop();
+
+    memset(w->strings + w->strings_len, 0, need);
+    const char * placed = str_place(w->strings + w->strings_len, s);
+    const img_ref ref = (img_ref)((const uint8_t *)placed - w->strings);
+    w->strings_len += need;
+    w->string_count++;
+
+    const size_t slot = img_index_slot(w->index, w->index_cap, w->strings, w->strings_len, s, hash);
+    w->index[slot] = ref;
+    return ref;
+}
+
+// Write bytes, or fold them into *crc when stream is nullptr
+static bool img_emit(FILE * stream, uint32_t * crc, const void * data, const size_t len) {
+    if (len == 0)
+        return true;
+    if (stream == nullptr) {
+        *crc = crc32c(data, len, *crc);
+        return true;
+    }
+    if (fwrite(data, 1, len, stream) != len) {
+        err_set(R_ERR_FORMAT_FAILED, "image write failed");
+        return false;
+    }
+    return true;
+}
+
+// Zero bytes up to the next multiple of align
+static bool img_emit_pad(FILE * stream, uint32_t * crc, size_t * at, const size_t align) {
+    static const uint8_t zeros[R_IMG_ALIGN] = {0};
+    const size_t pad = (align - *at % align) % align;
+    *at += pad;
+    return img_emit(stream, crc, zeros, pad);
+}
+
+// Everything after the header: first with stream == nullptr for the checksum, then for real
+static bool img_emit_body(const img_writer * w, const r_img_header * h, FILE * stream, uint32_t * crc) {
+    size_t at = sizeof(r_img_header);
+    size_t offset = R_IMG_ALIGN_UP(sizeof(r_img_header) + w->section_count * sizeof(r_img_section));
+    for (size_t i = 0; i < w->section_count; i++) {
+        r_img_section head = w->sections[i].head;
+        head.offset = offset;
+        offset += R_IMG_ALIGN_UP(w->sections[i].bytes);
+        if (!img_emit(stream, crc, &head, sizeof(head)))
+            return false;
+        at += sizeof(head);
+    }
+    for (size_t i = 0; i < w->section_count; i++) {
+        if (!img_emit_pad(stream, crc, &at, R_IMG_ALIGN) ||
+            !img_emit(stream, crc, w->sections[i].data, w->sections[i].bytes))
+            return false;
+        at += w->sections[i].bytes;
+    }
+    if (!img_emit_pad(stream, crc, &at, R_IMG_ALIGN) || !img_emit(stream, crc, w->strings, w->strings_len))
+        return false;
+    at += w->strings_len;
+    if (!img_emit_pad(stream, crc, &at, R_IMG_ALIGN) ||
+        !img_emit(stream, crc, w->index, w->index_cap * sizeof(img_ref)))
+        return false;
+    at += w->index_cap * sizeof(img_ref);
+    return at == h->size;
+}
+
+extern bool img_write(const img_writer * w, FILE * stream) {
+    if (err_null(w) || err_null(stream))
+        return false;
+
+    size_t offset = R_IMG_ALIGN_UP(sizeof(r_img_header) + w->section_count * sizeof(r_img_section));
+    for (size_t i = 0; i < w->section_count; i++)
+        offset += R_IMG_ALIGN_UP(w->sections[i].bytes);
+    const size_t strings = offset;
+    const size_t index = R_IMG_ALIGN_UP(strings + w->strings_len);
+
+    r_img_header h = {
+        .version = R_IMG_VERSION,
+        .byte_order = R_IMG_BYTE_ORDER,
+        .word_size = sizeof(size_t),
+        .flags = img_flags(),
+        .hash_seed = R_HASH_DEFAULT_SEED,
+        .size = index + w->index_cap * sizeof(img_ref),
+        .section_count = (uint32_t)w->section_count,
+        .strings = strings,
+        .strings_len = w->strings_len,
+        .string_count = w->string_count,
+        .index = index,
+        .index_cap = w->index_cap,
+    };
+    memcpy(h.magic, R_IMG_MAGIC, sizeof(h.magic));
+
+    uint32_t crc = 0;
+    if (!img_emit_body(w, &h, nullptr, &crc))
+        return false;
+    h.crc = crc;
+    return img_emit(stream, &crc, &h, sizeof(h)) && img_emit_body(w, &h, stream, &crc);
+}
+
+// =====================================================================================================================
+// Internal: Reader structure
+// =====================================================================================================================
+
+struct r_img {
+    allocator alloc;          // allocator current when the image was opened
+    const uint8_t * data;
+    size_t size;
+    bool mapped;              // data is an mmap of the file (img_open), otherwise borrowed (img_from)
+    const r_img_header * header;
+    const r_img_section * sections;
+};
+
+// Check the header and that every part lies inside the image
+static bool img_validate(const uint8_t * data, const size_t size) {
+    if (size < sizeof(r_img_header))
+        return false;
+    const r_img_header * h = (const r_img_header *)data;
+    if (memcmp(h->magic, R_IMG_MAGIC, sizeof(h->magic)) != 0 || h->version != R_IMG_VERSION ||
+        h->byte_order != R_IMG_BYTE_ORDER || h->word_size != sizeof(size_t) || h->flags != img_flags() ||
+        h->hash_seed != R_HASH_DEFAULT_SEED || h->size != size)
+        return false;
+    if (h->section_count > (size - sizeof(r_img_header)) / sizeof(r_img_section))
+        return false;
+
+    const r_img_section * sections = (const r_img_section *)(data + sizeof(r_img_header));
+    for (size_t i = 0; i < h->section_count; i++) {
+        const r_img_section * s = &sections[i];
+        if (memchr(s->name, '\0', sizeof(s->name)) == nullptr || s->offset % R_IMG_ALIGN != 0 || s->elem_size == 0)
+            return false;
+        if (s->kind != R_IMG_LIST && s->kind != R_IMG_TREE && s->kind != R_IMG_MAP)
+            return false;
+        if (s->kind == R_IMG_MAP ? (s->capacity != 0 && !img_pow2(s->capacity)) || s->count > s->capacity
+                                 : s->capacity != 0)
+            return false;
+        const size_t bytes = img_section_bytes(s->kind, s->elem_size, s->count, s->capacity);
+        if (bytes == SIZE_MAX || s->offset > size || bytes > size - s->offset)
+            return false;
+    }
+
+    if (h->strings > size || h->strings_len > size - h->strings)
+        return false;
+    if (h->index_cap != 0 && (!img_pow2(h->index_cap) || h->index % sizeof(img_ref) != 0 || h->index > size ||
+                              h->index_cap > (size - h->index) / sizeof(img_ref)))
+        return false;
+    return true;
+}
+
+static img * img_load(const uint8_t * data, const size_t size, const bool mapped) {
+    if (!img_validate(data, size)) {
+        err_set(R_ERR_PARSE_FAILED, "not an image, corrupt, or written by an incompatible build");
+        return nullptr;
+    }
+    img * im = mem_alloc(sizeof(img));
+    if (im == nullptr) {
+        err_set(R_ERR_ALLOC_FAILED, nullptr);
+        return nullptr;
+    }
+    *im = (img){
+        .alloc = alloc_current(),
+        .data = data,
+        .size = size,
+        .mapped = mapped,
+        .header = (const r_img_header *)data,
+        .sections = (const r_img_section *)(data + sizeof(r_img_header)),
+    };
+    return im;
+}
+
+// =====================================================================================================================
+// Public API: Reader
+// =====================================================================================================================
+
+extern img * img_open(const char * path) {
+    if (err_null(path))
+        return nullptr;
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        err_set(R_ERR_NOT_FOUND, "cannot open image file");
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(r_img_header)) {
+        close(fd);
+        err_set(R_ERR_PARSE_FAILED, "not an image");
+        return nullptr;
+    }
+    const size_t size = (size_t)st.st_size;
+    void * data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the file referenced
+    if (data == MAP_FAILED) {
+        err_set(R_ERR_ALLOC_FAILED, "cannot map image file");
+        return nullptr;
+    }
+
+    img * im = img_load(data, size, true);
+    if (im == nullptr)
+        munmap(data, size);
+    return im;
+}
+
+extern img * img_from(const void * data, const size_t size) {
+    if (err_null(data))
+        return nullptr;
+    if ((uintptr_t)data % R_IMG_ALIGN != 0) {
+        err_set(R_ERR_INVALID_ARGUMENT, "image data not aligned to R_IMG_ALIGN");
+        return nullptr;
+    }
+    return img_load(data, size, false);
+}
+
+extern void img_close(img * im) {
+    if (im == nullptr)
+        return;
+    if (im->mapped)
+        munmap((void *)im->data, im->size);
+    alloc_push(im->alloc);
+    mem_free(im, sizeof(img));
+    alloc_pop();
+}
+
+extern bool img_verify(const img * im) {
+    if (err_null(im))
+        return false;
+    const uint32_t crc = crc32c(im->data + sizeof(r_img_header), im->size - sizeof(r_img_header), 0);
+    if (crc != im->header->crc) {
+        err_set(R_ERR_PARSE_FAILED, "image checksum mismatch");
+        return false;
+    }
+    return true;
+}
+
+extern const r_img_section * R_(img_section)(
+    const img * im, const char * name, const r_img_kind kind, const size_t elem_size
+) {
+    if (err_null(im) || err_null(name))
+        return nullptr;
+    for (size_t i = 0; i < im->header->section_count; i++) {
+        const r_img_section * s = &im->sections[i];
+        if (strncmp(s->name, name, R_IMG_NAME_MAX) != 0)
+            continue;
+        if (s->kind != kind || s->elem_size != elem_size) {
+            err_set(R_ERR_INVALID_ARGUMENT, "image section has another kind or element size");
+            return nullptr;
+        }
+        return s;
+    }
+    err_set(R_ERR_NOT_FOUND, "no such image section");
+    return nullptr;
+}
+
+extern const void * R_(img_data)(const img * im, const r_img_section * section) {
+    return im->data + section->offset;
+}
+
+extern const void * R_(img_array)(
+    const img * im, const char * name, const r_img_kind kind, const size_t elem_size, size_t * n
+) {
+    if (err_null(n))
+        return nullptr;
+    *n = 0;
+    const r_img_section * s = R_(img_section)(im, name, kind, elem_size);
+    if (s == nullptr)
+        return nullptr;
+    *n = s->count;
+    return R_(img_data)(im, s);
+}
+
+extern const char * img_str(const img * im, const img_ref ref) {
+    if (im == nullptr || ref == 0)
+        return nullptr;
+    return str_placed(im->data + im->header->strings, im->header->strings_len, ref);
+}
+
+extern img_ref R_(img_str_find)(const img * im, const strview s) {
+    if (im == nullptr || s.data == nullptr || im->header->index_cap == 0)
+        return 0;
+    const img_ref * index = (const img_ref *)(im->data + im->header->index);
+    const size_t slot = img_index_slot(
+        index,
+        im->header->index_cap,
+        im->data + im->header->strings,
+        im->header->strings_len,
+        s,
+        R_(str_hash)(s, &R_IMG_STR_OPT)
+    );
+    return slot < im->header->index_cap ? index[slot] : 0;
+}
@@ -0,0 +1,397 @@
+/**
+ * Image module - Flat, relocatable snapshots of collections that are queried in place.
+ *
+ * Provides:
+ *   - One binary file of named sections addressed by offsets only (no pointers), so it can be mmap'ed at any address
+ *     and its pages shared by every process that opens it
+ *   - LIST(T) sections: the elements as one array
+ *   - Ordered sections from RBT(T) or BTREE(T): the keys as one ascending array, searched by binary search in place
+ *   - MAP(K, V) sections: the open-addressing table itself (control bytes and slots), so map_get, map_contains and
+ *     map_foreach run directly on the mapped pages
+ *   - A string section of placed managed strings (str.h layout, so str_len and str_hash are O(1)), deduplicated and
+ *     indexed by hash; collections refer to strings through img_ref offsets instead of pointers
+ *   - A CRC32C checksum of the whole image, verified on demand
+ *
+ * Quick Reference:
+ *
+ *   Writer
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   img_writer_new()             Create an empty writer
+ *   img_writer_free(w)           Free a writer (nullptr-safe)
+ *   img_add_list(w, name, lst)   Section with the elements of a LIST
+ *   img_add_rbt(w, name, t)      Ordered section with the values of an RBT (needs tree.h)
+ *   img_add_btree(w, name, t)    Ordered section with the keys of a BTREE (needs tree.h)
+ *   img_add_map(w, name, m)      Section with the table of a MAP (needs map.h)
+ *   img_add_str(w, s)            Copy a string or view into the string section, returns its img_ref
+ *   img_write(w, stream)         Write the image
+ *
+ *   Reader
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   img_open(path)               Map an image file read-only
+ *   img_from(data, size)         Use an image already in memory (not copied, must outlive the img)
+ *   img_close(im)                Unmap / release an image (nullptr-safe)
+ *   img_verify(im)               Check the checksum (reads every page)
+ *   img_list(type, im, name, n)  Elements of a list section (const type *, count stored in *n)
+ *   img_tree(type, im, name, n)  Keys of an ordered section, ascending (const type *, count stored in *n)
+ *   img_lower_bound(
+ *       keys, n, val, ...
+ *   )                            Index of the first key >= val in a sorted array (optional comparator)
+ *   img_find(keys, n, val, ...)  Pointer to the key equal to val in a sorted array or nullptr (optional comparator)
+ *   img_map(k_t, v_t, im, name)  Read-only MAP(k_t, v_t) over a map section (needs map.h)
+ *   img_str(im, ref)             Placed string for a reference (nullptr for 0 or an invalid reference)
+ *   img_str_find(im, s)          Reference of an equal string in the string section, 0 if there is none
+ *
+ * Example:
+ *   // Build once
+ *   img_writer * w = img_writer_new();
+ *   img_add_list(w, "users", &users);            // LIST(user), user has an img_ref name field
+ *   img_add_rbt(w, "ids", &ids);                 // RBT(u64)
+ *   img_add_map(w, "by_name", &by_name);         // MAP(img_ref, u32), keys from img_add_str(w, name)
+ *   img_write(w, file);
+ *   img_writer_free(w);
+ *
+ *   // Query in place in every process
+ *   img * im = img_open("index.img");
+ *   size_t n;
+ *   const u64 * ids = img_tree(u64, im, "ids", &n);
+ *   const u64 * id = img_find(ids, n, 42);
+ *   MAP(img_ref, u32) by_name = img_map(img_ref, u32, im, "by_name");
+ *   u32 * row = map_get(&by_name, img_str_find(im, "alice"));
+ *   img_close(im);
+ *
+ * Elements, keys and values are stored bytewise, so they must not contain pointers: store strings as img_ref and
+ * other objects as indices. Ordered sections keep the order of the tree they were written from, so img_lower_bound
+ * and img_find must use the comparator the tree used; rbt_build_sorted turns one back into a mutable tree in O(n).
+ * A map section keeps the table layout and the default hashing (hash.h), so the reading build must use the same
+ * hash and equality as the writer - custom ones are passed to the map operations as usual.
+ *
+ * Everything returned by the reader points into the image: it is read-only (a mapped file is mapped without write
+ * access), must not be freed (never map_free a map from img_map or str_free a placed string) and is valid until
+ * img_close. An image is only opened by a build with the same byte order, word size, string hash (RCFG__STR_BLOCK_HASH)
+ * and default hash seed as the one that wrote it; img_open and img_from reject any other image with R_ERR_PARSE_FAILED.
+ */
+
+// ReSharper disable CppInconsistentNaming
+#ifndef RUNE_IMG_H
+#define RUNE_IMG_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "r.h"
+#include "str.h"
+
+// Suppress pedantic warnings about GNU statement expressions (intentional, required for macro-based templates)
+#pragma GCC diagnostic ignored "-Wpedantic"
+
+// =====================================================================================================================
+// Configuration
+// =====================================================================================================================
+
+// Sections start on a cache line, which also aligns every element type up to 64 bytes
+static constexpr size_t R_IMG_ALIGN = 64;
+
+// Longest section name plus its terminator
+static constexpr size_t R_IMG_NAME_MAX = 32;
+
+// Control bytes mirrored after a map section's table: the widest group any build probes (AVX2), so an image written
+// by a portable or SSE2 build can be probed by an AVX2 one
+static constexpr size_t R_IMG_MAP_MIRROR = 32;
+
+// =====================================================================================================================
+// Types
+// =====================================================================================================================
+
+// Offset of a string in an image's string section; 0 refers to no string
+typedef uint64_t img_ref;
+
+typedef struct r_img img;
+typedef struct r_img_writer img_writer;
+
+typedef enum {
+    R_IMG_LIST = 1,
+    R_IMG_TREE = 2,
+    R_IMG_MAP = 3,
+} r_img_kind;
+
+/**
+ * Section table entry, stored as is in the image (64 bytes).
+ *
+ * @param name       Null-terminated name, unique within the image
+ * @param kind       r_img_kind
+ * @param elem_size  Element size (map sections: entry size)
+ * @param offset     Offset of the section data from the start of the image, a multiple of R_IMG_ALIGN
+ * @param count      Elements (map sections: live entries)
+ * @param capacity   Map sections: slots in the table (0 or a power of two); 0 for other kinds
+ */
+typedef struct {
+    char name[R_IMG_NAME_MAX];
+    uint32_t kind;
+    uint32_t elem_size;
+    uint64_t offset;
+    uint64_t count;
+    uint64_t capacity;
+} r_img_section;
+
+// Round a byte count up to R_IMG_ALIGN
+#define R_IMG_ALIGN_UP(n) (((n) + R_IMG_ALIGN - 1) / R_IMG_ALIGN * R_IMG_ALIGN)
+
+// Map section data: the control bytes (with R_IMG_MAP_MIRROR mirrored) padded to R_IMG_ALIGN, then the slots
+#define R_IMG_MAP_CTRL_SIZE(capacity) ((capacity) > 0 ? R_IMG_ALIGN_UP((capacity) + R_IMG_MAP_MIRROR) : 0)
+
+// Default view conversion for image strings: no length limit
+static const str_opt R_IMG_STR_OPT = {.max_len = SIZE_MAX, .max_tok = 0};
+
+// =====================================================================================================================
+// Writer
+// =====================================================================================================================
+
+/**
+ * A writer keeps the sections and strings added to it in memory until img_write. It allocates from the allocator
+ * current when it was created, and is not thread safe.
+ */
+[[nodiscard]]
+extern img_writer * img_writer_new(void);
+extern void img_writer_free(img_writer * w);
+
+// Add a section of count elements copied from data; false if the name is invalid or taken, or on allocation failure
+extern bool R_(img_add)(
+    img_writer * w, const char * name, r_img_kind kind, const void * data, size_t elem_size, size_t count
+);
+
+/**
+ * Add a section and return its zeroed data (bytes long, valid until the next call on the writer) for the caller to
+ * fill, or nullptr with the error set as for R_(img_add).
+ */
+[[nodiscard]]
+extern void * R_(img_reserve)(
+    img_writer * w, const char * name, r_img_kind kind, size_t elem_size, size_t count, size_t capacity, size_t bytes
+);
+
+// Accepts views; equal strings share one copy, so equal strings always get equal references (0 on failure)
+#define img_add_str(w, s) R_(img_add_str)((w), R_STR_VIEW((s), &R_IMG_STR_OPT))
+extern img_ref R_(img_add_str)(img_writer * w, strview s);
+
+extern bool img_write(const img_writer * w, FILE * stream);
+
+#define img_add_list(w, name, lst)                                                                                     \
+    ({                                                                                                                 \
+        typeof(lst) R_UNIQUE(_ial_lst) = (lst);                                                                        \
+        R_(img_add)(                                                                                                   \
+            (w),                                                                                                       \
+            (name),                                                                                                    \
+            R_IMG_LIST,                                                                                                \
+            R_UNIQUE(_ial_lst)->data,                                                                                  \
+            sizeof(*R_UNIQUE(_ial_lst)->data),                                                                         \
+            R_UNIQUE(_ial_lst)->size                                                                                   \
+        );                                                                                                             \
+    })
+
+// Values in ascending (in-order) order
+#define img_add_rbt(w, name, t)                                                                                        \
+    ({                                                                                                                 \
+        typeof(t) R_UNIQUE(_iar_t) = (t);                                                                              \
+        typeof_unqual(R_UNIQUE(_iar_t)->root->data) * R_UNIQUE(_iar_dst) = R_(img_reserve)(                           \
+            (w),                                                                                                       \
+            (name),                                                                                                    \
+            R_IMG_TREE,                                                                                                \
+            sizeof(R_UNIQUE(_iar_t)->root->data),                                                                      \
+            R_UNIQUE(_iar_t)->size,                                                                                    \
+            0,                                                                                                         \
+            R_UNIQUE(_iar_t)->size * sizeof(R_UNIQUE(_iar_t)->root->data)                                              \
+        );                                                                                                             \
+        if (R_UNIQUE(_iar_dst) != nullptr) {                                                                           \
+            size_t R_UNIQUE(_iar_i) = 0;                                                                               \
+            rbt_foreach(R_UNIQUE(_iar_t), R_UNIQUE(_iar_node)) {                                                       \
+                R_UNIQUE(_iar_dst)[R_UNIQUE(_iar_i)++] = R_UNIQUE(_iar_node)->data;                                    \
+            }                                                                                                          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_iar_dst) != nullptr;                                                                    \
+    })
+
+/**
+ * Keys in ascending order, by an in-order walk with an explicit stack. Each stack entry holds a node and a step: even
+ * steps 2i descend into child i, odd steps 2i + 1 emit key i. Leaves emit all their keys at once. Every node has at
+ * least two children, so 64 entries cover any tree that fits in memory.
+ */
+#define img_add_btree(w, name, t)                                                                                      \
+    ({                                                                                                                 \
+        typeof(t) R_UNIQUE(_iab_t) = (t);                                                                              \
+        typeof_unqual(R_UNIQUE(_iab_t)->root->keys[0]) * R_UNIQUE(_iab_dst) = R_(img_reserve)(                         \
+            (w),                                                                                                       \
+            (name),                                                                                                    \
+            R_IMG_TREE,                                                                                                \
+            sizeof(R_UNIQUE(_iab_t)->root->keys[0]),                                                                   \
+            R_UNIQUE(_iab_t)->size,                                                                                    \
+            0,                                                                                                         \
+            R_UNIQUE(_iab_t)->size * sizeof(R_UNIQUE(_iab_t)->root->keys[0])                                           \
+        );                                                                                                             \
+        if (R_UNIQUE(_iab_dst) != nullptr && R_UNIQUE(_iab_t)->root != nullptr) {                                      \
+            struct {                                                                                                   \
+                typeof_unqual(R_UNIQUE(_iab_t)->root) node;                                                            \
+                size_t step;                                                                                           \
+            } R_UNIQUE(_iab_stk)[64];                                                                                  \
+            size_t R_UNIQUE(_iab_sp) = 0;                                                                              \
+            size_t R_UNIQUE(_iab_i) = 0;                                                                               \
+            R_UNIQUE(_iab_stk)[R_UNIQUE(_iab_sp)++] = (typeof(R_UNIQUE(_iab_stk)[0])){R_UNIQUE(_iab_t)->root, 0};      \
+            while (R_UNIQUE(_iab_sp) > 0) {                                                                            \
+                typeof(R_UNIQUE(_iab_stk)[0]) * R_UNIQUE(_iab_top) = &R_UNIQUE(_iab_stk)[R_UNIQUE(_iab_sp) - 1];       \
+                const typeof(R_UNIQUE(_iab_t)->root) R_UNIQUE(_iab_node) = R_UNIQUE(_iab_top)->node;                   \
+                if (R_UNIQUE(_iab_node)->leaf) {                                                                       \
+                    memcpy(                                                                                            \
+                        &R_UNIQUE(_iab_dst)[R_UNIQUE(_iab_i)],                                                         \
+                        R_UNIQUE(_iab_node)->keys,                                                                     \
+                        R_UNIQUE(_iab_node)->len * sizeof(R_UNIQUE(_iab_node)->keys[0])                                \
+                    );                                                                                                 \
+                    R_UNIQUE(_iab_i) += R_UNIQUE(_iab_node)->len;                                                      \
+                    R_UNIQUE(_iab_sp)--;                                                                               \
+                    continue;                                                                                          \
+                }                                                                                                      \
+                const size_t R_UNIQUE(_iab_k) = R_UNIQUE(_iab_top)->step / 2;                                          \
+                const bool R_UNIQUE(_iab_emit) = R_UNIQUE(_iab_top)->step % 2 == 1;                                    \
+                R_UNIQUE(_iab_top)->step++;                                                                            \
+                if (R_UNIQUE(_iab_k) > R_UNIQUE(_iab_node)->len ||                                                     \
+                    (R_UNIQUE(_iab_emit) && R_UNIQUE(_iab_k) == R_UNIQUE(_iab_node)->len)) {                           \
+                    R_UNIQUE(_iab_sp)--;                                                                               \
+                } else if (R_UNIQUE(_iab_emit)) {                                                                      \
+                    R_UNIQUE(_iab_dst)[R_UNIQUE(_iab_i)++] = R_UNIQUE(_iab_node)->keys[R_UNIQUE(_iab_k)];              \
+                } else {                                                                                               \
+                    R_UNIQUE(_iab_stk)[R_UNIQUE(_iab_sp)++] =                                                          \
+                        (typeof(R_UNIQUE(_iab_stk)[0])){R_UNIQUE(_iab_node)->children[R_UNIQUE(_iab_k)], 0};           \
+                }                                                                                                      \
+            }                                                                                                          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_iab_dst) != nullptr;                                                                    \
+    })
+
+/**
+ * The table is copied slot for slot, tombstones included, so every probe sequence stays intact. Slots that hold no
+ * entry are written as zeros, so equal maps with equal histories give identical images.
+ */
+#define img_add_map(w, name, m)                                                                                        \
+    ({                                                                                                                 \
+        typeof(m) R_UNIQUE(_iam_m) = (m);                                                                              \
+        const size_t R_UNIQUE(_iam_cap) = R_UNIQUE(_iam_m)->capacity;                                                  \
+        const size_t R_UNIQUE(_iam_ctrl) = R_IMG_MAP_CTRL_SIZE(R_UNIQUE(_iam_cap));                                    \
+        uint8_t * R_UNIQUE(_iam_dst) = R_(img_reserve)(                                                                \
+            (w),                                                                                                       \
+            (name),                                                                                                    \
+            R_IMG_MAP,                                                                                                 \
+            map_entry_size(R_UNIQUE(_iam_m)),                                                                          \
+            R_UNIQUE(_iam_m)->size,                                                                                    \
+            R_UNIQUE(_iam_cap),                                                                                        \
+            R_UNIQUE(_iam_ctrl) + R_UNIQUE(_iam_cap) * map_entry_size(R_UNIQUE(_iam_m))                                \
+        );                                                                                                             \
+        if (R_UNIQUE(_iam_dst) != nullptr && R_UNIQUE(_iam_cap) > 0) {                                                 \
+            typeof(R_UNIQUE(_iam_m)->slots) R_UNIQUE(_iam_slots) =                                                     \
+                (typeof(R_UNIQUE(_iam_m)->slots))(R_UNIQUE(_iam_dst) + R_UNIQUE(_iam_ctrl));                           \
+            for (size_t R_UNIQUE(_iam_i) = 0; R_UNIQUE(_iam_i) < R_UNIQUE(_iam_cap); R_UNIQUE(_iam_i)++) {             \
+                R_UNIQUE(_iam_dst)[R_UNIQUE(_iam_i)] = R_UNIQUE(_iam_m)->ctrl[R_UNIQUE(_iam_i)];                       \
+                if (R_MAP_IS_FULL(R_UNIQUE(_iam_m)->ctrl[R_UNIQUE(_iam_i)])) {                                         \
+                    R_UNIQUE(_iam_slots)[R_UNIQUE(_iam_i)] = R_UNIQUE(_iam_m)->slots[R_UNIQUE(_iam_i)];                \
+                }                                                                                                      \
+            }                                                                                                          \
+            for (size_t R_UNIQUE(_iam_i) = 0; R_UNIQUE(_iam_i) < R_IMG_MAP_MIRROR; R_UNIQUE(_iam_i)++) {               \
+                R_UNIQUE(_iam_dst)[R_UNIQUE(_iam_cap) + R_UNIQUE(_iam_i)] =                                            \
+                    R_UNIQUE(_iam_dst)[R_UNIQUE(_iam_i) & (R_UNIQUE(_iam_cap) - 1)];                                   \
+            }                                                                                                          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_iam_dst) != nullptr;                                                                    \
+    })
+
+// =====================================================================================================================
+// Reader
+// =====================================================================================================================
+
+/**
+ * img_open maps the file read-only and shared, so opening is O(1) in the image size and the pages are loaded on
+ * first access (and shared with every other process mapping the same file). Both openers check the header and that
+ * every section lies inside the image; the checksum is only checked by img_verify.
+ */
+[[nodiscard]]
+extern img * img_open(const char * path);
+[[nodiscard]]
+extern img * img_from(const void * data, size_t size);
+extern void img_close(img * im);
+extern bool img_verify(const img * im);
+
+// Section with this name, kind and element size, or nullptr with R_ERR_NOT_FOUND / R_ERR_INVALID_ARGUMENT set
+extern const r_img_section * R_(img_section)(const img * im, const char * name, r_img_kind kind, size_t elem_size);
+
+// Data of a section found by R_(img_section)
+extern const void * R_(img_data)(const img * im, const r_img_section * section);
+
+// Data of a list or ordered section, with its element count stored in *n (0 when it is missing)
+extern const void * R_(img_array)(const img * im, const char * name, r_img_kind kind, size_t elem_size, size_t * n);
+
+#define img_list(type, im, name, n) ((const type *)R_(img_array)((im), (name), R_IMG_LIST, sizeof(type), (n)))
+#define img_tree(type, im, name, n) ((const type *)R_(img_array)((im), (name), R_IMG_TREE, sizeof(type), (n)))
+
+extern const char * img_str(const img * im, img_ref ref);
+
+// Accepts views
+#define img_str_find(im, s) R_(img_str_find)((im), R_STR_VIEW((s), &R_IMG_STR_OPT))
+extern img_ref R_(img_str_find)(const img * im, strview s);
+
+/* R_IMG_CMP with optional comparator - same convention as R_BST_CMP in tree.h (three-way result) */
+#define R_IMG_CMP_DEFAULT(a, b) (((a) > (b)) - ((a) < (b)))
+#define R_IMG_CMP_CUSTOM(a, b, cmp) ((cmp)((a), (b)))
+#define R_IMG_CMP_SELECT(_1, _2, _3, N, ...) N
+#define R_IMG_CMP(...) R_IMG_CMP_SELECT(__VA_ARGS__, R_IMG_CMP_CUSTOM, R_IMG_CMP_DEFAULT)(__VA_ARGS__)
+
+// Index of the first of the n sorted keys that is not less than val (n if there is none)
+#define img_lower_bound(keys, n, val, ...)                                                                             \
+    ({                                                                                                                 \
+        const typeof(&(keys)[0]) R_UNIQUE(_ilb_keys) = (keys);                                                         \
+        const typeof_unqual((keys)[0]) R_UNIQUE(_ilb_val) = (val);                                                     \
+        size_t R_UNIQUE(_ilb_lo) = 0;                                                                                  \
+        size_t R_UNIQUE(_ilb_hi) = (n);                                                                                \
+        while (R_UNIQUE(_ilb_lo) < R_UNIQUE(_ilb_hi)) {                                                                \
+            const size_t R_UNIQUE(_ilb_mid) = R_UNIQUE(_ilb_lo) + (R_UNIQUE(_ilb_hi) - R_UNIQUE(_ilb_lo)) / 2;         \
+            const int R_UNIQUE(_ilb_c) =                                                                               \
+                R_IMG_CMP(R_UNIQUE(_ilb_keys)[R_UNIQUE(_ilb_mid)], R_UNIQUE(_ilb_val) __VA_OPT__(, ) __VA_ARGS__);     \
+            if (R_UNIQUE(_ilb_c) < 0) {                                                                                \
+                R_UNIQUE(_ilb_lo) = R_UNIQUE(_ilb_mid) + 1;                                                            \
+            } else {                                                                                                   \
+                R_UNIQUE(_ilb_hi) = R_UNIQUE(_ilb_mid);                                                                \
+            }                                                                                                          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_ilb_lo);                                                                                \
+    })
+
+#define img_find(keys, n, val, ...)                                                                                    \
+    ({                                                                                                                 \
+        const typeof(&(keys)[0]) R_UNIQUE(_ifd_keys) = (keys);                                                         \
+        const size_t R_UNIQUE(_ifd_n) = (n);                                                                           \
+        const typeof_unqual((keys)[0]) R_UNIQUE(_ifd_val) = (val);                                                     \
+        const size_t R_UNIQUE(_ifd_at) =                                                                               \
+            img_lower_bound(R_UNIQUE(_ifd_keys), R_UNIQUE(_ifd_n), R_UNIQUE(_ifd_val) __VA_OPT__(, ) __VA_ARGS__);     \
+        /* return */ R_UNIQUE(_ifd_at) < R_UNIQUE(_ifd_n) &&                                                           \
+                R_IMG_CMP(R_UNIQUE(_ifd_keys)[R_UNIQUE(_ifd_at)], R_UNIQUE(_ifd_val) __VA_OPT__(, ) __VA_ARGS__) == 0  \
+            ? &R_UNIQUE(_ifd_keys)[R_UNIQUE(_ifd_at)]                                                                  \
+            : nullptr;                                                                                                 \
+    })
+
+/**
+ * MAP(key_t, val_t) whose table is the map section's data (empty, with R_ERR_NOT_FOUND or R_ERR_INVALID_ARGUMENT set,
+ * if there is no such section). Only the lookups and map_foreach may be used on it.
+ */
+#define img_map(key_t, val_t, im, name)                                                                                \
+    ({                                                                                                                 \
+        static_assert(R_MAP_GROUP_WIDTH <= R_IMG_MAP_MIRROR, "map groups wider than the mirrored control bytes");     \
+        const img * R_UNIQUE(_imp_im) = (im);                                                                          \
+        const r_img_section * R_UNIQUE(_imp_sec) =                                                                     \
+            R_(img_section)(R_UNIQUE(_imp_im), (name), R_IMG_MAP, sizeof(MAP_ENTRY(key_t, val_t)));                    \
+        MAP(key_t, val_t) R_UNIQUE(_imp_m) = map(key_t, val_t);                                                        \
+        if (R_UNIQUE(_imp_sec) != nullptr && R_UNIQUE(_imp_sec)->capacity > 0) {                                       \
+            uint8_t * R_UNIQUE(_imp_data) = (uint8_t *)R_(img_data)(R_UNIQUE(_imp_im), R_UNIQUE(_imp_sec));            \
+            R_UNIQUE(_imp_m).ctrl = R_UNIQUE(_imp_data);                                                               \
+            R_UNIQUE(_imp_m).slots =                                                                                   \
+                (MAP_ENTRY(key_t, val_t) *)(R_UNIQUE(_imp_data) + R_IMG_MAP_CTRL_SIZE(R_UNIQUE(_imp_sec)->capacity));  \
+            R_UNIQUE(_imp_m).size = R_UNIQUE(_imp_sec)->count;                                                         \
+            R_UNIQUE(_imp_m).capacity = R_UNIQUE(_imp_sec)->capacity;                                                  \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_imp_m);                                                                                 \
+    })
+
+#endif // RUNE_IMG_H
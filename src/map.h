@@ -1,50 +1,1129 @@
-#ifndef RUNE_MAP_H
-#define RUNE_MAP_H
+/**
+ * Generic hash map: flat open-addressing table with SwissTable-style control bytes.
+ *
+ * Provides:
+ *   - Cache-friendly open addressing: keys and values live in one contiguous slot array
+ *   - One control byte per slot (empty, deleted, or 7 bits of the key hash) for cheap probe filtering
+ *   - Group probing: 32 (AVX2), 16 (SSE2/NEON) or 8 (portable SWAR) control bytes compared per step; the
+ *     instruction set is picked at compile time and RCFG__MAP_NO_SIMD forces the portable path
+ *   - Generic type support via macro-based template expansion
+ *   - Default hashing through hash.h (hash_mix for 1-8 byte keys, hash64 otherwise, C strings by content)
+ *   - Custom hash/equality support per operation
+ *   - Parallel bulk insert on a task pool (task.h), with keys partitioned by hash prefix into table regions
+ *   - Progressive map (PMAP): grows by migrating a bounded number of slots per write into a new table, so no single
+ *     operation pays for a full rehash
+ *
+ * Quick Reference:
+ *
+ *   Hash Map API
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   map(key_t, val_t)            Create empty map
+ *   map_free(m)                  Free map memory
+ *   map_size(m)                  Get number of entries
+ *   map_capacity(m)              Get number of slots
+ *   map_empty(m)                 Check if map has no entries
+ *   map_put(m, k, v, ...)        Insert or overwrite, returns true if key was new (optional hash, eq)
+ *   map_get(m, k, ...)           Get pointer to value or nullptr (optional hash, eq)
+ *   map_contains(m, k, ...)      Check if key exists (optional hash, eq)
+ *   map_remove(m, k, ...)        Remove key, returns true if it existed (optional hash, eq)
+ *   map_reserve(m, n, ...)       Ensure room for n entries without rehashing (optional hash, eq)
+ *   map_put_all(
+ *       key_t, val_t,
+ *       m, pool,
+ *       keys, vals, n
+ *   )                            Put n keys and values on a task pool (needs task.h, K_HASH / K_EQ optional)
+ *   map_clear(m)                 Remove all entries, keep capacity
+ *   map_foreach(m, entry)        Iterate over entries (entry is a pointer with ->key and ->val)
+ *
+ *   Progressive Hash Map API (same key / value instantiation as MAP; hash and eq optional as for MAP)
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   pmap(key_t, val_t)           Create empty progressive map
+ *   pmap_free(m)                 Free both tables
+ *   pmap_size(m)                 Get number of entries
+ *   pmap_capacity(m)             Get number of slots of the current table
+ *   pmap_empty(m)                Check if map has no entries
+ *   pmap_put(m, k, v, ...)       Migration step, then insert or overwrite (returns true if key was new)
+ *   pmap_get(m, k, ...)          Get pointer to value or nullptr
+ *   pmap_contains(m, k, ...)     Check if key exists
+ *   pmap_remove(m, k, ...)       Migration step, then remove key (returns true if it existed)
+ *   pmap_migrating(m)            Check if an old table is still being migrated
+ *   pmap_step(m, n, ...)         Migrate up to n more slots, returns pmap_migrating(m)
+ *   pmap_clear(m)                Remove all entries, keep the current capacity
+ *   pmap_foreach(m, entry)       Iterate over entries
+ *
+ * Example:
+ *   // Basic map usage with default hashing
+ *   #define K int
+ *   #define V double
+ *   #include "map.h"
+ *   #undef K
+ *   #undef V
+ *
+ *   MAP(int, double) m = map(int, double);
+ *   map_put(&m, 1, 0.5);
+ *   map_put(&m, 2, 1.5);
+ *   double * v = map_get(&m, 2);  // points at 1.5
+ *   map_remove(&m, 1);
+ *   map_free(&m);
+ *
+ *   // Latency-sensitive map: growth is spread over the following puts and removes
+ *   PMAP(int, double) pm = pmap(int, double);
+ *   pmap_put(&pm, 1, 0.5);
+ *   while (idle() && pmap_step(&pm, 1024)) {}  // optionally finish a migration early
+ *   pmap_free(&pm);
+ *
+ *   // With custom hash and equality passed to operations
+ *   uint64_t point_hash(point p) { return hash_combine(hash_mix(p.x), hash_mix(p.y)); }
+ *   bool point_eq(point a, point b) { return a.x == b.x && a.y == b.y; }
+ *   MAP(point, int) pts = map(point, int);
+ *   map_put(&pts, p, 42, point_hash, point_eq);
+ *   int * n = map_get(&pts, p, point_hash, point_eq);
+ *
+ * Keys of pointer-to-char type (char *, const char *) are hashed and compared by content. Every other key type
+ * is hashed and compared bytewise by default, so struct keys with padding need a custom hash and equality.
+ * The same hash and equality must be used for every operation on a given map.
+ *
+ * Note: MAP requires template expansion via #define K / #define V before including this header. Type names are
+ * glued into identifiers, so pointer types need a typedef (e.g. typedef const char * cstr;).
+ *
+ * map_put_all runs its work in pool tasks, so its functions are generated per instantiation, only when task.h was
+ * included before it. They hash with K_HASH and K_EQ (defined alongside K and V) when both are defined, else with
+ * the defaults; every other operation on such a map must pass the same pair.
+ */
 
-// sample map data
-typedef struct {
-    const char * id;
-    const char * region;
-    const int type;
-} instance;
-
-#ifdef T
-#error "T is already defined"
-#else // T
-#define T instance
-#include "tree.h"
-#undef T
+// ReSharper disable once CppMissingIncludeGuard
+// ReSharper disable CppInconsistentNaming
+#include <stdint.h>
+#include <string.h>
+
+#include "hash.h"
+#include "r.h"
+
+// Group probing instruction set, selected at compile time (RCFG__MAP_NO_SIMD forces the portable path)
+#if !defined(RCFG__MAP_NO_SIMD) && defined(__AVX2__)
+#define R_MAP_AVX2
+#include <immintrin.h>
+#elif !defined(RCFG__MAP_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64))
+#define R_MAP_SSE2
+#include <emmintrin.h>
+#elif !defined(RCFG__MAP_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define R_MAP_NEON
+#include <arm_neon.h>
+#else
+#define R_MAP_SWAR
+#endif
+
+// Suppress pedantic warnings about GNU statement expressions (intentional, required for macro-based templates)
+#pragma GCC diagnostic ignored "-Wpedantic"
 
 // =====================================================================================================================
-// buckets
+// Hash Map
 // =====================================================================================================================
 
+// API
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifndef RUNE_MAP_API
+#define RUNE_MAP_API
+
+// ------------------------------------------------ Table configuration ------------------------------------------------
+
+#ifdef RCFG__MAP_MAX_LOAD
+static constexpr size_t R_MAP_MAX_LOAD = RCFG__MAP_MAX_LOAD;
+#else  // Default max load factor, in percent of capacity
+static constexpr size_t R_MAP_MAX_LOAD = 87;
+#endif // RCFG__MAP_MAX_LOAD
+
+#ifdef RCFG__MAP_MIN_CAPACITY
+static constexpr size_t R_MAP_MIN_CAPACITY = RCFG__MAP_MIN_CAPACITY;
+#else  // Default capacity of the first table allocation (must be a power of two)
+static constexpr size_t R_MAP_MIN_CAPACITY = 16;
+#endif // RCFG__MAP_MIN_CAPACITY
+
+#ifdef RCFG__MAP_BULK_REGION
+static constexpr size_t R_MAP_BULK_REGION = RCFG__MAP_BULK_REGION;
+#else  // Fewest slots per map_put_all region (a power of two); bulk inserts of fewer keys run on the calling thread
+static constexpr size_t R_MAP_BULK_REGION = 4096;
+#endif // RCFG__MAP_BULK_REGION
+
+#ifdef RCFG__MAP_BULK_BATCH
+static constexpr size_t R_MAP_BULK_BATCH = RCFG__MAP_BULK_BATCH;
+#else  // Keys map_put_all partitions at a time; its scratch memory is 16 bytes per key of one batch
+static constexpr size_t R_MAP_BULK_BATCH = 1 << 20;
+#endif // RCFG__MAP_BULK_BATCH
+
+#ifdef RCFG__MAP_MIGRATE_STEP
+static constexpr size_t R_MAP_MIGRATE_STEP = RCFG__MAP_MIGRATE_STEP;
+#else  // Old-table slots a progressive map moves per write; at least 4, so a migration ends before the new table fills
+static constexpr size_t R_MAP_MIGRATE_STEP = 32;
+#endif // RCFG__MAP_MIGRATE_STEP
+
+// -------------------------------------------------- Control bytes ----------------------------------------------------
+// Each slot has one control byte:
+//   0b1000'0000  empty    - never used, terminates probing
+//   0b1111'1110  deleted  - tombstone, skipped by lookups, reusable by inserts
+//   0b0xxx'xxxx  full     - low 7 bits of the key hash (h2), filters out most non-matching slots
+
+static constexpr uint8_t R_MAP_EMPTY = 0x80;
+static constexpr uint8_t R_MAP_DELETED = 0xFE;
+
+#define R_MAP_IS_FULL(ctrl) (((ctrl) & 0x80) == 0)
+#define R_MAP_H1(hash) ((size_t)((hash) >> 7))
+#define R_MAP_H2(hash) ((uint8_t)((hash) & 0x7F))
+
+// -------------------------------------------------- Group probing ----------------------------------------------------
+// A group is R_MAP_GROUP_WIDTH consecutive control bytes starting at any slot. Group loads never run off the end
+// of the table because the first R_MAP_GROUP_WIDTH control bytes are mirrored after the last one.
+//
+// Matching a group yields a bitmask with R_MAP_MASK_STRIDE bits per slot (1 for SSE2/AVX2 movemask, 4 for the
+// NEON narrowing shift, 8 for SWAR). Only the highest bit of each stride is ever set, so R_MAP_MASK_NEXT can turn
+// the lowest set bit back into a slot offset.
+
+#if defined(R_MAP_AVX2)
+static constexpr size_t R_MAP_GROUP_WIDTH = 32;
+#define R_MAP_MASK_SHIFT 0
+#elif defined(R_MAP_SSE2)
+static constexpr size_t R_MAP_GROUP_WIDTH = 16;
+#define R_MAP_MASK_SHIFT 0
+#elif defined(R_MAP_NEON)
+static constexpr size_t R_MAP_GROUP_WIDTH = 16;
+#define R_MAP_MASK_SHIFT 2
+#else
+static constexpr size_t R_MAP_GROUP_WIDTH = 8;
+#define R_MAP_MASK_SHIFT 3
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define R_MAP_CTZ(x) ((size_t)__builtin_ctzll((x)))
+#else
+[[maybe_unused]]
+static size_t R_(map_ctz)(uint64_t x) {
+    size_t n = 0;
+    while ((x & 1) == 0) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+}
+#define R_MAP_CTZ(x) R_(map_ctz)((x))
+#endif
+
+// Slot offset (within the group) of the lowest match in a non-zero mask
+#define R_MAP_MASK_NEXT(mask) (R_MAP_CTZ((mask)) >> R_MAP_MASK_SHIFT)
+
+// Mask of slots whose control byte equals h2
+[[maybe_unused]]
+static uint64_t R_(map_group_match)(const uint8_t * group, const uint8_t h2) {
+#if defined(R_MAP_AVX2)
+    const __m256i ctrl = _mm256_loadu_si256((const __m256i *)(const void *)group);
+    return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(ctrl, _mm256_set1_epi8((char)h2)));
+#elif defined(R_MAP_SSE2)
+    const __m128i ctrl = _mm_loadu_si128((const __m128i *)(const void *)group);
+    return (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)h2)));
+#elif defined(R_MAP_NEON)
+    const uint8x16_t eq = vceqq_u8(vld1q_u8(group), vdupq_n_u8(h2));
+    const uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ULL;
+#else
+    // Zero-byte detection on ctrl ^ broadcast(h2). May report a false match above a true one (borrow), which
+    // the caller's key comparison rejects.
+    uint64_t ctrl;
+    memcpy(&ctrl, group, sizeof(ctrl));
+    const uint64_t x = ctrl ^ (0x0101010101010101ULL * h2);
+    return (x - 0x0101010101010101ULL) & ~x & 0x8080808080808080ULL;
+#endif
+}
+
+// Mask of empty slots
+[[maybe_unused]]
+static uint64_t R_(map_group_match_empty)(const uint8_t * group) {
+#if defined(R_MAP_SWAR)
+    // Empty (0x80) is the only control byte with bit 7 set and bit 1 clear
+    uint64_t ctrl;
+    memcpy(&ctrl, group, sizeof(ctrl));
+    return ctrl & ~(ctrl << 6) & 0x8080808080808080ULL;
+#else
+    return R_(map_group_match)(group, R_MAP_EMPTY);
+#endif
+}
+
+// Mask of empty or deleted slots (control bytes with the high bit set)
+[[maybe_unused]]
+static uint64_t R_(map_group_match_free)(const uint8_t * group) {
+#if defined(R_MAP_AVX2)
+    return (uint32_t)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *)(const void *)group));
+#elif defined(R_MAP_SSE2)
+    return (uint16_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(const void *)group));
+#elif defined(R_MAP_NEON)
+    const uint8x16_t high = vtstq_u8(vld1q_u8(group), vdupq_n_u8(0x80));
+    const uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(high), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ULL;
+#else
+    uint64_t ctrl;
+    memcpy(&ctrl, group, sizeof(ctrl));
+    return ctrl & 0x8080808080808080ULL;
+#endif
+}
+
+// --------------------------------------------------- Type helpers ----------------------------------------------------
+
+#define MAP(key_t, val_t) R_GLUE(map_, R_JOIN(key_t, val_t, _))
+#define MAP_ENTRY(key_t, val_t) R_GLUE(MAP(key_t, val_t), _entry)
+
+#define map(key_t, val_t) {.slots = nullptr, .ctrl = nullptr, .size = 0, .capacity = 0, .tombstones = 0}
+
+#define map_key_type(m) typeof_unqual((m)->slots[0].key)
+#define map_entry_size(m) sizeof((m)->slots[0])
+
+// -------------------------------------------------- Default hashing --------------------------------------------------
+
+[[maybe_unused]]
+static uint64_t R_(map_hash_bytes)(const void * key, const size_t size) {
+    switch (size) {
+    case 1:
+        return hash_mix(*(const uint8_t *)key);
+    case 2: {
+        uint16_t v;
+        memcpy(&v, key, sizeof(v));
+        return hash_mix(v);
+    }
+    case 4: {
+        uint32_t v;
+        memcpy(&v, key, sizeof(v));
+        return hash_mix(v);
+    }
+    case 8: {
+        uint64_t v;
+        memcpy(&v, key, sizeof(v));
+        return hash_mix(v);
+    }
+    default:
+        return hash64(key, size);
+    }
+}
+
+[[maybe_unused]]
+static uint64_t R_(map_hash_str)(const void * key, const size_t size) {
+    (void)size;
+    const char * s;
+    memcpy(&s, key, sizeof(s));
+    return s != nullptr ? hash64(s, strlen(s)) : 0;
+}
+
+[[maybe_unused]]
+static bool R_(map_eq_bytes)(const void * a, const void * b, const size_t size) {
+    return memcmp(a, b, size) == 0;
+}
+
+[[maybe_unused]]
+static bool R_(map_eq_str)(const void * a, const void * b, const size_t size) {
+    (void)size;
+    const char * sa;
+    const char * sb;
+    memcpy(&sa, a, sizeof(sa));
+    memcpy(&sb, b, sizeof(sb));
+    if (sa == sb)
+        return true;
+    return sa != nullptr && sb != nullptr && strcmp(sa, sb) == 0;
+}
+
+/* R_MAP_HASH / R_MAP_EQ with optional (hash, eq) pair - selects implementation based on arg count */
+#define R_MAP_HASH_DEFAULT(k)                                                                                          \
+    _Generic((k), char *: R_(map_hash_str), const char *: R_(map_hash_str), default: R_(map_hash_bytes))(              \
+        &(k),                                                                                                          \
+        sizeof(k)                                                                                                      \
+    )
+#define R_MAP_HASH_CUSTOM(k, hash, eq) ((uint64_t)(hash)((k)))
+#define R_MAP_HASH_SELECT(_1, _2, _3, N, ...) N
+#define R_MAP_HASH(...)                                                                                                \
+    R_MAP_HASH_SELECT(__VA_ARGS__, R_MAP_HASH_CUSTOM, R_MAP_HASH_CUSTOM, R_MAP_HASH_DEFAULT)(__VA_ARGS__)
+
+#define R_MAP_EQ_DEFAULT(a, b)                                                                                         \
+    _Generic((a), char *: R_(map_eq_str), const char *: R_(map_eq_str), default: R_(map_eq_bytes))(                    \
+        &(a),                                                                                                          \
+        &(b),                                                                                                          \
+        sizeof(a)                                                                                                      \
+    )
+#define R_MAP_EQ_CUSTOM(a, b, hash, eq) ((eq)((a), (b)))
+#define R_MAP_EQ_SELECT(_1, _2, _3, _4, N, ...) N
+#define R_MAP_EQ(...) R_MAP_EQ_SELECT(__VA_ARGS__, R_MAP_EQ_CUSTOM, R_MAP_EQ_CUSTOM, R_MAP_EQ_DEFAULT)(__VA_ARGS__)
+
+// ------------------------------------------------- Capacity helpers --------------------------------------------------
+
+// Largest number of entries (live + tombstones) a table of the given capacity may hold
+[[maybe_unused]]
+static size_t R_(map_max_load)(const size_t capacity) {
+    return capacity / 100 * R_MAP_MAX_LOAD + capacity % 100 * R_MAP_MAX_LOAD / 100;
+}
+
+// Smallest power-of-two capacity that holds n entries under the max load factor
+[[maybe_unused]]
+static size_t R_(map_capacity_for)(const size_t n) {
+    size_t capacity = R_MAP_MIN_CAPACITY > R_MAP_GROUP_WIDTH ? R_MAP_MIN_CAPACITY : R_MAP_GROUP_WIDTH;
+    while (R_(map_max_load)(capacity) < n) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+// Bytes in one table block: slot array, one control byte per slot, then the mirrored first group
+[[maybe_unused]]
+static size_t R_(map_block_size)(const size_t capacity, const size_t entry_size) {
+    return capacity * entry_size + capacity + R_MAP_GROUP_WIDTH;
+}
+
+// Set a control byte, keeping the mirrored copy of the first group in sync
+[[maybe_unused]]
+static void R_(map_set_ctrl)(uint8_t * ctrl, const size_t capacity, const size_t pos, const uint8_t value) {
+    ctrl[pos] = value;
+    if (pos < R_MAP_GROUP_WIDTH) {
+        ctrl[capacity + pos] = value;
+    }
+}
+
+// First empty or deleted slot on the probe sequence of hash (table must not be full)
+[[maybe_unused]]
+static size_t R_(map_find_free)(const uint8_t * ctrl, const size_t capacity, const uint64_t hash) {
+    const size_t mask = capacity - 1;
+    size_t pos = R_MAP_H1(hash) & mask;
+    for (;;) {
+        const uint64_t free = R_(map_group_match_free)(ctrl + pos);
+        if (free != 0) {
+            return (pos + R_MAP_MASK_NEXT(free)) & mask;
+        }
+        pos = (pos + R_MAP_GROUP_WIDTH) & mask;
+    }
+}
+
+// First full slot at or after pos, or capacity if there is none
+[[maybe_unused]]
+static size_t R_(map_next_full)(const uint8_t * ctrl, const size_t capacity, size_t pos) {
+    while (pos < capacity && !R_MAP_IS_FULL(ctrl[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+// ------------------------------------------------- Internal macros ---------------------------------------------------
+
+/**
+ * Find the slot holding k (an lvalue of the key type) with precomputed hash.
+ * Returns the slot index, or SIZE_MAX if the key is not present.
+ *
+ * Probing walks whole groups linearly from the home slot (h1 & mask). Each group is compared against h2 in one
+ * step, and only matching slots touch the slot array; a group containing an empty control byte ends the probe.
+ * With RCFG__TRACE the number of groups examined feeds the map probe counters.
+ */
+#define R_MAP_FIND(m, k, hash, ...)                                                                                    \
+    ({                                                                                                                 \
+        size_t R_UNIQUE(_fnd_idx) = SIZE_MAX;                                                                          \
+        if ((m)->capacity > 0) {                                                                                       \
+            const size_t R_UNIQUE(_fnd_mask) = (m)->capacity - 1;                                                      \
+            const uint8_t R_UNIQUE(_fnd_h2) = R_MAP_H2((hash));                                                        \
+            size_t R_UNIQUE(_fnd_pos) = R_MAP_H1((hash)) & R_UNIQUE(_fnd_mask);                                        \
+            size_t R_UNIQUE(_fnd_groups) = 0;                                                                          \
+            for (size_t R_UNIQUE(_fnd_n) = 0; R_UNIQUE(_fnd_n) < (m)->capacity;                                        \
+                 R_UNIQUE(_fnd_n) += R_MAP_GROUP_WIDTH) {                                                              \
+                const uint8_t * R_UNIQUE(_fnd_group) = (m)->ctrl + R_UNIQUE(_fnd_pos);                                 \
+                R_UNIQUE(_fnd_groups)++;                                                                               \
+                uint64_t R_UNIQUE(_fnd_match) = R_(map_group_match)(R_UNIQUE(_fnd_group), R_UNIQUE(_fnd_h2));          \
+                while (R_UNIQUE(_fnd_match) != 0) {                                                                    \
+                    const size_t R_UNIQUE(_fnd_slot) =                                                                 \
+                        (R_UNIQUE(_fnd_pos) + R_MAP_MASK_NEXT(R_UNIQUE(_fnd_match))) & R_UNIQUE(_fnd_mask);            \
+                    if (R_MAP_EQ((m)->slots[R_UNIQUE(_fnd_slot)].key, (k) __VA_OPT__(, ) __VA_ARGS__)) {               \
+                        R_UNIQUE(_fnd_idx) = R_UNIQUE(_fnd_slot);                                                      \
+                        break;                                                                                         \
+                    }                                                                                                  \
+                    R_UNIQUE(_fnd_match) &= R_UNIQUE(_fnd_match) - 1;                                                  \
+                }                                                                                                      \
+                if (R_UNIQUE(_fnd_idx) != SIZE_MAX || R_(map_group_match_empty)(R_UNIQUE(_fnd_group)) != 0) {          \
+                    break;                                                                                             \
+                }                                                                                                      \
+                R_UNIQUE(_fnd_pos) = (R_UNIQUE(_fnd_pos) + R_MAP_GROUP_WIDTH) & R_UNIQUE(_fnd_mask);                   \
+            }                                                                                                          \
+            R_TRACE_ADD(R_TRACE_MAP_FINDS, 1);                                                                         \
+            R_TRACE_ADD(R_TRACE_MAP_PROBES, R_UNIQUE(_fnd_groups));                                                    \
+            R_TRACE_MAX(R_TRACE_MAP_PROBES_MAX, R_UNIQUE(_fnd_groups));                                                \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_fnd_idx);                                                                               \
+    })
+
+// Pointer to the first full slot at or after pos, or nullptr
+#define R_MAP_NEXT(m, pos)                                                                                             \
+    ({                                                                                                                 \
+        const size_t R_UNIQUE(_nxt_idx) = R_(map_next_full)((m)->ctrl, (m)->capacity, (pos));                          \
+        /* return */ R_UNIQUE(_nxt_idx) < (m)->capacity ? &(m)->slots[R_UNIQUE(_nxt_idx)] : nullptr;                   \
+    })
+
+/**
+ * Move every live entry into a freshly allocated table of new_capacity slots (a power of two).
+ * Tombstones are dropped, so this is also used to clean up a table at its current capacity. With RCFG__TRACE the
+ * rebuild is counted and timed. If the new table cannot be allocated the map is left as it is (R_ERR_ALLOC_FAILED).
+ */
+#define R_MAP_REHASH(m, new_capacity, ...)                                                                             \
+    ({                                                                                                                 \
+        const uint64_t R_UNIQUE(_rh_start) = R_TRACE_NOW();                                                            \
+        const size_t R_UNIQUE(_rh_cap) = (new_capacity);                                                               \
+        typeof((m)->slots) R_UNIQUE(_rh_slots) =                                                                       \
+            mem_alloc(R_(map_block_size)(R_UNIQUE(_rh_cap), map_entry_size(m)));                                       \
+        if (R_UNIQUE(_rh_slots) == nullptr) {                                                                          \
+            err_set(R_ERR_ALLOC_FAILED, nullptr);                                                                      \
+        } else {                                                                                                       \
+            uint8_t * R_UNIQUE(_rh_ctrl) = (uint8_t *)(R_UNIQUE(_rh_slots) + R_UNIQUE(_rh_cap));                       \
+            memset(R_UNIQUE(_rh_ctrl), R_MAP_EMPTY, R_UNIQUE(_rh_cap) + R_MAP_GROUP_WIDTH);                            \
+            for (size_t R_UNIQUE(_rh_i) = 0; R_UNIQUE(_rh_i) < (m)->capacity; R_UNIQUE(_rh_i)++) {                     \
+                if (R_MAP_IS_FULL((m)->ctrl[R_UNIQUE(_rh_i)])) {                                                       \
+                    const uint64_t R_UNIQUE(_rh_hash) =                                                                \
+                        R_MAP_HASH((m)->slots[R_UNIQUE(_rh_i)].key __VA_OPT__(, ) __VA_ARGS__);                        \
+                    const size_t R_UNIQUE(_rh_pos) =                                                                   \
+                        R_(map_find_free)(R_UNIQUE(_rh_ctrl), R_UNIQUE(_rh_cap), R_UNIQUE(_rh_hash));                  \
+                    R_(map_set_ctrl)(                                                                                  \
+                        R_UNIQUE(_rh_ctrl), R_UNIQUE(_rh_cap), R_UNIQUE(_rh_pos), R_MAP_H2(R_UNIQUE(_rh_hash))         \
+                    );                                                                                                 \
+                    R_UNIQUE(_rh_slots)[R_UNIQUE(_rh_pos)] = (m)->slots[R_UNIQUE(_rh_i)];                              \
+                }                                                                                                      \
+            }                                                                                                          \
+            if ((m)->slots != nullptr) {                                                                               \
+                mem_free((m)->slots, R_(map_block_size)((m)->capacity, map_entry_size(m)));                            \
+            }                                                                                                          \
+            (m)->slots = R_UNIQUE(_rh_slots);                                                                          \
+            (m)->ctrl = R_UNIQUE(_rh_ctrl);                                                                            \
+            (m)->capacity = R_UNIQUE(_rh_cap);                                                                         \
+            (m)->tombstones = 0;                                                                                       \
+            R_TRACE_ADD(R_TRACE_MAP_REHASHES, 1);                                                                      \
+            R_TRACE_ADD(R_TRACE_MAP_REHASH_NS, R_TRACE_NOW() - R_UNIQUE(_rh_start));                                   \
+        }                                                                                                              \
+    })
+
+// Grow, or purge tombstones in place, when one more key would exceed the max load (a failed rehash keeps the table)
+#define R_MAP_MAKE_ROOM(m, ...)                                                                                        \
+    ({                                                                                                                 \
+        if ((m)->size + (m)->tombstones + 1 > R_(map_max_load)((m)->capacity)) {                                       \
+            size_t R_UNIQUE(_mkr_cap) = (m)->capacity;                                                                 \
+            if (((m)->size + 1) * 2 > R_(map_max_load)((m)->capacity)) {                                               \
+                R_UNIQUE(_mkr_cap) = R_(map_capacity_for)((m)->size + 1);                                              \
+                if (R_UNIQUE(_mkr_cap) < (m)->capacity * 2) {                                                          \
+                    R_UNIQUE(_mkr_cap) = (m)->capacity * 2;                                                            \
+                }                                                                                                      \
+            }                                                                                                          \
+            R_MAP_REHASH((m), R_UNIQUE(_mkr_cap) __VA_OPT__(, ) __VA_ARGS__);                                          \
+        }                                                                                                              \
+    })
+
+// Remove the entry in full slot idx: emptied, or left as a tombstone, as described at map_remove; set_ctrl stores the
+// control bytes (R_(map_set_ctrl), or cmap.h's atomic variant)
+#define R_MAP_ERASE_WITH(m, idx, set_ctrl)                                                                             \
+    ({                                                                                                                 \
+        const size_t R_UNIQUE(_ers_idx) = (idx);                                                                       \
+        const size_t R_UNIQUE(_ers_next) = (R_UNIQUE(_ers_idx) + 1) & ((m)->capacity - 1);                             \
+        if ((m)->ctrl[R_UNIQUE(_ers_next)] == R_MAP_EMPTY) {                                                           \
+            set_ctrl((m)->ctrl, (m)->capacity, R_UNIQUE(_ers_idx), R_MAP_EMPTY);                                       \
+        } else {                                                                                                       \
+            set_ctrl((m)->ctrl, (m)->capacity, R_UNIQUE(_ers_idx), R_MAP_DELETED);                                     \
+            (m)->tombstones++;                                                                                         \
+        }                                                                                                              \
+        (m)->size--;                                                                                                   \
+    })
+
+#define R_MAP_ERASE(m, idx) R_MAP_ERASE_WITH((m), (idx), R_(map_set_ctrl))
+
+// --------------------------------------------------- Public macros ---------------------------------------------------
+
+#define map_size(m) (m)->size
+
+#define map_capacity(m) (m)->capacity
+
+#define map_empty(m) ((m)->size == 0)
+
+#define map_free(m)                                                                                                    \
+    ({                                                                                                                 \
+        if ((m) != nullptr) {                                                                                          \
+            if ((m)->slots != nullptr) {                                                                               \
+                mem_free((m)->slots, R_(map_block_size)((m)->capacity, map_entry_size(m)));                            \
+            }                                                                                                          \
+            (m)->slots = nullptr;                                                                                      \
+            (m)->ctrl = nullptr;                                                                                       \
+            (m)->size = 0;                                                                                             \
+            (m)->capacity = 0;                                                                                         \
+            (m)->tombstones = 0;                                                                                       \
+        }                                                                                                              \
+    })
+
+#define map_clear(m)                                                                                                   \
+    ({                                                                                                                 \
+        if ((m)->ctrl != nullptr) {                                                                                    \
+            memset((m)->ctrl, R_MAP_EMPTY, (m)->capacity + R_MAP_GROUP_WIDTH);                                         \
+        }                                                                                                              \
+        (m)->size = 0;                                                                                                 \
+        (m)->tombstones = 0;                                                                                           \
+    })
+
+#define map_reserve(m, n, ...)                                                                                         \
+    ({                                                                                                                 \
+        const size_t R_UNIQUE(_rsv_cap) = R_(map_capacity_for)((n));                                                   \
+        if (R_UNIQUE(_rsv_cap) > (m)->capacity) {                                                                      \
+            R_MAP_REHASH((m), R_UNIQUE(_rsv_cap) __VA_OPT__(, ) __VA_ARGS__);                                          \
+        }                                                                                                              \
+    })
+
+#define map_get(m, k, ...)                                                                                             \
+    ({                                                                                                                 \
+        map_key_type(m) R_UNIQUE(_get_key) = (k);                                                                      \
+        const uint64_t R_UNIQUE(_get_hash) = R_MAP_HASH(R_UNIQUE(_get_key) __VA_OPT__(, ) __VA_ARGS__);                \
+        const size_t R_UNIQUE(_get_idx) =                                                                              \
+            R_MAP_FIND((m), R_UNIQUE(_get_key), R_UNIQUE(_get_hash) __VA_OPT__(, ) __VA_ARGS__);                       \
+        /* return */ R_UNIQUE(_get_idx) != SIZE_MAX ? &(m)->slots[R_UNIQUE(_get_idx)].val : nullptr;                   \
+    })
+
+#define map_contains(m, k, ...) (map_get((m), (k)__VA_OPT__(, ) __VA_ARGS__) != nullptr)
+
+// true if k was new; false also when an empty map could not allocate its first table (R_ERR_ALLOC_FAILED)
+#define map_put(m, k, v, ...)                                                                                          \
+    ({                                                                                                                 \
+        map_key_type(m) R_UNIQUE(_put_key) = (k);                                                                      \
+        const uint64_t R_UNIQUE(_put_hash) = R_MAP_HASH(R_UNIQUE(_put_key) __VA_OPT__(, ) __VA_ARGS__);                \
+        size_t R_UNIQUE(_put_idx) =                                                                                    \
+            R_MAP_FIND((m), R_UNIQUE(_put_key), R_UNIQUE(_put_hash) __VA_OPT__(, ) __VA_ARGS__);                       \
+        bool R_UNIQUE(_put_new) = R_UNIQUE(_put_idx) == SIZE_MAX;                                                      \
+        if (R_UNIQUE(_put_new)) {                                                                                      \
+            R_MAP_MAKE_ROOM((m)__VA_OPT__(, ) __VA_ARGS__);                                                            \
+            if ((m)->ctrl == nullptr) {                                                                                \
+                /* no first table: the rehash failed with R_ERR_ALLOC_FAILED */                                        \
+                R_UNIQUE(_put_new) = false;                                                                            \
+            } else {                                                                                                   \
+                /* a failed grow leaves the table over its max load, but never without a free slot */                  \
+                R_UNIQUE(_put_idx) = R_(map_find_free)((m)->ctrl, (m)->capacity, R_UNIQUE(_put_hash));                 \
+                if ((m)->ctrl[R_UNIQUE(_put_idx)] == R_MAP_DELETED) {                                                  \
+                    (m)->tombstones--;                                                                                 \
+                }                                                                                                      \
+                R_(map_set_ctrl)((m)->ctrl, (m)->capacity, R_UNIQUE(_put_idx), R_MAP_H2(R_UNIQUE(_put_hash)));         \
+                (m)->slots[R_UNIQUE(_put_idx)].key = R_UNIQUE(_put_key);                                               \
+                (m)->size++;                                                                                           \
+            }                                                                                                          \
+        }                                                                                                              \
+        if (R_UNIQUE(_put_idx) != SIZE_MAX) {                                                                          \
+            (m)->slots[R_UNIQUE(_put_idx)].val = (v);                                                                  \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_put_new);                                                                               \
+    })
+
+/**
+ * Remove k from the map.
+ * The slot becomes empty when the next slot is already empty (no probe sequence can pass through it),
+ * otherwise it becomes a tombstone so that later keys on the same probe sequence stay reachable.
+ */
+#define map_remove(m, k, ...)                                                                                          \
+    ({                                                                                                                 \
+        map_key_type(m) R_UNIQUE(_rmv_key) = (k);                                                                      \
+        const uint64_t R_UNIQUE(_rmv_hash) = R_MAP_HASH(R_UNIQUE(_rmv_key) __VA_OPT__(, ) __VA_ARGS__);                \
+        const size_t R_UNIQUE(_rmv_idx) =                                                                              \
+            R_MAP_FIND((m), R_UNIQUE(_rmv_key), R_UNIQUE(_rmv_hash) __VA_OPT__(, ) __VA_ARGS__);                       \
+        if (R_UNIQUE(_rmv_idx) != SIZE_MAX) {                                                                          \
+            R_MAP_ERASE((m), R_UNIQUE(_rmv_idx));                                                                      \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_rmv_idx) != SIZE_MAX;                                                                   \
+    })
+
+/**
+ * Iterate over all entries in slot order.
+ * `entry` is declared as a pointer to the entry struct with `->key` and `->val` members.
+ * The map must not be modified during iteration; `break` and `continue` behave as in a plain loop.
+ */
+#define map_foreach(m, entry)                                                                                          \
+    for (typeof((m)->slots) entry = R_MAP_NEXT((m), 0); entry != nullptr;                                              \
+         entry = R_MAP_NEXT((m), (size_t)(entry - (m)->slots) + 1))
+
+/**
+ * Put n keys with their values (keys[i] -> vals[i], in order, so the last of equal keys wins) using a task pool, for a
+ * map instantiated with task.h included (see the header comment). Reserves room for all of them first. Returns false if
+ * m, pool, keys or vals is null or the scratch memory cannot be allocated (no key is put), or if a task fails: the
+ * map then holds some of the keys, with a size that counts them, and stays usable.
+ */
+#define map_put_all(key_t, val_t, m, pool, keys, vals, n)                                                              \
+    R_GLUE(MAP(key_t, val_t), _put_all)((m), (pool), (keys), (vals), (n))
+
+// ------------------------------------------------- Progressive map ---------------------------------------------------
+// A progressive map grows without a stop-the-world rehash. When its table (cur) is due to grow or be cleaned up, a
+// fresh table takes its place and the full one becomes old; every later put and remove first moves the next
+// R_MAP_MIGRATE_STEP slots of old into cur (Redis-style incremental rehashing), and old is freed once its last slot
+// has moved. Until then a key lives in exactly one of the two tables, lookups try cur and then old, and new keys go
+// to cur. Moved slots are left as tombstones in old, so a key moved and later removed cannot be found there again.
+
+#define PMAP(key_t, val_t) R_GLUE(pmap_, R_JOIN(key_t, val_t, _))
+
+#define pmap(key_t, val_t) {.cur = map(key_t, val_t), .old = map(key_t, val_t), .cursor = 0}
+
+// Move up to budget slots of old into cur; frees old when its last slot has moved
+#define R_PMAP_MIGRATE(m, budget, ...)                                                                                 \
+    ({                                                                                                                 \
+        if ((m)->old.capacity > 0) {                                                                                   \
+            const size_t R_UNIQUE(_mig_left) = (m)->old.capacity - (m)->cursor;                                        \
+            const size_t R_UNIQUE(_mig_end) =                                                                          \
+                (budget) < R_UNIQUE(_mig_left) ? (m)->cursor + (budget) : (m)->old.capacity;                           \
+            for (; (m)->cursor < R_UNIQUE(_mig_end); (m)->cursor++) {                                                  \
+                const size_t R_UNIQUE(_mig_i) = (m)->cursor;                                                           \
+                if (R_MAP_IS_FULL((m)->old.ctrl[R_UNIQUE(_mig_i)])) {                                                  \
+                    const uint64_t R_UNIQUE(_mig_hash) =                                                               \
+                        R_MAP_HASH((m)->old.slots[R_UNIQUE(_mig_i)].key __VA_OPT__(, ) __VA_ARGS__);                   \
+                    const size_t R_UNIQUE(_mig_pos) =                                                                  \
+                        R_(map_find_free)((m)->cur.ctrl, (m)->cur.capacity, R_UNIQUE(_mig_hash));                      \
+                    if ((m)->cur.ctrl[R_UNIQUE(_mig_pos)] == R_MAP_DELETED) {                                          \
+                        (m)->cur.tombstones--;                                                                         \
+                    }                                                                                                  \
+                    R_(map_set_ctrl)(                                                                                  \
+                        (m)->cur.ctrl, (m)->cur.capacity, R_UNIQUE(_mig_pos), R_MAP_H2(R_UNIQUE(_mig_hash))            \
+                    );                                                                                                 \
+                    (m)->cur.slots[R_UNIQUE(_mig_pos)] = (m)->old.slots[R_UNIQUE(_mig_i)];                             \
+                    (m)->cur.size++;                                                                                   \
+                    R_(map_set_ctrl)((m)->old.ctrl, (m)->old.capacity, R_UNIQUE(_mig_i), R_MAP_DELETED);               \
+                    (m)->old.size--;                                                                                   \
+                }                                                                                                      \
+            }                                                                                                          \
+            if ((m)->cursor == (m)->old.capacity) {                                                                    \
+                map_free(&(m)->old);                                                                                   \
+                (m)->cursor = 0;                                                                                       \
+            }                                                                                                          \
+        }                                                                                                              \
+    })
+
+/**
+ * Make cur an empty table of new_capacity slots and old the full one (nothing may be migrating).
+ * Returns false and leaves the map as it was if the table cannot be allocated (R_ERR_ALLOC_FAILED).
+ */
+#define R_PMAP_START(m, new_capacity)                                                                                  \
+    ({                                                                                                                 \
+        const size_t R_UNIQUE(_pst_cap) = (new_capacity);                                                              \
+        typeof((m)->cur.slots) R_UNIQUE(_pst_slots) =                                                                  \
+            mem_alloc(R_(map_block_size)(R_UNIQUE(_pst_cap), map_entry_size(&(m)->cur)));                              \
+        if (R_UNIQUE(_pst_slots) == nullptr) {                                                                         \
+            err_set(R_ERR_ALLOC_FAILED, nullptr);                                                                      \
+        } else {                                                                                                       \
+            (m)->old = (m)->cur;                                                                                       \
+            (m)->cursor = 0;                                                                                           \
+            (m)->cur = (typeof((m)->cur)){0};                                                                          \
+            (m)->cur.slots = R_UNIQUE(_pst_slots);                                                                     \
+            (m)->cur.ctrl = (uint8_t *)((m)->cur.slots + R_UNIQUE(_pst_cap));                                          \
+            (m)->cur.capacity = R_UNIQUE(_pst_cap);                                                                    \
+            memset((m)->cur.ctrl, R_MAP_EMPTY, R_UNIQUE(_pst_cap) + R_MAP_GROUP_WIDTH);                                \
+            R_TRACE_ADD(R_TRACE_MAP_REHASHES, 1);                                                                      \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_pst_slots) != nullptr;                                                                  \
+    })
+
+// Pointer to the slot holding k (an lvalue of the key type) in cur or old, or nullptr
+#define R_PMAP_FIND(m, k, hash, ...)                                                                                   \
+    ({                                                                                                                 \
+        typeof((m)->cur.slots) R_UNIQUE(_pfd_slot) = nullptr;                                                          \
+        const size_t R_UNIQUE(_pfd_cur) = R_MAP_FIND(&(m)->cur, (k), (hash) __VA_OPT__(, ) __VA_ARGS__);               \
+        if (R_UNIQUE(_pfd_cur) != SIZE_MAX) {                                                                          \
+            R_UNIQUE(_pfd_slot) = &(m)->cur.slots[R_UNIQUE(_pfd_cur)];                                                 \
+        } else if ((m)->old.size > 0) {                                                                                \
+            const size_t R_UNIQUE(_pfd_old) = R_MAP_FIND(&(m)->old, (k), (hash) __VA_OPT__(, ) __VA_ARGS__);           \
+            if (R_UNIQUE(_pfd_old) != SIZE_MAX) {                                                                      \
+                R_UNIQUE(_pfd_slot) = &(m)->old.slots[R_UNIQUE(_pfd_old)];                                             \
+            }                                                                                                          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_pfd_slot);                                                                              \
+    })
+
+// Entry at position pos of old followed by cur (the first full slot at or after it), or nullptr
+#define R_PMAP_NEXT(m, pos)                                                                                            \
+    ({                                                                                                                 \
+        const size_t R_UNIQUE(_pnx_pos) = (pos);                                                                       \
+        typeof((m)->cur.slots) R_UNIQUE(_pnx_entry) = nullptr;                                                         \
+        if (R_UNIQUE(_pnx_pos) < (m)->old.capacity) {                                                                  \
+            R_UNIQUE(_pnx_entry) = R_MAP_NEXT(&(m)->old, R_UNIQUE(_pnx_pos));                                          \
+        }                                                                                                              \
+        if (R_UNIQUE(_pnx_entry) == nullptr) {                                                                         \
+            R_UNIQUE(_pnx_entry) = R_MAP_NEXT(                                                                         \
+                &(m)->cur, R_UNIQUE(_pnx_pos) > (m)->old.capacity ? R_UNIQUE(_pnx_pos) - (m)->old.capacity : 0         \
+            );                                                                                                         \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_pnx_entry);                                                                             \
+    })
+
+#define R_PMAP_POS(m, entry)                                                                                           \
+    ((m)->old.slots != nullptr && (entry) >= (m)->old.slots && (entry) < (m)->old.slots + (m)->old.capacity            \
+         ? (size_t)((entry) - (m)->old.slots)                                                                          \
+         : (m)->old.capacity + (size_t)((entry) - (m)->cur.slots))
+
+#define pmap_size(m) ((m)->cur.size + (m)->old.size)
+
+#define pmap_capacity(m) (m)->cur.capacity
+
+#define pmap_empty(m) (pmap_size(m) == 0)
+
+#define pmap_migrating(m) ((m)->old.capacity > 0)
+
+#define pmap_free(m)                                                                                                   \
+    ({                                                                                                                 \
+        if ((m) != nullptr) {                                                                                          \
+            map_free(&(m)->cur);                                                                                       \
+            map_free(&(m)->old);                                                                                       \
+            (m)->cursor = 0;                                                                                           \
+        }                                                                                                              \
+    })
+
+#define pmap_clear(m)                                                                                                  \
+    ({                                                                                                                 \
+        map_clear(&(m)->cur);                                                                                          \
+        map_free(&(m)->old);                                                                                           \
+        (m)->cursor = 0;                                                                                               \
+    })
+
+// Move up to n slots of a migration in progress (e.g. from an idle loop); returns true while one is still running
+#define pmap_step(m, n, ...)                                                                                           \
+    ({                                                                                                                 \
+        R_PMAP_MIGRATE((m), (n)__VA_OPT__(, ) __VA_ARGS__);                                                            \
+        /* return */ pmap_migrating(m);                                                                                \
+    })
+
+#define pmap_get(m, k, ...)                                                                                            \
+    ({                                                                                                                 \
+        map_key_type(&(m)->cur) R_UNIQUE(_pgt_key) = (k);                                                              \
+        const uint64_t R_UNIQUE(_pgt_hash) = R_MAP_HASH(R_UNIQUE(_pgt_key) __VA_OPT__(, ) __VA_ARGS__);                \
+        typeof((m)->cur.slots) R_UNIQUE(_pgt_slot) =                                                                   \
+            R_PMAP_FIND((m), R_UNIQUE(_pgt_key), R_UNIQUE(_pgt_hash) __VA_OPT__(, ) __VA_ARGS__);                      \
+        /* return */ R_UNIQUE(_pgt_slot) != nullptr ? &R_UNIQUE(_pgt_slot)->val : nullptr;                             \
+    })
+
+#define pmap_contains(m, k, ...) (pmap_get((m), (k)__VA_OPT__(, ) __VA_ARGS__) != nullptr)
+
+/**
+ * Insert or overwrite like map_put, after one migration step. A new key that would push cur past the max load starts
+ * a migration to a table sized by the map_put rules instead of rehashing; the one exception is the very first table,
+ * which has nothing to move. Should a migration still be running at that point (R_MAP_MIGRATE_STEP configured too
+ * small), it is finished first. If the table for that new key cannot be allocated, the key is not put and false is
+ * returned (R_ERR_ALLOC_FAILED); the map keeps its entries and stays usable.
+ */
+#define pmap_put(m, k, v, ...)                                                                                         \
+    ({                                                                                                                 \
+        R_PMAP_MIGRATE((m), R_MAP_MIGRATE_STEP __VA_OPT__(, ) __VA_ARGS__);                                            \
+        map_key_type(&(m)->cur) R_UNIQUE(_ppt_key) = (k);                                                              \
+        const uint64_t R_UNIQUE(_ppt_hash) = R_MAP_HASH(R_UNIQUE(_ppt_key) __VA_OPT__(, ) __VA_ARGS__);                \
+        typeof((m)->cur.slots) R_UNIQUE(_ppt_slot) =                                                                   \
+            R_PMAP_FIND((m), R_UNIQUE(_ppt_key), R_UNIQUE(_ppt_hash) __VA_OPT__(, ) __VA_ARGS__);                      \
+        bool R_UNIQUE(_ppt_new) = R_UNIQUE(_ppt_slot) == nullptr;                                                      \
+        if (R_UNIQUE(_ppt_new)) {                                                                                      \
+            bool R_UNIQUE(_ppt_room) = true;                                                                           \
+            if ((m)->cur.size + (m)->cur.tombstones + 1 > R_(map_max_load)((m)->cur.capacity)) {                       \
+                if ((m)->cur.capacity == 0) {                                                                          \
+                    R_MAP_REHASH(&(m)->cur, R_(map_capacity_for)(1) __VA_OPT__(, ) __VA_ARGS__);                       \
+                    R_UNIQUE(_ppt_room) = (m)->cur.ctrl != nullptr;                                                    \
+                } else {                                                                                               \
+                    R_PMAP_MIGRATE((m), SIZE_MAX __VA_OPT__(, ) __VA_ARGS__);                                          \
+                    size_t R_UNIQUE(_ppt_cap) = (m)->cur.capacity;                                                     \
+                    if (((m)->cur.size + 1) * 2 > R_(map_max_load)((m)->cur.capacity)) {                               \
+                        R_UNIQUE(_ppt_cap) = R_(map_capacity_for)((m)->cur.size + 1);                                  \
+                        if (R_UNIQUE(_ppt_cap) < (m)->cur.capacity * 2) {                                              \
+                            R_UNIQUE(_ppt_cap) = (m)->cur.capacity * 2;                                                \
+                        }                                                                                              \
+                    }                                                                                                  \
+                    R_UNIQUE(_ppt_room) = R_PMAP_START((m), R_UNIQUE(_ppt_cap));                                       \
+                }                                                                                                      \
+            }                                                                                                          \
+            if (!R_UNIQUE(_ppt_room)) {                                                                                \
+                R_UNIQUE(_ppt_new) = false;                                                                            \
+            } else {                                                                                                   \
+                const size_t R_UNIQUE(_ppt_idx) =                                                                      \
+                    R_(map_find_free)((m)->cur.ctrl, (m)->cur.capacity, R_UNIQUE(_ppt_hash));                          \
+                if ((m)->cur.ctrl[R_UNIQUE(_ppt_idx)] == R_MAP_DELETED) {                                              \
+                    (m)->cur.tombstones--;                                                                             \
+                }                                                                                                      \
+                R_(map_set_ctrl)((m)->cur.ctrl, (m)->cur.capacity, R_UNIQUE(_ppt_idx), R_MAP_H2(R_UNIQUE(_ppt_hash))); \
+                R_UNIQUE(_ppt_slot) = &(m)->cur.slots[R_UNIQUE(_ppt_idx)];                                             \
+                R_UNIQUE(_ppt_slot)->key = R_UNIQUE(_ppt_key);                                                         \
+                (m)->cur.size++;                                                                                       \
+            }                                                                                                          \
+        }                                                                                                              \
+        if (R_UNIQUE(_ppt_slot) != nullptr) {                                                                          \
+            R_UNIQUE(_ppt_slot)->val = (v);                                                                            \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_ppt_new);                                                                               \
+    })
+
+// Remove k like map_remove, after one migration step
+#define pmap_remove(m, k, ...)                                                                                         \
+    ({                                                                                                                 \
+        R_PMAP_MIGRATE((m), R_MAP_MIGRATE_STEP __VA_OPT__(, ) __VA_ARGS__);                                            \
+        map_key_type(&(m)->cur) R_UNIQUE(_prm_key) = (k);                                                              \
+        const uint64_t R_UNIQUE(_prm_hash) = R_MAP_HASH(R_UNIQUE(_prm_key) __VA_OPT__(, ) __VA_ARGS__);                \
+        size_t R_UNIQUE(_prm_idx) =                                                                                    \
+            R_MAP_FIND(&(m)->cur, R_UNIQUE(_prm_key), R_UNIQUE(_prm_hash) __VA_OPT__(, ) __VA_ARGS__);                 \
+        bool R_UNIQUE(_prm_found) = R_UNIQUE(_prm_idx) != SIZE_MAX;                                                    \
+        if (R_UNIQUE(_prm_found)) {                                                                                    \
+            R_MAP_ERASE(&(m)->cur, R_UNIQUE(_prm_idx));                                                                \
+        } else if ((m)->old.size > 0) {                                                                                \
+            R_UNIQUE(_prm_idx) =                                                                                       \
+                R_MAP_FIND(&(m)->old, R_UNIQUE(_prm_key), R_UNIQUE(_prm_hash) __VA_OPT__(, ) __VA_ARGS__);             \
+            R_UNIQUE(_prm_found) = R_UNIQUE(_prm_idx) != SIZE_MAX;                                                     \
+            if (R_UNIQUE(_prm_found)) {                                                                                \
+                R_MAP_ERASE(&(m)->old, R_UNIQUE(_prm_idx));                                                            \
+            }                                                                                                          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_prm_found);                                                                             \
+    })
+
+/**
+ * Iterate over all entries: those still in old, then those in cur.
+ * The same rules as map_foreach apply; pmap_get and pmap_contains are allowed, put, remove and step are not.
+ */
+#define pmap_foreach(m, entry)                                                                                         \
+    for (typeof((m)->cur.slots) entry = R_PMAP_NEXT((m), 0); entry != nullptr;                                         \
+         entry = R_PMAP_NEXT((m), R_PMAP_POS((m), entry) + 1))
+
+#endif // RUNE_MAP_API
+
+// Type definition and implementation
+// ---------------------------------------------------------------------------------------------------------------------
+
+#if defined(K) && defined(V)
+
 typedef struct {
+    K key;
+    V val;
+} MAP_ENTRY(K, V);
+
+typedef struct {
+    MAP_ENTRY(K, V) * slots;
+    uint8_t * ctrl;
     size_t size;
-    RBT(instance) items;
-} map_bucket;
+    size_t capacity;
+    size_t tombstones;
+} MAP(K, V);
+
+// cur takes all inserts; old is the table being migrated out of (empty unless pmap_migrating), cursor its next slot
+typedef struct {
+    MAP(K, V) cur;
+    MAP(K, V) old;
+    size_t cursor;
+} PMAP(K, V);
 
-static map_bucket bucket() {
-    return (map_bucket){
-        .size = 0,
-        .items = rbt(instance),
-    };
+#ifdef RUNE_TASK_H
+
+// Hash and equality used by map_put_all: K_HASH / K_EQ when both are defined, the defaults otherwise
+#if defined(K_HASH) && defined(K_EQ)
+#define R_MAP_BULK_HASH(k) R_MAP_HASH_CUSTOM(k, K_HASH, K_EQ)
+#define R_MAP_BULK_EQ(a, b) R_MAP_EQ_CUSTOM(a, b, K_HASH, K_EQ)
+#define R_MAP_BULK_PUT(m, k, v) map_put((m), (k), (v), K_HASH, K_EQ)
+#define R_MAP_BULK_REHASH(m, new_capacity) R_MAP_REHASH((m), (new_capacity), K_HASH, K_EQ)
+#else
+#define R_MAP_BULK_HASH(k) R_MAP_HASH_DEFAULT(k)
+#define R_MAP_BULK_EQ(a, b) R_MAP_EQ_DEFAULT(a, b)
+#define R_MAP_BULK_PUT(m, k, v) map_put((m), (k), (v))
+#define R_MAP_BULK_REHASH(m, new_capacity) R_MAP_REHASH((m), (new_capacity))
+#endif
+
+/**
+ * map_put_all: the table is cut into a power of two regions of equal size, and a key belongs to the region of its
+ * home slot (a prefix of its hash). Per batch of keys, tasks hash the keys and count them per region, scatter their
+ * indices so each region's keys are contiguous (in input order), then insert the keys of each region into it. A key
+ * whose probe sequence would read a group reaching past the end of its region is deferred and inserted afterwards on
+ * the calling thread, so no two tasks ever touch the same control bytes or slots. The chunks of keys hashed and
+ * scattered by each task match the region count, so the per-chunk counts form a regions x regions table.
+ */
+typedef struct {
+    MAP(K, V) * m;
+    const K * keys;
+    const V * vals;
+    uint64_t * hashes;
+    size_t * order;
+    size_t * offsets;
+    size_t * starts;
+    size_t * deferred;
+    size_t * added;
+    size_t * reused;
+    size_t begin;
+    size_t n;
+    size_t regions;
+    size_t shift;
+} R_GLUE(MAP(K, V), _bulk);
+
+#define R_MAP_BULK_REGION_OF(job, hash) ((R_MAP_H1((hash)) & ((job)->m->capacity - 1)) >> (job)->shift)
+#define R_MAP_BULK_CHUNK_AT(job, c) ((c) * (job)->n / (job)->regions)
+
+[[maybe_unused]]
+static void R_GLUE(MAP(K, V), _bulk_hash)(void * arg, const size_t begin, const size_t end) {
+    const R_GLUE(MAP(K, V), _bulk) * job = arg;
+    for (size_t c = begin; c < end; c++) {
+        size_t * counts = job->offsets + c * job->regions;
+        for (size_t i = R_MAP_BULK_CHUNK_AT(job, c); i < R_MAP_BULK_CHUNK_AT(job, c + 1); i++) {
+            const uint64_t hash = R_MAP_BULK_HASH(job->keys[job->begin + i]);
+            job->hashes[i] = hash;
+            counts[R_MAP_BULK_REGION_OF(job, hash)]++;
+        }
+    }
 }
 
-static bool bucket_add(instance val) {
+[[maybe_unused]]
+static void R_GLUE(MAP(K, V), _bulk_scatter)(void * arg, const size_t begin, const size_t end) {
+    const R_GLUE(MAP(K, V), _bulk) * job = arg;
+    for (size_t c = begin; c < end; c++) {
+        size_t * next = job->offsets + c * job->regions;
+        for (size_t i = R_MAP_BULK_CHUNK_AT(job, c); i < R_MAP_BULK_CHUNK_AT(job, c + 1); i++) {
+            job->order[next[R_MAP_BULK_REGION_OF(job, job->hashes[i])]++] = i;
+        }
+    }
+}
 
+/**
+ * Put batch key i into the region ending at slot hi as map_put would, counting a new entry in added and a reused
+ * tombstone in reused. Returns false, changing nothing, when the probe reaches a group that does not lie entirely
+ * inside the region before it finds the key or an empty slot.
+ */
+[[maybe_unused]]
+static bool R_GLUE(MAP(K, V), _bulk_put)(
+    const R_GLUE(MAP(K, V), _bulk) * job, const size_t i, const size_t hi, size_t * added, size_t * reused
+) {
+    MAP(K, V) * m = job->m;
+    const size_t at = job->begin + i;
+    const uint64_t hash = job->hashes[i];
+    const uint8_t h2 = R_MAP_H2(hash);
+    size_t vacant = SIZE_MAX;
+    for (size_t pos = R_MAP_H1(hash) & (m->capacity - 1); pos + R_MAP_GROUP_WIDTH <= hi; pos += R_MAP_GROUP_WIDTH) {
+        const uint8_t * group = m->ctrl + pos;
+        for (uint64_t match = R_(map_group_match)(group, h2); match != 0; match &= match - 1) {
+            const size_t slot = pos + R_MAP_MASK_NEXT(match);
+            if (R_MAP_BULK_EQ(m->slots[slot].key, job->keys[at])) {
+                m->slots[slot].val = job->vals[at];
+                return true;
+            }
+        }
+        if (vacant == SIZE_MAX) {
+            const uint64_t free = R_(map_group_match_free)(group);
+            vacant = free != 0 ? pos + R_MAP_MASK_NEXT(free) : SIZE_MAX;
+        }
+        if (R_(map_group_match_empty)(group) != 0) {
+            *added += 1;
+            *reused += m->ctrl[vacant] == R_MAP_DELETED;
+            R_(map_set_ctrl)(m->ctrl, m->capacity, vacant, h2);
+            m->slots[vacant].key = job->keys[at];
+            m->slots[vacant].val = job->vals[at];
+            return true;
+        }
+    }
     return false;
 }
 
-// =====================================================================================================================
-// map
-// =====================================================================================================================
+// Insert the keys of regions [begin, end); each region's deferred keys move to the front of its part of order
+[[maybe_unused]]
+static void R_GLUE(MAP(K, V), _bulk_insert)(void * arg, const size_t begin, const size_t end) {
+    const R_GLUE(MAP(K, V), _bulk) * job = arg;
+    for (size_t r = begin; r < end; r++) {
+        const size_t hi = (r + 1) << job->shift;
+        const size_t first = job->starts[r];
+        size_t deferred = 0;
+        size_t added = 0;
+        size_t reused = 0;
+        for (size_t k = first; k < job->starts[r + 1]; k++) {
+            const size_t i = job->order[k];
+            if (!R_GLUE(MAP(K, V), _bulk_put)(job, i, hi, &added, &reused)) {
+                job->order[first + deferred++] = i;
+            }
+        }
+        job->deferred[r] = deferred;
+        job->added[r] = added;
+        job->reused[r] = reused;
+    }
+}
 
-typedef struct {
-    size_t n_buckets;
-    map_bucket * buckets;
-} map;
+[[maybe_unused]]
+static bool R_GLUE(MAP(K, V), _put_all)(
+    MAP(K, V) * m, task_pool * pool, const K * keys, const V * vals, const size_t n
+) {
+    if (err_null(m) || err_null(pool) || (n > 0 && (err_null(keys) || err_null(vals)))) {
+        return false;
+    }
+    // Room for every key up front: nothing below rehashes, so the regions stay put
+    if (m->size + m->tombstones + n > R_(map_max_load)(m->capacity)) {
+        const size_t capacity = R_(map_capacity_for)(m->size + n);
+        R_MAP_BULK_REHASH(m, capacity > m->capacity ? capacity : m->capacity);
+    }
+
+    R_GLUE(MAP(K, V), _bulk) job = {.m = m, .keys = keys, .vals = vals, .regions = 2};
+    while (job.regions < 4 * task_pool_workers(pool)) {
+        job.regions *= 2;
+    }
+    while (job.regions > 1 && m->capacity / job.regions < R_MAP_BULK_REGION) {
+        job.regions /= 2;
+    }
+    if (job.regions < 2 || n < R_MAP_BULK_REGION) {
+        for (size_t i = 0; i < n; i++) {
+            R_MAP_BULK_PUT(m, keys[i], vals[i]);
+        }
+        return true;
+    }
+    while ((job.regions << job.shift) < m->capacity) {
+        job.shift++;
+    }
+
+    const size_t batch = n < R_MAP_BULK_BATCH ? n : R_MAP_BULK_BATCH;
+    const size_t regions = job.regions;
+    const size_t counters = regions * regions + 4 * regions + 1;
+    const size_t block_size = batch * (sizeof(uint64_t) + sizeof(size_t)) + counters * sizeof(size_t);
+    job.hashes = mem_alloc(block_size);
+    if (job.hashes == nullptr) {
+        return false;
+    }
+    job.order = (size_t *)(job.hashes + batch);
+    job.offsets = job.order + batch;
+    job.starts = job.offsets + regions * regions;
+    job.deferred = job.starts + regions + 1;
+    job.added = job.deferred + regions;
+    job.reused = job.added + regions;
+
+    bool ok = true;
+    for (job.begin = 0; ok && job.begin < n; job.begin += job.n) {
+        job.n = n - job.begin < batch ? n - job.begin : batch;
+        memset(job.offsets, 0, regions * regions * sizeof(size_t));
+        ok = task_for(pool, regions, 1, R_GLUE(MAP(K, V), _bulk_hash), &job);
+
+        // Counts to first positions: regions in order, and within a region the chunks in order
+        size_t total = 0;
+        for (size_t r = 0; r < regions; r++) {
+            job.starts[r] = total;
+            for (size_t c = 0; c < regions; c++) {
+                const size_t count = job.offsets[c * regions + r];
+                job.offsets[c * regions + r] = total;
+                total += count;
+            }
+        }
+        job.starts[regions] = total;
+
+        ok = ok && task_for(pool, regions, 1, R_GLUE(MAP(K, V), _bulk_scatter), &job) &&
+             task_for(pool, regions, 1, R_GLUE(MAP(K, V), _bulk_insert), &job);
+        if (!ok) {
+            // Regions that did insert are not reported: recount from the control bytes to match the table again
+            m->size = 0;
+            m->tombstones = 0;
+            for (size_t i = 0; i < m->capacity; i++) {
+                m->size += R_MAP_IS_FULL(m->ctrl[i]);
+                m->tombstones += m->ctrl[i] == R_MAP_DELETED;
+            }
+            break;
+        }
+        for (size_t r = 0; r < regions; r++) {
+            m->size += job.added[r];
+            m->tombstones -= job.reused[r];
+        }
+        for (size_t r = 0; r < regions; r++) {
+            for (size_t d = 0; d < job.deferred[r]; d++) {
+                const size_t at = job.begin + job.order[job.starts[r] + d];
+                R_MAP_BULK_PUT(m, keys[at], vals[at]);
+            }
+        }
+    }
+    mem_free(job.hashes, block_size);
+    return ok;
+}
+
+#undef R_MAP_BULK_CHUNK_AT
+#undef R_MAP_BULK_REGION_OF
+#undef R_MAP_BULK_REHASH
+#undef R_MAP_BULK_PUT
+#undef R_MAP_BULK_EQ
+#undef R_MAP_BULK_HASH
 
-#endif // T
+#endif // RUNE_TASK_H
 
-#endif // RUNE_MAP_H
+#endif // K and V
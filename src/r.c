@@ -5,15 +5,29 @@
  *   - Thread-local error stack with automatic location capture
  *   - Allocator stack management with push/pop semantics
  *   - Default malloc/realloc/free allocator
+ *   - Arena (bump) allocator with chunk reuse across resets
+ *   - Slab allocator with size-class free lists
+ *   - Trace allocator recording counts, live/peak bytes, a size histogram and call sites, with a JSON dump
+ *   - Trace counters: per-thread blocks on a global list, summed on demand, with Prometheus and JSON exporters
  *   - Type-safe memory allocation macros
  */
 
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#ifndef __STDC_NO_THREADS__
+#include <threads.h>
+#endif
 
 #include "r.h"
 
+// The call-site macros (RCFG__ALLOC_SITES) would otherwise rename the definitions of the memory operations below
+#undef mem_alloc
+#undef mem_alloc_zero
+#undef mem_realloc
+
 /*
  * =====================================================================================================================
  * ERROR HANDLING
@@ -26,6 +40,15 @@ _Thread_local r_error_stack_t r_error_stack = {.depth = 0, .enabled = true};
 
 // ---------------------------------------------- API: Setup & Reporting -----------------------------------------------
 
+#ifdef RCFG__ERROR_CODE_ONLY
+bool R_(err_set)(r_error_code code, const char * message, const char * file, int line, const char * func) {
+    (void)message;
+    (void)file;
+    (void)line;
+    (void)func;
+    return R_(err_set_code)(code);
+}
+#else  // RCFG__ERROR_CODE_ONLY
 bool R_(err_set)(r_error_code code, const char * message, const char * file, int line, const char * func) {
     if (!r_error_stack.enabled || r_error_stack.depth >= R_ERROR_STACK_MAX) {
         return false;
@@ -45,6 +68,7 @@ bool R_(err_set)(r_error_code code, const char * message, const char * file, int
     memcpy(&r_error_stack.stack[r_error_stack.depth++], &new_error, sizeof(r_error_ctx));
     return true;
 }
+#endif // RCFG__ERROR_CODE_ONLY
 
 void R_(err_print)(FILE * stream) {
     if (!R_(err_has)()) {
@@ -54,7 +78,9 @@ void R_(err_print)(FILE * stream) {
 
     const r_error_ctx * err = R_(err_get)();
     fprintf(stream, "Error [%d]: %s\n", err->code, err->message);
-    fprintf(stream, "  at %s:%d in %s()\n", err->file, err->line, err->func);
+    if (err->file != nullptr) {
+        fprintf(stream, "  at %s:%d in %s()\n", err->file, err->line, err->func);
+    }
 }
 
 void R_(err_print_stack)(FILE * stream) {
@@ -65,8 +91,14 @@ void R_(err_print_stack)(FILE * stream) {
 
     fprintf(stream, "Error stack trace (depth=%d):\n", r_error_stack.depth);
     for (int i = r_error_stack.depth - 1; i >= 0; i--) {
-        const r_error_ctx * err = &r_error_stack.stack[i];
-        fprintf(stream, "  [%d] %s (%d) at %s:%d in %s()\n", i, err->message, err->code, err->file, err->line, err->func);
+        const r_error_ctx * err = R_(err_at)(i);
+        if (err->file == nullptr) {
+            fprintf(stream, "  [%d] %s (%d)\n", i, err->message, err->code);
+        } else {
+            fprintf(
+                stream, "  [%d] %s (%d) at %s:%d in %s()\n", i, err->message, err->code, err->file, err->line, err->func
+            );
+        }
     }
 }
 
@@ -142,16 +174,38 @@ const char * r_error_message(r_error_code code) {
 
 // -------------------------------------------------- API: Inspection --------------------------------------------------
 
+#ifdef RCFG__ERROR_CODE_ONLY
+// Contexts handed out by err_get / err_at, rebuilt from the recorded code on each query
+static _Thread_local r_error_ctx r_error_views[R_ERROR_STACK_MAX];
+
+static const r_error_ctx * r_error_view(int index) {
+    const r_error_code code = r_error_stack.stack[index];
+    const r_error_ctx view = {.code = code, .message = r_error_message(code)};
+    memcpy(&r_error_views[index], &view, sizeof(r_error_ctx));
+    return &r_error_views[index];
+}
+#else  // RCFG__ERROR_CODE_ONLY
+static const r_error_ctx * r_error_view(int index) {
+    return &r_error_stack.stack[index];
+}
+#endif // RCFG__ERROR_CODE_ONLY
+
 const r_error_ctx * R_(err_get)(void) {
     if (r_error_stack.depth == 0) {
         return nullptr;
     }
-    return &r_error_stack.stack[r_error_stack.depth - 1];
+    return r_error_view(r_error_stack.depth - 1);
 }
 
 r_error_code R_(err_code)(void) {
-    const r_error_ctx * err = R_(err_get)();
-    return err ? err->code : R_ERR_OK;
+    if (r_error_stack.depth == 0) {
+        return R_ERR_OK;
+    }
+#ifdef RCFG__ERROR_CODE_ONLY
+    return r_error_stack.stack[r_error_stack.depth - 1];
+#else  // RCFG__ERROR_CODE_ONLY
+    return r_error_stack.stack[r_error_stack.depth - 1].code;
+#endif // RCFG__ERROR_CODE_ONLY
 }
 
 const char * R_(err_msg)(void) {
@@ -171,7 +225,7 @@ const r_error_ctx * R_(err_at)(int index) {
     if (index < 0 || index >= r_error_stack.depth) {
         return nullptr;
     }
-    return &r_error_stack.stack[index];
+    return r_error_view(index);
 }
 
 // -------------------------------------------------- API: Management --------------------------------------------------
@@ -209,6 +263,13 @@ typedef struct {
 
 static _Thread_local mem_alloc_stack_t mem_alloc_stack = {.depth = 0};
 
+// Top of mem_alloc_stack, or nullptr while it is empty so the mem_* fast path calls the default allocator directly
+static _Thread_local const allocator * mem_alloc_top = nullptr;
+
+// Caller of the memory operation in progress, set by the R_(mem_*_at) entry points and read by trace allocators
+static _Thread_local const char * mem_alloc_site_file = nullptr;
+static _Thread_local int mem_alloc_site_line = 0;
+
 // ------------------------------------------------- Default allocator -------------------------------------------------
 
 // ReSharper disable CppParameterMayBeConstPtrOrRef - match allocator struct function pointers
@@ -222,6 +283,15 @@ static void * r_default_alloc(void * ctx, size_t size) {
     return ptr;
 }
 
+static void * r_default_alloc_zero(size_t size) {
+    void * ptr = calloc(1, size);
+    if (ptr == nullptr) {
+        err_set(R_ERR_OUT_OF_MEMORY, nullptr);
+    }
+    assert(ptr != nullptr);
+    return ptr;
+}
+
 static void * r_default_realloc(void * ctx, void * ptr, size_t old_size, size_t new_size) {
     (void)ctx;
     (void)old_size;
@@ -255,6 +325,7 @@ extern void alloc_push(allocator a) {
     }
     assert(mem_alloc_stack.depth < mem_alloc_STACK_MAX && "Allocator stack overflow");
     mem_alloc_stack.stack[mem_alloc_stack.depth++] = a;
+    mem_alloc_top = &mem_alloc_stack.stack[mem_alloc_stack.depth - 1];
 }
 
 extern void alloc_pop(void) {
@@ -263,37 +334,777 @@ extern void alloc_pop(void) {
     }
     assert(mem_alloc_stack.depth > 0 && "Allocator stack underflow");
     mem_alloc_stack.depth--;
+    mem_alloc_top = mem_alloc_stack.depth > 0 ? &mem_alloc_stack.stack[mem_alloc_stack.depth - 1] : nullptr;
 }
 
 extern allocator alloc_current(void) {
-    if (mem_alloc_stack.depth == 0) {
+    if (mem_alloc_top == nullptr) {
         return r_default_allocator;
     }
-    return mem_alloc_stack.stack[mem_alloc_stack.depth - 1];
+    return *mem_alloc_top;
 }
 
 // ---------------------------------------------- API: Memory operations -----------------------------------------------
+// Each operation reads the cached top-of-stack pointer once. With no allocator pushed it calls the default allocator
+// directly (no struct copy, no indirect call), and mem_alloc_zero uses calloc instead of malloc + memset. With
+// RCFG__TRACE they also feed the allocator trace counters.
 
 extern void * mem_alloc(size_t size) {
-    const allocator a = alloc_current();
-    return a.alloc(a.ctx, size);
+    R_TRACE_ADD(R_TRACE_ALLOCS, 1);
+    R_TRACE_ADD(R_TRACE_ALLOC_BYTES, size);
+    const allocator * a = mem_alloc_top;
+    if (a == nullptr) {
+        return r_default_alloc(nullptr, size);
+    }
+    return a->alloc(a->ctx, size);
 }
 
 extern void * mem_alloc_zero(size_t size) {
-    const allocator a = alloc_current();
-    void * ptr = a.alloc(a.ctx, size);
-    memset(ptr, 0, size);
+    R_TRACE_ADD(R_TRACE_ALLOCS, 1);
+    R_TRACE_ADD(R_TRACE_ALLOC_BYTES, size);
+    const allocator * a = mem_alloc_top;
+    if (a == nullptr) {
+        return r_default_alloc_zero(size);
+    }
+    void * ptr = a->alloc(a->ctx, size);
+    if (ptr != nullptr) {
+        memset(ptr, 0, size);
+    }
     return ptr;
 }
 
 extern void * mem_realloc(void * ptr, size_t old_size, size_t new_size) {
-    const allocator a = alloc_current();
-    return a.realloc(a.ctx, ptr, old_size, new_size);
+    R_TRACE_ADD(R_TRACE_REALLOCS, 1);
+    R_TRACE_ADD(R_TRACE_ALLOC_BYTES, new_size > old_size ? new_size - old_size : 0);
+    const allocator * a = mem_alloc_top;
+    if (a == nullptr) {
+        return r_default_realloc(nullptr, ptr, old_size, new_size);
+    }
+    return a->realloc(a->ctx, ptr, old_size, new_size);
 }
 
 extern void mem_free(void * ptr, size_t size) {
     if (ptr != nullptr) {
-        const allocator a = alloc_current();
-        a.free(a.ctx, ptr, size);
+        R_TRACE_ADD(R_TRACE_FREES, 1);
+        const allocator * a = mem_alloc_top;
+        if (a == nullptr) {
+            r_default_free(nullptr, ptr, size);
+        } else {
+            a->free(a->ctx, ptr, size);
+        }
+    }
+}
+
+// ---------------------------------------------- API: Call-site capture -----------------------------------------------
+
+extern void * R_(mem_alloc_at)(size_t size, const char * file, int line) {
+    mem_alloc_site_file = file;
+    mem_alloc_site_line = line;
+    void * ptr = mem_alloc(size);
+    mem_alloc_site_file = nullptr;
+    mem_alloc_site_line = 0;
+    return ptr;
+}
+
+extern void * R_(mem_alloc_zero_at)(size_t size, const char * file, int line) {
+    mem_alloc_site_file = file;
+    mem_alloc_site_line = line;
+    void * ptr = mem_alloc_zero(size);
+    mem_alloc_site_file = nullptr;
+    mem_alloc_site_line = 0;
+    return ptr;
+}
+
+extern void * R_(mem_realloc_at)(void * ptr, size_t old_size, size_t new_size, const char * file, int line) {
+    mem_alloc_site_file = file;
+    mem_alloc_site_line = line;
+    void * new_ptr = mem_realloc(ptr, old_size, new_size);
+    mem_alloc_site_file = nullptr;
+    mem_alloc_site_line = 0;
+    return new_ptr;
+}
+
+/*
+ * =====================================================================================================================
+ * ARENA ALLOCATOR
+ * =====================================================================================================================
+ */
+
+// -------------------------------------------------- Chunk management -------------------------------------------------
+
+// Round n up to max_align_t alignment (returns 0 on overflow)
+static size_t r_arena_align(size_t n) {
+    constexpr size_t align = alignof(max_align_t);
+    if (n > SIZE_MAX - (align - 1)) {
+        return 0;
+    }
+    return (n + align - 1) & ~(align - 1);
+}
+
+static size_t r_arena_chunk_free(const r_arena_chunk * chunk) {
+    return chunk->size - sizeof(r_arena_chunk) - chunk->used;
+}
+
+/*
+ * Make a->current a chunk with at least size free bytes: keep the current chunk if it has room, move on to the next
+ * spare chunk if that one fits, otherwise link a new chunk right after the current one.
+ */
+static r_arena_chunk * r_arena_reserve(arena * a, size_t size) {
+    r_arena_chunk * current = a->current;
+    if (current != nullptr && r_arena_chunk_free(current) >= size) {
+        return current;
+    }
+
+    r_arena_chunk * next = current != nullptr ? current->next : a->first;
+    if (next != nullptr && next->size - sizeof(r_arena_chunk) >= size) {
+        next->used = 0;
+        a->current = next;
+        return next;
+    }
+
+    if (size > SIZE_MAX - sizeof(r_arena_chunk)) {
+        err_set(R_ERR_OVERFLOW, "arena allocation too large");
+        return nullptr;
+    }
+    size_t chunk_size = a->chunk_size;
+    if (chunk_size < sizeof(r_arena_chunk) + size) {
+        chunk_size = sizeof(r_arena_chunk) + size;
+    }
+
+    r_arena_chunk * chunk = a->parent.alloc(a->parent.ctx, chunk_size);
+    if (chunk == nullptr) {
+        return nullptr;
+    }
+    chunk->size = chunk_size;
+    chunk->used = 0;
+    chunk->next = next;
+    if (current != nullptr) {
+        current->next = chunk;
+    } else {
+        a->first = chunk;
+    }
+    a->current = chunk;
+    return chunk;
+}
+
+// ------------------------------------------------ Allocator callbacks ------------------------------------------------
+
+// ReSharper disable CppParameterMayBeConstPtrOrRef - match allocator struct function pointers
+static void * r_arena_alloc(void * ctx, size_t size) {
+    arena * a = ctx;
+    const size_t need = r_arena_align(size > 0 ? size : 1);
+    if (need == 0) {
+        err_set(R_ERR_OVERFLOW, "arena allocation too large");
+        return nullptr;
+    }
+
+    r_arena_chunk * chunk = r_arena_reserve(a, need);
+    if (chunk == nullptr) {
+        return nullptr;
+    }
+    void * ptr = chunk->data + chunk->used;
+    chunk->used += need;
+    a->used += need;
+    return ptr;
+}
+
+static void * r_arena_realloc(void * ctx, void * ptr, size_t old_size, size_t new_size) {
+    arena * a = ctx;
+    if (ptr == nullptr) {
+        return r_arena_alloc(ctx, new_size);
+    }
+
+    // The most recent allocation can be resized in place
+    r_arena_chunk * chunk = a->current;
+    const size_t old_need = r_arena_align(old_size > 0 ? old_size : 1);
+    const size_t new_need = r_arena_align(new_size > 0 ? new_size : 1);
+    if (chunk != nullptr && new_need != 0 && (unsigned char *)ptr + old_need == chunk->data + chunk->used &&
+        chunk->used - old_need + new_need <= chunk->size - sizeof(r_arena_chunk)) {
+        chunk->used = chunk->used - old_need + new_need;
+        a->used = a->used - old_need + new_need;
+        return ptr;
+    }
+
+    if (new_size <= old_size) {
+        return ptr;
+    }
+    void * new_ptr = r_arena_alloc(ctx, new_size);
+    if (new_ptr != nullptr) {
+        memcpy(new_ptr, ptr, old_size);
+    }
+    return new_ptr;
+}
+
+static void r_arena_free(void * ctx, void * ptr, size_t size) {
+    // Arena memory is released in bulk by arena_reset() / arena_free()
+    (void)ctx;
+    (void)ptr;
+    (void)size;
+}
+// ReSharper restore CppParameterMayBeConstPtrOrRef
+
+// ----------------------------------------------------- API: Arena ----------------------------------------------------
+
+extern allocator arena_allocator(arena * a) {
+    return (allocator){
+        .alloc = r_arena_alloc,
+        .realloc = r_arena_realloc,
+        .free = r_arena_free,
+        .ctx = a,
+    };
+}
+
+extern void arena_reset(arena * a) {
+    // Spare chunks after first keep stale fill levels; r_arena_reserve() rewinds each one as it is reused
+    if (a->first != nullptr) {
+        a->first->used = 0;
+    }
+    a->current = a->first;
+    a->used = 0;
+}
+
+extern void arena_free(arena * a) {
+    r_arena_chunk * chunk = a->first;
+    while (chunk != nullptr) {
+        r_arena_chunk * next = chunk->next;
+        a->parent.free(a->parent.ctx, chunk, chunk->size);
+        chunk = next;
+    }
+    a->first = nullptr;
+    a->current = nullptr;
+    a->used = 0;
+}
+
+extern size_t arena_used(const arena * a) {
+    return a->used;
+}
+
+/*
+ * =====================================================================================================================
+ * SLAB ALLOCATOR
+ * =====================================================================================================================
+ */
+
+// --------------------------------------------------- Size classes ----------------------------------------------------
+
+// Size class index for a request of size bytes (size must be at most R_SLAB_MAX_SIZE)
+static size_t r_slab_class(size_t size) {
+    return size > 0 ? (size - 1) / R_SLAB_GRANULE : 0;
+}
+
+static size_t r_slab_class_size(size_t cls) {
+    return (cls + 1) * R_SLAB_GRANULE;
+}
+
+// Carve one object of the given class from the current page, starting a new page when it runs out
+static void * r_slab_carve(slab * s, size_t cls) {
+    const size_t size = r_slab_class_size(cls);
+    if (s->cursor == nullptr || (size_t)(s->end - s->cursor) < size) {
+        size_t page_size = s->page_size;
+        if (page_size < sizeof(r_slab_page) + size) {
+            page_size = sizeof(r_slab_page) + size;
+        }
+        r_slab_page * page = s->parent.alloc(s->parent.ctx, page_size);
+        if (page == nullptr) {
+            return nullptr;
+        }
+        page->size = page_size;
+        page->next = s->pages;
+        s->pages = page;
+        s->cursor = page->data;
+        s->end = (unsigned char *)page + page_size;
+    }
+    void * ptr = s->cursor;
+    s->cursor += size;
+    return ptr;
+}
+
+// ------------------------------------------------ Allocator callbacks ------------------------------------------------
+
+// ReSharper disable CppParameterMayBeConstPtrOrRef - match allocator struct function pointers
+static void * r_slab_alloc(void * ctx, size_t size) {
+    slab * s = ctx;
+    if (size > R_SLAB_MAX_SIZE) {
+        return s->parent.alloc(s->parent.ctx, size);
+    }
+
+    const size_t cls = r_slab_class(size);
+    void * ptr = s->free[cls];
+    if (ptr != nullptr) {
+        s->free[cls] = *(void **)ptr;
+        return ptr;
+    }
+    return r_slab_carve(s, cls);
+}
+
+static void r_slab_free(void * ctx, void * ptr, size_t size) {
+    slab * s = ctx;
+    if (size > R_SLAB_MAX_SIZE) {
+        s->parent.free(s->parent.ctx, ptr, size);
+        return;
+    }
+
+    const size_t cls = r_slab_class(size);
+    *(void **)ptr = s->free[cls];
+    s->free[cls] = ptr;
+}
+
+static void * r_slab_realloc(void * ctx, void * ptr, size_t old_size, size_t new_size) {
+    slab * s = ctx;
+    if (ptr == nullptr) {
+        return r_slab_alloc(ctx, new_size);
+    }
+    if (old_size > R_SLAB_MAX_SIZE && new_size > R_SLAB_MAX_SIZE) {
+        return s->parent.realloc(s->parent.ctx, ptr, old_size, new_size);
+    }
+    if (old_size <= R_SLAB_MAX_SIZE && new_size <= R_SLAB_MAX_SIZE &&
+        r_slab_class(old_size) == r_slab_class(new_size)) {
+        return ptr;
+    }
+
+    void * new_ptr = r_slab_alloc(ctx, new_size);
+    if (new_ptr != nullptr) {
+        memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+        r_slab_free(ctx, ptr, old_size);
+    }
+    return new_ptr;
+}
+// ReSharper restore CppParameterMayBeConstPtrOrRef
+
+// ----------------------------------------------------- API: Slab -----------------------------------------------------
+
+extern allocator slab_allocator(slab * s) {
+    return (allocator){
+        .alloc = r_slab_alloc,
+        .realloc = r_slab_realloc,
+        .free = r_slab_free,
+        .ctx = s,
+    };
+}
+
+extern void slab_free(slab * s) {
+    r_slab_page * page = s->pages;
+    while (page != nullptr) {
+        r_slab_page * next = page->next;
+        s->parent.free(s->parent.ctx, page, page->size);
+        page = next;
+    }
+    memset(s->free, 0, sizeof(s->free));
+    s->pages = nullptr;
+    s->cursor = nullptr;
+    s->end = nullptr;
+}
+
+/*
+ * =====================================================================================================================
+ * TRACE ALLOCATOR
+ * =====================================================================================================================
+ */
+
+// ----------------------------------------------------- Recording -----------------------------------------------------
+
+// Histogram bucket of a request: ceil(log2(size)), clamped to the last bucket
+static size_t r_trace_bucket(size_t size) {
+    if (size <= 1) {
+        return 0;
+    }
+#if defined(__GNUC__) || defined(__clang__)
+    const size_t bucket = 64 - (size_t)__builtin_clzll((unsigned long long)(size - 1));
+#else
+    size_t bucket = 0;
+    for (size_t rest = size - 1; rest != 0; rest >>= 1) {
+        bucket++;
+    }
+#endif
+    return bucket < R_ALLOC_TRACE_BUCKETS ? bucket : R_ALLOC_TRACE_BUCKETS - 1;
+}
+
+static bool r_trace_same_file(const char * a, const char * b) {
+    return a == b || (a != nullptr && b != nullptr && strcmp(a, b) == 0);
+}
+
+/*
+ * Slot of the entry for file:line, or of the empty slot where it belongs; SIZE_MAX if it is absent and the table is
+ * full. Only the line is hashed: __FILE__ of one file is a different pointer in every translation unit that expands
+ * it, so files are compared by content.
+ */
+static size_t r_trace_slot(const alloc_trace * t, const char * file, int line) {
+    size_t idx = (size_t)(((uint64_t)(unsigned)line * 0x9E3779B97F4A7C15ULL) >> 32) % R_ALLOC_TRACE_SITES;
+    for (size_t probe = 0; probe < R_ALLOC_TRACE_SITES; probe++) {
+        const alloc_site * site = &t->sites[idx];
+        if (site->count == 0 || (site->line == line && r_trace_same_file(site->file, file))) {
+            return idx;
+        }
+        idx = idx + 1 < R_ALLOC_TRACE_SITES ? idx + 1 : 0;
+    }
+    return SIZE_MAX;
+}
+
+// Count one allocation or reallocation of size bytes (grown of them new) against the current call site
+static void r_trace_record(alloc_trace * t, size_t size, size_t grown) {
+    t->histogram[r_trace_bucket(size)]++;
+
+    const size_t idx = r_trace_slot(t, mem_alloc_site_file, mem_alloc_site_line);
+    if (idx == SIZE_MAX) {
+        t->sites_dropped++;
+    } else {
+        alloc_site * site = &t->sites[idx];
+        if (site->count == 0) {
+            site->file = mem_alloc_site_file;
+            site->line = mem_alloc_site_line;
+            t->site_count++;
+        }
+        site->count++;
+        site->bytes += grown;
+    }
+
+    const size_t live = alloc_trace_live(t);
+    if (live > t->peak) {
+        t->peak = live;
+    }
+}
+
+// ------------------------------------------------ Allocator callbacks ------------------------------------------------
+
+// ReSharper disable CppParameterMayBeConstPtrOrRef - match allocator struct function pointers
+static void * r_trace_alloc(void * ctx, size_t size) {
+    alloc_trace * t = ctx;
+    void * ptr = t->parent.alloc(t->parent.ctx, size);
+    if (ptr != nullptr) {
+        t->allocs++;
+        t->bytes_allocated += size;
+        r_trace_record(t, size, size);
+    }
+    return ptr;
+}
+
+static void * r_trace_realloc(void * ctx, void * ptr, size_t old_size, size_t new_size) {
+    alloc_trace * t = ctx;
+    void * new_ptr = t->parent.realloc(t->parent.ctx, ptr, old_size, new_size);
+    if (new_ptr != nullptr) {
+        const size_t grown = new_size > old_size ? new_size - old_size : 0;
+        t->reallocs++;
+        t->bytes_allocated += grown;
+        t->bytes_freed += old_size > new_size ? old_size - new_size : 0;
+        r_trace_record(t, new_size, grown);
     }
+    return new_ptr;
+}
+
+static void r_trace_free(void * ctx, void * ptr, size_t size) {
+    alloc_trace * t = ctx;
+    t->parent.free(t->parent.ctx, ptr, size);
+    t->frees++;
+    t->bytes_freed += size;
+}
+// ReSharper restore CppParameterMayBeConstPtrOrRef
+
+// ---------------------------------------------------- JSON output ----------------------------------------------------
+
+static void r_trace_json_string(FILE * stream, const char * s) {
+    if (s == nullptr) {
+        fputs("null", stream);
+        return;
+    }
+    fputc('"', stream);
+    for (; *s != NULLTERM; s++) {
+        const unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fprintf(stream, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(stream, "\\u%04x", c);
+        } else {
+            fputc(c, stream);
+        }
+    }
+    fputc('"', stream);
+}
+
+// Heaviest sites first: by bytes, then by count
+static int r_trace_site_cmp(const void * a, const void * b) {
+    const alloc_site * x = *(const alloc_site * const *)a;
+    const alloc_site * y = *(const alloc_site * const *)b;
+    if (x->bytes != y->bytes) {
+        return x->bytes < y->bytes ? 1 : -1;
+    }
+    return (x->count < y->count) - (x->count > y->count);
+}
+
+// ---------------------------------------------------- API: Trace -----------------------------------------------------
+
+extern allocator alloc_trace_allocator(alloc_trace * t) {
+    return (allocator){
+        .alloc = r_trace_alloc,
+        .realloc = r_trace_realloc,
+        .free = r_trace_free,
+        .ctx = t,
+    };
+}
+
+extern void alloc_trace_reset(alloc_trace * t) {
+    const allocator parent = t->parent;
+    memset(t, 0, sizeof(*t));
+    t->parent = parent;
+}
+
+extern size_t alloc_trace_live(const alloc_trace * t) {
+    return t->bytes_allocated > t->bytes_freed ? t->bytes_allocated - t->bytes_freed : 0;
+}
+
+extern const alloc_site * alloc_trace_site(const alloc_trace * t, const char * file, int line) {
+    const size_t idx = r_trace_slot(t, file, line);
+    return idx != SIZE_MAX && t->sites[idx].count > 0 ? &t->sites[idx] : nullptr;
+}
+
+extern void alloc_trace_json(const alloc_trace * t, FILE * stream) {
+    fprintf(stream, "{\n");
+    fprintf(stream, "  \"allocs\": %zu,\n  \"reallocs\": %zu,\n  \"frees\": %zu,\n", t->allocs, t->reallocs, t->frees);
+    fprintf(stream, "  \"bytes_allocated\": %zu,\n  \"bytes_freed\": %zu,\n", t->bytes_allocated, t->bytes_freed);
+    fprintf(stream, "  \"live_bytes\": %zu,\n  \"peak_bytes\": %zu,\n", alloc_trace_live(t), t->peak);
+
+    // Non-empty buckets only; the last bucket is open-ended
+    fprintf(stream, "  \"histogram\": [");
+    bool first = true;
+    for (size_t b = 0; b < R_ALLOC_TRACE_BUCKETS; b++) {
+        if (t->histogram[b] == 0) {
+            continue;
+        }
+        fprintf(stream, "%s\n    {\"max_size\": ", first ? "" : ",");
+        if (b + 1 < R_ALLOC_TRACE_BUCKETS) {
+            fprintf(stream, "%zu", (size_t)1 << b);
+        } else {
+            fputs("null", stream);
+        }
+        fprintf(stream, ", \"count\": %zu}", t->histogram[b]);
+        first = false;
+    }
+    fprintf(stream, "%s],\n", first ? "" : "\n  ");
+
+    const alloc_site * order[R_ALLOC_TRACE_SITES];
+    size_t n = 0;
+    for (size_t i = 0; i < R_ALLOC_TRACE_SITES; i++) {
+        if (t->sites[i].count > 0) {
+            order[n++] = &t->sites[i];
+        }
+    }
+    qsort(order, n, sizeof(order[0]), r_trace_site_cmp);
+
+    fprintf(stream, "  \"sites\": [");
+    for (size_t i = 0; i < n; i++) {
+        fprintf(stream, "%s\n    {\"file\": ", i > 0 ? "," : "");
+        r_trace_json_string(stream, order[i]->file);
+        fprintf(stream, ", \"line\": %d, \"count\": %zu, \"bytes\": %zu}", order[i]->line, order[i]->count,
+                order[i]->bytes);
+    }
+    fprintf(stream, "%s],\n", n > 0 ? "\n  " : "");
+    fprintf(stream, "  \"sites_dropped\": %zu\n}\n", t->sites_dropped);
+}
+
+/*
+ * =====================================================================================================================
+ * TRACE COUNTERS
+ * =====================================================================================================================
+ */
+
+// ------------------------------------------------------- Blocks ------------------------------------------------------
+
+_Thread_local r_trace_block * r_trace_local = nullptr;
+R_Atomic(uint64_t) r_trace_epoch = 0;
+
+// Shared by threads whose own block could not be allocated: their counts race with each other, but are not dropped
+static r_trace_block r_trace_fallback;
+
+// Every block ever attached, newest first; the fallback block is always the last
+static R_Atomic(r_trace_block *) r_trace_blocks = &r_trace_fallback;
+
+#ifndef __STDC_NO_THREADS__
+static tss_t r_trace_key;
+static bool r_trace_keyed = false;
+static once_flag r_trace_key_once = ONCE_FLAG_INIT;
+
+// Runs when a thread that holds a block exits: the next thread to attach takes the block over, counts included
+static void r_trace_detach(void * block) {
+    r_trace_block * b = block;
+    r_trace_local = nullptr;
+    // The next owner sees every count this thread stored
+    atomic_store_explicit(&b->free, true, memory_order_release);
+}
+
+static void r_trace_key_create(void) {
+    r_trace_keyed = tss_create(&r_trace_key, r_trace_detach) == thrd_success;
+}
+#endif // __STDC_NO_THREADS__
+
+static r_trace_block * r_trace_claim(void) {
+    for (r_trace_block * b = atomic_load_explicit(&r_trace_blocks, memory_order_acquire); b != nullptr; b = b->next) {
+        bool free = atomic_load_explicit(&b->free, memory_order_relaxed);
+        if (free && atomic_compare_exchange_strong_explicit(
+                        &b->free, &free, false, memory_order_acquire, memory_order_relaxed
+                    )) {
+            return b;
+        }
+    }
+    return nullptr;
+}
+
+static r_trace_block * r_trace_attach(void) {
+#ifndef __STDC_NO_THREADS__
+    call_once(&r_trace_key_once, r_trace_key_create);
+#endif
+    r_trace_block * b = r_trace_claim();
+    if (b == nullptr) {
+        // Straight from the C library: the probes in mem_alloc must not recurse into the allocator stack
+        const size_t size = (sizeof(r_trace_block) + R_CACHE_LINE - 1) / R_CACHE_LINE * R_CACHE_LINE;
+        b = aligned_alloc(R_CACHE_LINE, size);
+        if (b == nullptr) {
+            return &r_trace_fallback;
+        }
+        memset(b, 0, size);
+        b->next = atomic_load_explicit(&r_trace_blocks, memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(
+            &r_trace_blocks, &b->next, b, memory_order_release, memory_order_relaxed
+        )) {
+        }
+    }
+#ifndef __STDC_NO_THREADS__
+    // Without the destructor the block stays with this thread for good, as it does with no C11 threads at all
+    if (r_trace_keyed) {
+        tss_set(r_trace_key, b);
+    }
+#endif
+    return b;
+}
+
+extern r_trace_block * R_(trace_refresh)(void) {
+    if (r_trace_local == nullptr) {
+        r_trace_local = r_trace_attach();
+    }
+    r_trace_block * b = r_trace_local;
+    const uint64_t epoch = atomic_load_explicit(&r_trace_epoch, memory_order_relaxed);
+    if (atomic_load_explicit(&b->epoch, memory_order_relaxed) != epoch) {
+        for (size_t i = 0; i < R_TRACE_COUNTERS; i++) {
+            atomic_store_explicit(&b->counters[i], 0, memory_order_relaxed);
+        }
+        // Readers that see the new epoch see the zeroed counters
+        atomic_store_explicit(&b->epoch, epoch, memory_order_release);
+    }
+    return b;
+}
+
+extern uint64_t R_(trace_now)(void) {
+    struct timespec ts;
+#ifdef TIME_MONOTONIC
+    timespec_get(&ts, TIME_MONOTONIC);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// ----------------------------------------------------- Metadata ------------------------------------------------------
+
+static const struct {
+    const char * name;
+    const char * help;
+    bool max;
+} r_trace_info[R_TRACE_COUNTERS] = {
+    [R_TRACE_ALLOCS] = {"allocs", "mem_alloc and mem_alloc_zero calls", false},
+    [R_TRACE_ALLOC_BYTES] = {"alloc_bytes", "Bytes requested by allocations and realloc growth", false},
+    [R_TRACE_REALLOCS] = {"reallocs", "mem_realloc calls", false},
+    [R_TRACE_FREES] = {"frees", "mem_free calls", false},
+    [R_TRACE_RBT_INSERTS] = {"rbt_inserts", "Red-black tree inserts that added a node", false},
+    [R_TRACE_RBT_DEPTH] = {"rbt_depth", "Sum of red-black tree insert depths", false},
+    [R_TRACE_RBT_DEPTH_MAX] = {"rbt_depth_max", "Deepest red-black tree insert", true},
+    [R_TRACE_RBT_ROTATIONS] = {"rbt_rotations", "Red-black tree rotations after inserts", false},
+    [R_TRACE_LFQ_FULL] = {"lfq_full", "lfq pushes that found the ring full", false},
+    [R_TRACE_LFQ_EMPTY] = {"lfq_empty", "lfq pops that found the ring empty", false},
+    [R_TRACE_MPMC_FULL] = {"mpmc_full", "mpmc pushes that found the ring full", false},
+    [R_TRACE_MPMC_EMPTY] = {"mpmc_empty", "mpmc pops that found the ring empty", false},
+    [R_TRACE_STR_FINDS] = {"str_finds", "Substring searches", false},
+    [R_TRACE_STR_FIND_BYTES] = {"str_find_bytes", "Text bytes covered by substring searches", false},
+    [R_TRACE_MAP_FINDS] = {"map_finds", "Map lookups by key", false},
+    [R_TRACE_MAP_PROBES] = {"map_probes", "Control groups examined by map lookups", false},
+    [R_TRACE_MAP_PROBES_MAX] = {"map_probes_max", "Longest map lookup in control groups", true},
+    [R_TRACE_MAP_REHASHES] = {"map_rehashes", "Map table rebuilds", false},
+    [R_TRACE_MAP_REHASH_NS] = {"map_rehash_ns", "Nanoseconds spent rebuilding map tables", false},
+};
+
+// ---------------------------------------------------- Exporters ------------------------------------------------------
+
+static void r_trace_prometheus_metric(void * ctx, const trace_metric * metric) {
+    FILE * stream = ctx;
+    const char * suffix = metric->max ? "" : "_total";
+    fprintf(stream, "# HELP rune_%s%s %s\n", metric->name, suffix, metric->help);
+    fprintf(stream, "# TYPE rune_%s%s %s\n", metric->name, suffix, metric->max ? "gauge" : "counter");
+    fprintf(stream, "rune_%s%s %llu\n", metric->name, suffix, (unsigned long long)metric->value);
+}
+
+typedef struct {
+    FILE * stream;
+    bool first;
+} r_trace_json_ctx;
+
+static void r_trace_json_metric(void * ctx, const trace_metric * metric) {
+    r_trace_json_ctx * json = ctx;
+    fprintf(json->stream, "%s\n  \"%s\": %llu", json->first ? "" : ",", metric->name,
+            (unsigned long long)metric->value);
+    json->first = false;
+}
+
+// --------------------------------------------------- API: Counters ---------------------------------------------------
+
+extern void trace_snapshot(trace_stats * out) {
+    *out = (trace_stats){0};
+    const uint64_t epoch = atomic_load_explicit(&r_trace_epoch, memory_order_relaxed);
+    for (r_trace_block * b = atomic_load_explicit(&r_trace_blocks, memory_order_acquire); b != nullptr; b = b->next) {
+        if (atomic_load_explicit(&b->epoch, memory_order_acquire) != epoch) {
+            continue; // not yet zeroed by its owner after a reset
+        }
+        for (size_t i = 0; i < R_TRACE_COUNTERS; i++) {
+            const uint64_t v = atomic_load_explicit(&b->counters[i], memory_order_relaxed);
+            if (!r_trace_info[i].max) {
+                out->counters[i] += v;
+            } else if (v > out->counters[i]) {
+                out->counters[i] = v;
+            }
+        }
+    }
+}
+
+extern uint64_t trace_count(const r_trace_counter c) {
+    if (c >= R_TRACE_COUNTERS) {
+        return 0;
+    }
+    trace_stats stats;
+    trace_snapshot(&stats);
+    return stats.counters[c];
+}
+
+extern void trace_reset(void) {
+    atomic_fetch_add_explicit(&r_trace_epoch, 1, memory_order_relaxed);
+}
+
+extern void trace_export(const trace_exporter fn, void * ctx) {
+    trace_stats stats;
+    trace_snapshot(&stats);
+    for (size_t i = 0; i < R_TRACE_COUNTERS; i++) {
+        const trace_metric metric = {
+            .name = r_trace_info[i].name,
+            .help = r_trace_info[i].help,
+            .max = r_trace_info[i].max,
+            .value = stats.counters[i],
+        };
+        fn(ctx, &metric);
+    }
+}
+
+extern void trace_prometheus(FILE * stream) {
+    trace_export(r_trace_prometheus_metric, stream);
+}
+
+extern void trace_json(FILE * stream) {
+    r_trace_json_ctx json = {.stream = stream, .first = true};
+    fputc('{', stream);
+    trace_export(r_trace_json_metric, &json);
+    fputs("\n}\n", stream);
 }
@@ -6,13 +6,18 @@
  *   - Flexible allocator system with push/pop stack semantics
  *   - RAII-style allocator scopes via alloc_scope() macro
  *   - Type-safe memory allocation macros (mem_alloc, mem_alloc_zero, mem_realloc)
- *   - Default malloc/realloc/free allocator with thread-local stack fallback
+ *   - Default malloc/realloc/free allocator with thread-local stack fallback (called directly, calloc for zeroing)
+ *   - Arena (bump) allocator with chunked growth and O(1) reset
+ *   - Slab allocator with size-class free lists for fixed-size objects (tree nodes, string headers)
+ *   - Trace allocator that counts traffic, live/peak bytes, sizes and (with RCFG__ALLOC_SITES) call sites
+ *   - Trace counters: per-thread probes in the hot paths (RCFG__TRACE), summed on demand and exported as
+ *     Prometheus text, JSON or through a callback
  *
  * Quick Reference:
  *
  *   Error API
  *   -------------------------------------------------------------------------------------------------------------------
- *   err_set(code, message)       Set error with automatic location capture
+ *   err_set(code, message)       Set error with automatic location capture (code only with RCFG__ERROR_CODE_ONLY)
  *   err_get()                    Get most recent error context
  *   err_code()                   Get error code of most recent error
  *   err_msg()                    Get error message of most recent error
@@ -39,6 +44,40 @@
  *   )                            Reallocate typed array
  *   mem_free(ptr, size)          Free allocated memory
  *
+ *   Arena Allocator API
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   arena(...)                   Create empty arena (optional chunk size)
+ *   arena_allocator(a)           Get allocator that bump-allocates from arena a
+ *   arena_reset(a)               Release every allocation at once, keep chunks for reuse (O(1))
+ *   arena_free(a)                Return all chunks to the parent allocator
+ *   arena_used(a)                Get bytes handed out since the last reset
+ *
+ *   Slab Allocator API
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   slab(...)                    Create empty slab (optional page size)
+ *   slab_allocator(s)            Get allocator that serves small sizes from per-class free lists of slab s
+ *   slab_free(s)                 Return all pages to the parent allocator at once
+ *
+ *   Trace Allocator API
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   alloc_trace()                Create empty trace (forwards to the current allocator)
+ *   alloc_trace_allocator(t)     Get allocator that records every call in trace t, then forwards it
+ *   alloc_trace_live(t)          Get bytes allocated and not yet freed under t
+ *   alloc_trace_site(
+ *       t, file, line
+ *   )                            Get the counters of one call site (nullptr if none recorded)
+ *   alloc_trace_json(t, stream)  Write totals, histogram and call sites (heaviest first) as JSON
+ *   alloc_trace_reset(t)         Zero all counters
+ *
+ *   Trace Counter API (probes compiled in with RCFG__TRACE, else the counters stay zero)
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   trace_count(c)               Get one counter summed over all threads
+ *   trace_snapshot(out)          Get every counter summed over all threads
+ *   trace_reset()                Zero every counter of every thread
+ *   trace_export(fn, ctx)        Call fn(ctx, metric) once per counter with its name, help text and value
+ *   trace_prometheus(stream)     Write the counters in the Prometheus text exposition format
+ *   trace_json(stream)           Write the counters as a JSON object
+ *
  * Example:
  *   // Allocate and use default allocator
  *   int * x = mem_alloc(int);
@@ -50,6 +89,24 @@
  *       int * y = mem_alloc(int);  // Uses my_custom_allocator
  *   }
  *
+ *   // Arena scope: temporaries are released together, mem_free is a no-op
+ *   arena a = arena();
+ *   alloc_scope(arena_allocator(&a)) {
+ *       char * s = str_cat("a", "b", nullptr);
+ *   }
+ *   arena_reset(&a);
+ *   arena_free(&a);
+ *
+ *   // Trace scope: which calls allocate the most (build with -DRCFG__ALLOC_SITES for per-line counts)
+ *   alloc_trace t = alloc_trace();
+ *   alloc_scope(alloc_trace_allocator(&t)) {
+ *       run_workload();
+ *   }
+ *   alloc_trace_json(&t, stderr);
+ *
+ *   // Queue saturation and tree shape of a running service (build with -DRCFG__TRACE)
+ *   trace_prometheus(metrics_stream);
+ *
  * Requires C11 for _Thread_local support.
  * Identifiers beginning with `R_` or `r_` are reserved for internal use.
  */
@@ -59,6 +116,8 @@
 
 // ReSharper disable once CppUnusedIncludeDirective
 #include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 // =====================================================================================================================
@@ -132,6 +191,12 @@
 
 static constexpr char NULLTERM = '\0';
 
+#ifdef RCFG__CACHE_LINE
+static constexpr size_t R_CACHE_LINE = RCFG__CACHE_LINE;
+#else  // Default cache line size in bytes, used to keep concurrently written fields apart
+static constexpr size_t R_CACHE_LINE = 64;
+#endif // RCFG__CACHE_LINE
+
 // ------------------------------------------------ Allocator interface ------------------------------------------------
 
 /**
@@ -213,11 +278,20 @@ static constexpr int R_ERROR_STACK_MAX = RCFG__ERROR_STACK_MAX;
 static constexpr int R_ERROR_STACK_MAX = 8;
 #endif // RCFG__ERROR_STACK_MAX
 
+#ifdef RCFG__ERROR_CODE_ONLY
+// Code-only tracking: err_set records the code alone, messages and source locations are compiled out
+typedef struct {
+    r_error_code stack[R_ERROR_STACK_MAX];
+    int depth;
+    bool enabled;
+} r_error_stack_t;
+#else  // Full tracking: each entry keeps its message and the file, line and function that set it
 typedef struct {
     r_error_ctx stack[R_ERROR_STACK_MAX];
     int depth;
     bool enabled;
 } r_error_stack_t;
+#endif // RCFG__ERROR_CODE_ONLY
 
 extern _Thread_local r_error_stack_t r_error_stack;
 
@@ -233,7 +307,24 @@ extern const char * r_error_message(r_error_code code);
 
 // ------------------------------------------- Error API: Setup & Reporting --------------------------------------------
 
+#ifdef RCFG__ERROR_CODE_ONLY
+/*
+ * err_set inlines to a bounds check and a single thread-local store: the message is not kept (queries report the
+ * default message for the code) and no location is captured (err_get and err_at report a nullptr file and func).
+ */
+#define err_set(code, message) ((void)(message), R_(err_set_code)(code))
+
+[[maybe_unused]]
+static inline bool R_(err_set_code)(const r_error_code code) {
+    if (!r_error_stack.enabled || r_error_stack.depth >= R_ERROR_STACK_MAX) {
+        return false;
+    }
+    r_error_stack.stack[r_error_stack.depth++] = code;
+    return true;
+}
+#else  // RCFG__ERROR_CODE_ONLY
 #define err_set(code, message) R_(err_set)((code), (message), __FILE__, __LINE__, __func__)
+#endif // RCFG__ERROR_CODE_ONLY
 #define err_print(stream) R_(err_print)(stream)
 #define err_print_stack(stream) R_(err_print_stack)(stream)
 
@@ -351,4 +442,384 @@ extern allocator alloc_current(void);
 [[nodiscard]] extern void * mem_realloc(void * ptr, size_t old_size, size_t new_size);
 extern void mem_free(void * ptr, size_t size);
 
+// =====================================================================================================================
+// ARENA ALLOCATOR
+// =====================================================================================================================
+
+// ------------------------------------------------ Arena configuration ------------------------------------------------
+
+#ifdef RCFG__ARENA_CHUNK_SIZE
+static constexpr size_t R_ARENA_CHUNK_SIZE = RCFG__ARENA_CHUNK_SIZE;
+#else  // Default arena chunk size in bytes (chunk header included)
+static constexpr size_t R_ARENA_CHUNK_SIZE = 64 * 1024;
+#endif // RCFG__ARENA_CHUNK_SIZE
+
+// ---------------------------------------------------- Arena types ----------------------------------------------------
+
+/**
+ * One block of arena memory. Chunks form a singly-linked list; chunks after `current` are spares kept by
+ * arena_reset() and reused before new chunks are requested.
+ *
+ * @param next  Next chunk in the list
+ * @param size  Total chunk size in bytes (header included), as passed to the parent allocator
+ * @param used  Bytes handed out from data
+ * @param data  Allocation space
+ */
+typedef struct r_arena_chunk {
+    struct r_arena_chunk * next;
+    size_t size;
+    size_t used;
+    alignas(max_align_t) unsigned char data[];
+} r_arena_chunk;
+
+/**
+ * Arena (bump) allocator state.
+ *
+ * Allocations are carved sequentially from the current chunk and aligned to max_align_t. Individual frees are
+ * no-ops; memory comes back all at once through arena_reset() or arena_free(). Realloc of the most recent
+ * allocation grows or shrinks in place when the chunk has room.
+ *
+ * Chunks are obtained from the parent allocator - the allocator current when the arena was created - so the
+ * arena must not be the current allocator when it is created. An arena is not thread safe.
+ *
+ * @param first       Head of the chunk list
+ * @param current     Chunk allocations are carved from
+ * @param chunk_size  Default chunk size (larger requests get a dedicated chunk)
+ * @param used        Bytes handed out since the last reset
+ * @param parent      Allocator the chunks come from
+ */
+typedef struct {
+    r_arena_chunk * first;
+    r_arena_chunk * current;
+    size_t chunk_size;
+    size_t used;
+    allocator parent;
+} arena;
+
+// ----------------------------------------------------- Arena API -----------------------------------------------------
+
+#define arena(...)                                                                                                     \
+    ((arena){                                                                                                          \
+        .first = nullptr,                                                                                              \
+        .current = nullptr,                                                                                            \
+        .chunk_size = R_OPT(R_ARENA_CHUNK_SIZE, __VA_ARGS__),                                                          \
+        .used = 0,                                                                                                     \
+        .parent = alloc_current(),                                                                                     \
+    })
+
+[[nodiscard]] extern allocator arena_allocator(arena * a);
+extern void arena_reset(arena * a);
+extern void arena_free(arena * a);
+extern size_t arena_used(const arena * a);
+
+// =====================================================================================================================
+// SLAB ALLOCATOR
+// =====================================================================================================================
+
+// ------------------------------------------------ Slab configuration -------------------------------------------------
+
+#ifdef RCFG__SLAB_PAGE_SIZE
+static constexpr size_t R_SLAB_PAGE_SIZE = RCFG__SLAB_PAGE_SIZE;
+#else  // Default slab page size in bytes (page header included)
+static constexpr size_t R_SLAB_PAGE_SIZE = 64 * 1024;
+#endif // RCFG__SLAB_PAGE_SIZE
+
+#ifdef RCFG__SLAB_MAX_SIZE
+static constexpr size_t R_SLAB_MAX_SIZE = RCFG__SLAB_MAX_SIZE;
+#else  // Largest size served from free lists; bigger requests pass through to the parent allocator
+static constexpr size_t R_SLAB_MAX_SIZE = 256;
+#endif // RCFG__SLAB_MAX_SIZE
+
+// Size classes are multiples of R_SLAB_GRANULE (which keeps every object max_align_t aligned)
+static constexpr size_t R_SLAB_GRANULE = 16;
+static constexpr size_t R_SLAB_CLASSES = (R_SLAB_MAX_SIZE + R_SLAB_GRANULE - 1) / R_SLAB_GRANULE;
+
+// ---------------------------------------------------- Slab types -----------------------------------------------------
+
+/**
+ * One page of slab memory, carved into objects on demand. Pages are only returned by slab_free().
+ *
+ * @param next  Next page in the list
+ * @param size  Total page size in bytes (header included), as passed to the parent allocator
+ * @param data  Object space
+ */
+typedef struct r_slab_page {
+    struct r_slab_page * next;
+    size_t size;
+    alignas(max_align_t) unsigned char data[];
+} r_slab_page;
+
+/**
+ * Slab allocator state.
+ *
+ * Requests up to R_SLAB_MAX_SIZE bytes are rounded up to a size class. Each class keeps an intrusive free list,
+ * and mem_free pushes a block back onto the list picked by its size argument, so the size passed to free and
+ * realloc must match the size the block was allocated with. Empty free lists are refilled by carving the current
+ * page; larger requests go straight to the parent allocator and are freed back to it individually.
+ *
+ * Pages come from the parent allocator - the allocator current when the slab was created. A slab is not thread
+ * safe: give each thread its own (e.g. a _Thread_local slab), which makes the free lists per thread.
+ *
+ * @param free       Free list head per size class
+ * @param pages      Head of the page list
+ * @param cursor     Next uncarved byte of the current page
+ * @param end        End of the current page
+ * @param page_size  Size of each page
+ * @param parent     Allocator the pages (and large requests) come from
+ */
+typedef struct {
+    void * free[R_SLAB_CLASSES];
+    r_slab_page * pages;
+    unsigned char * cursor;
+    unsigned char * end;
+    size_t page_size;
+    allocator parent;
+} slab;
+
+// ----------------------------------------------------- Slab API ------------------------------------------------------
+
+#define slab(...)                                                                                                      \
+    ((slab){                                                                                                           \
+        .free = {nullptr},                                                                                             \
+        .pages = nullptr,                                                                                              \
+        .cursor = nullptr,                                                                                             \
+        .end = nullptr,                                                                                                \
+        .page_size = R_OPT(R_SLAB_PAGE_SIZE, __VA_ARGS__),                                                             \
+        .parent = alloc_current(),                                                                                     \
+    })
+
+[[nodiscard]] extern allocator slab_allocator(slab * s);
+extern void slab_free(slab * s);
+
+// =====================================================================================================================
+// TRACE ALLOCATOR
+// =====================================================================================================================
+
+// ------------------------------------------------ Trace configuration ------------------------------------------------
+
+#ifdef RCFG__ALLOC_TRACE_SITES
+static constexpr size_t R_ALLOC_TRACE_SITES = RCFG__ALLOC_TRACE_SITES;
+#else  // Call sites kept per trace; events from further sites are only counted in sites_dropped
+static constexpr size_t R_ALLOC_TRACE_SITES = 128;
+#endif // RCFG__ALLOC_TRACE_SITES
+
+// Size histogram: bucket 0 counts requests of 0-1 bytes, bucket b sizes in (2^(b-1), 2^b], the last bucket the rest
+static constexpr size_t R_ALLOC_TRACE_BUCKETS = 32;
+
+// ---------------------------------------------------- Trace types ----------------------------------------------------
+
+/**
+ * Allocation traffic from one source location.
+ *
+ * @param file   Source file of the mem_alloc / mem_alloc_zero / mem_realloc call, nullptr for calls compiled
+ *               without RCFG__ALLOC_SITES (all of those share one entry)
+ * @param line   Line of the call
+ * @param count  Allocations and reallocations made from here
+ * @param bytes  Bytes requested from here (allocation sizes plus realloc growth)
+ */
+typedef struct {
+    const char * file;
+    int line;
+    size_t count;
+    size_t bytes;
+} alloc_site;
+
+/**
+ * Trace allocator state: a wrapper that forwards every call to its parent allocator and records it.
+ *
+ * Totals, live and peak bytes and the size histogram are always kept. Per-site counts need the call site, which
+ * mem_alloc, mem_alloc_zero and mem_realloc only capture (like err_set, via __FILE__ / __LINE__) in translation
+ * units compiled with RCFG__ALLOC_SITES; build the code under investigation (e.g. src/str.c) with it.
+ *
+ * Live bytes are bytes allocated minus bytes freed, so memory allocated before the trace was pushed and freed
+ * under it can make them undercount (they never go below zero). The parent is the allocator current when the trace
+ * was created. A trace is not thread safe - like the allocator stack it belongs to one thread.
+ *
+ * @param allocs           mem_alloc / mem_alloc_zero calls
+ * @param reallocs         mem_realloc calls
+ * @param frees            mem_free calls
+ * @param bytes_allocated  Allocation sizes plus realloc growth
+ * @param bytes_freed      Free sizes plus realloc shrinkage
+ * @param peak             Highest live byte count seen
+ * @param histogram        Requested sizes (allocations and realloc targets) by power-of-two bucket
+ * @param sites            Open-addressed table of call sites (empty slots have count 0)
+ * @param site_count       Occupied entries of sites
+ * @param sites_dropped    Events whose call site did not fit in the table
+ * @param parent           Allocator every call is forwarded to
+ */
+typedef struct {
+    size_t allocs;
+    size_t reallocs;
+    size_t frees;
+    size_t bytes_allocated;
+    size_t bytes_freed;
+    size_t peak;
+    size_t histogram[R_ALLOC_TRACE_BUCKETS];
+    alloc_site sites[R_ALLOC_TRACE_SITES];
+    size_t site_count;
+    size_t sites_dropped;
+    allocator parent;
+} alloc_trace;
+
+// ----------------------------------------------------- Trace API -----------------------------------------------------
+
+#define alloc_trace() ((alloc_trace){.parent = alloc_current()})
+
+[[nodiscard]] extern allocator alloc_trace_allocator(alloc_trace * t);
+extern void alloc_trace_reset(alloc_trace * t);
+extern size_t alloc_trace_live(const alloc_trace * t);
+extern const alloc_site * alloc_trace_site(const alloc_trace * t, const char * file, int line);
+extern void alloc_trace_json(const alloc_trace * t, FILE * stream);
+
+// ------------------------------------------------- Call-site capture -------------------------------------------------
+// With RCFG__ALLOC_SITES the memory operations record their caller for a trace allocator on the stack. Defined
+// after the prototypes above, so the functions themselves keep their plain names.
+
+extern void * R_(mem_alloc_at)(size_t size, const char * file, int line);
+extern void * R_(mem_alloc_zero_at)(size_t size, const char * file, int line);
+extern void * R_(mem_realloc_at)(void * ptr, size_t old_size, size_t new_size, const char * file, int line);
+
+#ifdef RCFG__ALLOC_SITES
+#define mem_alloc(size) R_(mem_alloc_at)((size), __FILE__, __LINE__)
+#define mem_alloc_zero(size) R_(mem_alloc_zero_at)((size), __FILE__, __LINE__)
+#define mem_realloc(ptr, old_size, new_size) R_(mem_realloc_at)((ptr), (old_size), (new_size), __FILE__, __LINE__)
+#endif // RCFG__ALLOC_SITES
+
+// =====================================================================================================================
+// TRACE COUNTERS
+// =====================================================================================================================
+
+// ------------------------------------------------------ Counters -----------------------------------------------------
+
+/**
+ * Counters fed by the probes in the hot paths. Probes are compiled in per translation unit: r.c and str.c count
+ * when built with RCFG__TRACE, the header collections (tree.h, coll.h, map.h) in the files that include them with
+ * it defined. Without RCFG__TRACE a probe compiles to nothing.
+ *
+ * Counters named *_MAX hold the largest value seen, all others are running totals.
+ */
+typedef enum {
+    R_TRACE_ALLOCS,         // mem_alloc / mem_alloc_zero calls
+    R_TRACE_ALLOC_BYTES,    // Bytes requested by them and by mem_realloc growth
+    R_TRACE_REALLOCS,       // mem_realloc calls
+    R_TRACE_FREES,          // mem_free calls
+    R_TRACE_RBT_INSERTS,    // rbt_insert calls that added a node
+    R_TRACE_RBT_DEPTH,      // Sum of the depths at which those nodes were added (mean depth = this / inserts)
+    R_TRACE_RBT_DEPTH_MAX,  // Deepest insert
+    R_TRACE_RBT_ROTATIONS,  // Rotations done to rebalance after inserts
+    R_TRACE_LFQ_FULL,       // lfq_push / lfq_push_n calls that found the ring full
+    R_TRACE_LFQ_EMPTY,      // lfq_pop / lfq_pop_n calls that found the ring empty
+    R_TRACE_MPMC_FULL,      // mpmc_push calls that found the ring full
+    R_TRACE_MPMC_EMPTY,     // mpmc_pop calls that found the ring empty
+    R_TRACE_STR_FINDS,      // Substring searches (str_find, str_rfind and the replace / split / count scans)
+    R_TRACE_STR_FIND_BYTES, // Text bytes those searches covered
+    R_TRACE_MAP_FINDS,      // Map lookups by key (get, put, remove)
+    R_TRACE_MAP_PROBES,     // Control groups those lookups examined (a direct hit examines one)
+    R_TRACE_MAP_PROBES_MAX, // Longest lookup in groups
+    R_TRACE_MAP_REHASHES,   // Table rebuilds (growth or tombstone cleanup), progressive migrations included
+    R_TRACE_MAP_REHASH_NS,  // Nanoseconds spent in them (migrations excluded: their work is spread over writes)
+    R_TRACE_COUNTERS        // Number of counters
+} r_trace_counter;
+
+/**
+ * One thread's counters. A thread gets its block on its first probe; the block is linked into a global list and
+ * never freed. When the thread exits, the block is marked free and the next thread to attach takes it over with
+ * its counts, so a finished thread's counts stay in the sums and the list grows with the most threads probing at
+ * once, not with every thread ever started. Without C11 threads (__STDC_NO_THREADS__) there is no exit hook and
+ * each thread keeps its block for good. Only the owning thread writes to a block (a relaxed load and store, no
+ * read-modify-write); readers sum the blocks with relaxed loads.
+ *
+ * @param counters  Values by r_trace_counter
+ * @param epoch     trace_reset generation the values belong to; an older block is zeroed by its owner on its next
+ *                  probe and reads as zero until then
+ * @param free      Set when the owning thread exits; cleared by the thread that takes the block over
+ * @param next      Next block in the global list
+ */
+typedef struct r_trace_block {
+    R_Atomic(uint64_t) counters[R_TRACE_COUNTERS];
+    R_Atomic(uint64_t) epoch;
+    R_Atomic(bool) free;
+    struct r_trace_block * next;
+} r_trace_block;
+
+extern _Thread_local r_trace_block * r_trace_local;
+extern R_Atomic(uint64_t) r_trace_epoch;
+
+// Slow path of a probe: attach a block to this thread, or zero it after a trace_reset
+extern r_trace_block * R_(trace_refresh)(void);
+extern uint64_t R_(trace_now)(void);
+
+[[maybe_unused]]
+static inline r_trace_block * R_(trace_block)(void) {
+    r_trace_block * b = r_trace_local;
+    if (b == nullptr || atomic_load_explicit(&b->epoch, memory_order_relaxed) !=
+                            atomic_load_explicit(&r_trace_epoch, memory_order_relaxed)) {
+        b = R_(trace_refresh)();
+    }
+    return b;
+}
+
+[[maybe_unused]]
+static inline void R_(trace_add)(const r_trace_counter c, const uint64_t n) {
+    R_Atomic(uint64_t) * v = &R_(trace_block)()->counters[c];
+    atomic_store_explicit(v, atomic_load_explicit(v, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+[[maybe_unused]]
+static inline void R_(trace_max)(const r_trace_counter c, const uint64_t n) {
+    R_Atomic(uint64_t) * v = &R_(trace_block)()->counters[c];
+    if (n > atomic_load_explicit(v, memory_order_relaxed)) {
+        atomic_store_explicit(v, n, memory_order_relaxed);
+    }
+}
+
+// ------------------------------------------------------- Probes ------------------------------------------------------
+// R_TRACE_NOW() is a monotonic nanosecond clock. Without RCFG__TRACE the arguments are still evaluated (as void),
+// so values computed only for a probe do not trip unused-variable warnings, and R_TRACE_NOW() is 0.
+
+#ifdef RCFG__TRACE
+#define R_TRACE_ADD(counter, n) R_(trace_add)((counter), (uint64_t)(n))
+#define R_TRACE_MAX(counter, n) R_(trace_max)((counter), (uint64_t)(n))
+#define R_TRACE_NOW() R_(trace_now)()
+#else
+#define R_TRACE_ADD(counter, n) ((void)(counter), (void)(n))
+#define R_TRACE_MAX(counter, n) ((void)(counter), (void)(n))
+#define R_TRACE_NOW() ((uint64_t)0)
+#endif // RCFG__TRACE
+
+// ----------------------------------------------------- Trace API -----------------------------------------------------
+
+typedef struct {
+    uint64_t counters[R_TRACE_COUNTERS];
+} trace_stats;
+
+/**
+ * One counter as handed to an exporter.
+ *
+ * @param name   Snake-case name without prefix (e.g. "lfq_full")
+ * @param help   One-line description
+ * @param max    true for *_MAX counters (a gauge), false for running totals
+ * @param value  Sum over all threads (maximum for *_MAX counters)
+ */
+typedef struct {
+    const char * name;
+    const char * help;
+    bool max;
+    uint64_t value;
+} trace_metric;
+
+typedef void (*trace_exporter)(void * ctx, const trace_metric * metric);
+
+/**
+ * Sums are read without stopping the threads that write them, so a snapshot taken under load is a little behind
+ * and its counters are not mutually consistent (e.g. R_TRACE_RBT_DEPTH may already include an insert that
+ * R_TRACE_RBT_INSERTS does not). trace_reset zeroes lazily: counts a thread adds while the reset happens may be lost.
+ */
+extern uint64_t trace_count(r_trace_counter c);
+extern void trace_snapshot(trace_stats * out);
+extern void trace_reset(void);
+extern void trace_export(trace_exporter fn, void * ctx);
+extern void trace_prometheus(FILE * stream);
+extern void trace_json(FILE * stream);
+
 #endif // RUNE_H
@@ -3,6 +3,8 @@
  */
 
 #include "str.h"
+#include "hash.h"
+#include "map.h"
 
 #include <stdarg.h>
 #include <stddef.h>
@@ -10,26 +12,33 @@
 #include <stdio.h>
 #include <string.h>
 
+// Substring search instruction set, selected at compile time (RCFG__STR_NO_SIMD forces the scalar path)
+#if !defined(RCFG__STR_NO_SIMD) && defined(__AVX2__)
+#define R_STR_SIMD
+#define R_STR_AVX2
+#include <immintrin.h>
+#elif !defined(RCFG__STR_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64))
+#define R_STR_SIMD
+#define R_STR_SSE2
+#include <emmintrin.h>
+#elif !defined(RCFG__STR_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define R_STR_SIMD
+#define R_STR_NEON
+#include <arm_neon.h>
+#endif
+
 // =====================================================================================================================
-// Internal: FNV-1a hashing
+// Internal: String hashing
 // =====================================================================================================================
 
-static uint64_t fnv1a_start(void) {
-    return 0xCBF29CE484222325ULL;
-}
-
-static uint64_t fnv1a_next(const uint64_t hash, const uint8_t byte) {
-    return (hash ^ byte) * 0x100000001B3ULL;
-}
-
-static uint64_t fnv1a_mix(const uint64_t h1, const uint64_t h2) {
-    return (h1 ^ h2) * 0x100000001B3ULL;
-}
+// Hash of exactly len bytes: xxHash64 (32-byte stripes) with R_STR_BLOCK_HASH, FNV-1a otherwise
+static uint64_t str_hash_bytes(const char * data, const size_t len) {
+    if (R_STR_BLOCK_HASH)
+        return xxhash64(data, len, R_HASH_DEFAULT_SEED);
 
-static uint64_t fnv1a_hash(const char * data, const size_t max_len) {
-    uint64_t hash = fnv1a_start();
-    for (size_t i = 0; i < max_len && data[i] != NULLTERM; i++) {
-        hash = fnv1a_next(hash, (uint8_t)data[i]);
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)data[i]) * 0x100000001B3ULL;
     }
     return hash;
 }
@@ -42,8 +51,18 @@ static constexpr char SOH = 0x01; // start of header
 static constexpr char STX = 0x02; // start of text
 static constexpr char ETX = 0x03; // end of text
 
+// UTF-8 state of a managed string, computed on first use (str_place computes it up front)
+static constexpr uint8_t R_STR_UTF8_UNKNOWN = 0;
+static constexpr uint8_t R_STR_UTF8_ASCII = 1;
+static constexpr uint8_t R_STR_UTF8_VALID = 2;
+static constexpr uint8_t R_STR_UTF8_INVALID = 3;
+// Added to the state by str_place: the header may be read-only (img.h maps images read-only), so it is never written
+static constexpr uint8_t R_STR_UTF8_PLACED = 0x80;
+
+// utf8 sits in the padding after soh, so the header size and the data offset are those of the plain layout
 typedef struct {
     char soh;
+    R_Atomic(uint8_t) utf8;
     size_t len;
     size_t cap;
     uint64_t hash;
@@ -70,10 +89,13 @@ static rstr * rstr_from(const char * data) {
 static rstr * rstr_alloc(const size_t len) {
     const size_t total = sizeof(rstr) + len + 2; // +1 for null, +1 for ETX
     rstr * r = mem_alloc(total);
+    if (r == nullptr)
+        return nullptr;
     r->soh = SOH;
     r->len = len;
     r->cap = len;
     r->hash = 0L;
+    atomic_init(&r->utf8, R_STR_UTF8_UNKNOWN);
     r->stx = STX;
     r->data[len] = NULLTERM;
     r->data[len + 1] = ETX;
@@ -85,19 +107,13 @@ static rstr * rstr_new(const char * data, const size_t max_len) {
     if (data == nullptr)
         return nullptr;
 
-    // Compute length and hash in one pass
-    size_t len = 0;
-    uint64_t hash = fnv1a_start();
-    while (len < max_len && data[len] != NULLTERM) {
-        hash = fnv1a_next(hash, (uint8_t)data[len]);
-        len++;
-    }
-
+    // Length first (libc strnlen scans a word or vector at a time), then hash the copied block
+    const size_t len = strnlen(data, max_len);
     rstr * r = rstr_alloc(len);
     if (r == nullptr)
         return nullptr;
-    r->hash = hash;
     memcpy(r->data, data, len);
+    r->hash = str_hash_bytes(r->data, len);
     return r;
 }
 
@@ -112,57 +128,453 @@ static uint64_t rstr_hash(const char * s, const size_t max_len) {
     if (s == nullptr)
         return 0;
     const rstr * r = rstr_from(s);
-    return r ? r->hash : fnv1a_hash(s, max_len);
+    return r ? r->hash : str_hash_bytes(s, strnlen(s, max_len));
 }
 
 // =====================================================================================================================
-// Internal: KMP string search
+// Internal: Substring search
 // =====================================================================================================================
+// Needles of one byte go through memchr (forward) or a byte scan (reverse). Longer needles use first/last byte
+// filtering: a block of candidate positions is compared against the needle's first byte and, shifted by len - 1,
+// its last byte; only positions matching both are verified with memcmp. Blocks are 32 (AVX2) or 16 (SSE2/NEON)
+// positions wide; without SIMD (or with RCFG__STR_NO_SIMD) the same filter runs one position at a time.
+
+#if defined(R_STR_AVX2)
+static constexpr size_t R_STR_BLOCK = 32;
+#define R_STR_MASK_SHIFT 0
+typedef __m256i str_vec;
+
+static inline str_vec str_vec_splat(const char c) {
+    return _mm256_set1_epi8(c);
+}
 
-static void kmp_lps(const char * pat, const size_t len, int * lps) {
-    int k = 0;
-    lps[0] = 0;
-    for (size_t i = 1; i < len;) {
-        if (pat[i] == pat[k]) {
-            lps[i++] = ++k;
-        } else if (k) {
-            k = lps[k - 1];
-        } else {
-            lps[i++] = 0;
+static inline uint64_t str_vec_match(const char * p, const str_vec v) {
+    const __m256i block = _mm256_loadu_si256((const __m256i *)(const void *)p);
+    return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, v));
+}
+#elif defined(R_STR_SSE2)
+static constexpr size_t R_STR_BLOCK = 16;
+#define R_STR_MASK_SHIFT 0
+typedef __m128i str_vec;
+
+static inline str_vec str_vec_splat(const char c) {
+    return _mm_set1_epi8(c);
+}
+
+static inline uint64_t str_vec_match(const char * p, const str_vec v) {
+    const __m128i block = _mm_loadu_si128((const __m128i *)(const void *)p);
+    return (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, v));
+}
+#elif defined(R_STR_NEON)
+static constexpr size_t R_STR_BLOCK = 16;
+#define R_STR_MASK_SHIFT 2
+typedef uint8x16_t str_vec;
+
+static inline str_vec str_vec_splat(const char c) {
+    return vdupq_n_u8((uint8_t)c);
+}
+
+// 4 bits per position (narrowing shift); only the top bit of each nibble is kept
+static inline uint64_t str_vec_match(const char * p, const str_vec v) {
+    const uint8x16_t eq = vceqq_u8(vld1q_u8((const uint8_t *)(const void *)p), v);
+    const uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ULL;
+}
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define R_STR_LOW_BIT(x) ((unsigned)__builtin_ctzll((x)))
+#define R_STR_HIGH_BIT(x) (63u - (unsigned)__builtin_clzll((x)))
+#define R_STR_POPCOUNT(x) ((size_t)__builtin_popcountll((x)))
+#else
+[[maybe_unused]]
+static unsigned str_low_bit(uint64_t x) {
+    unsigned n = 0;
+    while ((x & 1) == 0) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+}
+
+[[maybe_unused]]
+static unsigned str_high_bit(uint64_t x) {
+    unsigned n = 0;
+    while (x >>= 1) {
+        n++;
+    }
+    return n;
+}
+[[maybe_unused]]
+static size_t str_popcount(uint64_t x) {
+    size_t n = 0;
+    for (; x != 0; x &= x - 1) {
+        n++;
+    }
+    return n;
+}
+#define R_STR_LOW_BIT(x) str_low_bit((x))
+#define R_STR_HIGH_BIT(x) str_high_bit((x))
+#define R_STR_POPCOUNT(x) str_popcount((x))
+#endif
+
+// Needle bytes between the first and the last (both already matched by the filter)
+static inline bool str_match_inner(const char * at, const char * pat, const size_t pat_len) {
+    return pat_len <= 2 || memcmp(at + 1, pat + 1, pat_len - 2) == 0;
+}
+
+static const char * str_search_fwd(const char * text, const size_t text_len, const char * pat, const size_t pat_len) {
+    if (pat_len == 1)
+        return memchr(text, pat[0], text_len);
+
+    const size_t starts = text_len - pat_len + 1; // candidate positions [0, starts)
+    const char first = pat[0];
+    const char last = pat[pat_len - 1];
+    size_t i = 0;
+
+#ifdef R_STR_SIMD
+    const str_vec v_first = str_vec_splat(first);
+    const str_vec v_last = str_vec_splat(last);
+    for (; i + R_STR_BLOCK <= starts; i += R_STR_BLOCK) {
+        uint64_t mask = str_vec_match(text + i, v_first) & str_vec_match(text + i + pat_len - 1, v_last);
+        while (mask != 0) {
+            const size_t pos = i + (R_STR_LOW_BIT(mask) >> R_STR_MASK_SHIFT);
+            if (str_match_inner(text + pos, pat, pat_len))
+                return text + pos;
+            mask &= mask - 1;
         }
     }
+#endif // R_STR_SIMD
+
+    while (i < starts) {
+        const char * p = memchr(text + i, first, starts - i);
+        if (p == nullptr)
+            return nullptr;
+        if (p[pat_len - 1] == last && str_match_inner(p, pat, pat_len))
+            return p;
+        i = (size_t)(p - text) + 1;
+    }
+    return nullptr;
 }
 
+static const char * str_search_rev(const char * text, const size_t text_len, const char * pat, const size_t pat_len) {
+    size_t starts = text_len - pat_len + 1; // candidate positions [0, starts), scanned from the end
+    const char first = pat[0];
+    const char last = pat[pat_len - 1];
+
+#ifdef R_STR_SIMD
+    const str_vec v_first = str_vec_splat(first);
+    const str_vec v_last = str_vec_splat(last);
+    while (starts >= R_STR_BLOCK) {
+        const size_t i = starts - R_STR_BLOCK;
+        uint64_t mask = str_vec_match(text + i, v_first) & str_vec_match(text + i + pat_len - 1, v_last);
+        while (mask != 0) {
+            const unsigned bit = R_STR_HIGH_BIT(mask);
+            const size_t pos = i + (bit >> R_STR_MASK_SHIFT);
+            if (str_match_inner(text + pos, pat, pat_len))
+                return text + pos;
+            mask &= ~(1ULL << bit);
+        }
+        starts = i;
+    }
+#endif // R_STR_SIMD
+
+    while (starts > 0) {
+        const char * p = text + --starts;
+        if (p[0] == first && p[pat_len - 1] == last && str_match_inner(p, pat, pat_len))
+            return p;
+    }
+    return nullptr;
+}
+
+// Find pat in text without reporting errors (nullptr when absent)
 static const char *
-kmp_find(const char * text, const size_t text_len, const char * pat, const size_t pat_len, const bool reverse, int * lps) {
-    kmp_lps(pat, pat_len, lps);
+str_search(const char * text, const size_t text_len, const char * pat, const size_t pat_len, const bool reverse) {
+    if (pat_len == 0)
+        return reverse ? text + text_len : text;
+    if (text_len < pat_len)
+        return nullptr;
+    const char * p =
+        reverse ? str_search_rev(text, text_len, pat, pat_len) : str_search_fwd(text, text_len, pat, pat_len);
+    // Bytes covered: up to the end of the match (from the far end when reversed), or the whole text
+    R_TRACE_ADD(R_TRACE_STR_FINDS, 1);
+    R_TRACE_ADD(
+        R_TRACE_STR_FIND_BYTES,
+        p == nullptr ? text_len : reverse ? (size_t)(text + text_len - p) : (size_t)(p - text) + pat_len
+    );
+    return p;
+}
 
-    size_t i = 0, j = 0;
-    ptrdiff_t last = -1;
+// View length clamped to max_len
+static size_t sv_len(const strview v, const size_t max_len) {
+    return v.len < max_len ? v.len : max_len;
+}
+
+// =====================================================================================================================
+// Internal: UTF-8 validation
+// =====================================================================================================================
+// Well-formed UTF-8 as in Unicode Table 3-7: no overlong forms, no surrogates (U+D800-U+DFFF), nothing past
+// U+10FFFF. The scalar path skips ASCII 16 bytes at a time and decodes the rest one sequence at a time. With AVX2,
+// 32-byte blocks go through the lookup algorithm of Keiser and Lemire, "Validating UTF-8 In Less Than One
+// Instruction Per Byte" (2021): three 16-entry nibble tables classify each byte pair, and two saturating subtractions
+// check where continuation bytes are required. Pure ASCII blocks skip both.
+
+static constexpr uint64_t R_STR_HIGH_BITS = 0x8080808080808080ULL;
+
+// Length of the well-formed sequence at s (n > 0 bytes left), 0 if it is malformed or truncated
+[[maybe_unused]]
+static size_t str_utf8_seq(const uint8_t * s, const size_t n) {
+    const uint8_t b = s[0];
+    if (b < 0x80)
+        return 1;
+    if (b < 0xC2)
+        return 0;
+    if (b < 0xE0)
+        return n >= 2 && (s[1] & 0xC0) == 0x80 ? 2 : 0;
+    if (b < 0xF0) {
+        const uint8_t lo = b == 0xE0 ? 0xA0 : 0x80;
+        const uint8_t hi = b == 0xED ? 0x9F : 0xBF;
+        return n >= 3 && s[1] >= lo && s[1] <= hi && (s[2] & 0xC0) == 0x80 ? 3 : 0;
+    }
+    if (b < 0xF5) {
+        const uint8_t lo = b == 0xF0 ? 0x90 : 0x80;
+        const uint8_t hi = b == 0xF4 ? 0x8F : 0xBF;
+        return n >= 4 && s[1] >= lo && s[1] <= hi && (s[2] & 0xC0) == 0x80 && (s[3] & 0xC0) == 0x80 ? 4 : 0;
+    }
+    return 0;
+}
 
-    while (i < text_len) {
-        if (text[i] == pat[j]) {
+[[maybe_unused]]
+static uint8_t str_utf8_scan_scalar(const uint8_t * s, const size_t len) {
+    bool ascii = true;
+    size_t i = 0;
+    while (i < len) {
+        if (len - i >= 16) {
+            uint64_t w[2];
+            memcpy(w, s + i, sizeof(w));
+            if (((w[0] | w[1]) & R_STR_HIGH_BITS) == 0) {
+                i += 16;
+                continue;
+            }
+        }
+        if (s[i] < 0x80) {
             i++;
-            j++;
+            continue;
         }
-        if (j == pat_len) {
-            if (reverse) {
-                last = (ptrdiff_t)(i - j);
-                j = (size_t)lps[j - 1];
-            } else {
-                return text + (i - j);
-            }
+        const size_t n = str_utf8_seq(s + i, len - i);
+        if (n == 0)
+            return R_STR_UTF8_INVALID;
+        ascii = false;
+        i += n;
+    }
+    return ascii ? R_STR_UTF8_ASCII : R_STR_UTF8_VALID;
+}
+
+#if defined(R_STR_AVX2)
+
+// Error classes of a byte pair; a pair is malformed when its three table lookups share a bit
+static constexpr char R_UTF8_TOO_SHORT = 1 << 0;  // lead byte followed by a lead byte or ASCII
+static constexpr char R_UTF8_TOO_LONG = 1 << 1;   // ASCII followed by a continuation byte
+static constexpr char R_UTF8_OVERLONG_3 = 1 << 2; // E0 followed by 80-9F
+static constexpr char R_UTF8_TOO_LARGE = 1 << 3;  // F4 followed by 90-BF, or F5-FF
+static constexpr char R_UTF8_SURROGATE = 1 << 4;  // ED followed by A0-BF
+static constexpr char R_UTF8_OVERLONG_2 = 1 << 5; // C0 or C1
+static constexpr char R_UTF8_TOO_LARGE_1000 = 1 << 6;
+static constexpr char R_UTF8_OVERLONG_4 = 1 << 6; // F0 followed by 80-8F
+static constexpr char R_UTF8_TWO_CONTS = (char)(1 << 7); // two continuation bytes (checked against required ones)
+static constexpr char R_UTF8_CARRY = R_UTF8_TOO_SHORT | R_UTF8_TOO_LONG | R_UTF8_TWO_CONTS;
+
+// The 16 bytes repeated in both 128-bit lanes (shuffles look up within a lane)
+#define R_STR_UTF8_TABLE(...) _mm256_setr_epi8(__VA_ARGS__, __VA_ARGS__)
+
+// The block shifted by n bytes, the first n taken from the end of the previous block
+#define R_STR_UTF8_PREV(input, prev, n)                                                                                \
+    _mm256_alignr_epi8((input), _mm256_permute2x128_si256((prev), (input), 0x21), 16 - (n))
+
+static inline __m256i str_utf8_high_nibbles(const __m256i v) {
+    return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+}
+
+// Errors of the block: special cases from the nibble tables, corrected where continuation bytes are required
+static __m256i str_utf8_block_errors(const __m256i input, const __m256i prev_input) {
+    const __m256i prev1 = R_STR_UTF8_PREV(input, prev_input, 1);
+    const __m256i byte_1_high = _mm256_shuffle_epi8(
+        R_STR_UTF8_TABLE(
+            // 0_______ (ASCII), 10______ (continuation), 1100____, 1101____, 1110____, 1111____
+            R_UTF8_TOO_LONG, R_UTF8_TOO_LONG, R_UTF8_TOO_LONG, R_UTF8_TOO_LONG, R_UTF8_TOO_LONG, R_UTF8_TOO_LONG,
+            R_UTF8_TOO_LONG, R_UTF8_TOO_LONG, R_UTF8_TWO_CONTS, R_UTF8_TWO_CONTS, R_UTF8_TWO_CONTS, R_UTF8_TWO_CONTS,
+            R_UTF8_TOO_SHORT | R_UTF8_OVERLONG_2, R_UTF8_TOO_SHORT,
+            R_UTF8_TOO_SHORT | R_UTF8_OVERLONG_3 | R_UTF8_SURROGATE,
+            R_UTF8_TOO_SHORT | R_UTF8_TOO_LARGE | R_UTF8_TOO_LARGE_1000 | R_UTF8_OVERLONG_4
+        ),
+        str_utf8_high_nibbles(prev1)
+    );
+    const __m256i byte_1_low = _mm256_shuffle_epi8(
+        R_STR_UTF8_TABLE(
+            // ____0000 to ____1111
+            R_UTF8_CARRY | R_UTF8_OVERLONG_3 | R_UTF8_OVERLONG_2 | R_UTF8_OVERLONG_4, R_UTF8_CARRY | R_UTF8_OVERLONG_2,
+            R_UTF8_CARRY, R_UTF8_CARRY, R_UTF8_CARRY | R_UTF8_TOO_LARGE,
+            R_UTF8_CARRY | R_UTF8_TOO_LARGE | R_UTF8_TOO_LARGE_1000,
+            R_UTF8_CARRY | R_UTF8_TOO_LARGE | R_UTF8_TOO_LARGE_1000,
+            R_UTF8_CARRY | R_UTF8_TOO_LARGE | R_UTF8_TOO_LARGE_1000,
+            R_UTF8_CARRY | R_UTF8_TOO_LARGE | R_UTF8_TOO_LARGE_1000,
+            R_UTF8_CARRY | R_UTF8_TOO_LARGE | R_UTF8_TOO_LARGE_1000,
+            R_UTF8_CARRY | R_UTF8_TOO_LARGE | R_UTF8_TOO_LARGE_1000,
+            R_UTF8_CARRY | R_UTF8_TOO_LARGE | R_UTF8_TOO_LARGE_1000,
+            R_UTF8_CARRY | R_UTF8_TOO_LARGE | R_UTF8_TOO_LARGE_1000,
+            R_UTF8_CARRY | R_UTF8_TOO_LARGE | R_UTF8_TOO_LARGE_1000 | R_UTF8_SURROGATE,
+            R_UTF8_CARRY | R_UTF8_TOO_LARGE | R_UTF8_TOO_LARGE_1000,
+            R_UTF8_CARRY | R_UTF8_TOO_LARGE | R_UTF8_TOO_LARGE_1000
+        ),
+        _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F))
+    );
+    const char cont = R_UTF8_TOO_LONG | R_UTF8_OVERLONG_2 | R_UTF8_TWO_CONTS;
+    const __m256i byte_2_high = _mm256_shuffle_epi8(
+        R_STR_UTF8_TABLE(
+            // ________ 0_______, 1000____, 1001____, 101_____, 11______
+            R_UTF8_TOO_SHORT, R_UTF8_TOO_SHORT, R_UTF8_TOO_SHORT, R_UTF8_TOO_SHORT, R_UTF8_TOO_SHORT,
+            R_UTF8_TOO_SHORT, R_UTF8_TOO_SHORT, R_UTF8_TOO_SHORT,
+            cont | R_UTF8_OVERLONG_3 | R_UTF8_TOO_LARGE_1000 | R_UTF8_OVERLONG_4,
+            cont | R_UTF8_OVERLONG_3 | R_UTF8_TOO_LARGE, cont | R_UTF8_SURROGATE | R_UTF8_TOO_LARGE,
+            cont | R_UTF8_SURROGATE | R_UTF8_TOO_LARGE, R_UTF8_TOO_SHORT, R_UTF8_TOO_SHORT, R_UTF8_TOO_SHORT,
+            R_UTF8_TOO_SHORT
+        ),
+        str_utf8_high_nibbles(input)
+    );
+    const __m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    // Bytes two after a 3- or 4-byte lead, or three after a 4-byte lead, must be continuations (only 111_____ and
+    // 1111____ leads reach 0x80 after the saturating subtraction)
+    const __m256i prev2 = R_STR_UTF8_PREV(input, prev_input, 2);
+    const __m256i prev3 = R_STR_UTF8_PREV(input, prev_input, 3);
+    const __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80)));
+    const __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)));
+    const __m256i required = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+    return _mm256_xor_si256(required, special);
+}
+
+// Nonzero where the block ends inside a sequence (a lead byte in one of the last three positions that needs more)
+static inline __m256i str_utf8_incomplete(const __m256i input) {
+    const __m256i max = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1)
+    );
+    return _mm256_subs_epu8(input, max);
+}
+
+static uint8_t str_utf8_scan(const uint8_t * s, const size_t len) {
+    __m256i error = _mm256_setzero_si256();
+    __m256i prev_input = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+    bool ascii = true;
+    uint8_t tail[32] = {0};
+    for (size_t i = 0; i < len; i += 32) {
+        __m256i input;
+        if (len - i >= 32) {
+            input = _mm256_loadu_si256((const __m256i *)(s + i));
+        } else {
+            memcpy(tail, s + i, len - i);
+            input = _mm256_loadu_si256((const __m256i *)tail);
         }
-        if (i < text_len && text[i] != pat[j]) {
-            if (j == 0) {
-                i++;
-            } else {
-                j = (size_t)lps[j - 1];
-            }
+        if (_mm256_movemask_epi8(input) == 0) {
+            // An ASCII block only has to close the sequence the previous block ended in
+            error = _mm256_or_si256(error, prev_incomplete);
+            prev_incomplete = _mm256_setzero_si256();
+        } else {
+            ascii = false;
+            error = _mm256_or_si256(error, str_utf8_block_errors(input, prev_input));
+            prev_incomplete = str_utf8_incomplete(input);
         }
+        prev_input = input;
+        if (!_mm256_testz_si256(error, error))
+            return R_STR_UTF8_INVALID;
+    }
+    if (!_mm256_testz_si256(prev_incomplete, prev_incomplete))
+        return R_STR_UTF8_INVALID;
+    return ascii ? R_STR_UTF8_ASCII : R_STR_UTF8_VALID;
+}
+
+// Code points of valid UTF-8: the bytes that are not continuations (signed, those above -65 = 0xBF)
+static size_t str_utf8_count(const uint8_t * s, const size_t len) {
+    size_t count = 0;
+    size_t i = 0;
+    const __m256i last_cont = _mm256_set1_epi8((char)0xBF);
+    for (; len - i >= 32; i += 32) {
+        const __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+        count += R_STR_POPCOUNT((uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(v, last_cont)));
+    }
+    for (; i < len; i++)
+        count += (s[i] & 0xC0) != 0x80;
+    return count;
+}
+
+#else
+
+#define str_utf8_scan str_utf8_scan_scalar
+
+// Code points of valid UTF-8: the bytes minus the continuation bytes (10______), eight at a time
+static size_t str_utf8_count(const uint8_t * s, const size_t len) {
+    size_t cont = 0;
+    size_t i = 0;
+    for (; len - i >= 8; i += 8) {
+        uint64_t w;
+        memcpy(&w, s + i, sizeof(w));
+        cont += R_STR_POPCOUNT(w & ~w << 1 & R_STR_HIGH_BITS); // bit 7 set, bit 6 clear
     }
+    for (; i < len; i++)
+        cont += (s[i] & 0xC0) == 0x80;
+    return len - cont;
+}
+
+#endif
+
+// UTF-8 state of len bytes at s, cached in the header when s is a managed string of that length (not a placed one)
+static uint8_t rstr_utf8(const char * s, const size_t len) {
+    rstr * r = rstr_from(s);
+    if (r == nullptr || r->len != len)
+        return str_utf8_scan((const uint8_t *)s, len);
+    const uint8_t cached = atomic_load_explicit(&r->utf8, memory_order_relaxed);
+    const uint8_t state = cached & (uint8_t)~R_STR_UTF8_PLACED;
+    if (state != R_STR_UTF8_UNKNOWN)
+        return state;
+    const uint8_t scanned = str_utf8_scan((const uint8_t *)s, len);
+    if ((cached & R_STR_UTF8_PLACED) == 0)
+        atomic_store_explicit(&r->utf8, scanned, memory_order_relaxed);
+    return scanned;
+}
+
+// =====================================================================================================================
+// Internal: Interning pool
+// =====================================================================================================================
+
+// Pool key: points at the interned bytes; probe keys point at the caller's bytes
+typedef struct {
+    const char * data;
+    size_t len;
+    uint64_t hash;
+} str_intern_key;
+
+typedef const char * str_interned;
+
+#define K str_intern_key
+#define V str_interned
+#include "map.h"
+#undef K
+#undef V
+
+struct r_str_pool {
+    MAP(str_intern_key, str_interned) map;
+    allocator alloc; // strings and table are allocated from the allocator current at pool creation
+};
+
+static _Thread_local str_pool * r_str_default_pool = nullptr;
 
-    return reverse && last >= 0 ? text + last : nullptr;
+static uint64_t str_intern_hash(const str_intern_key k) {
+    return k.hash;
+}
+
+static bool str_intern_eq(const str_intern_key a, const str_intern_key b) {
+    return a.len == b.len && a.hash == b.hash && memcmp(a.data, b.data, a.len) == 0;
 }
 
 // =====================================================================================================================
@@ -264,113 +676,159 @@ extern size_t str_size(const char * s) {
     return r ? sizeof(rstr) + r->cap + 2 : 0;
 }
 
-extern uint64_t R_(str_hash)(const char * s, const str_opt * opt) {
+extern uint64_t R_(str_hash)(const strview s, const str_opt * opt) {
+    if (opt == nullptr)
+        opt = &R_STR_OPTS_DEFAULT;
+    if (s.data == nullptr)
+        return 0;
+    const size_t len = sv_len(s, opt->max_len);
+    const rstr * r = rstr_from(s.data);
+    return r && r->len == len ? r->hash : str_hash_bytes(s.data, len);
+}
+
+// =====================================================================================================================
+// Public API: UTF-8
+// =====================================================================================================================
+
+extern bool R_(str_utf8_valid)(const strview s, const str_opt * opt) {
+    if (opt == nullptr)
+        opt = &R_STR_OPTS_DEFAULT;
+    if (err_null(s.data))
+        return false;
+    if (rstr_utf8(s.data, sv_len(s, opt->max_len)) == R_STR_UTF8_INVALID) {
+        err_set(R_ERR_INVALID_UTF8, nullptr);
+        return false;
+    }
+    return true;
+}
+
+extern size_t R_(str_utf8_len)(const strview s, const str_opt * opt) {
     if (opt == nullptr)
         opt = &R_STR_OPTS_DEFAULT;
-    return rstr_hash(s, opt->max_len);
+    if (s.data == nullptr)
+        return 0;
+    const size_t len = sv_len(s, opt->max_len);
+    const uint8_t state = rstr_utf8(s.data, len);
+    if (state == R_STR_UTF8_INVALID) {
+        err_set(R_ERR_INVALID_UTF8, nullptr);
+        return SIZE_MAX;
+    }
+    return state == R_STR_UTF8_ASCII ? len : str_utf8_count((const uint8_t *)s.data, len);
+}
+
+// =====================================================================================================================
+// Public API: Views
+// =====================================================================================================================
+
+extern strview R_(str_view)(const char * s, const str_opt * opt) {
+    if (opt == nullptr)
+        opt = &R_STR_OPTS_DEFAULT;
+    return (strview){.data = s, .len = s ? rstr_len(s, opt->max_len) : 0};
+}
+
+extern char * R_(str_from_view)(const strview v, const str_opt * opt) {
+    if (opt == nullptr)
+        opt = &R_STR_OPTS_DEFAULT;
+    if (err_null(v.data))
+        return nullptr;
+    rstr * r = rstr_new(v.data, sv_len(v, opt->max_len));
+    if (r == nullptr) {
+        err_set(R_ERR_ALLOC_FAILED, nullptr);
+        return nullptr;
+    }
+    return r->data;
 }
 
 // =====================================================================================================================
 // Public API: Comparison
 // =====================================================================================================================
 
-extern int R_(str_cmp)(const char * a, const char * b, const str_opt * opt) {
+extern int R_(str_cmp)(const strview a, const strview b, const str_opt * opt) {
     if (opt == nullptr)
         opt = &R_STR_OPTS_DEFAULT;
-    if (a == nullptr)
-        return b == nullptr ? 0 : -1;
-    if (b == nullptr)
+    if (a.data == nullptr)
+        return b.data == nullptr ? 0 : -1;
+    if (b.data == nullptr)
         return 1;
-    return strncmp(a, b, opt->max_len);
+
+    const size_t a_len = sv_len(a, opt->max_len);
+    const size_t b_len = sv_len(b, opt->max_len);
+    const int cmp = memcmp(a.data, b.data, a_len < b_len ? a_len : b_len);
+    if (cmp != 0)
+        return cmp;
+    return a_len < b_len ? -1 : a_len > b_len;
 }
 
-extern bool R_(str_eq)(const char * a, const char * b, const str_opt * opt) {
+extern bool R_(str_eq)(const strview a, const strview b, const str_opt * opt) {
     if (opt == nullptr)
         opt = &R_STR_OPTS_DEFAULT;
-    if (a == nullptr)
-        return b == nullptr;
-    if (b == nullptr)
+    if (a.data == nullptr)
+        return b.data == nullptr;
+    if (b.data == nullptr)
         return false;
 
-    // Fast path: compare hashes first
-    if (rstr_hash(a, opt->max_len) != rstr_hash(b, opt->max_len)) {
+    const size_t len = sv_len(a, opt->max_len);
+    if (len != sv_len(b, opt->max_len))
         return false;
-    }
-    return strncmp(a, b, opt->max_len) == 0;
+
+    // Same bytes (always the case for equal strings interned in the same pool)
+    if (a.data == b.data)
+        return true;
+
+    // Both whole managed strings: the cached hashes reject almost every mismatch without touching the bytes
+    const rstr * ra = rstr_from(a.data);
+    const rstr * rb = rstr_from(b.data);
+    if (ra && rb && ra->len == len && rb->len == len && ra->hash != rb->hash)
+        return false;
+    return memcmp(a.data, b.data, len) == 0;
 }
 
 // =====================================================================================================================
 // Public API: Search
 // =====================================================================================================================
 
-extern const char * R_(str_find)(const char * data, const char * target, const str_opt * opt) {
+extern const char * R_(str_find)(const strview data, const strview target, const str_opt * opt) {
     if (opt == nullptr)
         opt = &R_STR_OPTS_DEFAULT;
-    if (err_null(data) || err_null(target))
+    if (err_null(data.data) || err_null(target.data))
         return nullptr;
 
-    const size_t h_len = rstr_len(data, opt->max_len);
-    const size_t n_len = rstr_len(target, opt->max_len);
-
-    if (n_len == 0)
-        return data;
-    if (h_len < n_len) {
+    const char * result =
+        str_search(data.data, sv_len(data, opt->max_len), target.data, sv_len(target, opt->max_len), false);
+    if (result == nullptr) {
         err_set(R_ERR_PATTERN_NOT_FOUND, nullptr);
-        return nullptr;
     }
+    return result;
+}
 
-    // Use stack buffer for small patterns (<=R_STR_STACK_MAX), heap for large patterns.
-    // This avoids VLA overhead for common cases while protecting stack on systems with
-    // limited stack space. Pattern length is naturally bounded by max_len (typically 4KB).
-    const char * result;
-    if (n_len <= R_STR_STACK_MAX) {
-        int lps[n_len];
-        result = kmp_find(data, h_len, target, n_len, false, lps);
-    } else {
-        int * lps = mem_alloc(n_len * sizeof(int));
-        result = kmp_find(data, h_len, target, n_len, false, lps);
-        mem_free(lps, n_len * sizeof(int));
-    }
+extern const char * R_(str_rfind)(const strview data, const strview target, const str_opt * opt) {
+    if (opt == nullptr)
+        opt = &R_STR_OPTS_DEFAULT;
+    if (err_null(data.data) || err_null(target.data))
+        return nullptr;
 
+    const char * result =
+        str_search(data.data, sv_len(data, opt->max_len), target.data, sv_len(target, opt->max_len), true);
     if (result == nullptr) {
         err_set(R_ERR_PATTERN_NOT_FOUND, nullptr);
     }
     return result;
 }
 
-extern const char * R_(str_rfind)(const char * data, const char * target, const str_opt * opt) {
+extern const char * R_(str_find_quiet)(const strview data, const strview target, const str_opt * opt) {
     if (opt == nullptr)
         opt = &R_STR_OPTS_DEFAULT;
-    if (err_null(data) || err_null(target))
+    if (data.data == nullptr || target.data == nullptr)
         return nullptr;
+    return str_search(data.data, sv_len(data, opt->max_len), target.data, sv_len(target, opt->max_len), false);
+}
 
-    const size_t h_len = rstr_len(data, opt->max_len);
-    const size_t n_len = rstr_len(target, opt->max_len);
-
-    if (n_len == 0)
-        return data + h_len;
-    if (h_len < n_len) {
-        err_set(R_ERR_PATTERN_NOT_FOUND, nullptr);
+extern const char * R_(str_rfind_quiet)(const strview data, const strview target, const str_opt * opt) {
+    if (opt == nullptr)
+        opt = &R_STR_OPTS_DEFAULT;
+    if (data.data == nullptr || target.data == nullptr)
         return nullptr;
-    }
-
-    // Use stack buffer for small patterns (<=R_STR_STACK_MAX), heap for large patterns.
-    // This avoids VLA overhead for common cases while protecting stack on systems with
-    // limited stack space. Pattern length is naturally bounded by max_len (typically 4KB).
-    const char * result;
-    if (n_len <= R_STR_STACK_MAX) {
-        int lps[n_len];
-        result = kmp_find(data, h_len, target, n_len, true, lps);
-    } else {
-        int * lps = mem_alloc(n_len * sizeof(int));
-        result = kmp_find(data, h_len, target, n_len, true, lps);
-        mem_free(lps, n_len * sizeof(int));
-    }
-
-    if (result == nullptr) {
-        err_set(R_ERR_PATTERN_NOT_FOUND, nullptr);
-    }
-    return result;
+    return str_search(data.data, sv_len(data, opt->max_len), target.data, sv_len(target, opt->max_len), true);
 }
 
 // =====================================================================================================================
@@ -390,24 +848,11 @@ extern char * R_(str_cat)(const str_opt * opt, const char * first, ...) {
     va_start(args, first);
 
     size_t total_len = 0;
-    uint64_t hash = fnv1a_start();
     size_t count = 0;
     bool overflow = false;
 
     for (const char * p = first; p != nullptr && count < R_STR_MAX_VARG; p = va_arg(args, const char *)) {
-        const rstr * r = rstr_from(p);
-        size_t len;
-
-        if (r) {
-            len = r->len;
-            hash = fnv1a_mix(hash, r->hash);
-        } else {
-            len = 0;
-            while (len < max_len && p[len] != NULLTERM) {
-                hash = fnv1a_next(hash, (uint8_t)p[len]);
-                len++;
-            }
-        }
+        const size_t len = rstr_len(p, max_len);
 
         if (total_len + len > max_len) {
             overflow = true;
@@ -429,7 +874,6 @@ extern char * R_(str_cat)(const str_opt * opt, const char * first, ...) {
         err_set(R_ERR_ALLOC_FAILED, nullptr);
         return nullptr;
     }
-    result->hash = hash;
 
     // Second pass: copy data
     va_start(args, first);
@@ -444,6 +888,8 @@ extern char * R_(str_cat)(const str_opt * opt, const char * first, ...) {
     }
     va_end(args);
 
+    // Hash the result so the cached hash always matches the content (str_eq relies on it)
+    result->hash = str_hash_bytes(result->data, total_len);
     return result->data;
 }
 
@@ -459,21 +905,9 @@ extern char * R_(str_join)(const char * delim, const char ** arr, const str_opt
     // Count strings and compute total length
     size_t count = 0;
     size_t total_len = 0;
-    uint64_t hash = fnv1a_start();
 
     for (const char ** p = arr; *p != nullptr; p++) {
-        const rstr * r = rstr_from(*p);
-        size_t len;
-
-        if (r) {
-            len = r->len;
-            hash = fnv1a_mix(hash, r->hash);
-        } else {
-            len = strnlen(*p, max_len);
-            for (size_t i = 0; i < len; i++) {
-                hash = fnv1a_next(hash, (uint8_t)(*p)[i]);
-            }
-        }
+        const size_t len = rstr_len(*p, max_len);
 
         const size_t needed = total_len + len + (count > 0 ? delim_len : 0);
         if (needed > max_len)
@@ -494,7 +928,6 @@ extern char * R_(str_join)(const char * delim, const char ** arr, const str_opt
         err_set(R_ERR_ALLOC_FAILED, nullptr);
         return nullptr;
     }
-    result->hash = hash;
 
     size_t pos = 0;
     for (size_t i = 0; i < count; i++) {
@@ -507,6 +940,7 @@ extern char * R_(str_join)(const char * delim, const char ** arr, const str_opt
         pos += len;
     }
 
+    result->hash = str_hash_bytes(result->data, total_len);
     return result->data;
 }
 
@@ -533,11 +967,10 @@ extern char * R_(str_repeat)(const char * s, const size_t n, const str_opt * opt
         err_set(R_ERR_ALLOC_FAILED, nullptr);
         return nullptr;
     }
-    result->hash = rstr_hash(s, max_len); // Simplified: not combining hashes
-
     for (size_t i = 0; i < n; i++) {
         memcpy(result->data + i * len, s, len);
     }
+    result->hash = str_hash_bytes(result->data, total);
 
     return result->data;
 }
@@ -559,15 +992,13 @@ extern char * R_(str_replace)(const char * s, const char * target, const char *
     }
 
     // Count occurrences to compute result size
-    // Note: str_find() sets R_ERR_PATTERN_NOT_FOUND when pattern is not found.
-    // We clear this expected error after counting, as "not found" is normal for the loop exit.
+    const char * const end = s + s_len;
     size_t count = 0;
     const char * p = s;
-    while ((p = R_(str_find)(p, target, opt)) != nullptr) {
+    while ((p = str_search(p, (size_t)(end - p), target, t_len, false)) != nullptr) {
         count++;
         p += t_len;
     }
-    err_clear(); // Clear R_ERR_PATTERN_NOT_FOUND from the final str_find() call
 
     if (count == 0) {
         return R_(str)(s, opt);
@@ -595,7 +1026,7 @@ extern char * R_(str_replace)(const char * s, const char * target, const char *
     const char * src = s;
     char * dst = result->data;
 
-    while ((p = R_(str_find)(src, target, opt)) != nullptr) {
+    while ((p = str_search(src, (size_t)(end - src), target, t_len, false)) != nullptr) {
         const size_t chunk = (size_t)(p - src);
         memcpy(dst, src, chunk);
         dst += chunk;
@@ -603,16 +1034,51 @@ extern char * R_(str_replace)(const char * s, const char * target, const char *
         dst += r_len;
         src = p + t_len;
     }
-    err_clear(); // Clear R_ERR_PATTERN_NOT_FOUND from the final str_find() call
 
     // Copy remainder
     const size_t tail = s_len - (size_t)(src - s);
     memcpy(dst, src, tail);
 
-    result->hash = fnv1a_hash(result->data, new_len);
+    result->hash = str_hash_bytes(result->data, new_len);
     return result->data;
 }
 
+extern str_split_iter R_(str_split_iter)(const strview s, const strview delim, const str_opt * opt) {
+    if (opt == nullptr)
+        opt = &R_STR_OPTS_DEFAULT;
+    if (err_null(s.data) || err_null(delim.data))
+        return (str_split_iter){0};
+
+    const str_split_iter it = {
+        .rest = {.data = s.data, .len = sv_len(s, opt->max_len)},
+        .delim = {.data = delim.data, .len = sv_len(delim, opt->max_len)},
+    };
+    if (it.delim.len == 0) {
+        err_set(R_ERR_INVALID_ARGUMENT, nullptr);
+        return (str_split_iter){0};
+    }
+    return it;
+}
+
+extern bool str_split_next(str_split_iter * it, strview * token) {
+    if (it == nullptr || token == nullptr)
+        return false;
+
+    while (it->rest.len > 0) {
+        const char * start = it->rest.data;
+        const char * end = str_search(start, it->rest.len, it->delim.data, it->delim.len, false);
+        const size_t len = end ? (size_t)(end - start) : it->rest.len;
+        const size_t skip = end ? len + it->delim.len : len;
+        it->rest.data += skip;
+        it->rest.len -= skip;
+        if (len > 0) {
+            *token = (strview){.data = start, .len = len};
+            return true;
+        }
+    }
+    return false;
+}
+
 extern char ** R_(str_split)(const char * s, const char * delim, const str_opt * opt) {
     if (opt == nullptr)
         opt = &R_STR_OPTS_DEFAULT;
@@ -630,20 +1096,14 @@ extern char ** R_(str_split)(const char * s, const char * delim, const str_opt *
     }
 
     // First pass: count tokens
+    const strview sv = {.data = s, .len = s_len};
+    const strview dv = {.data = delim, .len = d_len};
+    str_split_iter it = R_(str_split_iter)(sv, dv, opt);
+    strview token;
     size_t count = 0;
-    const char * start = s;
-    const char * end;
-
-    while (count < max_tokens && (size_t)(start - s) < s_len) {
-        end = R_(str_find)(start, delim, opt);
-        if (end == nullptr)
-            end = s + s_len;
-
-        if (end > start)
-            count++;
-        start = end + d_len;
+    while (count < max_tokens && str_split_next(&it, &token)) {
+        count++;
     }
-    err_clear(); // Clear error from str_find
 
     if (count == 0) {
         err_set(R_ERR_EMPTY_INPUT, nullptr);
@@ -658,32 +1118,20 @@ extern char ** R_(str_split)(const char * s, const char * delim, const str_opt *
     }
 
     // Second pass: extract tokens
-    start = s;
-    size_t i = 0;
-
-    while (i < count && (size_t)(start - s) < s_len) {
-        end = R_(str_find)(start, delim, opt);
-        if (end == nullptr)
-            end = s + s_len;
-
-        const size_t len = (size_t)(end - start);
-        if (len > 0 && len <= max_len) {
-            rstr * token = rstr_alloc(len);
-            if (token == nullptr) {
-                err_set(R_ERR_ALLOC_FAILED, nullptr);
-                // Partial failure - free what we've allocated so far and return nullptr
-                str_free_arr(result);
-                return nullptr;
-            }
-            memcpy(token->data, start, len);
-            token->hash = fnv1a_hash(token->data, len);
-            result[i++] = token->data;
+    it = R_(str_split_iter)(sv, dv, opt);
+    for (size_t i = 0; i < count && str_split_next(&it, &token); i++) {
+        rstr * r = rstr_alloc(token.len);
+        if (r == nullptr) {
+            err_set(R_ERR_ALLOC_FAILED, nullptr);
+            // Partial failure - free what we've allocated so far and return nullptr
+            str_free_arr(result);
+            return nullptr;
         }
-        start = end + d_len;
+        memcpy(r->data, token.data, token.len);
+        r->hash = str_hash_bytes(r->data, token.len);
+        result[i] = r->data;
     }
-    err_clear(); // Clear error from str_find
 
-    result[i] = nullptr;
     return result;
 }
 
@@ -703,3 +1151,298 @@ void str_free_arr(char ** arr) {
 
     mem_free(arr, (count + 1) * sizeof(char *));
 }
+
+// =====================================================================================================================
+// Public API: Builder
+// =====================================================================================================================
+
+// Managed string behind a spilled builder
+static rstr * strbuf_rstr(const strbuf * b) {
+    return (rstr *)(b->heap - offsetof(rstr, data));
+}
+
+// Move the contents into a managed string of exactly cap bytes (cap >= len). Its len and hash are only written by
+// strbuf_finish, so until then the start marker is cleared and the buffer reads as a plain C string
+static bool strbuf_resize(strbuf * b, const size_t cap) {
+    rstr * r;
+    if (b->heap == nullptr) {
+        r = rstr_alloc(cap);
+        if (r != nullptr)
+            memcpy(r->data, b->small, b->len);
+    } else {
+        r = mem_realloc(strbuf_rstr(b), sizeof(rstr) + b->cap + 2, sizeof(rstr) + cap + 2);
+    }
+    if (r == nullptr) {
+        err_set(R_ERR_ALLOC_FAILED, nullptr);
+        return false;
+    }
+    r->soh = NULLTERM;
+    r->cap = cap;
+    atomic_store_explicit(&r->utf8, R_STR_UTF8_UNKNOWN, memory_order_relaxed);
+    r->data[b->len] = NULLTERM;
+    r->data[cap] = NULLTERM;
+    b->heap = r->data;
+    b->cap = cap;
+    return true;
+}
+
+// Make room for extra more bytes, doubling the capacity (clamped to max_len) when it runs out
+static bool strbuf_grow(strbuf * b, const size_t extra) {
+    if (extra > b->max_len - b->len) {
+        err_set(R_ERR_LENGTH_EXCEEDED, nullptr);
+        return false;
+    }
+    const size_t needed = b->len + extra;
+    if (needed <= b->cap)
+        return true;
+
+    size_t cap = b->cap < 32 ? 64 : b->cap > b->max_len / 2 ? b->max_len : b->cap * 2;
+    if (cap > b->max_len)
+        cap = b->max_len;
+    if (cap < needed)
+        cap = needed;
+    return strbuf_resize(b, cap);
+}
+
+extern bool R_(strbuf_add)(strbuf * b, const strview s) {
+    if (err_null(b) || err_null(s.data))
+        return false;
+
+    // Appending the builder to itself: growth may move the bytes s points at
+    const char * data = strbuf_cstr(b);
+    const bool self = s.data >= data && s.data <= data + b->len;
+    const size_t offset = self ? (size_t)(s.data - data) : 0;
+    if (!strbuf_grow(b, s.len))
+        return false;
+
+    char * dst = b->heap ? b->heap : b->small;
+    memmove(dst + b->len, self ? dst + offset : s.data, s.len);
+    b->len += s.len;
+    dst[b->len] = NULLTERM;
+    return true;
+}
+
+extern bool strbuf_addc(strbuf * b, const char c) {
+    if (err_null(b) || !strbuf_grow(b, 1))
+        return false;
+    char * dst = b->heap ? b->heap : b->small;
+    dst[b->len++] = c;
+    dst[b->len] = NULLTERM;
+    return true;
+}
+
+extern bool strbuf_addf(strbuf * b, const char * fmt, ...) {
+    if (err_null(b) || err_null(fmt))
+        return false;
+
+    // Format straight into the spare capacity; only output that does not fit is formatted a second time
+    va_list args;
+    va_start(args, fmt);
+    va_list retry;
+    va_copy(retry, args);
+    const size_t spare = (b->cap < b->max_len ? b->cap : b->max_len) - b->len;
+    const int n = vsnprintf((b->heap ? b->heap : b->small) + b->len, spare + 1, fmt, args);
+    va_end(args);
+    if (n < 0 || (size_t)n > spare)
+        (b->heap ? b->heap : b->small)[b->len] = NULLTERM;
+
+    bool ok = n >= 0;
+    if (!ok) {
+        err_set(R_ERR_FORMAT_FAILED, nullptr);
+    } else if ((size_t)n > spare) {
+        ok = strbuf_grow(b, (size_t)n);
+        if (ok)
+            vsnprintf(b->heap + b->len, (size_t)n + 1, fmt, retry);
+    }
+    va_end(retry);
+
+    if (ok)
+        b->len += (size_t)n;
+    return ok;
+}
+
+extern bool strbuf_reserve(strbuf * b, const size_t n) {
+    if (err_null(b))
+        return false;
+    if (n > b->max_len) {
+        err_set(R_ERR_LENGTH_EXCEEDED, nullptr);
+        return false;
+    }
+    return n <= b->cap || strbuf_resize(b, n);
+}
+
+extern void strbuf_clear(strbuf * b) {
+    if (b == nullptr)
+        return;
+    b->len = 0;
+    (b->heap ? b->heap : b->small)[0] = NULLTERM;
+}
+
+extern char * strbuf_finish(strbuf * b) {
+    if (err_null(b))
+        return nullptr;
+
+    rstr * r;
+    if (b->heap == nullptr) {
+        // Inline contents: one exact-size allocation
+        r = rstr_alloc(b->len);
+        if (r == nullptr) {
+            err_set(R_ERR_ALLOC_FAILED, nullptr);
+            return nullptr;
+        }
+        memcpy(r->data, b->small, b->len);
+    } else {
+        // Trim a reservation that went mostly unused (doubling alone leaves at most half the buffer spare); a failed
+        // trim keeps the larger buffer, so its errors are dropped
+        if (b->cap / 2 > b->len && b->cap - b->len > R_STRBUF_SMALL) {
+            const int depth = err_depth();
+            if (!strbuf_resize(b, b->len)) {
+                while (err_depth() > depth)
+                    err_pop();
+            }
+        }
+        r = strbuf_rstr(b);
+        r->soh = SOH;
+        r->len = b->len;
+        r->data[r->cap + 1] = ETX;
+        // The contents may have changed since a view of them cached a UTF-8 state
+        atomic_store_explicit(&r->utf8, R_STR_UTF8_UNKNOWN, memory_order_relaxed);
+    }
+    r->hash = str_hash_bytes(r->data, r->len);
+
+    *b = (strbuf){.cap = R_STRBUF_SMALL, .max_len = b->max_len};
+    return r->data;
+}
+
+extern void strbuf_free(strbuf * b) {
+    if (b == nullptr)
+        return;
+    if (b->heap != nullptr)
+        mem_free(strbuf_rstr(b), sizeof(rstr) + b->cap + 2);
+    *b = (strbuf){.cap = R_STRBUF_SMALL, .max_len = b->max_len};
+}
+
+// =====================================================================================================================
+// Public API: Interning
+// =====================================================================================================================
+
+extern str_pool * str_pool_new(void) {
+    str_pool * pool = mem_alloc(sizeof(str_pool));
+    if (pool == nullptr) {
+        err_set(R_ERR_ALLOC_FAILED, nullptr);
+        return nullptr;
+    }
+    *pool = (str_pool){.map = map(str_intern_key, str_interned), .alloc = alloc_current()};
+    return pool;
+}
+
+extern void str_pool_free(str_pool * pool) {
+    if (pool == nullptr)
+        return;
+
+    alloc_push(pool->alloc);
+    map_foreach(&pool->map, entry) {
+        str_free(entry->key.data);
+    }
+    map_free(&pool->map);
+    mem_free(pool, sizeof(str_pool));
+    alloc_pop();
+}
+
+extern size_t str_pool_size(const str_pool * pool) {
+    return pool ? map_size(&pool->map) : 0;
+}
+
+extern const char * R_(str_intern)(str_pool * pool, const char * s, const str_opt * opt) {
+    if (opt == nullptr)
+        opt = &R_STR_OPTS_DEFAULT;
+    if (err_null(s))
+        return nullptr;
+
+    if (pool == nullptr) {
+        if (r_str_default_pool == nullptr)
+            r_str_default_pool = str_pool_new();
+        pool = r_str_default_pool;
+        if (pool == nullptr)
+            return nullptr;
+    }
+
+    // A managed string's cached length and hash cover all of it: they only serve when max_len cuts nothing off
+    const rstr * managed = rstr_from(s);
+    size_t len = managed != nullptr ? managed->len : strnlen(s, opt->max_len);
+    if (len > opt->max_len)
+        len = opt->max_len;
+    const uint64_t hash = managed == nullptr || managed->len == len ? rstr_hash(s, len) : str_hash_bytes(s, len);
+    const str_intern_key probe = {.data = s, .len = len, .hash = hash};
+    const str_interned * found = map_get(&pool->map, probe, str_intern_hash, str_intern_eq);
+    if (found != nullptr)
+        return *found;
+
+    alloc_push(pool->alloc);
+    rstr * r = rstr_new(s, len);
+    if (r == nullptr) {
+        alloc_pop();
+        err_set(R_ERR_ALLOC_FAILED, nullptr);
+        return nullptr;
+    }
+    const str_intern_key key = {.data = r->data, .len = len, .hash = r->hash};
+    if (!map_put(&pool->map, key, r->data, str_intern_hash, str_intern_eq)) {
+        mem_free(r, sizeof(rstr) + r->cap + 2);
+        alloc_pop();
+        return nullptr;
+    }
+    alloc_pop();
+    return r->data;
+}
+
+extern void str_intern_free(void) {
+    str_pool_free(r_str_default_pool);
+    r_str_default_pool = nullptr;
+}
+
+// =====================================================================================================================
+// Public API: Placement
+// =====================================================================================================================
+
+extern size_t str_place_size(const size_t len) {
+    const size_t size = sizeof(rstr) + len + 2;
+    return (size + alignof(rstr) - 1) / alignof(rstr) * alignof(rstr);
+}
+
+extern const char * str_place(void * dst, const strview s) {
+    if (err_null(dst) || (s.len > 0 && err_null(s.data)))
+        return nullptr;
+
+    rstr * r = dst;
+    r->soh = SOH;
+    r->len = s.len;
+    r->cap = s.len;
+    r->hash = str_hash_bytes(s.data, s.len);
+    // Computed now and never cached later: placed strings may end up in read-only memory
+    atomic_init(&r->utf8, R_STR_UTF8_PLACED | str_utf8_scan((const uint8_t *)s.data, s.len));
+    r->stx = STX;
+    if (s.len > 0)
+        memcpy(r->data, s.data, s.len);
+    r->data[s.len] = NULLTERM;
+    r->data[s.len + 1] = ETX;
+    return r->data;
+}
+
+extern const char * str_placed(const void * base, const size_t size, const size_t offset) {
+    if (base == nullptr || offset < offsetof(rstr, data) || offset > size ||
+        (offset - offsetof(rstr, data)) % alignof(rstr) != 0)
+        return nullptr;
+    const rstr * r = (const rstr *)((const char *)base + offset - offsetof(rstr, data));
+    if (r->soh != SOH || r->stx != STX)
+        return nullptr;
+    // The contents, terminator and end marker must fit in what follows offset before any of them is read
+    if (r->cap > size - offset || size - offset - r->cap < 2 || r->len > r->cap)
+        return nullptr;
+    if (r->data[r->len] != NULLTERM || r->data[r->cap + 1] != ETX)
+        return nullptr;
+    // A placed header is never written, so its UTF-8 state must be a known one with the placed flag (cleared by ^)
+    const uint8_t state = atomic_load_explicit(&r->utf8, memory_order_relaxed) ^ R_STR_UTF8_PLACED;
+    if (state == R_STR_UTF8_UNKNOWN || state > R_STR_UTF8_INVALID)
+        return nullptr;
+    return r->data;
+}
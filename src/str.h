@@ -4,6 +4,7 @@
  * Provides:
  *   - Managed string creation with automatic memory handling
  *   - Safe UTF-8 operations (all functions work with byte sequences, not character counts)
+ *   - UTF-8 validation and code point counting, vectorized with AVX2 (pure ASCII runs are skipped a block at a time)
  *   - Efficient hashing and comparison with optional caching for managed strings
  *   - String searching, transformation, and manipulation
  *   - Configurable limits and optional parameters for each operation
@@ -22,7 +23,22 @@
  *   str_is(data, ...)        Check if pointer is managed string
  *   str_len(data, ...)       Get string byte length
  *   str_size(data, ...)      Get allocation size (metadata included)
- *   str_hash(data, ...)      Get FNV-1a hash (cached for managed strings)
+ *   str_hash(data, ...)      Get FNV-1a or xxHash64 hash (cached for managed strings)
+ *
+ *   UTF-8 (validation cached for managed strings)
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   str_utf8_valid(s, ...)   Check for well-formed UTF-8
+ *   str_utf8_len(s, ...)     Count code points (SIZE_MAX if not well-formed)
+ *   (both accept views)
+ *
+ *   Views (non-owning, no allocation)
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   str_view(data, ...)      View of a C or managed string
+ *   str_view_n(ptr, n)       View of n bytes at ptr
+ *   str_from_view(v, ...)    Create managed string from a view
+ *   str_split_iter(s, delim) Lazy split iterator (tokens are views into s)
+ *   str_split_next(it, tok)  Advance iterator; false when exhausted
+ *   (str_hash, str_cmp, str_eq, str_find and str_rfind accept views for any string argument)
  *
  *   Comparison
  *   -------------------------------------------------------------------------------------------------------------------
@@ -33,6 +49,8 @@
  *   -------------------------------------------------------------------------------------------------------------------
  *   str_find(data, target)   Find first occurrence (returns pointer or nullptr)
  *   str_rfind(data, target)  Find last occurrence (returns pointer or nullptr)
+ *   str_find_quiet(d, t)     str_find without reporting misses or nullptr arguments as errors
+ *   str_rfind_quiet(d, t)    str_rfind without reporting misses or nullptr arguments as errors
  *
  *   Transformation (returns new strings - free with str_free)
  *   -------------------------------------------------------------------------------------------------------------------
@@ -46,6 +64,35 @@
  *   )                        Replace all occurrences
  *   str_split(s, delim)      Split by delimiter (returns nullptr-terminated array)
  *
+ *   Builder (amortized in-place appends, short contents inline)
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   strbuf(...)              Empty builder (optional str_opt sets max_len)
+ *   strbuf_add(b, s)         Append a string or view
+ *   strbuf_addc(b, c)        Append one byte
+ *   strbuf_addf(b, fmt, ...) Append formatted text (printf-style)
+ *   strbuf_reserve(b, n)     Ensure capacity for n bytes in total
+ *   strbuf_len(b)            Bytes appended so far
+ *   strbuf_cstr(b)           Contents so far (null-terminated, builder-owned)
+ *   strbuf_view(b)           Contents so far as a view
+ *   strbuf_clear(b)          Drop contents, keep capacity
+ *   strbuf_finish(b)         Hand contents over as a managed string (no copy once on the heap)
+ *   strbuf_free(b)           Release the builder's buffer
+ *
+ *   Interning (pool-owned strings - never str_free them)
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   str_intern(s, ...)       Intern in the calling thread's default pool
+ *   str_intern_free()        Free the calling thread's default pool
+ *   str_pool_new()           Create an interning pool
+ *   str_pool_intern(p, s)    Intern in pool p (equal strings return the same pointer)
+ *   str_pool_size(p)         Number of distinct strings in pool p
+ *   str_pool_free(p)         Free pool p and every string it interned
+ *
+ *   Placement (managed-string layout in caller memory - never str_free them)
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   str_place_size(len)      Bytes a placed copy of a len-byte string occupies
+ *   str_place(dst, view)     Copy a view to dst with the managed-string header (cached length and hash)
+ *   str_placed(p, n, off)    Placed string at offset off of n bytes at p, checked to lie inside them
+ *
  * Example:
  *   char * greeting = str("Hello");
  *   if (err_has()) { err_print(stderr); return; }
@@ -72,6 +119,17 @@
 // Configuration
 // =====================================================================================================================
 
+// Cached hash of managed strings (also used by str_hash)
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef RCFG__STR_BLOCK_HASH
+[[maybe_unused]]
+static constexpr bool R_STR_BLOCK_HASH = RCFG__STR_BLOCK_HASH;
+#else  // FNV-1a by default; xxHash64 (hash64) when enabled, much faster for strings beyond a few dozen bytes
+[[maybe_unused]]
+static constexpr bool R_STR_BLOCK_HASH = false;
+#endif // RCFG__STR_BLOCK_HASH
+
 // String operation limits
 // ---------------------------------------------------------------------------------------------------------------------
 
@@ -108,6 +166,17 @@ static constexpr size_t R_STR_MAX_TOK = RCFG__STR_MAX_TOK;
 static constexpr size_t R_STR_MAX_TOK = 64;
 #endif // RCFG__STR_MAX_TOK
 
+// String builder
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef RCFG__STRBUF_SMALL
+[[maybe_unused]]
+static constexpr size_t R_STRBUF_SMALL = RCFG__STRBUF_SMALL;
+#else  // Bytes a builder holds inline before its first heap allocation (keeps sizeof(strbuf) at 56 bytes)
+[[maybe_unused]]
+static constexpr size_t R_STRBUF_SMALL = 23;
+#endif // RCFG__STRBUF_SMALL
+
 // String options structure
 // ---------------------------------------------------------------------------------------------------------------------
 
@@ -121,6 +190,28 @@ static const str_opt R_STR_OPTS_DEFAULT = {
     .max_tok = R_STR_MAX_TOK,
 };
 
+// String view
+// ---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Non-owning slice of a string: data is not necessarily null-terminated and is never freed through the view.
+ * Functions documented as accepting views take either a strview or a C/managed string for each string argument.
+ */
+typedef struct {
+    const char * data;
+    size_t len;
+} strview;
+
+// Convert a string argument to a view: views pass through, C strings are measured (cached for managed strings)
+#define R_STR_VIEW(s, opt) _Generic((s), strview: R_(str_view_self), default: R_(str_view))((s), (opt))
+
+// Call fn(view, view, opt) with opt evaluated once
+#define R_STR_VIEW_CALL2(fn, a, b, opt)                                                                                \
+    ({                                                                                                                 \
+        const str_opt * R_UNIQUE(_sv_opt) = (opt);                                                                     \
+        fn(R_STR_VIEW((a), R_UNIQUE(_sv_opt)), R_STR_VIEW((b), R_UNIQUE(_sv_opt)), R_UNIQUE(_sv_opt));                 \
+    })
+
 // =====================================================================================================================
 // Creation & Destruction
 // =====================================================================================================================
@@ -159,28 +250,87 @@ extern size_t R_(str_len)(const char * s, const str_opt * opt);
 
 extern size_t str_size(const char * s);
 
-#define str_hash(data, ...) R_(str_hash)((data), R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__))
-extern uint64_t R_(str_hash)(const char * s, const str_opt * opt);
+// Accepts views
+#define str_hash(data, ...)                                                                                            \
+    ({                                                                                                                 \
+        const str_opt * R_UNIQUE(_sv_opt) = R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__);                                   \
+        R_(str_hash)(R_STR_VIEW((data), R_UNIQUE(_sv_opt)), R_UNIQUE(_sv_opt));                                        \
+    })
+extern uint64_t R_(str_hash)(strview s, const str_opt * opt);
+
+// =====================================================================================================================
+// UTF-8
+// =====================================================================================================================
+
+/**
+ * Well-formed means as defined by Unicode (Table 3-7): no overlong encodings, no surrogates, nothing past U+10FFFF.
+ * Both fail with R_ERR_INVALID_UTF8 otherwise. A managed string is validated once; its result is kept in the header.
+ */
+#define str_utf8_valid(data, ...)                                                                                      \
+    ({                                                                                                                 \
+        const str_opt * R_UNIQUE(_sv_opt) = R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__);                                   \
+        R_(str_utf8_valid)(R_STR_VIEW((data), R_UNIQUE(_sv_opt)), R_UNIQUE(_sv_opt));                                  \
+    })
+extern bool R_(str_utf8_valid)(strview s, const str_opt * opt);
+
+#define str_utf8_len(data, ...)                                                                                        \
+    ({                                                                                                                 \
+        const str_opt * R_UNIQUE(_sv_opt) = R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__);                                   \
+        R_(str_utf8_len)(R_STR_VIEW((data), R_UNIQUE(_sv_opt)), R_UNIQUE(_sv_opt));                                    \
+    })
+extern size_t R_(str_utf8_len)(strview s, const str_opt * opt);
+
+// =====================================================================================================================
+// Views
+// =====================================================================================================================
+
+#define str_view(data, ...) R_(str_view)((data), R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__))
+extern strview R_(str_view)(const char * s, const str_opt * opt);
+
+#define str_view_n(ptr, n) ((strview){.data = (ptr), .len = (n)})
+
+[[maybe_unused]]
+static inline strview R_(str_view_self)(const strview v, const str_opt * opt) {
+    (void)opt;
+    return v;
+}
+
+#define str_from_view(v, ...) R_(str_from_view)((v), R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__))
+[[nodiscard]]
+extern char * R_(str_from_view)(strview v, const str_opt * opt);
 
 // =====================================================================================================================
 // Comparison
 // =====================================================================================================================
 
-#define str_cmp(a, b, ...) R_(str_cmp)((a), (b), R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__))
-extern int R_(str_cmp)(const char * a, const char * b, const str_opt * opt);
+// Both accept views
+#define str_cmp(a, b, ...) R_STR_VIEW_CALL2(R_(str_cmp), (a), (b), R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__))
+extern int R_(str_cmp)(strview a, strview b, const str_opt * opt);
 
-#define str_eq(a, b, ...) R_(str_eq)((a), (b), R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__))
-extern bool R_(str_eq)(const char * a, const char * b, const str_opt * opt);
+#define str_eq(a, b, ...) R_STR_VIEW_CALL2(R_(str_eq), (a), (b), R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__))
+extern bool R_(str_eq)(strview a, strview b, const str_opt * opt);
 
 // =====================================================================================================================
 // Search
 // =====================================================================================================================
 
-#define str_find(data, target, ...) R_(str_find)((data), (target), R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__))
-extern const char * R_(str_find)(const char * data, const char * target, const str_opt * opt);
+// Both accept views
+#define str_find(data, target, ...)                                                                                    \
+    R_STR_VIEW_CALL2(R_(str_find), (data), (target), R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__))
+extern const char * R_(str_find)(strview data, strview target, const str_opt * opt);
+
+#define str_rfind(data, target, ...)                                                                                   \
+    R_STR_VIEW_CALL2(R_(str_rfind), (data), (target), R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__))
+extern const char * R_(str_rfind)(strview data, strview target, const str_opt * opt);
 
-#define str_rfind(data, target, ...) R_(str_rfind)((data), (target), R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__))
-extern const char * R_(str_rfind)(const char * data, const char * target, const str_opt * opt);
+// Non-reporting variants for hot loops: a miss (or a nullptr argument) returns nullptr without touching the error stack
+#define str_find_quiet(data, target, ...)                                                                              \
+    R_STR_VIEW_CALL2(R_(str_find_quiet), (data), (target), R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__))
+extern const char * R_(str_find_quiet)(strview data, strview target, const str_opt * opt);
+
+#define str_rfind_quiet(data, target, ...)                                                                             \
+    R_STR_VIEW_CALL2(R_(str_rfind_quiet), (data), (target), R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__))
+extern const char * R_(str_rfind_quiet)(strview data, strview target, const str_opt * opt);
 
 // =====================================================================================================================
 // Transformation
@@ -213,4 +363,143 @@ extern char * R_(str_replace)(const char * s, const char * target, const char *
 [[nodiscard]]
 extern char ** R_(str_split)(const char * s, const char * delim, const str_opt * opt);
 
+/**
+ * Lazy, non-allocating split: each str_split_next() yields the next non-empty token as a view into s, skipping empty
+ * tokens exactly like str_split. s and delim accept views and must outlive the iterator.
+ *
+ *   str_split_iter it = str_split_iter(line, ",");
+ *   strview field;
+ *   while (str_split_next(&it, &field)) { ... }
+ */
+typedef struct {
+    strview rest;
+    strview delim;
+} str_split_iter;
+
+#define str_split_iter(s, delim, ...)                                                                                  \
+    R_STR_VIEW_CALL2(R_(str_split_iter), (s), (delim), R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__))
+extern str_split_iter R_(str_split_iter)(strview s, strview delim, const str_opt * opt);
+extern bool str_split_next(str_split_iter * it, strview * token);
+
+// =====================================================================================================================
+// Builder
+// =====================================================================================================================
+
+/**
+ * Growable string builder. Contents of up to R_STRBUF_SMALL bytes live inline in the builder itself, so short strings
+ * never touch the heap while being built. Longer contents live in a managed string whose capacity doubles as it
+ * fills, so n appends copy O(n) bytes in total. strbuf_finish hands that managed string over as is (no copy) and
+ * leaves the builder empty and reusable.
+ *
+ * The contents are always null-terminated and never exceed the builder's max_len: an append that would is rejected
+ * whole with R_ERR_LENGTH_EXCEEDED. A builder owning a heap buffer must not be copied by value, and must be finished
+ * or released with strbuf_free under the allocator it grew with.
+ *
+ *   strbuf b = strbuf(&(str_opt){.max_len = 1 << 20});
+ *   strbuf_add(&b, "HTTP/1.1 ");
+ *   strbuf_addf(&b, "%d %s\r\n", 200, "OK");
+ *   char * response = strbuf_finish(&b); // free with str_free
+ */
+typedef struct {
+    char * heap; // data of the managed string being built, nullptr while the contents are inline
+    size_t len;
+    size_t cap; // bytes available for contents (terminator excluded)
+    size_t max_len;
+    char small[R_STRBUF_SMALL + 1];
+} strbuf;
+
+// Empty builder; the optional str_opt sets the length limit (default R_STR_MAX_LEN)
+#define strbuf(...) ((strbuf){.cap = R_STRBUF_SMALL, .max_len = (R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__))->max_len})
+
+// Contents so far (null-terminated; invalidated by the next append, finish or free)
+[[maybe_unused]]
+static inline const char * strbuf_cstr(const strbuf * b) {
+    return b->heap ? b->heap : b->small;
+}
+
+[[maybe_unused]]
+static inline strview strbuf_view(const strbuf * b) {
+    return (strview){.data = strbuf_cstr(b), .len = b->len};
+}
+
+[[maybe_unused]]
+static inline size_t strbuf_len(const strbuf * b) {
+    return b->len;
+}
+
+// Append; s accepts views (C strings are measured against the builder's max_len)
+#define strbuf_add(b, s)                                                                                               \
+    ({                                                                                                                 \
+        strbuf * R_UNIQUE(_sb) = (b);                                                                                  \
+        R_(strbuf_add)(                                                                                                \
+            R_UNIQUE(_sb),                                                                                             \
+            R_STR_VIEW((s), R_UNIQUE(_sb) ? &(str_opt){.max_len = R_UNIQUE(_sb)->max_len} : nullptr)                   \
+        );                                                                                                             \
+    })
+extern bool R_(strbuf_add)(strbuf * b, strview s);
+
+extern bool strbuf_addc(strbuf * b, char c);
+extern bool strbuf_addf(strbuf * b, const char * fmt, ...);
+
+// Ensure room for n bytes of contents in total (single allocation)
+extern bool strbuf_reserve(strbuf * b, size_t n);
+
+// Drop the contents, keeping the buffer for reuse
+extern void strbuf_clear(strbuf * b);
+
+// Managed string holding the contents (hashed, free with str_free); the builder is left empty
+[[nodiscard]]
+extern char * strbuf_finish(strbuf * b);
+
+// Release the buffer without producing a string
+extern void strbuf_free(strbuf * b);
+
+// =====================================================================================================================
+// Interning
+// =====================================================================================================================
+
+/**
+ * An interning pool keeps one managed copy of each distinct string. Interning an equal string again returns the
+ * same pointer, so interned strings from one pool compare equal exactly when the pointers are equal.
+ *
+ * Strings returned by str_intern/str_pool_intern are owned by their pool: never pass them to str_free. The pool and
+ * its strings are allocated from the allocator current when the pool was created, and are released by
+ * str_pool_free (or str_intern_free for the thread's default pool). Pools are not thread-safe.
+ */
+typedef struct r_str_pool str_pool;
+
+[[nodiscard]]
+extern str_pool * str_pool_new(void);
+extern void str_pool_free(str_pool * pool);
+extern size_t str_pool_size(const str_pool * pool);
+
+#define str_pool_intern(pool, s, ...) R_(str_intern)((pool), (s), R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__))
+#define str_intern(s, ...) R_(str_intern)(nullptr, (s), R_OPT(&R_STR_OPTS_DEFAULT, __VA_ARGS__))
+extern const char * R_(str_intern)(str_pool * pool, const char * s, const str_opt * opt);
+
+extern void str_intern_free(void);
+
+// =====================================================================================================================
+// Placement
+// =====================================================================================================================
+
+/**
+ * A placed string has the managed-string layout (str_is is true, str_len and str_hash read the cached values) but
+ * lives in memory the caller provides, such as the string section of an image (img.h). It is read-only, and never
+ * passed to str_free: the memory belongs to whoever provided it.
+ */
+
+// Bytes a placed copy of a len-byte string occupies; a multiple of the header alignment, so copies can be packed
+extern size_t str_place_size(size_t len);
+
+// Copy s to dst (str_place_size(s.len) bytes, aligned like a pointer) and return the placed string (its data pointer)
+extern const char * str_place(void * dst, strview s);
+
+/**
+ * Placed string whose data starts offset bytes into the size bytes at base (aligned like a pointer), or nullptr unless
+ * a whole placement with consistent header fields lies inside them. For placements read from untrusted memory, such
+ * as an image file, where str_is alone would trust the stored length and capacity.
+ */
+extern const char * str_placed(const void * base, size_t size, size_t offset);
+
 #endif // RUNE_CORE_STR_H
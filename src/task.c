@@ -0,0 +1,439 @@
+/*
+ * Task module implementation - Chase-Lev work-stealing deques over a pthread pool.
+ *
+ * Deque algorithm: Chase and Lev, "Dynamic Circular Work-Stealing Deque" (SPAA 2005), with the C11 memory orderings
+ * of Le, Pop, Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+ */
+
+#include "task.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct {
+    task_fn fn;
+    void * arg;
+    task_group * group;
+} r_task;
+
+#define T r_task
+#include "coll.h"
+#undef T
+
+// =====================================================================================================================
+// Internal: Pool structure
+// =====================================================================================================================
+
+// Slot fields are atomic (relaxed) because a thief may read a slot the owner is about to reuse; the thief's CAS on
+// top then fails and the torn read is discarded
+typedef struct {
+    R_Atomic(task_fn) fn;
+    R_Atomic(void *) arg;
+    R_Atomic(task_group *) group;
+} r_task_slot;
+
+/**
+ * Worker thread and its deque. The owner pushes and takes at bottom, thieves steal at top; the two indices sit on
+ * separate cache lines so stealing does not bounce the owner's line.
+ */
+typedef struct {
+    R_Atomic(int64_t) top;
+    char pad0[R_CACHE_LINE - sizeof(int64_t)];
+    R_Atomic(int64_t) bottom;
+    char pad1[R_CACHE_LINE - sizeof(int64_t)];
+    r_task_slot slots[R_TASK_DEQUE_CAP];
+    task_pool * pool;
+    size_t index;
+    arena scratch;
+    pthread_t thread;
+} r_task_worker;
+
+struct r_task_pool {
+    r_task_worker * workers;
+    size_t count;
+    MPMC(r_task) inject;        // tasks spawned from outside the pool
+    R_Atomic(size_t) queued;    // tasks sitting in a deque or in inject (sleeping workers wait for it to rise)
+    R_Atomic(size_t) sleeping;  // workers blocked on wake
+    R_Atomic(bool) stop;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    allocator alloc; // pool memory, and tasks' allocations unless workers own arenas
+    bool arenas;
+};
+
+static _Thread_local r_task_worker * r_task_self = nullptr;
+static _Thread_local uint64_t r_task_rng = 0;
+
+// =====================================================================================================================
+// Internal: Chase-Lev deque
+// =====================================================================================================================
+
+static void r_task_slot_store(r_task_slot * s, const r_task t) {
+    atomic_store_explicit(&s->fn, t.fn, memory_order_relaxed);
+    atomic_store_explicit(&s->arg, t.arg, memory_order_relaxed);
+    atomic_store_explicit(&s->group, t.group, memory_order_relaxed);
+}
+
+static r_task r_task_slot_load(r_task_slot * s) {
+    return (r_task){
+        .fn = atomic_load_explicit(&s->fn, memory_order_relaxed),
+        .arg = atomic_load_explicit(&s->arg, memory_order_relaxed),
+        .group = atomic_load_explicit(&s->group, memory_order_relaxed),
+    };
+}
+
+// Owner only: false when the deque is full
+static bool r_task_deque_push(r_task_worker * w, const r_task t) {
+    const int64_t b = atomic_load_explicit(&w->bottom, memory_order_relaxed);
+    const int64_t top = atomic_load_explicit(&w->top, memory_order_acquire);
+    if (b - top >= (int64_t)R_TASK_DEQUE_CAP) {
+        return false;
+    }
+    r_task_slot_store(&w->slots[(uint64_t)b % R_TASK_DEQUE_CAP], t);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+    return true;
+}
+
+// Owner only: newest task
+static bool r_task_deque_take(r_task_worker * w, r_task * out) {
+    const int64_t b = atomic_load_explicit(&w->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&w->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&w->top, memory_order_relaxed);
+    if (t > b) {
+        atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+        return false;
+    }
+
+    *out = r_task_slot_load(&w->slots[(uint64_t)b % R_TASK_DEQUE_CAP]);
+    if (t < b) {
+        return true;
+    }
+
+    // Last task: race the thieves for it
+    const bool won =
+        atomic_compare_exchange_strong_explicit(&w->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+    atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+    return won;
+}
+
+// Any thread: oldest task (false when empty or when another thief got there first)
+static bool r_task_deque_steal(r_task_worker * w, r_task * out) {
+    int64_t t = atomic_load_explicit(&w->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    const int64_t b = atomic_load_explicit(&w->bottom, memory_order_acquire);
+    if (t >= b) {
+        return false;
+    }
+    *out = r_task_slot_load(&w->slots[(uint64_t)t % R_TASK_DEQUE_CAP]);
+    return atomic_compare_exchange_strong_explicit(&w->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+}
+
+// =====================================================================================================================
+// Internal: Scheduling
+// =====================================================================================================================
+
+static uint64_t r_task_random(void) {
+    if (r_task_rng == 0) {
+        r_task_rng = (uint64_t)(uintptr_t)&r_task_rng | 1;
+    }
+    r_task_rng ^= r_task_rng << 13;
+    r_task_rng ^= r_task_rng >> 7;
+    r_task_rng ^= r_task_rng << 17;
+    return r_task_rng;
+}
+
+// Injection queue pop that leaves no R_ERR_QUEUE_EMPTY behind when another consumer wins the race
+static bool r_task_inject_pop(task_pool * pool, r_task * out) {
+    if (mpmc_empty(&pool->inject)) {
+        return false;
+    }
+    const int depth = err_depth();
+    *out = mpmc_pop(&pool->inject);
+    if (out->fn == nullptr) {
+        while (err_depth() > depth) {
+            err_pop();
+        }
+        return false;
+    }
+    return true;
+}
+
+// Next task for the calling thread: its own deque (newest first), the injection queue, then a random victim's oldest
+static bool r_task_find(task_pool * pool, r_task_worker * self, r_task * out) {
+    bool found = (self != nullptr && r_task_deque_take(self, out)) || r_task_inject_pop(pool, out);
+    const size_t start = pool->count > 1 ? (size_t)(r_task_random() % pool->count) : 0;
+    for (size_t i = 0; !found && i < pool->count; i++) {
+        r_task_worker * victim = &pool->workers[(start + i) % pool->count];
+        found = victim != self && r_task_deque_steal(victim, out);
+    }
+    if (found) {
+        atomic_fetch_sub_explicit(&pool->queued, 1, memory_order_relaxed);
+    }
+    return found;
+}
+
+// Run a task, folding any error it leaves into its group
+static void r_task_run(const r_task t) {
+    const int depth = err_depth();
+    t.fn(t.arg);
+    if (err_depth() > depth) {
+        int expected = R_ERR_OK;
+        atomic_compare_exchange_strong_explicit(
+            &t.group->error, &expected, (int)err_code(), memory_order_relaxed, memory_order_relaxed
+        );
+        while (err_depth() > depth) {
+            err_pop();
+        }
+    }
+    atomic_fetch_sub_explicit(&t.group->pending, 1, memory_order_acq_rel);
+}
+
+// Wake one sleeping worker; pairs with the sleeping/queued check in r_task_worker_main (both sides seq_cst)
+static void r_task_signal(task_pool * pool) {
+    if (atomic_load(&pool->sleeping) > 0) {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_signal(&pool->wake);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+static void * r_task_worker_main(void * arg) {
+    r_task_worker * w = arg;
+    task_pool * pool = w->pool;
+    r_task_self = w;
+    alloc_push(pool->arenas ? arena_allocator(&w->scratch) : pool->alloc);
+
+    size_t idle = 0;
+    while (!atomic_load_explicit(&pool->stop, memory_order_acquire)) {
+        r_task t;
+        if (r_task_find(pool, w, &t)) {
+            r_task_run(t);
+            idle = 0;
+            continue;
+        }
+        if (++idle < R_TASK_SPIN) {
+            sched_yield();
+            continue;
+        }
+
+        // Nothing to steal for a while: sleep until a spawn raises queued (or the pool stops)
+        idle = 0;
+        atomic_fetch_add(&pool->sleeping, 1);
+        pthread_mutex_lock(&pool->lock);
+        while (atomic_load(&pool->queued) == 0 && !atomic_load(&pool->stop)) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+        atomic_fetch_sub(&pool->sleeping, 1);
+    }
+
+    alloc_pop();
+    r_task_self = nullptr;
+    return nullptr;
+}
+
+// Release what task_pool_new set up for the first started workers (called with pool->alloc current)
+static void r_task_pool_release(task_pool * pool, const size_t started) {
+    pthread_mutex_lock(&pool->lock);
+    atomic_store(&pool->stop, true);
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(pool->workers[i].thread, nullptr);
+    }
+
+    for (size_t i = 0; i < pool->count; i++) {
+        arena_free(&pool->workers[i].scratch);
+    }
+    mpmc_free(&pool->inject);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    mem_free(pool->workers, pool->count * sizeof(r_task_worker));
+    mem_free(pool, sizeof(task_pool));
+}
+
+// =====================================================================================================================
+// Public API: Pool
+// =====================================================================================================================
+
+extern task_pool * R_(task_pool_new)(const task_opt * opt) {
+    if (opt == nullptr)
+        opt = &R_TASK_OPTS_DEFAULT;
+
+    size_t count = opt->workers;
+    if (count == 0) {
+        const long online = sysconf(_SC_NPROCESSORS_ONLN);
+        count = online > 0 ? (size_t)online : 1;
+    }
+
+    task_pool * pool = mem_alloc_zero(sizeof(task_pool));
+    if (pool == nullptr) {
+        err_set(R_ERR_ALLOC_FAILED, nullptr);
+        return nullptr;
+    }
+    pool->workers = mem_alloc_zero(count * sizeof(r_task_worker));
+    if (pool->workers == nullptr) {
+        mem_free(pool, sizeof(task_pool));
+        err_set(R_ERR_ALLOC_FAILED, nullptr);
+        return nullptr;
+    }
+    pool->count = count;
+    pool->inject = mpmc(r_task, R_TASK_INJECT_CAP);
+    atomic_init(&pool->queued, 0);
+    atomic_init(&pool->sleeping, 0);
+    atomic_init(&pool->stop, false);
+    pthread_mutex_init(&pool->lock, nullptr);
+    pthread_cond_init(&pool->wake, nullptr);
+    pool->alloc = alloc_current();
+    pool->arenas = opt->arena_chunk > 0;
+
+    for (size_t i = 0; i < count; i++) {
+        r_task_worker * w = &pool->workers[i];
+        atomic_init(&w->top, 0);
+        atomic_init(&w->bottom, 0);
+        w->pool = pool;
+        w->index = i;
+        w->scratch = arena(pool->arenas ? opt->arena_chunk : R_ARENA_CHUNK_SIZE);
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (pthread_create(&pool->workers[i].thread, nullptr, r_task_worker_main, &pool->workers[i]) != 0) {
+            r_task_pool_release(pool, i);
+            err_set(R_ERR_ALLOC_FAILED, "could not start worker thread");
+            return nullptr;
+        }
+    }
+    return pool;
+}
+
+extern void task_pool_free(task_pool * pool) {
+    if (pool == nullptr)
+        return;
+    alloc_push(pool->alloc);
+    r_task_pool_release(pool, pool->count);
+    alloc_pop();
+}
+
+extern size_t task_pool_workers(const task_pool * pool) {
+    return pool ? pool->count : 0;
+}
+
+extern void task_pool_reset(task_pool * pool) {
+    if (pool == nullptr || !pool->arenas)
+        return;
+    for (size_t i = 0; i < pool->count; i++) {
+        arena_reset(&pool->workers[i].scratch);
+    }
+}
+
+extern size_t task_worker_index(void) {
+    return r_task_self ? r_task_self->index : SIZE_MAX;
+}
+
+// =====================================================================================================================
+// Public API: Groups
+// =====================================================================================================================
+
+extern bool task_spawn(task_group * g, const task_fn fn, void * arg) {
+    if (err_null(g) || err_null(g->pool) || err_null(fn))
+        return false;
+
+    task_pool * pool = g->pool;
+    const r_task t = {.fn = fn, .arg = arg, .group = g};
+    atomic_fetch_add_explicit(&g->pending, 1, memory_order_relaxed);
+    atomic_fetch_add(&pool->queued, 1);
+
+    // Workers of this pool push onto their own deque, every other thread goes through the injection queue
+    r_task_worker * self = r_task_self;
+    bool queued = self != nullptr && self->pool == pool && r_task_deque_push(self, t);
+    if (!queued) {
+        const int depth = err_depth();
+        queued = mpmc_push(&pool->inject, t).fn != nullptr;
+        while (err_depth() > depth) {
+            err_pop();
+        }
+    }
+
+    if (!queued) {
+        // Full: run it right here, which also throttles a producer that outpaces the workers
+        atomic_fetch_sub_explicit(&pool->queued, 1, memory_order_relaxed);
+        r_task_run(t);
+        return true;
+    }
+    r_task_signal(pool);
+    return true;
+}
+
+extern bool task_wait(task_group * g) {
+    if (err_null(g) || err_null(g->pool))
+        return false;
+
+    task_pool * pool = g->pool;
+    r_task_worker * self = r_task_self != nullptr && r_task_self->pool == pool ? r_task_self : nullptr;
+    while (atomic_load_explicit(&g->pending, memory_order_acquire) > 0) {
+        r_task t;
+        if (r_task_find(pool, self, &t)) {
+            r_task_run(t);
+        } else {
+            sched_yield();
+        }
+    }
+
+    const int code = atomic_exchange_explicit(&g->error, R_ERR_OK, memory_order_relaxed);
+    if (code != R_ERR_OK) {
+        err_set((r_error_code)code, "task failed");
+        return false;
+    }
+    return true;
+}
+
+// =====================================================================================================================
+// Public API: Loops
+// =====================================================================================================================
+
+typedef struct {
+    task_range_fn fn;
+    void * arg;
+    size_t n;
+    size_t grain;
+    R_Atomic(size_t) next;
+} r_task_range;
+
+// Claim chunks until the range is exhausted, so fast runners take over the share of slow ones
+static void r_task_range_main(void * arg) {
+    r_task_range * r = arg;
+    for (;;) {
+        const size_t begin = atomic_fetch_add_explicit(&r->next, r->grain, memory_order_relaxed);
+        if (begin >= r->n) {
+            return;
+        }
+        r->fn(r->arg, begin, r->n - begin < r->grain ? r->n : begin + r->grain);
+    }
+}
+
+extern bool task_for(task_pool * pool, const size_t n, size_t grain, const task_range_fn fn, void * arg) {
+    if (err_null(pool) || err_null(fn))
+        return false;
+    if (n == 0)
+        return true;
+    if (grain == 0) {
+        grain = n / (8 * pool->count);
+        grain = grain > 0 ? grain : 1;
+    }
+
+    r_task_range range = {.fn = fn, .arg = arg, .n = n, .grain = grain};
+    atomic_init(&range.next, 0);
+
+    // One runner per worker at most; the waiting thread picks up runners too
+    const size_t chunks = n / grain + (n % grain != 0);
+    const size_t runners = chunks < pool->count ? chunks : pool->count;
+    task_group g = task_group(pool);
+    for (size_t i = 0; i < runners; i++) {
+        task_spawn(&g, r_task_range_main, &range);
+    }
+    return task_wait(&g);
+}
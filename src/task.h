@@ -0,0 +1,153 @@
+/**
+ * Task module - Work-stealing thread pool.
+ *
+ * Provides:
+ *   - A fixed pool of worker threads, each owning a Chase-Lev deque of tasks
+ *   - Work stealing: owners run their newest task first, idle workers take the oldest task of a random victim
+ *   - An injection queue (MPMC ring from coll.h) for tasks spawned by threads outside the pool
+ *   - Task groups: spawn any number of tasks, then wait for all of them (the waiting thread runs tasks meanwhile)
+ *   - Parallel loops over index ranges with dynamic chunking
+ *   - Optional per-worker arenas, so scratch allocations made by tasks never contend on the shared allocator
+ *
+ * Quick Reference:
+ *
+ *   Pool
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   task_pool(...)                Start a pool (optional task_opt: worker count, per-worker arena chunk size)
+ *   task_pool_free(pool)          Stop and join the workers, release the pool (nullptr-safe)
+ *   task_pool_workers(pool)       Number of worker threads
+ *   task_pool_reset(pool)         Release every worker arena allocation at once (pool must be idle)
+ *   task_worker_index()           Index of the calling worker thread, SIZE_MAX outside any pool
+ *
+ *   Groups
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   task_group(pool)              Empty group of tasks running on pool
+ *   task_spawn(g, fn, arg)        Queue fn(arg) as part of group g
+ *   task_wait(g)                  Run tasks until every task of g has finished; false if one of them failed
+ *
+ *   Loops
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   task_for(
+ *       pool, n, grain,
+ *       fn, arg
+ *   )                             fn(arg, begin, end) over [0, n) in chunks of grain indices, returns when done
+ *
+ * Example:
+ *   task_pool * pool = task_pool(&(task_opt){.workers = 8});
+ *
+ *   task_group g = task_group(pool);
+ *   for (size_t i = 0; i < files; i++) task_spawn(&g, index_file, &jobs[i]);
+ *   if (!task_wait(&g)) err_print(stderr);
+ *
+ *   task_for(pool, count, 4096, hash_range, &batch);   // hash_range(&batch, begin, end)
+ *   task_pool_free(pool);
+ *
+ * Tasks run on the workers and, while a thread waits in task_wait or task_for, on that thread. A task that leaves an
+ * error on its thread's error stack marks its group failed: the first such code is reported by task_wait, and the
+ * task's errors are cleared so they never leak into unrelated work. Pools are safe to use from any thread; a group
+ * belongs to the thread that waits on it, though its tasks may spawn more tasks into it.
+ */
+
+// ReSharper disable CppInconsistentNaming
+#ifndef RUNE_TASK_H
+#define RUNE_TASK_H
+
+#include <stdint.h>
+
+#include "r.h"
+
+// =====================================================================================================================
+// Configuration
+// =====================================================================================================================
+
+#ifdef RCFG__TASK_DEQUE_CAP
+static constexpr size_t R_TASK_DEQUE_CAP = RCFG__TASK_DEQUE_CAP;
+#else  // Tasks each worker deque holds; a worker spawning into a full deque runs the task itself
+static constexpr size_t R_TASK_DEQUE_CAP = 4096;
+#endif // RCFG__TASK_DEQUE_CAP
+
+#ifdef RCFG__TASK_INJECT_CAP
+static constexpr size_t R_TASK_INJECT_CAP = RCFG__TASK_INJECT_CAP;
+#else  // Tasks queued by threads outside the pool; a spawn into a full queue runs the task on the spawning thread
+static constexpr size_t R_TASK_INJECT_CAP = 4096;
+#endif // RCFG__TASK_INJECT_CAP
+
+#ifdef RCFG__TASK_SPIN
+static constexpr size_t R_TASK_SPIN = RCFG__TASK_SPIN;
+#else  // Fruitless steal rounds (each followed by a yield) before an idle worker goes to sleep
+static constexpr size_t R_TASK_SPIN = 64;
+#endif // RCFG__TASK_SPIN
+
+// =====================================================================================================================
+// Types
+// =====================================================================================================================
+
+typedef void (*task_fn)(void * arg);
+typedef void (*task_range_fn)(void * arg, size_t begin, size_t end);
+
+typedef struct r_task_pool task_pool;
+
+/**
+ * Pool options.
+ *
+ * @param workers      Worker threads to start, 0 for one per online CPU
+ * @param arena_chunk  0: tasks on workers allocate from the allocator current at task_pool(), which must then be
+ *                     thread safe. Otherwise each worker owns an arena with chunks of this size (chunks come from
+ *                     that same allocator), pushed as the worker's current allocator: allocations made by tasks on
+ *                     workers live until task_pool_reset or task_pool_free and must not be freed any other way.
+ */
+typedef struct {
+    size_t workers;
+    size_t arena_chunk;
+} task_opt;
+
+static const task_opt R_TASK_OPTS_DEFAULT = {
+    .workers = 0,
+    .arena_chunk = 0,
+};
+
+/**
+ * Tasks spawned together and waited for together.
+ *
+ * @param pool     Pool the tasks run on
+ * @param pending  Tasks spawned and not finished yet
+ * @param error    First r_error_code left by one of the tasks (R_ERR_OK while none failed)
+ */
+typedef struct {
+    task_pool * pool;
+    R_Atomic(size_t) pending;
+    R_Atomic(int) error;
+} task_group;
+
+// =====================================================================================================================
+// Pool
+// =====================================================================================================================
+
+#define task_pool(...) R_(task_pool_new)(R_OPT(&R_TASK_OPTS_DEFAULT, __VA_ARGS__))
+[[nodiscard]]
+extern task_pool * R_(task_pool_new)(const task_opt * opt);
+
+// Stops the workers: every group must have been waited for (tasks still queued are dropped)
+extern void task_pool_free(task_pool * pool);
+
+extern size_t task_pool_workers(const task_pool * pool);
+extern void task_pool_reset(task_pool * pool);
+extern size_t task_worker_index(void);
+
+// =====================================================================================================================
+// Groups
+// =====================================================================================================================
+
+#define task_group(p) ((task_group){.pool = (p), .pending = 0, .error = R_ERR_OK})
+
+extern bool task_spawn(task_group * g, task_fn fn, void * arg);
+extern bool task_wait(task_group * g);
+
+// =====================================================================================================================
+// Loops
+// =====================================================================================================================
+
+// grain 0 picks chunks of about n / (8 * workers) indices
+extern bool task_for(task_pool * pool, size_t n, size_t grain, task_range_fn fn, void * arg);
+
+#endif // RUNE_TASK_H
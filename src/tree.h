@@ -1,5 +1,5 @@
 /**
- * Red-black self-balancing binary search tree.
+ * Ordered trees: red-black self-balancing binary search tree and cache-friendly B-tree.
  *
  * Provides:
  *   - Self-balancing binary search tree with O(log n) operations
@@ -7,6 +7,9 @@
  *   - Custom comparator support per operation with default numeric comparison
  *   - Efficient insertion, search, and deletion operations
  *   - Proper handling of red-black tree invariants
+ *   - O(n) bulk construction from sorted input into a single contiguous node block
+ *   - Stackless in-order iteration, lower/upper bound and range visits
+ *   - B-tree with wide nodes sized to cache lines (RCFG__BTREE_NODE_BYTES), keys stored inline in each node
  *
  * Quick Reference:
  *
@@ -16,10 +19,33 @@
  *   rbt_contains(t, val, ...)   Check if value exists (optional comparator)
  *   rbt_insert(t, val, ...)     Insert value, ignored if duplicate (optional comparator)
  *   rbt_remove(t, val, ...)     Remove value from tree (optional comparator)
+ *   rbt_first(t) / rbt_last(t)  Smallest / largest node (nullptr if empty)
+ *   rbt_lower_bound(t, v, ...)  First node with value >= v (optional comparator)
+ *   rbt_upper_bound(t, v, ...)  First node with value > v (optional comparator)
+ *   rbt_foreach(t, node)        Iterate nodes in ascending order
+ *   rbt_foreach_range(t, lo, hi, node, ...)
+ *                               Iterate nodes with lo <= value < hi (optional comparator)
+ *   rbt_build_sorted(t, arr, n) Replace contents with sorted array in O(n), one node block
+ *   rbt_clear(t)                Free all nodes, tree stays usable
+ *   rbt_free(t)                 Release all memory owned by the tree
+ *
+ *   B-Tree API
+ *   -------------------------------------------------------------------------------------------------------------------
+ *   btree(type)                 Create empty tree
+ *   btree_size(t)               Number of keys
+ *   btree_contains(t, val, ...) Check if key exists (optional comparator)
+ *   btree_find(t, val, ...)     Pointer to stored key or nullptr (optional comparator)
+ *   btree_insert(t, val, ...)   Insert key, false if duplicate (optional comparator)
+ *   btree_remove(t, val, ...)   Remove key, false if absent (optional comparator)
+ *   btree_clear(t)              Free all nodes, tree stays usable
+ *   btree_free(t)               Release all memory owned by the tree
  *
  *   BST Helper API
  *   -------------------------------------------------------------------------------------------------------------------
  *   bst_min(node)               Find minimum node in subtree
+ *   bst_max(node)               Find maximum node in subtree
+ *   bst_next(node)              In-order successor via parent pointers (nullptr after last)
+ *   bst_prev(node)              In-order predecessor via parent pointers (nullptr before first)
  *   bst_find(t, val, ...)       Find node with value in tree (optional comparator)
  *   bst_remove(t, node)         Remove specific node from tree (internal use)
  *
@@ -43,11 +69,25 @@
  *   bool found = rbt_contains(&tree2, 3, cmp);
  *   rbt_remove(&tree2, 5, cmp);
  *
- * Note: RBT requires template expansion via #define T / #undef T for type instantiation.
+ *   // Range scan without copying: visits 3 <= value < 7 only
+ *   rbt_foreach_range(&tree, 3, 7, node) {
+ *       printf("%d\n", node->data);
+ *   }
+ *
+ *   // B-tree over the same instantiation: about 4 bytes per int key instead of an RBT_NODE each
+ *   BTREE(int) index = btree(int);
+ *   btree_insert(&index, 42);
+ *   bool has = btree_contains(&index, 42);  // true
+ *   btree_free(&index);
+ *
+ * Note: RBT and BTREE require template expansion via #define T / #undef T for type instantiation.
  */
 
 // ReSharper disable once CppMissingIncludeGuard
 
+#include <stdint.h>
+#include <string.h>
+
 #include "r.h"
 
 // Suppress pedantic warnings about GNU statement expressions (intentional, required for macro-based templates)
@@ -80,6 +120,57 @@
         /* return */ R_UNIQUE(_min_cur);                                                                               \
     })
 
+#define bst_max(node)                                                                                                  \
+    ({                                                                                                                 \
+        typeof_unqual((node)) R_UNIQUE(_max_cur) = (node);                                                             \
+        while (R_UNIQUE(_max_cur) != nullptr && R_UNIQUE(_max_cur)->right != nullptr) {                                \
+            R_UNIQUE(_max_cur) = R_UNIQUE(_max_cur)->right;                                                            \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_max_cur);                                                                               \
+    })
+
+/**
+ * In-order successor of a node, or nullptr after the last node.
+ * Walks the parent pointers instead of a stack: down to the minimum of the right subtree if there is one, otherwise
+ * up until the walk leaves a left subtree. A full traversal touches every edge twice, so it is O(1) amortized.
+ */
+#define bst_next(node)                                                                                                 \
+    ({                                                                                                                 \
+        typeof_unqual((node)) R_UNIQUE(_nxt_cur) = (node);                                                             \
+        if (R_UNIQUE(_nxt_cur) != nullptr) {                                                                           \
+            if (R_UNIQUE(_nxt_cur)->right != nullptr) {                                                                \
+                R_UNIQUE(_nxt_cur) = bst_min(R_UNIQUE(_nxt_cur)->right);                                               \
+            } else {                                                                                                   \
+                while (R_UNIQUE(_nxt_cur)->parent != nullptr &&                                                        \
+                       R_UNIQUE(_nxt_cur)->parent->right == R_UNIQUE(_nxt_cur)) {                                      \
+                    R_UNIQUE(_nxt_cur) = R_UNIQUE(_nxt_cur)->parent;                                                   \
+                }                                                                                                      \
+                R_UNIQUE(_nxt_cur) = R_UNIQUE(_nxt_cur)->parent;                                                       \
+            }                                                                                                          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_nxt_cur);                                                                               \
+    })
+
+/**
+ * In-order predecessor of a node, or nullptr before the first node (mirror of bst_next).
+ */
+#define bst_prev(node)                                                                                                 \
+    ({                                                                                                                 \
+        typeof_unqual((node)) R_UNIQUE(_prv_cur) = (node);                                                             \
+        if (R_UNIQUE(_prv_cur) != nullptr) {                                                                           \
+            if (R_UNIQUE(_prv_cur)->left != nullptr) {                                                                 \
+                R_UNIQUE(_prv_cur) = bst_max(R_UNIQUE(_prv_cur)->left);                                                \
+            } else {                                                                                                   \
+                while (R_UNIQUE(_prv_cur)->parent != nullptr &&                                                        \
+                       R_UNIQUE(_prv_cur)->parent->left == R_UNIQUE(_prv_cur)) {                                       \
+                    R_UNIQUE(_prv_cur) = R_UNIQUE(_prv_cur)->parent;                                                   \
+                }                                                                                                      \
+                R_UNIQUE(_prv_cur) = R_UNIQUE(_prv_cur)->parent;                                                       \
+            }                                                                                                          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_prv_cur);                                                                               \
+    })
+
 #define bst_find(t, val, ...)                                                                                          \
     ({                                                                                                                 \
         typeof_unqual((t)->root) R_UNIQUE(_cur) = (t)->root;                                                           \
@@ -91,6 +182,14 @@
         /* return */ R_UNIQUE(_cur);                                                                                   \
     })
 
+/**
+ * Check whether a node lives in the tree's bulk-built node block (see rbt_build_sorted).
+ * A single unsigned comparison covers both ends of the block.
+ */
+#define R_BST_IN_BLOCK(t, node)                                                                                        \
+    ((t)->block != nullptr &&                                                                                          \
+     (uintptr_t)(node) - (uintptr_t)(t)->block < (t)->block_len * (t)->node_size)
+
 /**
  * Replace a node with its child in the tree (used in BST deletion).
  */
@@ -179,7 +278,12 @@
         node_to_free->left = nullptr;                                                                                  \
         node_to_free->right = nullptr;                                                                                 \
         node_to_free->parent = nullptr;                                                                                \
-        mem_free(node_to_free, (t)->node_size);                                                                        \
+        /* Nodes carved from a bulk-built block are released together with the block */                                \
+        if (R_BST_IN_BLOCK((t), node_to_free)) {                                                                       \
+            (t)->block_live--;                                                                                         \
+        } else {                                                                                                       \
+            mem_free(node_to_free, (t)->node_size);                                                                    \
+        }                                                                                                              \
         /* return */ suc;                                                                                              \
     })
 
@@ -202,7 +306,13 @@ enum rbt_dir { R_(rbt_left), R_(rbt_right), R_(rbt_exists) };
 #define RBT(type) R_GLUE(rbt_, type)
 #define RBT_NODE(type) R_GLUE(rbt_node_, type)
 
-#define rbt(type) {.root = nullptr, .node_size = sizeof(struct RBT_NODE(type)), .size = 0}
+#define rbt(type)                                                                                                      \
+    {.root = nullptr,                                                                                                  \
+     .node_size = sizeof(struct RBT_NODE(type)),                                                                       \
+     .size = 0,                                                                                                        \
+     .block = nullptr,                                                                                                 \
+     .block_len = 0,                                                                                                   \
+     .block_live = 0}
 
 #define R_RBT_PARENT(t, val, out_dir, ...)                                                                             \
     ({                                                                                                                 \
@@ -227,6 +337,21 @@ enum rbt_dir { R_(rbt_left), R_(rbt_right), R_(rbt_exists) };
         /* return */ R_UNIQUE(_parent_parent);                                                                         \
     })
 
+// Edges from node up to the root; only computed for the trace counters (0 without RCFG__TRACE)
+#ifdef RCFG__TRACE
+#define R_RBT_DEPTH(node)                                                                                              \
+    ({                                                                                                                 \
+        size_t R_UNIQUE(_depth_n) = 0;                                                                                 \
+        for (typeof_unqual(node) R_UNIQUE(_depth_cur) = (node)->parent; R_UNIQUE(_depth_cur) != nullptr;               \
+             R_UNIQUE(_depth_cur) = R_UNIQUE(_depth_cur)->parent) {                                                    \
+            R_UNIQUE(_depth_n)++;                                                                                      \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_depth_n);                                                                               \
+    })
+#else
+#define R_RBT_DEPTH(node) ((size_t)0)
+#endif // RCFG__TRACE
+
 /**
  * Rotate a node left around its parent.
  *
@@ -263,7 +388,7 @@ enum rbt_dir { R_(rbt_left), R_(rbt_right), R_(rbt_exists) };
             const typeof_unqual(R_UNIQUE(_node_parent)->parent) R_UNIQUE(_gparent) = R_UNIQUE(_node_parent)->parent;   \
             if (R_UNIQUE(_gparent) == nullptr) {                                                                       \
                 /* parent is root */                                                                                   \
-                t->root = (node);                                                                                      \
+                (t)->root = (node);                                                                                    \
             } else if (R_BST_LEFT(R_UNIQUE(_node_parent))) {                                                           \
                 R_UNIQUE(_gparent)->left = (node);                                                                     \
             } else {                                                                                                   \
@@ -273,15 +398,15 @@ enum rbt_dir { R_(rbt_left), R_(rbt_right), R_(rbt_exists) };
                                                                                                                        \
             /* node make node's former parent its right child */                                                       \
             typeof_unqual((t)->root) R_UNIQUE(_prev) = nullptr;                                                        \
-            if (dir == R_(rbt_left)) {                                                                                 \
+            if ((dir) == R_(rbt_left)) {                                                                               \
                 R_UNIQUE(_prev) = (node)->left;                                                                        \
                 (node)->left = R_UNIQUE(_node_parent);                                                                 \
                 R_UNIQUE(_node_parent)->parent = (node);                                                               \
                 R_UNIQUE(_node_parent)->right = R_UNIQUE(_prev);                                                       \
             } else {                                                                                                   \
-                R_UNIQUE(_prev) = node->right;                                                                         \
-                node->right = R_UNIQUE(_node_parent);                                                                  \
-                R_UNIQUE(_node_parent)->parent = node;                                                                 \
+                R_UNIQUE(_prev) = (node)->right;                                                                       \
+                (node)->right = R_UNIQUE(_node_parent);                                                                \
+                R_UNIQUE(_node_parent)->parent = (node);                                                               \
                 R_UNIQUE(_node_parent)->left = R_UNIQUE(_prev);                                                        \
             }                                                                                                          \
                                                                                                                        \
@@ -302,6 +427,63 @@ enum rbt_dir { R_(rbt_left), R_(rbt_right), R_(rbt_exists) };
 /* rbt_contains: optional comparator */
 #define rbt_contains(t, val, ...) (((t) != nullptr) && (bst_find((t), (val), __VA_ARGS__) != nullptr))
 
+/* rbt_first / rbt_last: smallest and largest node, nullptr for an empty tree */
+#define rbt_first(t) ((t) != nullptr ? bst_min((t)->root) : nullptr)
+#define rbt_last(t) ((t) != nullptr ? bst_max((t)->root) : nullptr)
+
+/**
+ * First node whose value is not less than val, or nullptr if every value is smaller (optional comparator).
+ */
+#define rbt_lower_bound(t, val, ...)                                                                                   \
+    ({                                                                                                                 \
+        typeof_unqual((t)->root) R_UNIQUE(_lb_cur) = (t) != nullptr ? (t)->root : nullptr;                             \
+        typeof_unqual((t)->root) R_UNIQUE(_lb_best) = nullptr;                                                         \
+        while (R_UNIQUE(_lb_cur) != nullptr) {                                                                         \
+            if (R_BST_CMP(R_UNIQUE(_lb_cur)->data, (val) __VA_OPT__(, ) __VA_ARGS__) < 0) {                            \
+                R_UNIQUE(_lb_cur) = R_UNIQUE(_lb_cur)->right;                                                          \
+            } else {                                                                                                   \
+                R_UNIQUE(_lb_best) = R_UNIQUE(_lb_cur);                                                                \
+                R_UNIQUE(_lb_cur) = R_UNIQUE(_lb_cur)->left;                                                           \
+            }                                                                                                          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_lb_best);                                                                               \
+    })
+
+/**
+ * First node whose value is greater than val, or nullptr if no value is (optional comparator).
+ */
+#define rbt_upper_bound(t, val, ...)                                                                                   \
+    ({                                                                                                                 \
+        typeof_unqual((t)->root) R_UNIQUE(_ub_cur) = (t) != nullptr ? (t)->root : nullptr;                             \
+        typeof_unqual((t)->root) R_UNIQUE(_ub_best) = nullptr;                                                         \
+        while (R_UNIQUE(_ub_cur) != nullptr) {                                                                         \
+            if (R_BST_CMP((val), R_UNIQUE(_ub_cur)->data __VA_OPT__(, ) __VA_ARGS__) < 0) {                            \
+                R_UNIQUE(_ub_best) = R_UNIQUE(_ub_cur);                                                                \
+                R_UNIQUE(_ub_cur) = R_UNIQUE(_ub_cur)->left;                                                           \
+            } else {                                                                                                   \
+                R_UNIQUE(_ub_cur) = R_UNIQUE(_ub_cur)->right;                                                          \
+            }                                                                                                          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_ub_best);                                                                               \
+    })
+
+/**
+ * Iterate over all nodes in ascending order.
+ * `node` is declared as a node pointer; the value is `node->data`. The tree must not be modified during iteration;
+ * `break` and `continue` behave as in a plain loop.
+ */
+#define rbt_foreach(t, node)                                                                                           \
+    for (typeof_unqual((t)->root) node = rbt_first((t)); node != nullptr; node = bst_next(node))
+
+/**
+ * Iterate over the nodes with lo <= value < hi in ascending order (optional comparator).
+ * Costs one O(log n) descent plus O(1) amortized per visited node, so a narrow range never touches the rest of the
+ * tree. hi is compared on every step and should be a plain value. The same rules as rbt_foreach apply.
+ */
+#define rbt_foreach_range(t, lo, hi, node, ...)                                                                        \
+    for (typeof_unqual((t)->root) node = rbt_lower_bound((t), (lo) __VA_OPT__(, ) __VA_ARGS__);                        \
+         node != nullptr && R_BST_CMP(node->data, (hi) __VA_OPT__(, ) __VA_ARGS__) < 0; node = bst_next(node))
+
 #define rbt_insert(t, val, ...)                                                                                        \
     ({                                                                                                                 \
         if ((t) != nullptr) {                                                                                          \
@@ -316,6 +498,7 @@ enum rbt_dir { R_(rbt_left), R_(rbt_right), R_(rbt_exists) };
                 new_node->color = R_(rbt_red);                                                                         \
                 new_node->data = (val);                                                                                \
                 (t)->size++;                                                                                           \
+                R_TRACE_ADD(R_TRACE_RBT_INSERTS, 1);                                                                   \
                                                                                                                        \
                 /* 4 - check if the tree is empty */                                                                   \
                 if (parent == nullptr) {                                                                               \
@@ -330,6 +513,11 @@ enum rbt_dir { R_(rbt_left), R_(rbt_right), R_(rbt_exists) };
                         parent->right = new_node;                                                                      \
                     }                                                                                                  \
                                                                                                                        \
+                    /* trace the insert depth (tree shape) */                                                          \
+                    const size_t new_depth = R_RBT_DEPTH(new_node);                                                    \
+                    R_TRACE_ADD(R_TRACE_RBT_DEPTH, new_depth);                                                         \
+                    R_TRACE_MAX(R_TRACE_RBT_DEPTH_MAX, new_depth);                                                     \
+                                                                                                                       \
                     /* 6 - handle red parent violations */                                                             \
                     typeof_unqual((t)->root) cur = new_node;                                                           \
                                                                                                                        \
@@ -342,6 +530,7 @@ enum rbt_dir { R_(rbt_left), R_(rbt_right), R_(rbt_exists) };
                         /* 8 - check if uncle is black, if so, we need rotations and then exit */                      \
                         if (uncle == nullptr || uncle->color == R_(rbt_black)) {                                       \
                             /* uncle is black */                                                                       \
+                            R_TRACE_ADD(R_TRACE_RBT_ROTATIONS, (R_BST_LEFT(cur)) == parent_left ? 1 : 2);              \
                             if (R_BST_LEFT(cur)) {                                                                     \
                                 if (parent_left) {                                                                     \
                                     /* left-left (single rotation) */                                                  \
@@ -387,7 +576,8 @@ enum rbt_dir { R_(rbt_left), R_(rbt_right), R_(rbt_exists) };
 
 /**
  * Fix red-black tree violations after deleting a black node.
- * Handles the double-black node by applying one of four cases:
+ * The double-black (DB) position is passed as node plus its parent, since the node that took the deleted node's
+ * place is often nullptr. Handles it by applying one of four cases:
  *
  * CASE 1: Sibling is RED
  *   The parent must be black (RBT property). Rotate to convert this into
@@ -449,398 +639,639 @@ enum rbt_dir { R_(rbt_left), R_(rbt_right), R_(rbt_exists) };
  * The loop continues until the double-black reaches the root or is eliminated.
  * If it reaches the root, we simply make it single black (no violation at root).
  */
-#define R_RBT_FIX_DELETE(t, node)                                                                                      \
+#define R_RBT_FIX_DELETE(t, node, node_parent)                                                                         \
     ({                                                                                                                 \
-        while ((node) != nullptr && (node)->color == R_(rbt_double_black) && (node) != (t)->root) {                    \
-            const bool R_UNIQUE(_fix_is_left) = R_BST_LEFT((node));                                                    \
-            typeof_unqual((node)->parent) R_UNIQUE(_fix_sib) =                                                         \
-                R_UNIQUE(_fix_is_left) ? (node)->parent->right : (node)->parent->left;                                 \
-                                                                                                                       \
-            if (R_UNIQUE(_fix_sib) != nullptr && R_UNIQUE(_fix_sib)->color == R_(rbt_red)) {                           \
-                /* CASE 1: Sibling is RED - rotate and recolor to convert to cases 2-4 */                              \
-                const enum rbt_color R_UNIQUE(_fix_pcolor) = (node)->parent->color;                                    \
-                if (R_UNIQUE(_fix_is_left)) {                                                                          \
-                    R_RBT_ROTATE((t), R_UNIQUE(_fix_sib), R_(rbt_left));                                               \
+        typeof_unqual((t)->root) R_UNIQUE(_fix_x) = (node);                                                            \
+        typeof_unqual((t)->root) R_UNIQUE(_fix_xp) = (node_parent);                                                    \
+        while (R_UNIQUE(_fix_xp) != nullptr &&                                                                         \
+               (R_UNIQUE(_fix_x) == nullptr || R_UNIQUE(_fix_x)->color == R_(rbt_black))) {                            \
+            const bool R_UNIQUE(_fix_is_left) = R_UNIQUE(_fix_x) == R_UNIQUE(_fix_xp)->left;                           \
+            typeof_unqual((t)->root) R_UNIQUE(_fix_sib) =                                                              \
+                R_UNIQUE(_fix_is_left) ? R_UNIQUE(_fix_xp)->right : R_UNIQUE(_fix_xp)->left;                           \
+            const enum rbt_dir R_UNIQUE(_fix_up) = R_UNIQUE(_fix_is_left) ? R_(rbt_left) : R_(rbt_right);              \
+            if (R_UNIQUE(_fix_sib)->color == R_(rbt_red)) {                                                            \
+                /* Case 1 - red sibling: rotate it above the parent */                                                 \
+                R_UNIQUE(_fix_sib)->color = R_(rbt_black);                                                             \
+                R_UNIQUE(_fix_xp)->color = R_(rbt_red);                                                                \
+                R_RBT_ROTATE((t), R_UNIQUE(_fix_sib), R_UNIQUE(_fix_up));                                              \
+                R_UNIQUE(_fix_sib) = R_UNIQUE(_fix_is_left) ? R_UNIQUE(_fix_xp)->right : R_UNIQUE(_fix_xp)->left;      \
+            }                                                                                                          \
+            typeof_unqual((t)->root) R_UNIQUE(_fix_near) =                                                             \
+                R_UNIQUE(_fix_is_left) ? R_UNIQUE(_fix_sib)->left : R_UNIQUE(_fix_sib)->right;                         \
+            typeof_unqual((t)->root) R_UNIQUE(_fix_far) =                                                              \
+                R_UNIQUE(_fix_is_left) ? R_UNIQUE(_fix_sib)->right : R_UNIQUE(_fix_sib)->left;                         \
+            if ((R_UNIQUE(_fix_near) == nullptr || R_UNIQUE(_fix_near)->color == R_(rbt_black)) &&                     \
+                (R_UNIQUE(_fix_far) == nullptr || R_UNIQUE(_fix_far)->color == R_(rbt_black))) {                       \
+                /* Case 2 - black sibling with black children: push the deficit up */                                  \
+                R_UNIQUE(_fix_sib)->color = R_(rbt_red);                                                               \
+                R_UNIQUE(_fix_x) = R_UNIQUE(_fix_xp);                                                                  \
+                R_UNIQUE(_fix_xp) = R_UNIQUE(_fix_x)->parent;                                                          \
+            } else {                                                                                                   \
+                if (R_UNIQUE(_fix_far) == nullptr || R_UNIQUE(_fix_far)->color == R_(rbt_black)) {                     \
+                    /* Case 3 - red near child: rotate it into the far position */                                     \
+                    R_UNIQUE(_fix_near)->color = R_(rbt_black);                                                        \
+                    R_UNIQUE(_fix_sib)->color = R_(rbt_red);                                                           \
+                    R_RBT_ROTATE(                                                                                      \
+                        (t), R_UNIQUE(_fix_near), R_UNIQUE(_fix_is_left) ? R_(rbt_right) : R_(rbt_left)                \
+                    );                                                                                                 \
+                    R_UNIQUE(_fix_far) = R_UNIQUE(_fix_sib);                                                           \
+                    R_UNIQUE(_fix_sib) = R_UNIQUE(_fix_near);                                                          \
+                }                                                                                                      \
+                /* Case 4 - red far child: rotate the sibling above the parent, done */                                \
+                R_UNIQUE(_fix_sib)->color = R_UNIQUE(_fix_xp)->color;                                                  \
+                R_UNIQUE(_fix_xp)->color = R_(rbt_black);                                                              \
+                R_UNIQUE(_fix_far)->color = R_(rbt_black);                                                             \
+                R_RBT_ROTATE((t), R_UNIQUE(_fix_sib), R_UNIQUE(_fix_up));                                              \
+                R_UNIQUE(_fix_x) = (t)->root;                                                                          \
+                R_UNIQUE(_fix_xp) = nullptr;                                                                           \
+            }                                                                                                          \
+        }                                                                                                              \
+        if (R_UNIQUE(_fix_x) != nullptr) {                                                                             \
+            R_UNIQUE(_fix_x)->color = R_(rbt_black);                                                                   \
+        }                                                                                                              \
+    })
+
+/**
+ * Remove a value from the tree.
+ *
+ * The node is unlinked with bst_remove, which splices in the in-order successor when the node has two children. The
+ * color that actually leaves its position is the successor's (bst_remove gives the successor the removed node's
+ * color), so the fix-up runs from the successor's old slot when that color was black.
+ */
+#define rbt_remove(t, val, ...)                                                                                        \
+    ({                                                                                                                 \
+        typeof_unqual((t)->root) R_UNIQUE(_rmv_node) = nullptr;                                                        \
+        if ((t) != nullptr) {                                                                                          \
+            R_UNIQUE(_rmv_node) = bst_find((t), (val), __VA_ARGS__);                                                   \
+            if (R_UNIQUE(_rmv_node) != nullptr) {                                                                      \
+                (t)->size--;                                                                                           \
+                /* Node whose color leaves the tree, the child that takes its place, and that child's parent */        \
+                enum rbt_color R_UNIQUE(_rmv_color) = R_UNIQUE(_rmv_node)->color;                                      \
+                typeof_unqual((t)->root) R_UNIQUE(_rmv_x) = nullptr;                                                   \
+                typeof_unqual((t)->root) R_UNIQUE(_rmv_xp) = R_UNIQUE(_rmv_node)->parent;                              \
+                if (R_UNIQUE(_rmv_node)->left == nullptr) {                                                            \
+                    R_UNIQUE(_rmv_x) = R_UNIQUE(_rmv_node)->right;                                                     \
+                } else if (R_UNIQUE(_rmv_node)->right == nullptr) {                                                    \
+                    R_UNIQUE(_rmv_x) = R_UNIQUE(_rmv_node)->left;                                                      \
                 } else {                                                                                               \
-                    R_RBT_ROTATE((t), R_UNIQUE(_fix_sib), R_(rbt_right));                                              \
+                    typeof_unqual((t)->root) R_UNIQUE(_rmv_suc) = bst_min(R_UNIQUE(_rmv_node)->right);                 \
+                    R_UNIQUE(_rmv_color) = R_UNIQUE(_rmv_suc)->color;                                                  \
+                    R_UNIQUE(_rmv_x) = R_UNIQUE(_rmv_suc)->right;                                                      \
+                    R_UNIQUE(_rmv_xp) = R_UNIQUE(_rmv_suc)->parent == R_UNIQUE(_rmv_node)                              \
+                                            ? R_UNIQUE(_rmv_suc)                                                       \
+                                            : R_UNIQUE(_rmv_suc)->parent;                                              \
+                }                                                                                                      \
+                bst_remove((t), R_UNIQUE(_rmv_node));                                                                  \
+                if (R_UNIQUE(_rmv_color) == R_(rbt_black)) {                                                           \
+                    R_RBT_FIX_DELETE((t), R_UNIQUE(_rmv_x), R_UNIQUE(_rmv_xp));                                        \
                 }                                                                                                      \
-                R_UNIQUE(_fix_sib)->color = R_UNIQUE(_fix_pcolor);                                                     \
-                (node)->parent->color = R_(rbt_red);                                                                   \
-                /* Get new sibling after rotation (was child of old sibling) */                                        \
-                R_UNIQUE(_fix_sib) = R_UNIQUE(_fix_is_left) ? (node)->parent->right : (node)->parent->left;            \
             }                                                                                                          \
-                                                                                                                       \
-            if (R_UNIQUE(_fix_sib) != nullptr) {                                                                       \
-                const bool R_UNIQUE(_fix_sl_red) =                                                                     \
-                    R_UNIQUE(_fix_sib)->left != nullptr && R_UNIQUE(_fix_sib)->left->color == R_(rbt_red);             \
-                const bool R_UNIQUE(_fix_sr_red) =                                                                     \
-                    R_UNIQUE(_fix_sib)->right != nullptr && R_UNIQUE(_fix_sib)->right->color == R_(rbt_red);           \
-                                                                                                                       \
-                if (!R_UNIQUE(_fix_sl_red) && !R_UNIQUE(_fix_sr_red)) {                                                \
-                    /* CASE 2: Sibling BLACK, both children BLACK */                                                   \
-                    R_UNIQUE(_fix_sib)->color = R_(rbt_red);                                                           \
-                    (node)->color = R_(rbt_black);                                                                     \
-                    if ((node)->parent != nullptr && (node)->parent->color == R_(rbt_red)) {                           \
-                        /* Parent is RED - resolve immediately */                                                      \
-                        (node)->parent->color = R_(rbt_black);                                                         \
-                        (node) = nullptr; /* Exit loop - violation resolved */                                         \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_rmv_node);                                                                              \
+    })
+
+/**
+ * Free every node and reset the tree to empty.
+ *
+ * Individually allocated nodes are released in one post-order walk that follows the parent pointers, so no stack or
+ * recursion is needed. A tree whose nodes all come from rbt_build_sorted skips the walk and releases its node block
+ * with a single free.
+ */
+#define rbt_clear(t)                                                                                                   \
+    ({                                                                                                                 \
+        if ((t) != nullptr) {                                                                                          \
+            if ((t)->block_live != (t)->size) {                                                                        \
+                typeof_unqual((t)->root) R_UNIQUE(_clr_cur) = (t)->root;                                               \
+                while (R_UNIQUE(_clr_cur) != nullptr) {                                                                \
+                    if (R_UNIQUE(_clr_cur)->left != nullptr) {                                                         \
+                        R_UNIQUE(_clr_cur) = R_UNIQUE(_clr_cur)->left;                                                 \
+                    } else if (R_UNIQUE(_clr_cur)->right != nullptr) {                                                 \
+                        R_UNIQUE(_clr_cur) = R_UNIQUE(_clr_cur)->right;                                                \
                     } else {                                                                                           \
-                        /* Parent is BLACK - move violation up */                                                      \
-                        (node) = (node)->parent;                                                                       \
-                        if ((node) != nullptr) {                                                                       \
-                            (node)->color = R_(rbt_double_black);                                                      \
+                        /* Leaf: unlink from the parent, free it and climb back up */                                  \
+                        typeof_unqual((t)->root) R_UNIQUE(_clr_parent) = R_UNIQUE(_clr_cur)->parent;                   \
+                        if (R_UNIQUE(_clr_parent) != nullptr) {                                                        \
+                            if (R_UNIQUE(_clr_parent)->left == R_UNIQUE(_clr_cur)) {                                   \
+                                R_UNIQUE(_clr_parent)->left = nullptr;                                                 \
+                            } else {                                                                                   \
+                                R_UNIQUE(_clr_parent)->right = nullptr;                                                \
+                            }                                                                                          \
+                        }                                                                                              \
+                        if (!R_BST_IN_BLOCK((t), R_UNIQUE(_clr_cur))) {                                                \
+                            mem_free(R_UNIQUE(_clr_cur), (t)->node_size);                                              \
                         }                                                                                              \
+                        R_UNIQUE(_clr_cur) = R_UNIQUE(_clr_parent);                                                    \
                     }                                                                                                  \
-                } else if ((R_UNIQUE(_fix_is_left) && R_UNIQUE(_fix_sr_red)) ||                                        \
-                           (!R_UNIQUE(_fix_is_left) && R_UNIQUE(_fix_sl_red))) {                                       \
-                    /* CASE 4: Far child RED - final fix eliminates double-black */                                    \
-                    if (R_UNIQUE(_fix_is_left)) {                                                                      \
-                        const enum rbt_color R_UNIQUE(_fix_pcolor2) = (node)->parent->color;                           \
-                        R_RBT_ROTATE((t), R_UNIQUE(_fix_sib), R_(rbt_left));                                           \
-                        R_UNIQUE(_fix_sib)->color = R_UNIQUE(_fix_pcolor2);                                            \
-                        R_UNIQUE(_fix_sib)->left->color = R_(rbt_black);                                               \
-                        R_UNIQUE(_fix_sib)->right->color = R_(rbt_black);                                              \
+                }                                                                                                      \
+            }                                                                                                          \
+            if ((t)->block != nullptr) {                                                                               \
+                mem_free((t)->block, (t)->block_len * (t)->node_size);                                                 \
+            }                                                                                                          \
+            (t)->root = nullptr;                                                                                       \
+            (t)->size = 0;                                                                                             \
+            (t)->block = nullptr;                                                                                      \
+            (t)->block_len = 0;                                                                                        \
+            (t)->block_live = 0;                                                                                       \
+        }                                                                                                              \
+    })
+
+/* rbt_free: release all memory owned by the tree; the tree is left empty and reusable */
+#define rbt_free(t) rbt_clear(t)
+
+/**
+ * Replace the tree's contents with the n values of arr in O(n), without comparisons or rebalancing.
+ *
+ * arr must be sorted strictly ascending under the comparator later passed to the other operations. All nodes come
+ * from one contiguous block, laid out in key order, and the tree is built by repeatedly taking the midpoint of
+ * each range. Sibling subtrees then differ in size by at most one, so every level above depth floor(log2(n + 1)) is
+ * full: those nodes are colored black and the remaining (deepest) nodes red, which gives equal black height on every
+ * path and no red node with a red child. The tree stays fully mutable; removed block nodes are reclaimed when the
+ * block is released by rbt_clear/rbt_free.
+ *
+ * Returns true on success, false if the block could not be allocated (the tree is left empty).
+ */
+#define rbt_build_sorted(t, arr, n)                                                                                    \
+    ({                                                                                                                 \
+        bool R_UNIQUE(_bld_ok) = false;                                                                                \
+        if ((t) != nullptr) {                                                                                          \
+            rbt_clear((t));                                                                                            \
+            const size_t R_UNIQUE(_bld_n) = (n);                                                                       \
+            const typeof(&(arr)[0]) R_UNIQUE(_bld_arr) = (arr);                                                        \
+            typeof_unqual((t)->root) R_UNIQUE(_bld_block) =                                                            \
+                R_UNIQUE(_bld_n) > 0 ? mem_alloc(R_UNIQUE(_bld_n) * (t)->node_size) : nullptr;                         \
+            R_UNIQUE(_bld_ok) = R_UNIQUE(_bld_n) == 0 || R_UNIQUE(_bld_block) != nullptr;                              \
+            if (R_UNIQUE(_bld_block) != nullptr) {                                                                     \
+                /* Number of full levels: largest d with 2^d - 1 <= n */                                               \
+                size_t R_UNIQUE(_bld_full) = 0;                                                                        \
+                while ((((size_t)2 << R_UNIQUE(_bld_full)) - 1) <= R_UNIQUE(_bld_n)) {                                 \
+                    R_UNIQUE(_bld_full)++;                                                                             \
+                }                                                                                                      \
+                /* Pending ranges; pushing right before left keeps at most one entry per level */                      \
+                struct {                                                                                               \
+                    size_t lo;                                                                                         \
+                    size_t hi;                                                                                         \
+                    size_t depth;                                                                                      \
+                    typeof_unqual((t)->root) parent;                                                                   \
+                    bool left;                                                                                         \
+                } R_UNIQUE(_bld_stack)[2 * sizeof(size_t) * 8];                                                        \
+                size_t R_UNIQUE(_bld_sp) = 0;                                                                          \
+                R_UNIQUE(_bld_stack)[R_UNIQUE(_bld_sp)++] = (typeof(R_UNIQUE(_bld_stack)[0])){                         \
+                    .lo = 0, .hi = R_UNIQUE(_bld_n), .depth = 0, .parent = nullptr, .left = false};                    \
+                while (R_UNIQUE(_bld_sp) > 0) {                                                                        \
+                    R_UNIQUE(_bld_sp)--;                                                                               \
+                    const typeof(R_UNIQUE(_bld_stack)[0]) R_UNIQUE(_bld_r) =                                           \
+                        R_UNIQUE(_bld_stack)[R_UNIQUE(_bld_sp)];                                                       \
+                    const size_t R_UNIQUE(_bld_mid) =                                                                  \
+                        R_UNIQUE(_bld_r).lo + (R_UNIQUE(_bld_r).hi - R_UNIQUE(_bld_r).lo) / 2;                         \
+                    typeof_unqual((t)->root) R_UNIQUE(_bld_node) = R_UNIQUE(_bld_block) + R_UNIQUE(_bld_mid);          \
+                    R_UNIQUE(_bld_node)->data = R_UNIQUE(_bld_arr)[R_UNIQUE(_bld_mid)];                                \
+                    R_UNIQUE(_bld_node)->color =                                                                       \
+                        R_UNIQUE(_bld_r).depth < R_UNIQUE(_bld_full) ? R_(rbt_black) : R_(rbt_red);                    \
+                    R_UNIQUE(_bld_node)->parent = R_UNIQUE(_bld_r).parent;                                             \
+                    R_UNIQUE(_bld_node)->left = nullptr;                                                               \
+                    R_UNIQUE(_bld_node)->right = nullptr;                                                              \
+                    if (R_UNIQUE(_bld_r).parent == nullptr) {                                                          \
+                        (t)->root = R_UNIQUE(_bld_node);                                                               \
+                    } else if (R_UNIQUE(_bld_r).left) {                                                                \
+                        R_UNIQUE(_bld_r).parent->left = R_UNIQUE(_bld_node);                                           \
                     } else {                                                                                           \
-                        const enum rbt_color R_UNIQUE(_fix_pcolor2) = (node)->parent->color;                           \
-                        R_RBT_ROTATE((t), R_UNIQUE(_fix_sib), R_(rbt_right));                                          \
-                        R_UNIQUE(_fix_sib)->color = R_UNIQUE(_fix_pcolor2);                                            \
-                        R_UNIQUE(_fix_sib)->left->color = R_(rbt_black);                                               \
-                        R_UNIQUE(_fix_sib)->right->color = R_(rbt_black);                                              \
+                        R_UNIQUE(_bld_r).parent->right = R_UNIQUE(_bld_node);                                          \
                     }                                                                                                  \
-                    (node)->color = R_(rbt_black);                                                                     \
-                    (node) = nullptr; /* Exit loop - violation resolved */                                             \
-                } else {                                                                                               \
-                    /* CASE 3: Near child RED, far child BLACK - setup for case 4 */                                   \
-                    typeof_unqual(R_UNIQUE(_fix_sib)) R_UNIQUE(_fix_near) =                                            \
-                        R_UNIQUE(_fix_is_left) ? R_UNIQUE(_fix_sib)->left : R_UNIQUE(_fix_sib)->right;                 \
-                    if (R_UNIQUE(_fix_is_left)) {                                                                      \
-                        R_RBT_ROTATE((t), R_UNIQUE(_fix_near), R_(rbt_right));                                         \
-                    } else {                                                                                           \
-                        R_RBT_ROTATE((t), R_UNIQUE(_fix_near), R_(rbt_left));                                          \
+                    if (R_UNIQUE(_bld_mid) + 1 < R_UNIQUE(_bld_r).hi) {                                                \
+                        R_UNIQUE(_bld_stack)[R_UNIQUE(_bld_sp)++] = (typeof(R_UNIQUE(_bld_stack)[0])){                 \
+                            .lo = R_UNIQUE(_bld_mid) + 1,                                                              \
+                            .hi = R_UNIQUE(_bld_r).hi,                                                                 \
+                            .depth = R_UNIQUE(_bld_r).depth + 1,                                                       \
+                            .parent = R_UNIQUE(_bld_node),                                                             \
+                            .left = false};                                                                            \
+                    }                                                                                                  \
+                    if (R_UNIQUE(_bld_r).lo < R_UNIQUE(_bld_mid)) {                                                    \
+                        R_UNIQUE(_bld_stack)[R_UNIQUE(_bld_sp)++] = (typeof(R_UNIQUE(_bld_stack)[0])){                 \
+                            .lo = R_UNIQUE(_bld_r).lo,                                                                 \
+                            .hi = R_UNIQUE(_bld_mid),                                                                  \
+                            .depth = R_UNIQUE(_bld_r).depth + 1,                                                       \
+                            .parent = R_UNIQUE(_bld_node),                                                             \
+                            .left = true};                                                                             \
                     }                                                                                                  \
-                    /* After rotation, get new sibling */                                                              \
-                    R_UNIQUE(_fix_sib) = R_UNIQUE(_fix_is_left) ? (node)->parent->right : (node)->parent->left;        \
-                    R_UNIQUE(_fix_sib)->color = R_(rbt_black);                                                         \
-                    /* Old sibling is now a child of new sibling - color it red */                                     \
-                    typeof_unqual(R_UNIQUE(_fix_sib)) R_UNIQUE(_fix_old_sib) =                                         \
-                        R_UNIQUE(_fix_is_left) ? R_UNIQUE(_fix_sib)->right : R_UNIQUE(_fix_sib)->left;                 \
-                    R_UNIQUE(_fix_old_sib)->color = R_(rbt_red);                                                       \
-                    /* Loop continues, now in Case 4 */                                                                \
                 }                                                                                                      \
+                (t)->size = R_UNIQUE(_bld_n);                                                                          \
+                (t)->block = R_UNIQUE(_bld_block);                                                                     \
+                (t)->block_len = R_UNIQUE(_bld_n);                                                                     \
+                (t)->block_live = R_UNIQUE(_bld_n);                                                                    \
+            }                                                                                                          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_bld_ok);                                                                                \
+    })
+
+#endif // RUNE_RBT_API
+
+// =====================================================================================================================
+// B-Tree
+// =====================================================================================================================
+
+// API
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifndef RUNE_BTREE_API
+#define RUNE_BTREE_API
+
+#ifdef RCFG__BTREE_NODE_BYTES
+static constexpr size_t R_BTREE_NODE_BYTES = RCFG__BTREE_NODE_BYTES;
+#else  // Default leaf node footprint in bytes (header plus keys), four 64-byte cache lines
+static constexpr size_t R_BTREE_NODE_BYTES = 256;
+#endif // RCFG__BTREE_NODE_BYTES
+
+// In-node searches narrow by binary search down to this many keys, then count the rest branch-free
+static constexpr size_t R_BTREE_LINEAR = 16;
+
+#define BTREE(type) R_GLUE(btree_, type)
+#define BTREE_NODE(type) R_GLUE(btree_node_, type)
+
+/* Minimum degree d: nodes hold d - 1 to 2d - 1 keys; sized so a leaf fits in R_BTREE_NODE_BYTES */
+#define R_BTREE_DEGREE(type)                                                                                           \
+    ((R_BTREE_NODE_BYTES - 2 * sizeof(uint32_t)) / (2 * sizeof(type)) > 2                                              \
+         ? (R_BTREE_NODE_BYTES - 2 * sizeof(uint32_t)) / (2 * sizeof(type))                                            \
+         : 2)
+
+#define btree(type) {.root = nullptr, .size = 0}
+
+/* Keys per node and minimum degree of a tree */
+#define btree_node_cap(t) (sizeof((t)->root->keys) / sizeof((t)->root->keys[0]))
+#define R_BTREE_MIN(t) ((btree_node_cap(t) + 1) / 2)
+
+/* Leaves omit the child pointer array that trails every internal node */
+#define R_BTREE_NODE_SIZE(t, is_leaf)                                                                                  \
+    (sizeof(*(t)->root) + ((is_leaf) ? 0 : (btree_node_cap(t) + 1) * sizeof((t)->root->children[0])))
+
+#define R_BTREE_NEW_NODE(t, is_leaf)                                                                                   \
+    ({                                                                                                                 \
+        typeof_unqual((t)->root) R_UNIQUE(_new_node) = mem_alloc(R_BTREE_NODE_SIZE((t), (is_leaf)));                   \
+        R_UNIQUE(_new_node)->len = 0;                                                                                  \
+        R_UNIQUE(_new_node)->leaf = (is_leaf);                                                                         \
+        /* return */ R_UNIQUE(_new_node);                                                                              \
+    })
+
+/**
+ * Index of the first key in a node that is not less than key (the node's len if there is none).
+ * Binary search narrows the window to R_BTREE_LINEAR keys, then the remaining keys are counted with a loop that has
+ * no data-dependent branches, which compilers vectorize for the default comparator on arithmetic keys.
+ */
+#define R_BTREE_SEARCH(node, key, ...)                                                                                 \
+    ({                                                                                                                 \
+        size_t R_UNIQUE(_srch_lo) = 0;                                                                                 \
+        size_t R_UNIQUE(_srch_hi) = (node)->len;                                                                       \
+        while (R_UNIQUE(_srch_hi) - R_UNIQUE(_srch_lo) > R_BTREE_LINEAR) {                                             \
+            const size_t R_UNIQUE(_srch_mid) = R_UNIQUE(_srch_lo) + (R_UNIQUE(_srch_hi) - R_UNIQUE(_srch_lo)) / 2;     \
+            if (R_BST_CMP((node)->keys[R_UNIQUE(_srch_mid)], (key) __VA_OPT__(, ) __VA_ARGS__) < 0) {                  \
+                R_UNIQUE(_srch_lo) = R_UNIQUE(_srch_mid) + 1;                                                          \
             } else {                                                                                                   \
-                /* No sibling - make double-black single black */                                                      \
-                (node)->color = R_(rbt_black);                                                                         \
+                R_UNIQUE(_srch_hi) = R_UNIQUE(_srch_mid);                                                              \
             }                                                                                                          \
         }                                                                                                              \
-        /* If root is double-black, make it single black */                                                            \
-        if ((node) != nullptr && (node)->color == R_(rbt_double_black)) {                                              \
-            (node)->color = R_(rbt_black);                                                                             \
+        size_t R_UNIQUE(_srch_pos) = R_UNIQUE(_srch_lo);                                                               \
+        for (size_t R_UNIQUE(_srch_i) = R_UNIQUE(_srch_lo); R_UNIQUE(_srch_i) < R_UNIQUE(_srch_hi);                    \
+             R_UNIQUE(_srch_i)++) {                                                                                    \
+            R_UNIQUE(_srch_pos) += R_BST_CMP((node)->keys[R_UNIQUE(_srch_i)], (key) __VA_OPT__(, ) __VA_ARGS__) < 0;   \
         }                                                                                                              \
+        /* return */ R_UNIQUE(_srch_pos);                                                                              \
     })
 
-#define rbt_remove(t, val, ...)                                                                                          \
-    ({                                                                                                                   \
-        typeof_unqual((t)->root) R_UNIQUE(_rmv_node) = nullptr;                                                          \
-        if ((t) != nullptr) {                                                                                            \
-            R_UNIQUE(_rmv_node) = bst_find((t), (val), __VA_ARGS__);                                                     \
-            if (R_UNIQUE(_rmv_node) != nullptr) {                                                                        \
-                (t)->size--;                                                                                             \
-                const enum rbt_color R_UNIQUE(_rmv_node_color) = R_UNIQUE(_rmv_node)->color;                             \
-                typeof_unqual((t)->root) R_UNIQUE(_rmv_parent) = R_UNIQUE(_rmv_node)->parent;                            \
-                const bool R_UNIQUE(_rmv_is_left_child) =                                                                \
-                    R_UNIQUE(_rmv_parent) != nullptr && R_BST_LEFT(R_UNIQUE(_rmv_node));                                 \
-                /* For two-children case, save successor's right child (will replace successor) */                       \
-                typeof_unqual((t)->root) R_UNIQUE(_rmv_suc_right_child) = nullptr;                                       \
-                typeof_unqual((t)->root) R_UNIQUE(_rmv_suc_parent_saved) = nullptr;                                      \
-                bool R_UNIQUE(_rmv_suc_was_left_child) = false;                                                          \
-                typeof_unqual((t)->root) R_UNIQUE(_rmv_successor) = nullptr;                                             \
-                if (R_UNIQUE(_rmv_node)->left != nullptr && R_UNIQUE(_rmv_node)->right != nullptr) {                     \
-                    R_UNIQUE(_rmv_successor) = bst_min(R_UNIQUE(_rmv_node)->right);                                      \
-                    R_UNIQUE(_rmv_suc_right_child) = R_UNIQUE(_rmv_successor)->right;                                    \
-                    R_UNIQUE(_rmv_suc_parent_saved) = R_UNIQUE(_rmv_successor)->parent;                                  \
-                    R_UNIQUE(_rmv_suc_was_left_child) =                                                                  \
-                        R_UNIQUE(_rmv_successor)->parent != nullptr && R_BST_LEFT(R_UNIQUE(_rmv_successor));             \
-                }                                                                                                        \
-                const enum rbt_color R_UNIQUE(_rmv_suc_color) =                                                          \
-                    (R_UNIQUE(_rmv_node)->left == nullptr && R_UNIQUE(_rmv_node)->right == nullptr)                      \
-                        ? R_(rbt_black)                                                                                  \
-                        : (R_UNIQUE(_rmv_node)->left == nullptr                                                          \
-                               ? R_UNIQUE(_rmv_node)->right->color                                                       \
-                               : (R_UNIQUE(_rmv_node)->right == nullptr ? R_UNIQUE(_rmv_node)->left->color               \
-                                                                        : R_UNIQUE(_rmv_successor)->color));             \
-                typeof_unqual((t)->root) R_UNIQUE(_rmv_node_suc) = bst_remove((t), (R_UNIQUE(_rmv_node)));               \
-                /* Only fix if both deleted node and replacement were black */                                           \
-                if (R_UNIQUE(_rmv_node_color) == R_(rbt_black) && R_UNIQUE(_rmv_suc_color) == R_(rbt_black) &&           \
-                    R_UNIQUE(_rmv_node_suc) != nullptr) {                                                                \
-                    if (R_UNIQUE(_rmv_suc_right_child) != nullptr || R_UNIQUE(_rmv_suc_parent_saved) != nullptr) {       \
-                        /* Two-children case: fix at successor's old position */                                         \
-                        const enum rbt_color R_UNIQUE(_rmv_rc_color) = R_UNIQUE(_rmv_suc_right_child) != nullptr         \
-                                                                           ? R_UNIQUE(_rmv_suc_right_child)->color       \
-                                                                           : R_(rbt_black);                              \
-                        if (R_UNIQUE(_rmv_rc_color) == R_(rbt_red)) {                                                    \
-                            /* Right child was red - just color it black */                                              \
-                            R_UNIQUE(_rmv_suc_right_child)->color = R_(rbt_black);                                       \
-                        } else if (R_UNIQUE(_rmv_suc_right_child) != nullptr) {                                          \
-                            /* Right child exists and is black - double black */                                         \
-                            R_UNIQUE(_rmv_suc_right_child)->color = R_(rbt_double_black);                                \
-                            R_RBT_FIX_DELETE((t), R_UNIQUE(_rmv_suc_right_child));                                       \
-                        } else {                                                                                         \
-                            /* No right child (nullptr) - black leaf removed, fix needed */                              \
-                            if (R_UNIQUE(_rmv_suc_parent_saved) == R_UNIQUE(_rmv_node)) {                                \
-                                /* Successor was direct right child - fix from successor's new position */               \
-                                /* The double-black is at R_UNIQUE(_rmv_node_suc)'s right (null) */                      \
-                                const bool R_UNIQUE(_rmv_db_is_right) =                                                  \
-                                    true; /* Always right for direct right child successor */                            \
-                                typeof_unqual(R_UNIQUE(_rmv_node_suc)) R_UNIQUE(_rmv_sib_direct) =                       \
-                                    R_UNIQUE(_rmv_node_suc)->left; /* Sibling is on the left */                          \
-                                if (R_UNIQUE(_rmv_sib_direct) != nullptr &&                                              \
-                                    R_UNIQUE(_rmv_sib_direct)->color == R_(rbt_red)) {                                   \
-                                    R_RBT_ROTATE((t), R_UNIQUE(_rmv_sib_direct), R_(rbt_right));                         \
-                                    R_UNIQUE(_rmv_sib_direct)->color = R_(rbt_black);                                    \
-                                    R_UNIQUE(_rmv_node_suc)->color = R_(rbt_red);                                        \
-                                    R_UNIQUE(_rmv_sib_direct) = R_UNIQUE(_rmv_node_suc)->left;                           \
-                                }                                                                                        \
-                                if (R_UNIQUE(_rmv_sib_direct) != nullptr) {                                              \
-                                    const bool R_UNIQUE(_rmv_sl_r_direct) =                                              \
-                                        R_UNIQUE(_rmv_sib_direct)->left != nullptr &&                                    \
-                                        R_UNIQUE(_rmv_sib_direct)->left->color == R_(rbt_red);                           \
-                                    const bool R_UNIQUE(_rmv_sr_r_direct) =                                              \
-                                        R_UNIQUE(_rmv_sib_direct)->right != nullptr &&                                   \
-                                        R_UNIQUE(_rmv_sib_direct)->right->color == R_(rbt_red);                          \
-                                    if (!R_UNIQUE(_rmv_sl_r_direct) && !R_UNIQUE(_rmv_sr_r_direct) &&                    \
-                                        R_UNIQUE(_rmv_node_suc)->color == R_(rbt_red)) {                                 \
-                                        R_UNIQUE(_rmv_node_suc)->color = R_(rbt_black);                                  \
-                                        R_UNIQUE(_rmv_sib_direct)->color = R_(rbt_red);                                  \
-                                    } else if (!R_UNIQUE(_rmv_sl_r_direct) && !R_UNIQUE(_rmv_sr_r_direct) &&             \
-                                               R_UNIQUE(_rmv_node_suc)->color == R_(rbt_black)) {                        \
-                                        R_UNIQUE(_rmv_sib_direct)->color = R_(rbt_red);                                  \
-                                        R_UNIQUE(_rmv_node_suc)->color = R_(rbt_double_black);                           \
-                                        R_RBT_FIX_DELETE((t), R_UNIQUE(_rmv_node_suc));                                  \
-                                    } else if ((!R_UNIQUE(_rmv_db_is_right) && R_UNIQUE(_rmv_sr_r_direct)) ||            \
-                                               (R_UNIQUE(_rmv_db_is_right) && R_UNIQUE(_rmv_sl_r_direct))) {             \
-                                        const enum rbt_color R_UNIQUE(_rmv_pc_direct) = R_UNIQUE(_rmv_node_suc)->color;  \
-                                        R_RBT_ROTATE(                                                                    \
-                                            (t),                                                                         \
-                                            R_UNIQUE(_rmv_sib_direct),                                                   \
-                                            R_UNIQUE(_rmv_db_is_right) ? R_(rbt_right) : R_(rbt_left)                    \
-                                        );                                                                               \
-                                        R_UNIQUE(_rmv_sib_direct)->color = R_UNIQUE(_rmv_pc_direct);                     \
-                                        if (R_UNIQUE(_rmv_db_is_right)) {                                                \
-                                            R_UNIQUE(_rmv_sib_direct)->right->color = R_(rbt_black);                     \
-                                            if (R_UNIQUE(_rmv_sib_direct)->left != nullptr)                              \
-                                                R_UNIQUE(_rmv_sib_direct)->left->color = R_(rbt_black);                  \
-                                        } else {                                                                         \
-                                            R_UNIQUE(_rmv_sib_direct)->left->color = R_(rbt_black);                      \
-                                            if (R_UNIQUE(_rmv_sib_direct)->right != nullptr)                             \
-                                                R_UNIQUE(_rmv_sib_direct)->right->color = R_(rbt_black);                 \
-                                        }                                                                                \
-                                    } else {                                                                             \
-                                        typeof_unqual(R_UNIQUE(_rmv_sib_direct)) R_UNIQUE(_rmv_nr_direct) =              \
-                                            R_UNIQUE(_rmv_db_is_right) ? R_UNIQUE(_rmv_sib_direct)->right                \
-                                                                       : R_UNIQUE(_rmv_sib_direct)->left;                \
-                                        const enum rbt_color R_UNIQUE(_rmv_pc2_direct) =                                 \
-                                            R_UNIQUE(_rmv_node_suc)->color;                                              \
-                                        R_RBT_ROTATE(                                                                    \
-                                            (t),                                                                         \
-                                            R_UNIQUE(_rmv_nr_direct),                                                    \
-                                            R_UNIQUE(_rmv_db_is_right) ? R_(rbt_left) : R_(rbt_right)                    \
-                                        );                                                                               \
-                                        R_UNIQUE(_rmv_nr_direct)->color = R_(rbt_black);                                 \
-                                        R_UNIQUE(_rmv_nr_direct)->parent->color = R_(rbt_red);                           \
-                                        R_UNIQUE(_rmv_sib_direct) = R_UNIQUE(_rmv_db_is_right)                           \
-                                                                        ? R_UNIQUE(_rmv_node_suc)->left                  \
-                                                                        : R_UNIQUE(_rmv_node_suc)->right;                \
-                                        R_RBT_ROTATE(                                                                    \
-                                            (t),                                                                         \
-                                            R_UNIQUE(_rmv_sib_direct),                                                   \
-                                            R_UNIQUE(_rmv_db_is_right) ? R_(rbt_right) : R_(rbt_left)                    \
-                                        );                                                                               \
-                                        R_UNIQUE(_rmv_sib_direct)->color = R_UNIQUE(_rmv_pc2_direct);                    \
-                                        R_UNIQUE(_rmv_sib_direct)->left->color = R_(rbt_black);                          \
-                                        R_UNIQUE(_rmv_sib_direct)->right->color = R_(rbt_black);                         \
-                                    }                                                                                    \
-                                }                                                                                        \
-                            } else {                                                                                     \
-                                /* Successor was deeper - fix from saved R_UNIQUE(_rmv_parent) position */               \
-                                const bool R_UNIQUE(_rmv_suc_was_left) = R_UNIQUE(_rmv_suc_was_left_child);              \
-                                typeof_unqual(R_UNIQUE(_rmv_suc_parent_saved)) R_UNIQUE(_rmv_sib_suc) =                  \
-                                    R_UNIQUE(_rmv_suc_was_left) ? R_UNIQUE(_rmv_suc_parent_saved)->right                 \
-                                                                : R_UNIQUE(_rmv_suc_parent_saved)->left;                 \
-                                /* Apply same black leaf deletion logic */                                               \
-                                if (R_UNIQUE(_rmv_sib_suc) != nullptr && R_UNIQUE(_rmv_sib_suc)->color == R_(rbt_red)) { \
-                                    R_RBT_ROTATE(                                                                        \
-                                        (t),                                                                             \
-                                        R_UNIQUE(_rmv_sib_suc),                                                          \
-                                        R_UNIQUE(_rmv_suc_was_left) ? R_(rbt_left) : R_(rbt_right)                       \
-                                    );                                                                                   \
-                                    R_UNIQUE(_rmv_sib_suc)->color = R_(rbt_black);                                       \
-                                    R_UNIQUE(_rmv_suc_parent_saved)->color = R_(rbt_red);                                \
-                                    R_UNIQUE(_rmv_sib_suc) = R_UNIQUE(_rmv_suc_was_left)                                 \
-                                                                 ? R_UNIQUE(_rmv_suc_parent_saved)->right                \
-                                                                 : R_UNIQUE(_rmv_suc_parent_saved)->left;                \
-                                }                                                                                        \
-                                if (R_UNIQUE(_rmv_sib_suc) != nullptr) {                                                 \
-                                    const bool R_UNIQUE(_rmv_sl_r_suc) =                                                 \
-                                        R_UNIQUE(_rmv_sib_suc)->left != nullptr &&                                       \
-                                        R_UNIQUE(_rmv_sib_suc)->left->color == R_(rbt_red);                              \
-                                    const bool R_UNIQUE(_rmv_sr_r_suc) =                                                 \
-                                        R_UNIQUE(_rmv_sib_suc)->right != nullptr &&                                      \
-                                        R_UNIQUE(_rmv_sib_suc)->right->color == R_(rbt_red);                             \
-                                    if (!R_UNIQUE(_rmv_sl_r_suc) && !R_UNIQUE(_rmv_sr_r_suc) &&                          \
-                                        R_UNIQUE(_rmv_suc_parent_saved)->color == R_(rbt_red)) {                         \
-                                        R_UNIQUE(_rmv_suc_parent_saved)->color = R_(rbt_black);                          \
-                                        R_UNIQUE(_rmv_sib_suc)->color = R_(rbt_red);                                     \
-                                    } else if (!R_UNIQUE(_rmv_sl_r_suc) && !R_UNIQUE(_rmv_sr_r_suc) &&                   \
-                                               R_UNIQUE(_rmv_suc_parent_saved)->color == R_(rbt_black)) {                \
-                                        R_UNIQUE(_rmv_sib_suc)->color = R_(rbt_red);                                     \
-                                        R_UNIQUE(_rmv_suc_parent_saved)->color = R_(rbt_double_black);                   \
-                                        R_RBT_FIX_DELETE((t), R_UNIQUE(_rmv_suc_parent_saved));                          \
-                                    } else if ((R_UNIQUE(_rmv_suc_was_left) && R_UNIQUE(_rmv_sr_r_suc)) ||               \
-                                               (!R_UNIQUE(_rmv_suc_was_left) && R_UNIQUE(_rmv_sl_r_suc))) {              \
-                                        const enum rbt_color R_UNIQUE(_rmv_pc_suc) =                                     \
-                                            R_UNIQUE(_rmv_suc_parent_saved)->color;                                      \
-                                        R_RBT_ROTATE(                                                                    \
-                                            (t),                                                                         \
-                                            R_UNIQUE(_rmv_sib_suc),                                                      \
-                                            R_UNIQUE(_rmv_suc_was_left) ? R_(rbt_left) : R_(rbt_right)                   \
-                                        );                                                                               \
-                                        R_UNIQUE(_rmv_sib_suc)->color = R_UNIQUE(_rmv_pc_suc);                           \
-                                        if (R_UNIQUE(_rmv_suc_was_left)) {                                               \
-                                            R_UNIQUE(_rmv_sib_suc)->left->color = R_(rbt_black);                         \
-                                            if (R_UNIQUE(_rmv_sib_suc)->right != nullptr)                                \
-                                                R_UNIQUE(_rmv_sib_suc)->right->color = R_(rbt_black);                    \
-                                        } else {                                                                         \
-                                            R_UNIQUE(_rmv_sib_suc)->right->color = R_(rbt_black);                        \
-                                            if (R_UNIQUE(_rmv_sib_suc)->left != nullptr)                                 \
-                                                R_UNIQUE(_rmv_sib_suc)->left->color = R_(rbt_black);                     \
-                                        }                                                                                \
-                                    } else {                                                                             \
-                                        typeof_unqual(R_UNIQUE(_rmv_sib_suc)) R_UNIQUE(_rmv_nr_suc) =                    \
-                                            R_UNIQUE(_rmv_suc_was_left) ? R_UNIQUE(_rmv_sib_suc)->left                   \
-                                                                        : R_UNIQUE(_rmv_sib_suc)->right;                 \
-                                        const enum rbt_color R_UNIQUE(_rmv_pc2_suc) =                                    \
-                                            R_UNIQUE(_rmv_suc_parent_saved)->color;                                      \
-                                        R_RBT_ROTATE(                                                                    \
-                                            (t),                                                                         \
-                                            R_UNIQUE(_rmv_nr_suc),                                                       \
-                                            R_UNIQUE(_rmv_suc_was_left) ? R_(rbt_right) : R_(rbt_left)                   \
-                                        );                                                                               \
-                                        R_UNIQUE(_rmv_nr_suc)->color = R_(rbt_black);                                    \
-                                        R_UNIQUE(_rmv_nr_suc)->parent->color = R_(rbt_red);                              \
-                                        R_UNIQUE(_rmv_sib_suc) = R_UNIQUE(_rmv_suc_was_left)                             \
-                                                                     ? R_UNIQUE(_rmv_suc_parent_saved)->right            \
-                                                                     : R_UNIQUE(_rmv_suc_parent_saved)->left;            \
-                                        R_RBT_ROTATE(                                                                    \
-                                            (t),                                                                         \
-                                            R_UNIQUE(_rmv_sib_suc),                                                      \
-                                            R_UNIQUE(_rmv_suc_was_left) ? R_(rbt_left) : R_(rbt_right)                   \
-                                        );                                                                               \
-                                        R_UNIQUE(_rmv_sib_suc)->color = R_UNIQUE(_rmv_pc2_suc);                          \
-                                        R_UNIQUE(_rmv_sib_suc)->left->color = R_(rbt_black);                             \
-                                        R_UNIQUE(_rmv_sib_suc)->right->color = R_(rbt_black);                            \
-                                    }                                                                                    \
-                                }                                                                                        \
-                            }                                                                                            \
-                        }                                                                                                \
-                    } else {                                                                                             \
-                        /* One-child case: fix at replacement position */                                                \
-                        R_UNIQUE(_rmv_node_suc)->color = R_(rbt_double_black);                                           \
-                        R_RBT_FIX_DELETE((t), R_UNIQUE(_rmv_node_suc));                                                  \
-                    }                                                                                                    \
-                } else if (R_UNIQUE(_rmv_node_color) == R_(rbt_black) && R_UNIQUE(_rmv_node_suc) != nullptr &&           \
-                           R_UNIQUE(_rmv_suc_parent_saved) == nullptr && R_UNIQUE(_rmv_suc_color) == R_(rbt_red)) {      \
-                    /* One-child case: replacement was red - just color it black */                                      \
-                    R_UNIQUE(_rmv_node_suc)->color = R_(rbt_black);                                                      \
-                } else if (R_UNIQUE(_rmv_node_color) == R_(rbt_black) && R_UNIQUE(_rmv_node_suc) == nullptr &&           \
-                           R_UNIQUE(_rmv_parent) != nullptr) {                                                           \
-                    /* Black leaf deletion: apply fix from R_UNIQUE(_rmv_parent)'s perspective */                        \
-                    /* The R_UNIQUE(_rmv_sibling) is R_UNIQUE(_rmv_parent)'s other child */                              \
-                    const bool R_UNIQUE(_rmv_del_was_left) = R_UNIQUE(_rmv_is_left_child);                               \
-                    typeof_unqual(R_UNIQUE(_rmv_parent)) R_UNIQUE(_rmv_sibling) =                                        \
-                        R_UNIQUE(_rmv_del_was_left) ? R_UNIQUE(_rmv_parent)->right : R_UNIQUE(_rmv_parent)->left;        \
-                    if (R_UNIQUE(_rmv_sibling) != nullptr && R_UNIQUE(_rmv_sibling)->color == R_(rbt_red)) {             \
-                        /* Parent must be black, R_UNIQUE(_rmv_sibling) is red: rotate and continue */                   \
-                        R_RBT_ROTATE(                                                                                    \
-                            (t),                                                                                         \
-                            R_UNIQUE(_rmv_sibling),                                                                      \
-                            R_UNIQUE(_rmv_del_was_left) ? R_(rbt_left) : R_(rbt_right)                                   \
-                        );                                                                                               \
-                        R_UNIQUE(_rmv_sibling)->color = R_(rbt_black);                                                   \
-                        R_UNIQUE(_rmv_parent)->color = R_(rbt_red);                                                      \
-                        R_UNIQUE(_rmv_sibling) =                                                                         \
-                            R_UNIQUE(_rmv_del_was_left) ? R_UNIQUE(_rmv_parent)->right : R_UNIQUE(_rmv_parent)->left;    \
-                    }                                                                                                    \
-                    if (R_UNIQUE(_rmv_sibling) != nullptr) {                                                             \
-                        const bool R_UNIQUE(_rmv_sl_red) = R_UNIQUE(_rmv_sibling)->left != nullptr &&                    \
-                                                           R_UNIQUE(_rmv_sibling)->left->color == R_(rbt_red);           \
-                        const bool R_UNIQUE(_rmv_sr_red) = R_UNIQUE(_rmv_sibling)->right != nullptr &&                   \
-                                                           R_UNIQUE(_rmv_sibling)->right->color == R_(rbt_red);          \
-                        if (!R_UNIQUE(_rmv_sl_red) && !R_UNIQUE(_rmv_sr_red) &&                                          \
-                            R_UNIQUE(_rmv_parent)->color == R_(rbt_red)) {                                               \
-                            /* Parent red, R_UNIQUE(_rmv_sibling) black with black children: recolor */                  \
-                            R_UNIQUE(_rmv_parent)->color = R_(rbt_black);                                                \
-                            R_UNIQUE(_rmv_sibling)->color = R_(rbt_red);                                                 \
-                        } else if (!R_UNIQUE(_rmv_sl_red) && !R_UNIQUE(_rmv_sr_red) &&                                   \
-                                   R_UNIQUE(_rmv_parent)->color == R_(rbt_black)) {                                      \
-                            /* Parent black, R_UNIQUE(_rmv_sibling) black with black children: make                      \
-                             * R_UNIQUE(_rmv_sibling) red, R_UNIQUE(_rmv_parent) DB */                                   \
-                            R_UNIQUE(_rmv_sibling)->color = R_(rbt_red);                                                 \
-                            R_UNIQUE(_rmv_parent)->color = R_(rbt_double_black);                                         \
-                            R_RBT_FIX_DELETE((t), R_UNIQUE(_rmv_parent));                                                \
-                        } else {                                                                                         \
-                            /* Sibling has at least one red child: rotate and recolor */                                 \
-                            if ((R_UNIQUE(_rmv_del_was_left) && R_UNIQUE(_rmv_sr_red)) ||                                \
-                                (!R_UNIQUE(_rmv_del_was_left) && R_UNIQUE(_rmv_sl_red))) {                               \
-                                /* Far child is red: final rotation */                                                   \
-                                const enum rbt_color R_UNIQUE(_rmv_pc_leaf) = R_UNIQUE(_rmv_parent)->color;              \
-                                if (R_UNIQUE(_rmv_del_was_left)) {                                                       \
-                                    R_RBT_ROTATE((t), R_UNIQUE(_rmv_sibling), R_(rbt_left));                             \
-                                    R_UNIQUE(_rmv_sibling)->color = R_UNIQUE(_rmv_pc_leaf);                              \
-                                    R_UNIQUE(_rmv_sibling)->left->color = R_(rbt_black);                                 \
-                                    if (R_UNIQUE(_rmv_sibling)->right != nullptr)                                        \
-                                        R_UNIQUE(_rmv_sibling)->right->color = R_(rbt_black);                            \
-                                } else {                                                                                 \
-                                    R_RBT_ROTATE((t), R_UNIQUE(_rmv_sibling), R_(rbt_right));                            \
-                                    R_UNIQUE(_rmv_sibling)->color = R_UNIQUE(_rmv_pc_leaf);                              \
-                                    R_UNIQUE(_rmv_sibling)->right->color = R_(rbt_black);                                \
-                                    if (R_UNIQUE(_rmv_sibling)->left != nullptr)                                         \
-                                        R_UNIQUE(_rmv_sibling)->left->color = R_(rbt_black);                             \
-                                }                                                                                        \
-                            } else {                                                                                     \
-                                /* Near child is red: rotate to make it far, then rotate again */                        \
-                                typeof_unqual(R_UNIQUE(_rmv_sibling)) R_UNIQUE(_rmv_near) =                              \
-                                    R_UNIQUE(_rmv_del_was_left) ? R_UNIQUE(_rmv_sibling)->left                           \
-                                                                : R_UNIQUE(_rmv_sibling)->right;                         \
-                                const enum rbt_color R_UNIQUE(_rmv_parent_color) = R_UNIQUE(_rmv_parent)->color;         \
-                                if (R_UNIQUE(_rmv_del_was_left)) {                                                       \
-                                    R_RBT_ROTATE((t), R_UNIQUE(_rmv_near), R_(rbt_right));                               \
-                                    R_UNIQUE(_rmv_near)->color = R_(rbt_black);                                          \
-                                    R_UNIQUE(_rmv_near)->parent->color = R_(rbt_red);                                    \
-                                    R_UNIQUE(_rmv_sibling) = R_UNIQUE(_rmv_parent)->right;                               \
-                                    R_RBT_ROTATE((t), R_UNIQUE(_rmv_sibling), R_(rbt_left));                             \
-                                    R_UNIQUE(_rmv_sibling)->color = R_UNIQUE(_rmv_parent_color);                         \
-                                    R_UNIQUE(_rmv_sibling)->left->color = R_(rbt_black);                                 \
-                                    R_UNIQUE(_rmv_sibling)->right->color = R_(rbt_black);                                \
-                                } else {                                                                                 \
-                                    R_RBT_ROTATE((t), R_UNIQUE(_rmv_near), R_(rbt_left));                                \
-                                    R_UNIQUE(_rmv_near)->color = R_(rbt_black);                                          \
-                                    R_UNIQUE(_rmv_near)->parent->color = R_(rbt_red);                                    \
-                                    R_UNIQUE(_rmv_sibling) = R_UNIQUE(_rmv_parent)->left;                                \
-                                    R_RBT_ROTATE((t), R_UNIQUE(_rmv_sibling), R_(rbt_right));                            \
-                                    R_UNIQUE(_rmv_sibling)->color = R_UNIQUE(_rmv_parent_color);                         \
-                                    R_UNIQUE(_rmv_sibling)->right->color = R_(rbt_black);                                \
-                                    R_UNIQUE(_rmv_sibling)->left->color = R_(rbt_black);                                 \
-                                }                                                                                        \
-                            }                                                                                            \
-                        }                                                                                                \
-                    }                                                                                                    \
-                }                                                                                                        \
-            }                                                                                                            \
-        }                                                                                                                \
-        /* return */ R_UNIQUE(_rmv_node);                                                                                \
+/**
+ * Split the full child at index i of a non-full parent: the upper d - 1 keys move to a new right sibling and the
+ * median key moves up into the parent.
+ */
+#define R_BTREE_SPLIT(t, parent, i)                                                                                    \
+    ({                                                                                                                 \
+        const size_t R_UNIQUE(_spl_d) = R_BTREE_MIN((t));                                                              \
+        typeof_unqual((t)->root) R_UNIQUE(_spl_left) = (parent)->children[(i)];                                        \
+        typeof_unqual((t)->root) R_UNIQUE(_spl_right) = R_BTREE_NEW_NODE((t), R_UNIQUE(_spl_left)->leaf);              \
+        R_UNIQUE(_spl_right)->len = (uint32_t)(R_UNIQUE(_spl_d) - 1);                                                  \
+        memcpy(                                                                                                        \
+            R_UNIQUE(_spl_right)->keys,                                                                                \
+            R_UNIQUE(_spl_left)->keys + R_UNIQUE(_spl_d),                                                              \
+            (R_UNIQUE(_spl_d) - 1) * sizeof((t)->root->keys[0])                                                        \
+        );                                                                                                             \
+        if (!R_UNIQUE(_spl_left)->leaf) {                                                                              \
+            memcpy(                                                                                                    \
+                R_UNIQUE(_spl_right)->children,                                                                        \
+                R_UNIQUE(_spl_left)->children + R_UNIQUE(_spl_d),                                                      \
+                R_UNIQUE(_spl_d) * sizeof((t)->root->children[0])                                                      \
+            );                                                                                                         \
+        }                                                                                                              \
+        R_UNIQUE(_spl_left)->len = (uint32_t)(R_UNIQUE(_spl_d) - 1);                                                   \
+        memmove(                                                                                                       \
+            (parent)->children + (i) + 2,                                                                              \
+            (parent)->children + (i) + 1,                                                                              \
+            ((parent)->len - (i)) * sizeof((t)->root->children[0])                                                     \
+        );                                                                                                             \
+        (parent)->children[(i) + 1] = R_UNIQUE(_spl_right);                                                            \
+        memmove((parent)->keys + (i) + 1, (parent)->keys + (i), ((parent)->len - (i)) * sizeof((t)->root->keys[0]));   \
+        (parent)->keys[(i)] = R_UNIQUE(_spl_left)->keys[R_UNIQUE(_spl_d) - 1];                                         \
+        (parent)->len++;                                                                                               \
     })
 
-#endif // RUNE_RBT_API
+/**
+ * Merge child i + 1 into child i, pulling the separating key down from the parent, and free the right child.
+ */
+#define R_BTREE_MERGE(t, parent, i)                                                                                    \
+    ({                                                                                                                 \
+        typeof_unqual((t)->root) R_UNIQUE(_mrg_left) = (parent)->children[(i)];                                        \
+        typeof_unqual((t)->root) R_UNIQUE(_mrg_right) = (parent)->children[(i) + 1];                                   \
+        R_UNIQUE(_mrg_left)->keys[R_UNIQUE(_mrg_left)->len] = (parent)->keys[(i)];                                     \
+        memcpy(                                                                                                        \
+            R_UNIQUE(_mrg_left)->keys + R_UNIQUE(_mrg_left)->len + 1,                                                  \
+            R_UNIQUE(_mrg_right)->keys,                                                                                \
+            R_UNIQUE(_mrg_right)->len * sizeof((t)->root->keys[0])                                                     \
+        );                                                                                                             \
+        if (!R_UNIQUE(_mrg_left)->leaf) {                                                                              \
+            memcpy(                                                                                                    \
+                R_UNIQUE(_mrg_left)->children + R_UNIQUE(_mrg_left)->len + 1,                                          \
+                R_UNIQUE(_mrg_right)->children,                                                                        \
+                (R_UNIQUE(_mrg_right)->len + 1) * sizeof((t)->root->children[0])                                       \
+            );                                                                                                         \
+        }                                                                                                              \
+        R_UNIQUE(_mrg_left)->len += R_UNIQUE(_mrg_right)->len + 1;                                                     \
+        memmove(                                                                                                       \
+            (parent)->keys + (i), (parent)->keys + (i) + 1, ((parent)->len - (i) - 1) * sizeof((t)->root->keys[0])     \
+        );                                                                                                             \
+        memmove(                                                                                                       \
+            (parent)->children + (i) + 1,                                                                              \
+            (parent)->children + (i) + 2,                                                                              \
+            ((parent)->len - (i) - 1) * sizeof((t)->root->children[0])                                                 \
+        );                                                                                                             \
+        (parent)->len--;                                                                                               \
+        mem_free(R_UNIQUE(_mrg_right), R_BTREE_NODE_SIZE((t), R_UNIQUE(_mrg_right)->leaf));                            \
+    })
+
+/**
+ * Give child i of parent at least d keys before the removal descends into it: rotate a key through the parent from
+ * a sibling that can spare one, otherwise merge with a sibling. Returns the index of the child to descend into.
+ */
+#define R_BTREE_FILL(t, parent, i)                                                                                     \
+    ({                                                                                                                 \
+        size_t R_UNIQUE(_fil_i) = (i);                                                                                 \
+        typeof_unqual((t)->root) R_UNIQUE(_fil_child) = (parent)->children[R_UNIQUE(_fil_i)];                          \
+        typeof_unqual((t)->root) R_UNIQUE(_fil_prev) =                                                                 \
+            R_UNIQUE(_fil_i) > 0 ? (parent)->children[R_UNIQUE(_fil_i) - 1] : nullptr;                                 \
+        typeof_unqual((t)->root) R_UNIQUE(_fil_next) =                                                                 \
+            R_UNIQUE(_fil_i) < (parent)->len ? (parent)->children[R_UNIQUE(_fil_i) + 1] : nullptr;                     \
+        if (R_UNIQUE(_fil_prev) != nullptr && R_UNIQUE(_fil_prev)->len >= R_BTREE_MIN((t))) {                          \
+            /* Borrow from the left sibling through the separator */                                                   \
+            memmove(                                                                                                   \
+                R_UNIQUE(_fil_child)->keys + 1,                                                                        \
+                R_UNIQUE(_fil_child)->keys,                                                                            \
+                R_UNIQUE(_fil_child)->len * sizeof((t)->root->keys[0])                                                 \
+            );                                                                                                         \
+            R_UNIQUE(_fil_child)->keys[0] = (parent)->keys[R_UNIQUE(_fil_i) - 1];                                      \
+            if (!R_UNIQUE(_fil_child)->leaf) {                                                                         \
+                memmove(                                                                                               \
+                    R_UNIQUE(_fil_child)->children + 1,                                                                \
+                    R_UNIQUE(_fil_child)->children,                                                                    \
+                    (R_UNIQUE(_fil_child)->len + 1) * sizeof((t)->root->children[0])                                   \
+                );                                                                                                     \
+                R_UNIQUE(_fil_child)->children[0] = R_UNIQUE(_fil_prev)->children[R_UNIQUE(_fil_prev)->len];           \
+            }                                                                                                          \
+            (parent)->keys[R_UNIQUE(_fil_i) - 1] = R_UNIQUE(_fil_prev)->keys[R_UNIQUE(_fil_prev)->len - 1];            \
+            R_UNIQUE(_fil_prev)->len--;                                                                                \
+            R_UNIQUE(_fil_child)->len++;                                                                               \
+        } else if (R_UNIQUE(_fil_next) != nullptr && R_UNIQUE(_fil_next)->len >= R_BTREE_MIN((t))) {                   \
+            /* Borrow from the right sibling through the separator */                                                  \
+            R_UNIQUE(_fil_child)->keys[R_UNIQUE(_fil_child)->len] = (parent)->keys[R_UNIQUE(_fil_i)];                  \
+            if (!R_UNIQUE(_fil_child)->leaf) {                                                                         \
+                R_UNIQUE(_fil_child)->children[R_UNIQUE(_fil_child)->len + 1] = R_UNIQUE(_fil_next)->children[0];      \
+                memmove(                                                                                               \
+                    R_UNIQUE(_fil_next)->children,                                                                     \
+                    R_UNIQUE(_fil_next)->children + 1,                                                                 \
+                    R_UNIQUE(_fil_next)->len * sizeof((t)->root->children[0])                                          \
+                );                                                                                                     \
+            }                                                                                                          \
+            (parent)->keys[R_UNIQUE(_fil_i)] = R_UNIQUE(_fil_next)->keys[0];                                           \
+            memmove(                                                                                                   \
+                R_UNIQUE(_fil_next)->keys,                                                                             \
+                R_UNIQUE(_fil_next)->keys + 1,                                                                         \
+                (R_UNIQUE(_fil_next)->len - 1) * sizeof((t)->root->keys[0])                                            \
+            );                                                                                                         \
+            R_UNIQUE(_fil_next)->len--;                                                                                \
+            R_UNIQUE(_fil_child)->len++;                                                                               \
+        } else if (R_UNIQUE(_fil_next) != nullptr) {                                                                   \
+            R_BTREE_MERGE((t), (parent), R_UNIQUE(_fil_i));                                                            \
+        } else {                                                                                                       \
+            R_UNIQUE(_fil_i)--;                                                                                        \
+            R_BTREE_MERGE((t), (parent), R_UNIQUE(_fil_i));                                                            \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_fil_i);                                                                                 \
+    })
+
+/* btree_size: number of keys in the tree */
+#define btree_size(t) (t)->size
+
+/**
+ * Find a key, returning a pointer to the stored key or nullptr (optional comparator).
+ * The pointer is invalidated by the next insert or remove.
+ */
+#define btree_find(t, val, ...)                                                                                        \
+    ({                                                                                                                 \
+        typeof_unqual((t)->root->keys[0]) * R_UNIQUE(_bfind_res) = nullptr;                                            \
+        if ((t) != nullptr) {                                                                                          \
+            const typeof_unqual((t)->root->keys[0]) R_UNIQUE(_bfind_key) = (val);                                      \
+            typeof_unqual((t)->root) R_UNIQUE(_bfind_node) = (t)->root;                                                \
+            while (R_UNIQUE(_bfind_node) != nullptr) {                                                                 \
+                const size_t R_UNIQUE(_bfind_pos) =                                                                    \
+                    R_BTREE_SEARCH(R_UNIQUE(_bfind_node), R_UNIQUE(_bfind_key) __VA_OPT__(, ) __VA_ARGS__);            \
+                if (R_UNIQUE(_bfind_pos) < R_UNIQUE(_bfind_node)->len &&                                               \
+                    R_BST_CMP(                                                                                         \
+                        R_UNIQUE(_bfind_node)->keys[R_UNIQUE(_bfind_pos)],                                             \
+                        R_UNIQUE(_bfind_key) __VA_OPT__(, ) __VA_ARGS__                                                \
+                    ) == 0) {                                                                                          \
+                    R_UNIQUE(_bfind_res) = &R_UNIQUE(_bfind_node)->keys[R_UNIQUE(_bfind_pos)];                         \
+                    break;                                                                                             \
+                }                                                                                                      \
+                R_UNIQUE(_bfind_node) =                                                                                \
+                    R_UNIQUE(_bfind_node)->leaf ? nullptr : R_UNIQUE(_bfind_node)->children[R_UNIQUE(_bfind_pos)];     \
+            }                                                                                                          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_bfind_res);                                                                             \
+    })
+
+/* btree_contains: optional comparator */
+#define btree_contains(t, val, ...) (btree_find((t), (val) __VA_OPT__(, ) __VA_ARGS__) != nullptr)
+
+/**
+ * Insert a key, ignored if already present (optional comparator). Returns true if the key was added.
+ * Full nodes are split on the way down, so the insert never has to walk back up.
+ */
+#define btree_insert(t, val, ...)                                                                                      \
+    ({                                                                                                                 \
+        bool R_UNIQUE(_bins_added) = false;                                                                            \
+        if ((t) != nullptr) {                                                                                          \
+            const typeof_unqual((t)->root->keys[0]) R_UNIQUE(_bins_key) = (val);                                       \
+            if ((t)->root == nullptr) {                                                                                \
+                (t)->root = R_BTREE_NEW_NODE((t), true);                                                               \
+            } else if ((t)->root->len == btree_node_cap((t))) {                                                        \
+                typeof_unqual((t)->root) R_UNIQUE(_bins_top) = R_BTREE_NEW_NODE((t), false);                           \
+                R_UNIQUE(_bins_top)->children[0] = (t)->root;                                                          \
+                (t)->root = R_UNIQUE(_bins_top);                                                                       \
+                R_BTREE_SPLIT((t), R_UNIQUE(_bins_top), 0);                                                            \
+            }                                                                                                          \
+            typeof_unqual((t)->root) R_UNIQUE(_bins_node) = (t)->root;                                                 \
+            for (;;) {                                                                                                 \
+                size_t R_UNIQUE(_bins_pos) =                                                                           \
+                    R_BTREE_SEARCH(R_UNIQUE(_bins_node), R_UNIQUE(_bins_key) __VA_OPT__(, ) __VA_ARGS__);              \
+                if (R_UNIQUE(_bins_pos) < R_UNIQUE(_bins_node)->len &&                                                 \
+                    R_BST_CMP(                                                                                         \
+                        R_UNIQUE(_bins_node)->keys[R_UNIQUE(_bins_pos)],                                               \
+                        R_UNIQUE(_bins_key) __VA_OPT__(, ) __VA_ARGS__                                                 \
+                    ) == 0) {                                                                                          \
+                    break;                                                                                             \
+                }                                                                                                      \
+                if (R_UNIQUE(_bins_node)->leaf) {                                                                      \
+                    memmove(                                                                                           \
+                        R_UNIQUE(_bins_node)->keys + R_UNIQUE(_bins_pos) + 1,                                          \
+                        R_UNIQUE(_bins_node)->keys + R_UNIQUE(_bins_pos),                                              \
+                        (R_UNIQUE(_bins_node)->len - R_UNIQUE(_bins_pos)) * sizeof((t)->root->keys[0])                 \
+                    );                                                                                                 \
+                    R_UNIQUE(_bins_node)->keys[R_UNIQUE(_bins_pos)] = R_UNIQUE(_bins_key);                             \
+                    R_UNIQUE(_bins_node)->len++;                                                                       \
+                    (t)->size++;                                                                                       \
+                    R_UNIQUE(_bins_added) = true;                                                                      \
+                    break;                                                                                             \
+                }                                                                                                      \
+                if (R_UNIQUE(_bins_node)->children[R_UNIQUE(_bins_pos)]->len == btree_node_cap((t))) {                 \
+                    R_BTREE_SPLIT((t), R_UNIQUE(_bins_node), R_UNIQUE(_bins_pos));                                     \
+                    /* The promoted median decides which half to descend into */                                       \
+                    const int R_UNIQUE(_bins_cmp) = R_BST_CMP(                                                         \
+                        R_UNIQUE(_bins_key),                                                                           \
+                        R_UNIQUE(_bins_node)->keys[R_UNIQUE(_bins_pos)] __VA_OPT__(, ) __VA_ARGS__                     \
+                    );                                                                                                 \
+                    if (R_UNIQUE(_bins_cmp) == 0) {                                                                    \
+                        break;                                                                                         \
+                    }                                                                                                  \
+                    R_UNIQUE(_bins_pos) += R_UNIQUE(_bins_cmp) > 0;                                                    \
+                }                                                                                                      \
+                R_UNIQUE(_bins_node) = R_UNIQUE(_bins_node)->children[R_UNIQUE(_bins_pos)];                            \
+            }                                                                                                          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_bins_added);                                                                            \
+    })
+
+/**
+ * Remove a key (optional comparator). Returns true if the key was present.
+ * Single pass from the root: every child is topped up to at least d keys (R_BTREE_FILL) before the descent enters
+ * it, so the key always comes out of a leaf without rebalancing afterwards. A key found in an internal node is
+ * replaced by its predecessor or successor, or merged down when neither neighbouring child can spare a key.
+ */
+#define btree_remove(t, val, ...)                                                                                      \
+    ({                                                                                                                 \
+        bool R_UNIQUE(_brm_removed) = false;                                                                           \
+        if ((t) != nullptr && (t)->root != nullptr) {                                                                  \
+            typeof_unqual((t)->root->keys[0]) R_UNIQUE(_brm_key) = (val);                                              \
+            typeof_unqual((t)->root) R_UNIQUE(_brm_node) = (t)->root;                                                  \
+            for (;;) {                                                                                                 \
+                size_t R_UNIQUE(_brm_pos) =                                                                            \
+                    R_BTREE_SEARCH(R_UNIQUE(_brm_node), R_UNIQUE(_brm_key) __VA_OPT__(, ) __VA_ARGS__);                \
+                const bool R_UNIQUE(_brm_found) =                                                                      \
+                    R_UNIQUE(_brm_pos) < R_UNIQUE(_brm_node)->len &&                                                   \
+                    R_BST_CMP(                                                                                         \
+                        R_UNIQUE(_brm_node)->keys[R_UNIQUE(_brm_pos)], R_UNIQUE(_brm_key) __VA_OPT__(, ) __VA_ARGS__   \
+                    ) == 0;                                                                                            \
+                if (R_UNIQUE(_brm_node)->leaf) {                                                                       \
+                    if (R_UNIQUE(_brm_found)) {                                                                        \
+                        memmove(                                                                                       \
+                            R_UNIQUE(_brm_node)->keys + R_UNIQUE(_brm_pos),                                            \
+                            R_UNIQUE(_brm_node)->keys + R_UNIQUE(_brm_pos) + 1,                                        \
+                            (R_UNIQUE(_brm_node)->len - R_UNIQUE(_brm_pos) - 1) * sizeof((t)->root->keys[0])           \
+                        );                                                                                             \
+                        R_UNIQUE(_brm_node)->len--;                                                                    \
+                        (t)->size--;                                                                                   \
+                        R_UNIQUE(_brm_removed) = true;                                                                 \
+                    }                                                                                                  \
+                    break;                                                                                             \
+                }                                                                                                      \
+                typeof_unqual((t)->root) R_UNIQUE(_brm_left) = R_UNIQUE(_brm_node)->children[R_UNIQUE(_brm_pos)];      \
+                if (R_UNIQUE(_brm_found)) {                                                                            \
+                    typeof_unqual((t)->root) R_UNIQUE(_brm_right) =                                                    \
+                        R_UNIQUE(_brm_node)->children[R_UNIQUE(_brm_pos) + 1];                                         \
+                    if (R_UNIQUE(_brm_left)->len >= R_BTREE_MIN((t))) {                                                \
+                        /* Replace with the predecessor, then remove that from the left subtree */                     \
+                        typeof_unqual((t)->root) R_UNIQUE(_brm_cur) = R_UNIQUE(_brm_left);                             \
+                        while (!R_UNIQUE(_brm_cur)->leaf) {                                                            \
+                            R_UNIQUE(_brm_cur) = R_UNIQUE(_brm_cur)->children[R_UNIQUE(_brm_cur)->len];                \
+                        }                                                                                              \
+                        R_UNIQUE(_brm_key) = R_UNIQUE(_brm_cur)->keys[R_UNIQUE(_brm_cur)->len - 1];                    \
+                        R_UNIQUE(_brm_node)->keys[R_UNIQUE(_brm_pos)] = R_UNIQUE(_brm_key);                            \
+                        R_UNIQUE(_brm_node) = R_UNIQUE(_brm_left);                                                     \
+                    } else if (R_UNIQUE(_brm_right)->len >= R_BTREE_MIN((t))) {                                        \
+                        /* Replace with the successor, then remove that from the right subtree */                      \
+                        typeof_unqual((t)->root) R_UNIQUE(_brm_cur) = R_UNIQUE(_brm_right);                            \
+                        while (!R_UNIQUE(_brm_cur)->leaf) {                                                            \
+                            R_UNIQUE(_brm_cur) = R_UNIQUE(_brm_cur)->children[0];                                      \
+                        }                                                                                              \
+                        R_UNIQUE(_brm_key) = R_UNIQUE(_brm_cur)->keys[0];                                              \
+                        R_UNIQUE(_brm_node)->keys[R_UNIQUE(_brm_pos)] = R_UNIQUE(_brm_key);                            \
+                        R_UNIQUE(_brm_node) = R_UNIQUE(_brm_right);                                                    \
+                    } else {                                                                                           \
+                        /* Both neighbouring children are minimal: merge them around the key and continue there */     \
+                        R_BTREE_MERGE((t), R_UNIQUE(_brm_node), R_UNIQUE(_brm_pos));                                   \
+                        R_UNIQUE(_brm_node) = R_UNIQUE(_brm_left);                                                     \
+                    }                                                                                                  \
+                } else {                                                                                               \
+                    if (R_UNIQUE(_brm_left)->len < R_BTREE_MIN((t))) {                                                 \
+                        R_UNIQUE(_brm_pos) = R_BTREE_FILL((t), R_UNIQUE(_brm_node), R_UNIQUE(_brm_pos));               \
+                    }                                                                                                  \
+                    R_UNIQUE(_brm_node) = R_UNIQUE(_brm_node)->children[R_UNIQUE(_brm_pos)];                           \
+                }                                                                                                      \
+                /* A merge can empty the root: its only child becomes the new root */                                  \
+                if ((t)->root->len == 0 && !(t)->root->leaf) {                                                         \
+                    typeof_unqual((t)->root) R_UNIQUE(_brm_old) = (t)->root;                                           \
+                    (t)->root = R_UNIQUE(_brm_old)->children[0];                                                       \
+                    mem_free(R_UNIQUE(_brm_old), R_BTREE_NODE_SIZE((t), false));                                       \
+                }                                                                                                      \
+            }                                                                                                          \
+            if ((t)->root->len == 0) {                                                                                 \
+                mem_free((t)->root, R_BTREE_NODE_SIZE((t), true));                                                     \
+                (t)->root = nullptr;                                                                                   \
+            }                                                                                                          \
+        }                                                                                                              \
+        /* return */ R_UNIQUE(_brm_removed);                                                                           \
+    })
+
+/**
+ * Free every node and reset the tree to empty; the tree stays usable.
+ * Post-order walk with an explicit stack of (node, next child) pairs. The stack depth is the tree height, which is
+ * bounded by log_d(n) and never comes close to the 64 entries reserved for it.
+ */
+#define btree_clear(t)                                                                                                 \
+    ({                                                                                                                 \
+        if ((t) != nullptr && (t)->root != nullptr) {                                                                  \
+            struct {                                                                                                   \
+                typeof_unqual((t)->root) node;                                                                         \
+                size_t next;                                                                                           \
+            } R_UNIQUE(_bclr_stack)[64];                                                                               \
+            size_t R_UNIQUE(_bclr_sp) = 0;                                                                             \
+            R_UNIQUE(_bclr_stack)[R_UNIQUE(_bclr_sp)].node = (t)->root;                                                \
+            R_UNIQUE(_bclr_stack)[R_UNIQUE(_bclr_sp)++].next = 0;                                                      \
+            while (R_UNIQUE(_bclr_sp) > 0) {                                                                           \
+                typeof(R_UNIQUE(_bclr_stack)[0]) * R_UNIQUE(_bclr_top) =                                               \
+                    &R_UNIQUE(_bclr_stack)[R_UNIQUE(_bclr_sp) - 1];                                                    \
+                typeof_unqual((t)->root) R_UNIQUE(_bclr_node) = R_UNIQUE(_bclr_top)->node;                             \
+                if (!R_UNIQUE(_bclr_node)->leaf && R_UNIQUE(_bclr_top)->next <= R_UNIQUE(_bclr_node)->len) {           \
+                    R_UNIQUE(_bclr_stack)[R_UNIQUE(_bclr_sp)].node =                                                   \
+                        R_UNIQUE(_bclr_node)->children[R_UNIQUE(_bclr_top)->next++];                                   \
+                    R_UNIQUE(_bclr_stack)[R_UNIQUE(_bclr_sp)++].next = 0;                                              \
+                } else {                                                                                               \
+                    mem_free(R_UNIQUE(_bclr_node), R_BTREE_NODE_SIZE((t), R_UNIQUE(_bclr_node)->leaf));                \
+                    R_UNIQUE(_bclr_sp)--;                                                                              \
+                }                                                                                                      \
+            }                                                                                                          \
+            (t)->root = nullptr;                                                                                       \
+            (t)->size = 0;                                                                                             \
+        }                                                                                                              \
+    })
+
+/* btree_free: release all memory owned by the tree; the tree is left empty and reusable */
+#define btree_free(t) btree_clear(t)
+
+#endif // RUNE_BTREE_API
 
 // Type definition and implementation
 // ---------------------------------------------------------------------------------------------------------------------
@@ -859,6 +1290,21 @@ typedef struct {
     struct RBT_NODE(T) * root;
     const size_t node_size;
     size_t size;
+    struct RBT_NODE(T) * block; // Contiguous node block from rbt_build_sorted, or nullptr
+    size_t block_len;           // Nodes allocated in block
+    size_t block_live;          // Block nodes still linked into the tree
 } RBT(T);
 
+struct BTREE_NODE(T) {
+    uint32_t len; // Keys in use
+    bool leaf;
+    T keys[2 * R_BTREE_DEGREE(T) - 1];
+    struct BTREE_NODE(T) * children[]; // len + 1 children, internal nodes only
+};
+
+typedef struct {
+    struct BTREE_NODE(T) * root;
+    size_t size;
+} BTREE(T);
+
 #endif // T
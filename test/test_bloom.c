@@ -0,0 +1,248 @@
+/*
+ * bloom tests.
+ */
+
+// ReSharper disable CppDFATimeOver
+#include "../src/bloom.h"
+#include "CUnit/Basic.h"
+#include "test.h"
+
+#include <stdint.h>
+
+typedef struct {
+    int32_t x;
+    int32_t y;
+} bloom_test_point;
+
+static hash128_t bloom_test_point_hash(const bloom_test_point p) {
+    // Ignores y: points that differ only in y are the same key
+    return hash128(&p.x, sizeof(p.x));
+}
+
+// =====================================================================================================================
+// bloom_new() - Lifecycle
+// =====================================================================================================================
+
+static void bloom_new__for_lower_rate__should_use_more_memory(void) {
+    bloom * loose = bloom_new(10000, 0.05);
+    bloom * tight = bloom_new(10000, 0.0001);
+    CU_ASSERT_PTR_NOT_NULL(loose);
+    CU_ASSERT_PTR_NOT_NULL(tight);
+    CU_ASSERT(bloom_bytes(loose) < bloom_bytes(tight));
+    CU_ASSERT_EQUAL(bloom_bytes(loose) % 64, 0);
+    // About 10 bits per key for 1%
+    bloom * one = bloom_new(10000, 0.01);
+    CU_ASSERT(bloom_bytes(one) * 8 >= 10000 * 10);
+    CU_ASSERT(bloom_bytes(one) * 8 <= 10000 * 12);
+    bloom_free(loose);
+    bloom_free(tight);
+    bloom_free(one);
+    CU_ASSERT_FALSE(err_has());
+}
+
+static void bloom_new__with_invalid_rate__should_fail(void) {
+    CU_ASSERT_PTR_NULL(bloom_new(100, 0.0));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_INVALID_ARGUMENT);
+    err_clear();
+    CU_ASSERT_PTR_NULL(bloom_new(100, 1.0));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_INVALID_ARGUMENT);
+    err_clear();
+    bloom_free(nullptr);
+}
+
+static void bloom_new__for_zero_keys__should_hold_one_block(void) {
+    bloom * b = bloom_new(0, 0.01);
+    CU_ASSERT_PTR_NOT_NULL(b);
+    CU_ASSERT_EQUAL(bloom_bytes(b), 64);
+    CU_ASSERT_FALSE(bloom_has(b, 1));
+    bloom_add(b, 1);
+    CU_ASSERT_TRUE(bloom_has(b, 1));
+    bloom_free(b);
+}
+
+// =====================================================================================================================
+// bloom_add() / bloom_has() - Keys
+// =====================================================================================================================
+
+static void bloom_has__for_added_keys__should_never_miss(void) {
+    bloom * b = bloom_new(50000, 0.01);
+    for (int64_t i = 0; i < 50000; i++)
+        bloom_add(b, i * 7);
+    size_t missed = 0;
+    for (int64_t i = 0; i < 50000; i++)
+        missed += !bloom_has(b, i * 7);
+    CU_ASSERT_EQUAL(missed, 0);
+    CU_ASSERT_EQUAL(bloom_count(b), 50000);
+    bloom_free(b);
+}
+
+static void bloom_has__for_absent_keys__should_stay_near_target_rate(void) {
+    bloom * b = bloom_new(50000, 0.01);
+    for (int64_t i = 0; i < 50000; i++)
+        bloom_add(b, i);
+    size_t false_positives = 0;
+    for (int64_t i = 50000; i < 250000; i++)
+        false_positives += bloom_has(b, i);
+    // 200000 probes at 1%: about 2000 expected
+    CU_ASSERT(false_positives > 1000);
+    CU_ASSERT(false_positives < 3000);
+    CU_ASSERT(bloom_fpp(b) > 0.005 && bloom_fpp(b) < 0.015);
+    bloom_free(b);
+}
+
+static void bloom_has__for_string_keys__should_hash_contents(void) {
+    bloom * b = bloom_new(100, 0.001);
+    char buf[16] = "apple";
+    bloom_add(b, "apple");
+    bloom_add(b, (const char *)"banana");
+    CU_ASSERT_TRUE(bloom_has(b, buf));
+    CU_ASSERT_TRUE(bloom_has(b, "banana"));
+    CU_ASSERT_TRUE(bloom_has_bytes(b, "apple", 5));
+    CU_ASSERT_FALSE(bloom_has(b, "cherry"));
+    bloom_free(b);
+}
+
+static void bloom_has__with_custom_hash__should_use_it(void) {
+    bloom * b = bloom_new(100, 0.001);
+    bloom_add(b, ((bloom_test_point){1, 2}), bloom_test_point_hash);
+    CU_ASSERT_TRUE(bloom_has(b, ((bloom_test_point){1, 99}), bloom_test_point_hash));
+    CU_ASSERT_FALSE(bloom_has(b, ((bloom_test_point){2, 2}), bloom_test_point_hash));
+    bloom_free(b);
+}
+
+static void bloom_clear__after_adds__should_forget_keys(void) {
+    bloom * b = bloom_new(100, 0.01);
+    bloom_add(b, 42);
+    bloom_clear(b);
+    CU_ASSERT_FALSE(bloom_has(b, 42));
+    CU_ASSERT_EQUAL(bloom_count(b), 0);
+    CU_ASSERT_EQUAL(bloom_fpp(b), 0.0);
+    bloom_free(b);
+}
+
+// =====================================================================================================================
+// bloom_merge() / bloom_write() / bloom_read() - Whole filters
+// =====================================================================================================================
+
+static void bloom_merge__for_equal_sizes__should_hold_both_key_sets(void) {
+    bloom * a = bloom_new(1000, 0.01);
+    bloom * b = bloom_new(1000, 0.01);
+    for (int i = 0; i < 500; i++) {
+        bloom_add(a, i);
+        bloom_add(b, i + 500);
+    }
+    CU_ASSERT_TRUE(bloom_merge(a, b));
+    size_t missed = 0;
+    for (int i = 0; i < 1000; i++)
+        missed += !bloom_has(a, i);
+    CU_ASSERT_EQUAL(missed, 0);
+    CU_ASSERT_EQUAL(bloom_count(a), 1000);
+
+    // Into itself: same bits, same count, same estimated rate
+    const double fpp = bloom_fpp(a);
+    CU_ASSERT_TRUE(bloom_merge(a, a));
+    CU_ASSERT_EQUAL(bloom_count(a), 1000);
+    CU_ASSERT_EQUAL(bloom_fpp(a), fpp);
+
+    bloom * other = bloom_new(100000, 0.01);
+    CU_ASSERT_FALSE(bloom_merge(a, other));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_INVALID_ARGUMENT);
+    err_clear();
+    bloom_free(a);
+    bloom_free(b);
+    bloom_free(other);
+}
+
+static void bloom_read__after_write__should_answer_like_the_original(void) {
+    bloom * b = bloom_new(2000, 0.01);
+    for (int i = 0; i < 2000; i++)
+        bloom_add(b, i * 3);
+
+    FILE * f = tmpfile();
+    CU_ASSERT_PTR_NOT_NULL(f);
+    CU_ASSERT_TRUE(bloom_write(b, f));
+    rewind(f);
+    bloom * r = bloom_read(f);
+    fclose(f);
+    CU_ASSERT_PTR_NOT_NULL(r);
+    CU_ASSERT_EQUAL(bloom_bytes(r), bloom_bytes(b));
+    CU_ASSERT_EQUAL(bloom_count(r), 2000);
+    size_t differ = 0;
+    for (int i = 0; i < 10000; i++)
+        differ += bloom_has(r, i) != bloom_has(b, i);
+    CU_ASSERT_EQUAL(differ, 0);
+    bloom_free(r);
+    bloom_free(b);
+}
+
+static void bloom_read__for_invalid_input__should_fail(void) {
+    FILE * f = tmpfile();
+    fputs("not a bloom filter, just some text", f);
+    rewind(f);
+    CU_ASSERT_PTR_NULL(bloom_read(f));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_PARSE_FAILED);
+    err_clear();
+    fclose(f);
+
+    // Header without its bit array
+    bloom * b = bloom_new(1000, 0.01);
+    f = tmpfile();
+    CU_ASSERT_TRUE(bloom_write(b, f));
+    const long size = ftell(f);
+    rewind(f);
+    char buf[256];
+    CU_ASSERT_EQUAL(fread(buf, 1, 100, f), 100);
+    fclose(f);
+    CU_ASSERT(size > 100);
+    f = tmpfile();
+    fwrite(buf, 1, 100, f);
+    rewind(f);
+    CU_ASSERT_PTR_NULL(bloom_read(f));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_PARSE_FAILED);
+    err_clear();
+    fclose(f);
+    bloom_free(b);
+}
+
+int main(void) {
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // bloom_new() suite
+    CU_pSuite suite_new = CU_add_suite("bloom_new()", nullptr, nullptr);
+    if (suite_new == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_new, bloom_new__for_lower_rate__should_use_more_memory);
+    ADD_TEST(suite_new, bloom_new__with_invalid_rate__should_fail);
+    ADD_TEST(suite_new, bloom_new__for_zero_keys__should_hold_one_block);
+
+    // bloom_add() / bloom_has() suite
+    CU_pSuite suite_keys = CU_add_suite("bloom_add() / bloom_has()", nullptr, nullptr);
+    if (suite_keys == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_keys, bloom_has__for_added_keys__should_never_miss);
+    ADD_TEST(suite_keys, bloom_has__for_absent_keys__should_stay_near_target_rate);
+    ADD_TEST(suite_keys, bloom_has__for_string_keys__should_hash_contents);
+    ADD_TEST(suite_keys, bloom_has__with_custom_hash__should_use_it);
+    ADD_TEST(suite_keys, bloom_clear__after_adds__should_forget_keys);
+
+    // Whole filter suite
+    CU_pSuite suite_whole = CU_add_suite("bloom_merge() / bloom_write() / bloom_read()", nullptr, nullptr);
+    if (suite_whole == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_whole, bloom_merge__for_equal_sizes__should_hold_both_key_sets);
+    ADD_TEST(suite_whole, bloom_read__after_write__should_answer_like_the_original);
+    ADD_TEST(suite_whole, bloom_read__for_invalid_input__should_fail);
+
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,277 @@
+/*
+ * cmap tests.
+ */
+
+// ReSharper disable CppDFATimeOver
+#include <pthread.h>
+#include <stdint.h>
+
+#define K int64_t
+#define V int64_t
+#include "../src/map.h"
+#include "../src/cmap.h"
+#undef K
+#undef V
+
+typedef const char * cstr;
+#define K cstr
+#define V int
+#include "../src/map.h"
+#include "../src/cmap.h"
+#undef K
+#undef V
+
+#include "CUnit/Basic.h"
+#include "test.h"
+
+typedef struct {
+    int32_t id;
+    int32_t tag;
+} cmap_test_key;
+
+#define K cmap_test_key
+#define V int
+#include "../src/map.h"
+#include "../src/cmap.h"
+#undef K
+#undef V
+
+static uint64_t cmap_test_key_hash(const cmap_test_key k) {
+    return hash_mix((uint64_t)(uint32_t)k.id);
+}
+
+// Ignores tag: keys that differ only in tag are the same key
+static bool cmap_test_key_eq(const cmap_test_key a, const cmap_test_key b) {
+    return a.id == b.id;
+}
+
+// =====================================================================================================================
+// cmap_init() / cmap_put() / cmap_get() - Single thread
+// =====================================================================================================================
+
+static void cmap_init__with_shard_count__should_round_to_power_of_two(void) {
+    CMAP(int64_t, int64_t) m;
+    CU_ASSERT_TRUE(cmap_init(&m, 5));
+    CU_ASSERT_EQUAL(cmap_shards(&m), 8);
+    CU_ASSERT_EQUAL(cmap_size(&m), 0);
+    cmap_free(&m);
+
+    CU_ASSERT_TRUE(cmap_init(&m, 0));
+    CU_ASSERT_EQUAL(cmap_shards(&m), R_CMAP_SHARDS);
+    cmap_free(&m);
+
+    // One shard: every key lands in it
+    CU_ASSERT_TRUE(cmap_init(&m, 1));
+    for (int64_t i = 0; i < 100; i++)
+        cmap_put(&m, i, i);
+    CU_ASSERT_EQUAL(m.shards[0].map.size, 100);
+    cmap_free(&m);
+    CU_ASSERT_FALSE(err_has());
+}
+
+static void cmap_get__after_put__should_copy_value(void) {
+    CMAP(int64_t, int64_t) m;
+    CU_ASSERT_TRUE(cmap_init(&m, 4));
+    CU_ASSERT_TRUE(cmap_put(&m, 7, 70));
+    CU_ASSERT_FALSE(cmap_put(&m, 7, 71));
+    int64_t v = 0;
+    CU_ASSERT_TRUE(cmap_get(&m, 7, &v));
+    CU_ASSERT_EQUAL(v, 71);
+    CU_ASSERT_FALSE(cmap_get(&m, 8, &v));
+    CU_ASSERT_EQUAL(v, 71);
+    CU_ASSERT_TRUE(cmap_contains(&m, 7));
+    CU_ASSERT_FALSE(cmap_contains(&m, 8));
+    CU_ASSERT_EQUAL(cmap_size(&m), 1);
+    cmap_free(&m);
+}
+
+static void cmap_put__for_many_keys__should_spread_over_shards(void) {
+    CMAP(int64_t, int64_t) m;
+    CU_ASSERT_TRUE(cmap_init(&m, 16));
+    for (int64_t i = 0; i < 20000; i++)
+        cmap_put(&m, i, i * 3);
+    CU_ASSERT_EQUAL(cmap_size(&m), 20000);
+    size_t missed = 0;
+    for (int64_t i = 0; i < 20000; i++) {
+        int64_t v;
+        missed += !cmap_get(&m, i, &v) || v != i * 3;
+    }
+    CU_ASSERT_EQUAL(missed, 0);
+    // Every shard gets a share near 20000 / 16
+    for (size_t s = 0; s < cmap_shards(&m); s++) {
+        CU_ASSERT(m.shards[s].map.size > 1000);
+        CU_ASSERT(m.shards[s].map.size < 1500);
+    }
+    cmap_free(&m);
+}
+
+static void cmap_remove__for_present_and_absent_keys__should_report(void) {
+    CMAP(int64_t, int64_t) m;
+    CU_ASSERT_TRUE(cmap_init(&m, 2));
+    for (int64_t i = 0; i < 100; i++)
+        cmap_put(&m, i, i);
+    CU_ASSERT_TRUE(cmap_remove(&m, 42));
+    CU_ASSERT_FALSE(cmap_remove(&m, 42));
+    CU_ASSERT_FALSE(cmap_contains(&m, 42));
+    CU_ASSERT_EQUAL(cmap_size(&m), 99);
+    cmap_free(&m);
+}
+
+static void cmap_get__for_string_keys__should_compare_contents(void) {
+    CMAP(cstr, int) m;
+    CU_ASSERT_TRUE(cmap_init(&m, 4));
+    char buf[16] = "apple";
+    cmap_put(&m, "apple", 1);
+    cmap_put(&m, "banana", 2);
+    int v = 0;
+    CU_ASSERT_TRUE(cmap_get(&m, buf, &v));
+    CU_ASSERT_EQUAL(v, 1);
+    CU_ASSERT_FALSE(cmap_contains(&m, "cherry"));
+    cmap_free(&m);
+}
+
+static void cmap_get__with_custom_hash__should_use_it(void) {
+    CMAP(cmap_test_key, int) m;
+    CU_ASSERT_TRUE(cmap_init(&m, 8));
+    cmap_put(&m, ((cmap_test_key){1, 2}), 10, cmap_test_key_hash, cmap_test_key_eq);
+    int v = 0;
+    CU_ASSERT_TRUE(cmap_get(&m, ((cmap_test_key){1, 99}), &v, cmap_test_key_hash, cmap_test_key_eq));
+    CU_ASSERT_EQUAL(v, 10);
+    CU_ASSERT_FALSE(cmap_contains(&m, ((cmap_test_key){2, 2}), cmap_test_key_hash, cmap_test_key_eq));
+    CU_ASSERT_TRUE(cmap_remove(&m, ((cmap_test_key){1, 0}), cmap_test_key_hash, cmap_test_key_eq));
+    cmap_free(&m);
+}
+
+static void cmap_free__with_arena_allocator__should_return_memory_to_it(void) {
+    arena a = arena();
+    alloc_push(arena_allocator(&a));
+    CMAP(int64_t, int64_t) m;
+    CU_ASSERT_TRUE(cmap_init(&m, 4));
+    alloc_pop();
+    // Growth after the pop still allocates from the arena
+    const size_t used = arena_used(&a);
+    for (int64_t i = 0; i < 1000; i++)
+        cmap_put(&m, i, i);
+    CU_ASSERT(arena_used(&a) > used);
+    cmap_free(&m);
+    arena_free(&a);
+}
+
+// =====================================================================================================================
+// cmap_get() / cmap_put() - Concurrent readers and writers
+// =====================================================================================================================
+
+enum { CMAP_TEST_READERS = 64, CMAP_TEST_WRITERS = 4, CMAP_TEST_KEYS = 20000, CMAP_TEST_READS = 100000 };
+
+typedef struct {
+    CMAP(int64_t, int64_t) * m;
+    int64_t id;
+    R_Atomic(bool) * stop;
+    size_t wrong; // values that broke the v == 2 * key invariant
+    size_t found;
+} cmap_test_ctx;
+
+// Writers grow the map (forcing rehashes under the readers), then keep rewriting and removing keys
+static void * cmap_test_writer(void * arg) {
+    cmap_test_ctx * ctx = arg;
+    for (int64_t i = ctx->id; i < CMAP_TEST_KEYS; i += CMAP_TEST_WRITERS)
+        cmap_put(ctx->m, i, i * 2);
+    for (int64_t round = 0; !atomic_load(ctx->stop); round++) {
+        const int64_t k = (round * CMAP_TEST_WRITERS + ctx->id) % CMAP_TEST_KEYS;
+        if (round % 4 == 0) {
+            cmap_remove(ctx->m, k);
+        }
+        cmap_put(ctx->m, k, k * 2);
+    }
+    return nullptr;
+}
+
+static void * cmap_test_reader(void * arg) {
+    cmap_test_ctx * ctx = arg;
+    uint64_t x = (uint64_t)ctx->id * 0x9E3779B97F4A7C15ULL + 1;
+    for (size_t i = 0; i < CMAP_TEST_READS; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        const int64_t k = (int64_t)(x % CMAP_TEST_KEYS);
+        int64_t v;
+        if (cmap_get(ctx->m, k, &v)) {
+            ctx->found++;
+            ctx->wrong += v != k * 2;
+        }
+    }
+    return nullptr;
+}
+
+static void cmap_get__with_concurrent_writers__should_never_see_torn_values(void) {
+    CMAP(int64_t, int64_t) m;
+    CU_ASSERT_TRUE(cmap_init(&m, 16));
+    R_Atomic(bool) stop = false;
+    pthread_t writers[CMAP_TEST_WRITERS];
+    pthread_t readers[CMAP_TEST_READERS];
+    cmap_test_ctx wctx[CMAP_TEST_WRITERS];
+    cmap_test_ctx rctx[CMAP_TEST_READERS];
+    for (int t = 0; t < CMAP_TEST_WRITERS; t++) {
+        wctx[t] = (cmap_test_ctx){.m = &m, .id = t, .stop = &stop};
+        pthread_create(&writers[t], nullptr, cmap_test_writer, &wctx[t]);
+    }
+    for (int t = 0; t < CMAP_TEST_READERS; t++) {
+        rctx[t] = (cmap_test_ctx){.m = &m, .id = t, .stop = &stop};
+        pthread_create(&readers[t], nullptr, cmap_test_reader, &rctx[t]);
+    }
+    size_t wrong = 0;
+    size_t found = 0;
+    for (int t = 0; t < CMAP_TEST_READERS; t++) {
+        pthread_join(readers[t], nullptr);
+        wrong += rctx[t].wrong;
+        found += rctx[t].found;
+    }
+    atomic_store(&stop, true);
+    for (int t = 0; t < CMAP_TEST_WRITERS; t++)
+        pthread_join(writers[t], nullptr);
+
+    CU_ASSERT_EQUAL(wrong, 0);
+    CU_ASSERT(found > 0);
+    // Every key is put back after a remove, so the final map holds all of them
+    CU_ASSERT_EQUAL(cmap_size(&m), CMAP_TEST_KEYS);
+    size_t missed = 0;
+    for (int64_t i = 0; i < CMAP_TEST_KEYS; i++) {
+        int64_t v;
+        missed += !cmap_get(&m, i, &v) || v != i * 2;
+    }
+    CU_ASSERT_EQUAL(missed, 0);
+    cmap_free(&m);
+}
+
+int main(void) {
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // Single thread suite
+    CU_pSuite suite_basic = CU_add_suite("cmap_init() / cmap_put() / cmap_get()", nullptr, nullptr);
+    if (suite_basic == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_basic, cmap_init__with_shard_count__should_round_to_power_of_two);
+    ADD_TEST(suite_basic, cmap_get__after_put__should_copy_value);
+    ADD_TEST(suite_basic, cmap_put__for_many_keys__should_spread_over_shards);
+    ADD_TEST(suite_basic, cmap_remove__for_present_and_absent_keys__should_report);
+    ADD_TEST(suite_basic, cmap_get__for_string_keys__should_compare_contents);
+    ADD_TEST(suite_basic, cmap_get__with_custom_hash__should_use_it);
+    ADD_TEST(suite_basic, cmap_free__with_arena_allocator__should_return_memory_to_it);
+
+    // Concurrency suite
+    CU_pSuite suite_threads = CU_add_suite("cmap_get() / cmap_put() concurrent", nullptr, nullptr);
+    if (suite_threads == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_threads, cmap_get__with_concurrent_writers__should_never_see_torn_values);
+
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -7,6 +7,7 @@
 #include "CUnit/Basic.h"
 #include "test.h"
 
+#include <pthread.h>
 #include <stdlib.h>
 
 // =====================================================================================================================
@@ -20,6 +21,34 @@
 #include <limits.h>
 #undef T
 
+// Define LIST(uint64_t) with a comparator, which also generates list_par_sort for it
+static int coll_test_u64_cmp(const uint64_t a, const uint64_t b) {
+    return (a > b) - (a < b);
+}
+
+#define T uint64_t
+#define T_CMP coll_test_u64_cmp
+#include "../src/coll.h"
+#undef T_CMP
+#undef T
+
+// Define LIST(uint32_t) with a comparator that fails (leaves an error) after a set number of calls
+static R_Atomic(size_t) coll_test_cmp_calls;
+static size_t coll_test_cmp_limit = SIZE_MAX;
+
+static int coll_test_u32_cmp_limited(const uint32_t a, const uint32_t b) {
+    if (atomic_fetch_add_explicit(&coll_test_cmp_calls, 1, memory_order_relaxed) == coll_test_cmp_limit) {
+        err_set(R_ERR_INVALID_ARGUMENT, "comparison limit");
+    }
+    return (a > b) - (a < b);
+}
+
+#define T uint32_t
+#define T_CMP coll_test_u32_cmp_limited
+#include "../src/coll.h"
+#undef T_CMP
+#undef T
+
 // =====================================================================================================================
 // list() - Create list
 // =====================================================================================================================
@@ -246,15 +275,309 @@ static void list_grow__on_empty_list__should_allocate_initial_capacity(void) {
 }
 
 static void list_grow__when_full__should_double_capacity(void) {
-    LIST(int) lst = list(int, 1, 2, 3);
+    LIST(int) lst = list(int, 1, 2, 3, 4);
     const size_t old_capacity = lst.capacity;
+    CU_ASSERT_EQUAL(lst.size, old_capacity);
 
-    list_add(&lst, 4); // This triggers grow
-    CU_ASSERT_EQUAL(lst.capacity, old_capacity << 1);
-    CU_ASSERT_EQUAL(lst.size, 4);
+    list_add(&lst, 5); // This triggers grow
+    CU_ASSERT_EQUAL(lst.capacity, old_capacity * R_LIST_GROWTH / 100);
+    CU_ASSERT_EQUAL(lst.size, 5);
+    CU_ASSERT_EQUAL(list_get(&lst, 4), 5);
+    list_free(&lst);
+}
+
+static void list_grow__with_free_slot__should_keep_capacity(void) {
+    LIST(int) lst = list(int, 1, 2, 3);
+    const int * old_data = lst.data;
+
+    list_add(&lst, 4); // Fills the last slot
+    CU_ASSERT_EQUAL(lst.capacity, 4);
+    CU_ASSERT_PTR_EQUAL(lst.data, old_data);
+    list_free(&lst);
+}
+
+static void list_grown_capacity__for_needed_count__should_apply_growth_factor(void) {
+    CU_ASSERT_EQUAL(R_(list_grown_capacity)(0, 1), R_LIST_MIN_CAPACITY);
+    CU_ASSERT_EQUAL(R_(list_grown_capacity)(100, 101), 100 * R_LIST_GROWTH / 100);
+    CU_ASSERT(R_(list_grown_capacity)(100, 100000) >= 100000);
+    CU_ASSERT_EQUAL(R_(list_grown_capacity)(64, 10), 64); // never shrinks
+}
+
+// =====================================================================================================================
+// list_reserve() - Reserve capacity
+// =====================================================================================================================
+
+static void list_reserve__on_empty_list__should_allocate_exact_capacity(void) {
+    LIST(int) lst = list(int);
+
+    list_reserve(&lst, 1000);
+    CU_ASSERT_EQUAL(lst.capacity, 1000);
+    CU_ASSERT_EQUAL(lst.size, 0);
+
+    const int * data = lst.data;
+    for (int i = 0; i < 1000; i++) {
+        list_add(&lst, i);
+    }
+    CU_ASSERT_PTR_EQUAL(lst.data, data); // No reallocation while filling
+    CU_ASSERT_EQUAL(lst.capacity, 1000);
+    CU_ASSERT_EQUAL(list_get(&lst, 999), 999);
+    list_free(&lst);
+}
+
+static void list_reserve__for_smaller_count__should_keep_capacity(void) {
+    LIST(int) lst = list(int, 1, 2, 3);
+    list_reserve(&lst, 64);
+
+    list_reserve(&lst, 2);
+    CU_ASSERT_EQUAL(lst.capacity, 64);
+    CU_ASSERT_EQUAL(lst.size, 3);
+    CU_ASSERT_EQUAL(list_get(&lst, 2), 3);
     list_free(&lst);
 }
 
+// =====================================================================================================================
+// list_add_n() / list_extend() - Bulk append
+// =====================================================================================================================
+
+static void list_add_n__for_array__should_append_in_order(void) {
+    LIST(int) lst = list(int, 1, 2);
+    const int items[] = {3, 4, 5, 6, 7, 8, 9};
+
+    list_add_n(&lst, items, 7);
+    CU_ASSERT_EQUAL(lst.size, 9);
+    CU_ASSERT(lst.capacity >= 9);
+    for (int i = 0; i < 9; i++) {
+        CU_ASSERT_EQUAL(list_get(&lst, i), i + 1);
+    }
+    list_free(&lst);
+}
+
+static void list_add_n__for_zero_items__should_not_allocate(void) {
+    LIST(int) lst = list(int);
+
+    list_add_n(&lst, (const int *)nullptr, 0);
+    CU_ASSERT_EQUAL(lst.size, 0);
+    CU_ASSERT_EQUAL(lst.capacity, 0);
+    CU_ASSERT_PTR_NULL(lst.data);
+}
+
+static void list_add_n__for_items_of_same_list__should_copy_before_buffer_moves(void) {
+    LIST(int) lst = list(int, 1, 2, 3, 4);
+
+    list_add_n(&lst, &lst.data[1], 3); // Needs to grow, source lives in the old buffer
+    CU_ASSERT_EQUAL(lst.size, 7);
+    const int expected[] = {1, 2, 3, 4, 2, 3, 4};
+    for (int i = 0; i < 7; i++) {
+        CU_ASSERT_EQUAL(list_get(&lst, i), expected[i]);
+    }
+    list_free(&lst);
+}
+
+static void list_extend__for_other_list__should_append_all(void) {
+    LIST(int) a = list(int, 1, 2, 3);
+    LIST(int) b = list(int, 4, 5);
+
+    list_extend(&a, &b);
+    CU_ASSERT_EQUAL(a.size, 5);
+    for (int i = 0; i < 5; i++) {
+        CU_ASSERT_EQUAL(list_get(&a, i), i + 1);
+    }
+    CU_ASSERT_EQUAL(b.size, 2);
+
+    list_extend(&a, &a);
+    CU_ASSERT_EQUAL(a.size, 10);
+    CU_ASSERT_EQUAL(list_get(&a, 9), 5);
+    list_free(&a);
+    list_free(&b);
+}
+
+// =====================================================================================================================
+// list_shrink() - Shrink sparse lists
+// =====================================================================================================================
+
+static void list_shrink__for_sparse_list__should_shrink_to_quarter_threshold(void) {
+    LIST(int) lst = list(int, 1, 2, 3);
+    list_reserve(&lst, 64);
+
+    list_shrink(&lst);
+    CU_ASSERT_EQUAL(lst.capacity, 8); // 3 >= 8 / 4, 3 < 16 / 4
+    CU_ASSERT_EQUAL(list_get(&lst, 2), 3);
+    list_free(&lst);
+}
+
+static void list_shrink__for_empty_list__should_stop_at_min_capacity(void) {
+    LIST(int) lst = list(int);
+    list_reserve(&lst, 64);
+
+    list_shrink(&lst);
+    CU_ASSERT_EQUAL(lst.capacity, R_LIST_MIN_CAPACITY);
+    list_free(&lst);
+}
+
+static void list_remove__for_sparse_list__should_shrink_automatically(void) {
+    LIST(int) lst = list(int);
+    for (int i = 0; i < 64; i++) {
+        list_add(&lst, i);
+    }
+    const size_t full_capacity = lst.capacity;
+
+    while (lst.size > 1) {
+        list_remove(&lst, lst.size - 1);
+    }
+#ifdef RCFG__LIST_NO_AUTO_SHRINK
+    CU_ASSERT_EQUAL(lst.capacity, full_capacity);
+#else
+    CU_ASSERT(lst.capacity < full_capacity);
+    CU_ASSERT(lst.capacity >= R_LIST_MIN_CAPACITY);
+#endif
+    CU_ASSERT_EQUAL(list_get(&lst, 0), 0);
+    list_free(&lst);
+}
+
+// =====================================================================================================================
+// list_sort() / list_par_sort() - Sorting
+// =====================================================================================================================
+
+static int coll_test_int_desc(const int a, const int b) {
+    return (b > a) - (b < a);
+}
+
+static void list_sort__for_unsorted_ints__should_sort_ascending_and_keep_elements(void) {
+    LIST(int) lst = list(int);
+    int counts[100] = {0};
+    uint32_t x = 12345;
+    for (int i = 0; i < 5000; i++) {
+        x = x * 1103515245 + 12345;
+        const int v = (int)(x >> 16) % 100;
+        counts[v]++;
+        list_add(&lst, v);
+    }
+
+    list_sort(&lst);
+    size_t ordered = 0;
+    for (size_t i = 0; i < lst.size; i++) {
+        ordered += i == 0 || list_get(&lst, i - 1) <= list_get(&lst, i);
+        counts[list_get(&lst, i)]--;
+    }
+    CU_ASSERT_EQUAL(ordered, 5000);
+    size_t kept = 0;
+    for (int v = 0; v < 100; v++) {
+        kept += counts[v] == 0;
+    }
+    CU_ASSERT_EQUAL(kept, 100);
+    list_free(&lst);
+}
+
+static void list_sort__with_comparator__should_use_its_order(void) {
+    LIST(int) lst = list(int, 3, -7, 42, 0, 42, INT_MIN, INT_MAX, 5);
+    list_sort(&lst, coll_test_int_desc);
+    const int expected[] = {INT_MAX, 42, 42, 5, 3, 0, -7, INT_MIN};
+    for (size_t i = 0; i < 8; i++) {
+        CU_ASSERT_EQUAL(list_get(&lst, i), expected[i]);
+    }
+    list_free(&lst);
+}
+
+static void list_sort__for_patterned_inputs__should_sort_every_size(void) {
+    // Sorted, reversed, constant and organ-pipe inputs around the insertion sort cutoff and beyond
+    size_t sorted = 0;
+    size_t cases = 0;
+    for (size_t n = 0; n <= 300; n += n < 40 ? 1 : 37) {
+        for (int pattern = 0; pattern < 4; pattern++) {
+            LIST(int) lst = list(int);
+            for (size_t i = 0; i < n; i++) {
+                const int v = (int)i;
+                const int values[] = {v, (int)n - v, 7, v < (int)n / 2 ? v : (int)n - v};
+                list_add(&lst, values[pattern]);
+            }
+            list_sort(&lst);
+            bool ok = true;
+            for (size_t i = 1; i < lst.size; i++) {
+                ok = ok && list_get(&lst, i - 1) <= list_get(&lst, i);
+            }
+            sorted += ok;
+            cases++;
+            list_free(&lst);
+        }
+    }
+    CU_ASSERT_EQUAL(sorted, cases);
+}
+
+static void list_par_sort__for_large_list__should_match_list_sort(void) {
+    task_pool * pool = task_pool(&(task_opt){.workers = 4});
+    LIST(uint64_t) lst = list(uint64_t);
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < 200003; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        list_add(&lst, x % 50000); // plenty of duplicates
+    }
+    LIST(uint64_t) expected = list(uint64_t);
+    list_extend(&expected, &lst);
+
+    list_sort(&expected);
+    CU_ASSERT_TRUE(list_par_sort(uint64_t, &lst, pool));
+    CU_ASSERT_EQUAL(lst.size, expected.size);
+    CU_ASSERT_EQUAL(memcmp(lst.data, expected.data, lst.size * sizeof(uint64_t)), 0);
+    CU_ASSERT_FALSE(err_has());
+
+    list_free(&expected);
+    list_free(&lst);
+    task_pool_free(pool);
+}
+
+static void list_par_sort__when_a_task_fails__should_keep_every_element(void) {
+    task_pool * pool = task_pool(&(task_opt){.workers = 4});
+    LIST(uint32_t) input = list(uint32_t);
+    uint32_t x = 0x9E3779B9u;
+    for (size_t i = 0; i < 50000; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        list_add(&input, x % 1000);
+    }
+    LIST(uint32_t) expected = list(uint32_t);
+    list_extend(&expected, &input);
+    atomic_store(&coll_test_cmp_calls, 0);
+    CU_ASSERT_TRUE(list_par_sort(uint32_t, &expected, pool));
+    const size_t calls = atomic_load(&coll_test_cmp_calls);
+
+    // Fail at points spread over the chunk sorts and every merge round
+    size_t failed = 0;
+    for (size_t f = 1; f < 20; f++) {
+        LIST(uint32_t) lst = list(uint32_t);
+        list_extend(&lst, &input);
+        atomic_store(&coll_test_cmp_calls, 0);
+        coll_test_cmp_limit = calls * f / 20;
+        failed += !list_par_sort(uint32_t, &lst, pool) && err_code() == R_ERR_INVALID_ARGUMENT;
+        err_clear();
+        coll_test_cmp_limit = SIZE_MAX;
+        list_sort(&lst);
+        CU_ASSERT_EQUAL(memcmp(lst.data, expected.data, lst.size * sizeof(uint32_t)), 0);
+        list_free(&lst);
+    }
+    CU_ASSERT_EQUAL(failed, 19);
+
+    list_free(&expected);
+    list_free(&input);
+    task_pool_free(pool);
+}
+
+static void list_par_sort__for_short_list_or_null_pool__should_sort_inline_or_fail(void) {
+    task_pool * pool = task_pool(&(task_opt){.workers = 2});
+    LIST(uint64_t) lst = list(uint64_t, 9, 2, 7, 2, 0);
+    CU_ASSERT_TRUE(list_par_sort(uint64_t, &lst, pool));
+    const uint64_t expected[] = {0, 2, 2, 7, 9};
+    CU_ASSERT_EQUAL(memcmp(lst.data, expected, sizeof(expected)), 0);
+
+    CU_ASSERT_FALSE(list_par_sort(uint64_t, &lst, nullptr));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_NULL_POINTER);
+    err_clear();
+    list_free(&lst);
+    task_pool_free(pool);
+}
+
 // =====================================================================================================================
 // list_free() - Free list memory
 // =====================================================================================================================
@@ -447,6 +770,82 @@ static void lfq_resize__to_larger_capacity__should_grow_queue(void) {
     lfq_free(&q);
 }
 
+static void lfq_resize__for_wrapped_queue__should_keep_fifo_order(void) {
+    LFQ(int) q = lfq(int, 4, 1, 2, 3);
+    lfq_pop(&q);
+    lfq_pop(&q);
+    lfq_push(&q, 4);
+    lfq_push(&q, 5); // tail wrapped behind head
+
+    lfq_resize(&q, 8);
+    CU_ASSERT_EQUAL(q.mask, 7);
+    CU_ASSERT_EQUAL(lfq_depth(&q), 3);
+    for (int i = 3; i <= 5; i++) {
+        CU_ASSERT_EQUAL(lfq_pop(&q), i);
+    }
+    lfq_free(&q);
+}
+
+// =====================================================================================================================
+// lfq_push_n() / lfq_pop_n() - Batch push and pop
+// =====================================================================================================================
+
+static void lfq__for_power_of_two_capacity__should_wrap_with_mask(void) {
+    LFQ(int) q = lfq(int, 8);
+    CU_ASSERT_EQUAL(q.mask, 7);
+    for (int i = 1; i <= 20; i++) {
+        lfq_push(&q, i);
+        CU_ASSERT_EQUAL(lfq_pop(&q), i);
+    }
+    CU_ASSERT_TRUE(lfq_empty(&q));
+    lfq_free(&q);
+
+    LFQ(int) odd = lfq(int, 10);
+    CU_ASSERT_EQUAL(odd.mask, 0); // falls back to modulo
+    lfq_free(&odd);
+}
+
+static void lfq_push_n__across_wrap_point__should_keep_fifo_order(void) {
+    LFQ(int) q = lfq(int, 8, 0, 0, 0, 0, 0);
+    int scratch[8];
+    CU_ASSERT_EQUAL(lfq_pop_n(&q, scratch, 5), 5); // head and tail now at 5
+
+    const int items[] = {1, 2, 3, 4, 5, 6};
+    CU_ASSERT_EQUAL(lfq_push_n(&q, items, 6), 6); // slots 5..7 then 0..2
+    CU_ASSERT_EQUAL(lfq_depth(&q), 6);
+
+    int out[8] = {0};
+    CU_ASSERT_EQUAL(lfq_pop_n(&q, out, 8), 6);
+    for (int i = 0; i < 6; i++) {
+        CU_ASSERT_EQUAL(out[i], items[i]);
+    }
+    CU_ASSERT_TRUE(lfq_empty(&q));
+    lfq_free(&q);
+}
+
+static void lfq_push_n__when_nearly_full__should_push_what_fits(void) {
+    err_clear();
+    LFQ(int) q = lfq(int, 4); // max 3 items
+    const int items[] = {1, 2, 3, 4, 5};
+    CU_ASSERT_EQUAL(lfq_push_n(&q, items, 5), 3);
+    CU_ASSERT_FALSE(err_has());
+    CU_ASSERT_TRUE(lfq_full(&q));
+
+    CU_ASSERT_EQUAL(lfq_push_n(&q, items, 5), 0);
+    CU_ASSERT_EQUAL(err_code(), R_ERR_QUEUE_FULL);
+    err_clear();
+    lfq_free(&q);
+}
+
+static void lfq_pop_n__when_empty__should_set_error(void) {
+    LFQ(int) q = lfq(int, 4);
+    int out[4];
+    CU_ASSERT_EQUAL(lfq_pop_n(&q, out, 4), 0);
+    CU_ASSERT_EQUAL(err_code(), R_ERR_QUEUE_EMPTY);
+    err_clear();
+    lfq_free(&q);
+}
+
 // =====================================================================================================================
 // lfq_free() - Free queue memory
 // =====================================================================================================================
@@ -461,6 +860,267 @@ static void lfq_free__on_queue__should_deallocate_and_reset(void) {
     CU_ASSERT_EQUAL(q.capacity, 0);
 }
 
+// =====================================================================================================================
+// mpmc() / mpmc_push() / mpmc_pop() - Multi-producer / multi-consumer queue
+// =====================================================================================================================
+
+static void mpmc__for_capacity__should_round_up_to_power_of_two(void) {
+    MPMC(int) q = mpmc(int, 10);
+    CU_ASSERT_EQUAL(mpmc_capacity(&q), 16);
+    CU_ASSERT_TRUE(mpmc_empty(&q));
+    mpmc_free(&q);
+    CU_ASSERT_PTR_NULL(q.slots);
+}
+
+static void mpmc_push__until_full__should_fill_whole_capacity(void) {
+    MPMC(int) q = mpmc(int, 4);
+    for (int i = 1; i <= 4; i++) {
+        CU_ASSERT_EQUAL(mpmc_push(&q, i), i);
+    }
+    CU_ASSERT_FALSE(err_has());
+    CU_ASSERT_EQUAL(mpmc_depth(&q), 4);
+
+    CU_ASSERT_EQUAL(mpmc_push(&q, 5), 0);
+    CU_ASSERT_EQUAL(err_code(), R_ERR_QUEUE_FULL);
+    err_clear();
+    mpmc_free(&q);
+}
+
+static void mpmc_pop__after_wraparound__should_keep_fifo_order(void) {
+    MPMC(int) q = mpmc(int, 4, 1, 2, 3);
+    for (int i = 4; i < 100; i++) {
+        CU_ASSERT_EQUAL(mpmc_pop(&q), i - 3);
+        mpmc_push(&q, i);
+    }
+    CU_ASSERT_EQUAL(mpmc_depth(&q), 3);
+    mpmc_free(&q);
+}
+
+static void mpmc_pop__when_empty__should_set_error(void) {
+    MPMC(int) q = mpmc(int, 8);
+    CU_ASSERT_EQUAL(mpmc_pop(&q), 0);
+    CU_ASSERT_EQUAL(err_code(), R_ERR_QUEUE_EMPTY);
+    err_clear();
+    mpmc_free(&q);
+}
+
+// Concurrent producers push disjoint ranges; consumers pop until every item has been seen exactly once
+enum { MPMC_TEST_THREADS = 4, MPMC_TEST_ITEMS = 20000 };
+
+typedef struct {
+    MPMC(int) * q;
+    int id;
+    atomic_int * popped;
+    atomic_uchar * seen;
+} mpmc_test_ctx;
+
+static void * mpmc_test_producer(void * arg) {
+    const mpmc_test_ctx * ctx = arg;
+    for (int i = 0; i < MPMC_TEST_ITEMS; i++) {
+        const int item = ctx->id * MPMC_TEST_ITEMS + i + 1;
+        while (mpmc_push(ctx->q, item) == 0) {
+            err_clear();
+        }
+    }
+    return nullptr;
+}
+
+static void * mpmc_test_consumer(void * arg) {
+    const mpmc_test_ctx * ctx = arg;
+    while (atomic_load(ctx->popped) < MPMC_TEST_THREADS * MPMC_TEST_ITEMS) {
+        const int item = mpmc_pop(ctx->q);
+        if (item == 0) {
+            err_clear();
+            continue;
+        }
+        atomic_fetch_add(&ctx->seen[item - 1], 1);
+        atomic_fetch_add(ctx->popped, 1);
+    }
+    return nullptr;
+}
+
+static void mpmc__for_concurrent_producers_and_consumers__should_deliver_each_item_once(void) {
+    MPMC(int) q = mpmc(int, 256);
+    atomic_int popped = 0;
+    atomic_uchar * seen = calloc(MPMC_TEST_THREADS * MPMC_TEST_ITEMS, sizeof(atomic_uchar));
+    pthread_t producers[MPMC_TEST_THREADS];
+    pthread_t consumers[MPMC_TEST_THREADS];
+    mpmc_test_ctx ctx[MPMC_TEST_THREADS];
+
+    for (int t = 0; t < MPMC_TEST_THREADS; t++) {
+        ctx[t] = (mpmc_test_ctx){.q = &q, .id = t, .popped = &popped, .seen = seen};
+        pthread_create(&consumers[t], nullptr, mpmc_test_consumer, &ctx[t]);
+        pthread_create(&producers[t], nullptr, mpmc_test_producer, &ctx[t]);
+    }
+    for (int t = 0; t < MPMC_TEST_THREADS; t++) {
+        pthread_join(producers[t], nullptr);
+        pthread_join(consumers[t], nullptr);
+    }
+
+    bool exactly_once = true;
+    for (int i = 0; i < MPMC_TEST_THREADS * MPMC_TEST_ITEMS; i++) {
+        exactly_once = exactly_once && atomic_load(&seen[i]) == 1;
+    }
+    CU_ASSERT_TRUE(exactly_once);
+    CU_ASSERT_TRUE(mpmc_empty(&q));
+
+    free(seen);
+    mpmc_free(&q);
+}
+
+// =====================================================================================================================
+// lfq - Single producer / single consumer across threads
+// =====================================================================================================================
+
+static void * lfq_test_producer(void * arg) {
+    LFQ(int) * q = arg;
+    for (int i = 1; i <= MPMC_TEST_ITEMS; i++) {
+        while (lfq_push(q, i) == 0) {
+            err_clear();
+        }
+    }
+    return nullptr;
+}
+
+static void lfq__for_producer_and_consumer_threads__should_keep_fifo_order(void) {
+    LFQ(int) q = lfq(int, 64);
+    pthread_t producer;
+    pthread_create(&producer, nullptr, lfq_test_producer, &q);
+
+    bool in_order = true;
+    for (int expected = 1; expected <= MPMC_TEST_ITEMS;) {
+        const int item = lfq_pop(&q);
+        if (item == 0) {
+            err_clear();
+            continue;
+        }
+        in_order = in_order && item == expected;
+        expected++;
+    }
+    pthread_join(producer, nullptr);
+
+    CU_ASSERT_TRUE(in_order);
+    CU_ASSERT_TRUE(lfq_empty(&q));
+    lfq_free(&q);
+}
+
+// =====================================================================================================================
+// segq() / segq_push() / segq_pop() - Segmented queue
+// =====================================================================================================================
+
+static void segq__for_small_capacity__should_link_larger_rings_and_keep_fifo_order(void) {
+    SEGQ(int) q = segq(int, 3, 1, 2, 3);
+    CU_ASSERT_EQUAL(q.head->mask + 1, 4);
+    for (int i = 4; i <= 1000; i++) {
+        CU_ASSERT_TRUE(segq_push(&q, i));
+    }
+    // Rings double from 4, each with one slot free: 3 + 7 + ... + 255 = 501 items, the rest in a ring of 512
+    CU_ASSERT_PTR_NOT_EQUAL(q.head, q.tail);
+    CU_ASSERT_EQUAL(q.tail->mask + 1, 512);
+    CU_ASSERT_FALSE(segq_empty(&q));
+
+    bool in_order = true;
+    for (int i = 1; i <= 1000; i++) {
+        in_order = in_order && segq_pop(&q) == i;
+    }
+    CU_ASSERT_TRUE(in_order);
+    // Drained rings are freed as the consumer leaves them
+    CU_ASSERT_PTR_EQUAL(q.head, q.tail);
+    CU_ASSERT_TRUE(segq_empty(&q));
+    CU_ASSERT_FALSE(err_has());
+    segq_free(&q);
+    CU_ASSERT_PTR_NULL(q.head);
+}
+
+static void segq_pop__when_empty__should_set_error(void) {
+    SEGQ(int) q = segq(int, 8);
+    CU_ASSERT_EQUAL(segq_pop(&q), 0);
+    CU_ASSERT_EQUAL(err_code(), R_ERR_QUEUE_EMPTY);
+    err_clear();
+    // Same after a grow and a full drain
+    for (int i = 1; i <= 20; i++) {
+        segq_push(&q, i);
+    }
+    for (int i = 1; i <= 20; i++) {
+        segq_pop(&q);
+    }
+    CU_ASSERT_EQUAL(segq_pop(&q), 0);
+    CU_ASSERT_EQUAL(err_code(), R_ERR_QUEUE_EMPTY);
+    err_clear();
+    segq_free(&q);
+}
+
+static void * segq_test_fail_alloc(void * ctx, const size_t size) {
+    (void)ctx;
+    (void)size;
+    return nullptr;
+}
+
+static void segq__when_first_ring_allocation_fails__should_refuse_push_and_read_empty(void) {
+    const allocator failing = {.alloc = segq_test_fail_alloc};
+    SEGQ(int) q;
+    alloc_scope(failing) {
+        q = segq(int, 4);
+    }
+    CU_ASSERT_PTR_NULL(q.tail);
+    CU_ASSERT_EQUAL(err_code(), R_ERR_ALLOC_FAILED);
+    err_clear();
+    CU_ASSERT_FALSE(segq_push(&q, 1));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_ALLOC_FAILED);
+    err_clear();
+    CU_ASSERT_TRUE(segq_empty(&q));
+    CU_ASSERT_EQUAL(segq_pop(&q), 0);
+    CU_ASSERT_EQUAL(err_code(), R_ERR_QUEUE_EMPTY);
+    err_clear();
+    segq_free(&q);
+}
+
+static void segq_push__after_alloc_pop__should_grow_from_creation_allocator(void) {
+    arena a = arena();
+    alloc_push(arena_allocator(&a));
+    SEGQ(int) q = segq(int, 2);
+    alloc_pop();
+    const size_t used = arena_used(&a);
+    for (int i = 1; i <= 100; i++) {
+        segq_push(&q, i);
+    }
+    CU_ASSERT(arena_used(&a) > used);
+    CU_ASSERT_EQUAL(segq_pop(&q), 1);
+    segq_free(&q);
+    arena_free(&a);
+}
+
+static void * segq_test_producer(void * arg) {
+    SEGQ(int) * q = arg;
+    for (int i = 1; i <= MPMC_TEST_ITEMS; i++) {
+        segq_push(q, i);
+    }
+    return nullptr;
+}
+
+static void segq__for_producer_and_consumer_threads__should_keep_fifo_order(void) {
+    // A tiny first ring, so the producer links new rings while the consumer drains and frees old ones
+    SEGQ(int) q = segq(int, 2);
+    pthread_t producer;
+    pthread_create(&producer, nullptr, segq_test_producer, &q);
+
+    bool in_order = true;
+    for (int expected = 1; expected <= MPMC_TEST_ITEMS;) {
+        const int item = segq_pop(&q);
+        if (item == 0) {
+            err_clear();
+            continue;
+        }
+        in_order = in_order && item == expected;
+        expected++;
+    }
+    pthread_join(producer, nullptr);
+
+    CU_ASSERT_TRUE(in_order);
+    CU_ASSERT_TRUE(segq_empty(&q));
+    segq_free(&q);
+}
+
 // =====================================================================================================================
 // COMPLEX TYPE TESTS
 // =====================================================================================================================
@@ -625,6 +1285,51 @@ int main(void) {
     }
     ADD_TEST(suite_list_grow, list_grow__on_empty_list__should_allocate_initial_capacity);
     ADD_TEST(suite_list_grow, list_grow__when_full__should_double_capacity);
+    ADD_TEST(suite_list_grow, list_grow__with_free_slot__should_keep_capacity);
+    ADD_TEST(suite_list_grow, list_grown_capacity__for_needed_count__should_apply_growth_factor);
+
+    // list_reserve() suite
+    CU_pSuite suite_list_reserve = CU_add_suite("list_reserve()", nullptr, nullptr);
+    if (suite_list_reserve == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_list_reserve, list_reserve__on_empty_list__should_allocate_exact_capacity);
+    ADD_TEST(suite_list_reserve, list_reserve__for_smaller_count__should_keep_capacity);
+
+    // list_add_n() / list_extend() suite
+    CU_pSuite suite_list_add_n = CU_add_suite("list_add_n() / list_extend()", nullptr, nullptr);
+    if (suite_list_add_n == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_list_add_n, list_add_n__for_array__should_append_in_order);
+    ADD_TEST(suite_list_add_n, list_add_n__for_zero_items__should_not_allocate);
+    ADD_TEST(suite_list_add_n, list_add_n__for_items_of_same_list__should_copy_before_buffer_moves);
+    ADD_TEST(suite_list_add_n, list_extend__for_other_list__should_append_all);
+
+    // list_shrink() suite
+    CU_pSuite suite_list_shrink = CU_add_suite("list_shrink()", nullptr, nullptr);
+    if (suite_list_shrink == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_list_shrink, list_shrink__for_sparse_list__should_shrink_to_quarter_threshold);
+    ADD_TEST(suite_list_shrink, list_shrink__for_empty_list__should_stop_at_min_capacity);
+    ADD_TEST(suite_list_shrink, list_remove__for_sparse_list__should_shrink_automatically);
+
+    // list_sort() / list_par_sort() suite
+    CU_pSuite suite_list_sort = CU_add_suite("list_sort() / list_par_sort()", nullptr, nullptr);
+    if (suite_list_sort == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_list_sort, list_sort__for_unsorted_ints__should_sort_ascending_and_keep_elements);
+    ADD_TEST(suite_list_sort, list_sort__with_comparator__should_use_its_order);
+    ADD_TEST(suite_list_sort, list_sort__for_patterned_inputs__should_sort_every_size);
+    ADD_TEST(suite_list_sort, list_par_sort__for_large_list__should_match_list_sort);
+    ADD_TEST(suite_list_sort, list_par_sort__when_a_task_fails__should_keep_every_element);
+    ADD_TEST(suite_list_sort, list_par_sort__for_short_list_or_null_pool__should_sort_inline_or_fail);
 
     // list_free() suite
     CU_pSuite suite_list_free = CU_add_suite("list_free()", nullptr, nullptr);
@@ -692,6 +1397,18 @@ int main(void) {
         return CU_get_error();
     }
     ADD_TEST(suite_lfq_resize, lfq_resize__to_larger_capacity__should_grow_queue);
+    ADD_TEST(suite_lfq_resize, lfq_resize__for_wrapped_queue__should_keep_fifo_order);
+
+    // lfq_push_n() / lfq_pop_n() suite
+    CU_pSuite suite_lfq_batch = CU_add_suite("lfq_push_n() / lfq_pop_n()", nullptr, nullptr);
+    if (suite_lfq_batch == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_lfq_batch, lfq__for_power_of_two_capacity__should_wrap_with_mask);
+    ADD_TEST(suite_lfq_batch, lfq_push_n__across_wrap_point__should_keep_fifo_order);
+    ADD_TEST(suite_lfq_batch, lfq_push_n__when_nearly_full__should_push_what_fits);
+    ADD_TEST(suite_lfq_batch, lfq_pop_n__when_empty__should_set_error);
 
     // lfq_free() suite
     CU_pSuite suite_lfq_free = CU_add_suite("lfq_free()", nullptr, nullptr);
@@ -700,6 +1417,31 @@ int main(void) {
         return CU_get_error();
     }
     ADD_TEST(suite_lfq_free, lfq_free__on_queue__should_deallocate_and_reset);
+    ADD_TEST(suite_lfq_free, lfq__for_producer_and_consumer_threads__should_keep_fifo_order);
+
+    // segq() suite
+    CU_pSuite suite_segq = CU_add_suite("segq()", nullptr, nullptr);
+    if (suite_segq == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_segq, segq__for_small_capacity__should_link_larger_rings_and_keep_fifo_order);
+    ADD_TEST(suite_segq, segq_pop__when_empty__should_set_error);
+    ADD_TEST(suite_segq, segq__when_first_ring_allocation_fails__should_refuse_push_and_read_empty);
+    ADD_TEST(suite_segq, segq_push__after_alloc_pop__should_grow_from_creation_allocator);
+    ADD_TEST(suite_segq, segq__for_producer_and_consumer_threads__should_keep_fifo_order);
+
+    // mpmc() suite
+    CU_pSuite suite_mpmc = CU_add_suite("mpmc()", nullptr, nullptr);
+    if (suite_mpmc == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_mpmc, mpmc__for_capacity__should_round_up_to_power_of_two);
+    ADD_TEST(suite_mpmc, mpmc_push__until_full__should_fill_whole_capacity);
+    ADD_TEST(suite_mpmc, mpmc_pop__after_wraparound__should_keep_fifo_order);
+    ADD_TEST(suite_mpmc, mpmc_pop__when_empty__should_set_error);
+    ADD_TEST(suite_mpmc, mpmc__for_concurrent_producers_and_consumers__should_deliver_each_item_once);
 
     // Stress tests suite
     CU_pSuite suite_stress = CU_add_suite("Stress tests", nullptr, nullptr);
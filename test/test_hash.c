@@ -1207,6 +1207,265 @@ static void xxhash64_and_murmur64__should_be_deterministic_independently() {
     CU_ASSERT_EQUAL(hmur1, hmur2);
 }
 
+// =====================================================================================================================
+// Reference vectors - published digests for the one-shot functions
+// =====================================================================================================================
+
+static void xxhash64__for_reference_inputs__should_match_published_digests() {
+    // Arrange
+    const char * long_input = "Nobody inspects the spammish repetition"; // 39 bytes: one stripe plus a tail
+
+    // Act & Assert
+    CU_ASSERT_EQUAL(xxhash64("", 0, 0), 0xEF46DB3751D8E999ULL);
+    CU_ASSERT_EQUAL(xxhash64("abc", 3, 0), 0x44BC2CF5AD770999ULL);
+    CU_ASSERT_EQUAL(xxhash64(long_input, strlen(long_input), 0), 0xFBCEA83C8A378BF1ULL);
+}
+
+static void murmur128__for_reference_inputs__should_match_published_digests() {
+    // Arrange
+    const char * fox = "The quick brown fox jumps over the lazy dog";
+
+    // Act
+    const hash128_t h_hello = murmur128(HELLO, HELLO_LEN, 0);
+    const hash128_t h_fox = murmur128(fox, strlen(fox), 0);
+
+    // Assert
+    CU_ASSERT_EQUAL(h_hello.h1, 0xCBD8A7B341BD9B02ULL);
+    CU_ASSERT_EQUAL(h_hello.h2, 0x5B1E906A48AE1D19ULL);
+    CU_ASSERT_EQUAL(h_fox.h1, 0xE34BBC7BBC071B6CULL);
+    CU_ASSERT_EQUAL(h_fox.h2, 0x7A433CA9C49A9347ULL);
+}
+
+// =====================================================================================================================
+// Streaming tests - init/update/final
+// =====================================================================================================================
+
+// Deterministic test buffer
+static uint8_t * stream_test_data(const size_t size) {
+    uint8_t * data = malloc(size);
+    uint32_t x = 2463534242u;
+    for (size_t i = 0; i < size; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        data[i] = (uint8_t)x;
+    }
+    return data;
+}
+
+static void xxhash64_stream__for_any_chunking__should_equal_one_shot() {
+    // Arrange - sizes around the 32-byte stripe, chunk sizes that straddle it
+    static const size_t sizes[] = {0, 1, 31, 32, 33, 63, 64, 100, 1000, 4099};
+    static const size_t chunks[] = {1, 3, 16, 31, 32, 33, 500};
+    uint8_t * data = stream_test_data(4099);
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        const uint64_t expected = xxhash64(data, sizes[s], 7);
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+            // Act
+            xxhash64_state st;
+            xxhash64_init(&st, 7);
+            for (size_t off = 0; off < sizes[s]; off += chunks[c]) {
+                const size_t n = sizes[s] - off < chunks[c] ? sizes[s] - off : chunks[c];
+                xxhash64_update(&st, data + off, n);
+            }
+
+            // Assert
+            CU_ASSERT_EQUAL(xxhash64_final(&st), expected);
+        }
+    }
+    free(data);
+}
+
+static void xxhash64_stream__for_final_mid_stream__should_not_disturb_state() {
+    // Arrange
+    uint8_t * data = stream_test_data(200);
+    xxhash64_state st;
+    xxhash64_init(&st, 0);
+
+    // Act
+    xxhash64_update(&st, data, 70);
+    const uint64_t partial = xxhash64_final(&st);
+    xxhash64_update(&st, data + 70, 130);
+
+    // Assert
+    CU_ASSERT_EQUAL(partial, xxhash64(data, 70, 0));
+    CU_ASSERT_EQUAL(xxhash64_final(&st), xxhash64(data, 200, 0));
+    free(data);
+}
+
+static void xxhash64_stream__for_64k_reads__should_equal_one_shot() {
+    // Arrange - a multi-megabyte blob arriving in 64 KB reads
+    const size_t size = (size_t)3 << 20;
+    const size_t read_size = (size_t)64 << 10;
+    uint8_t * data = stream_test_data(size);
+
+    // Act
+    xxhash64_state st;
+    xxhash64_init(&st, R_HASH_DEFAULT_SEED);
+    for (size_t off = 0; off < size; off += read_size) {
+        xxhash64_update(&st, data + off, read_size);
+    }
+
+    // Assert
+    CU_ASSERT_EQUAL(xxhash64_final(&st), hash64(data, size));
+    free(data);
+}
+
+static void murmur128_stream__for_any_chunking__should_equal_one_shot() {
+    // Arrange - sizes around the 16-byte block, chunk sizes that straddle it
+    static const size_t sizes[] = {0, 1, 15, 16, 17, 31, 32, 100, 1000, 4099};
+    static const size_t chunks[] = {1, 5, 15, 16, 17, 250};
+    uint8_t * data = stream_test_data(4099);
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        const hash128_t expected = murmur128(data, sizes[s], 99);
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+            // Act
+            murmur128_state st;
+            murmur128_init(&st, 99);
+            for (size_t off = 0; off < sizes[s]; off += chunks[c]) {
+                const size_t n = sizes[s] - off < chunks[c] ? sizes[s] - off : chunks[c];
+                murmur128_update(&st, data + off, n);
+            }
+
+            // Assert
+            CU_ASSERT_TRUE(hash128_eq(murmur128_final(&st), expected));
+        }
+    }
+    free(data);
+}
+
+// =====================================================================================================================
+// Batch tests - hash64_batch / hash_mix_batch
+// =====================================================================================================================
+
+static void hash64_batch__for_mixed_lengths__should_equal_hash64_per_key() {
+    // Arrange - counts around the 4-key unroll, lengths below and above one xxHash64 stripe
+    uint8_t * data = stream_test_data(64 * 40);
+    const void * keys[40];
+    size_t lens[40];
+    uint64_t out[40];
+    for (size_t i = 0; i < 40; i++) {
+        keys[i] = data + 64 * i;
+        lens[i] = i < 24 ? i % 17 : i % 3 * 20 + 5;
+    }
+
+    for (size_t n = 0; n <= 40; n++) {
+        // Act
+        hash64_batch(keys, lens, n, out);
+
+        // Assert
+        for (size_t i = 0; i < n; i++) {
+            CU_ASSERT_EQUAL(out[i], hash64(keys[i], lens[i]));
+        }
+    }
+    free(data);
+}
+
+static void hash_mix_batch__for_any_count__should_equal_hash_mix_per_key() {
+    // Arrange - counts around the 4- and 8-lane widths
+    uint64_t keys[37];
+    uint64_t out[37];
+    for (size_t i = 0; i < 37; i++) {
+        keys[i] = i * 0x9E3779B97F4A7C15ULL + (i << 40);
+    }
+
+    for (size_t n = 0; n <= 37; n++) {
+        // Act
+        hash_mix_batch(keys, n, out);
+
+        // Assert
+        for (size_t i = 0; i < n; i++) {
+            CU_ASSERT_EQUAL(out[i], hash_mix(keys[i]));
+        }
+    }
+}
+
+static void hash_mix_batch__for_in_place_output__should_hash_keys() {
+    // Arrange
+    uint64_t keys[19];
+    uint64_t expected[19];
+    for (size_t i = 0; i < 19; i++) {
+        keys[i] = UINT64_MAX - i;
+        expected[i] = hash_mix(keys[i]);
+    }
+
+    // Act
+    hash_mix_batch(keys, 19, keys);
+
+    // Assert
+    for (size_t i = 0; i < 19; i++) {
+        CU_ASSERT_EQUAL(keys[i], expected[i]);
+    }
+}
+
+// =====================================================================================================================
+// crc32c / crchash64 tests
+// =====================================================================================================================
+
+static void crc32c__for_check_string__should_match_standard_value() {
+    // Arrange - the CRC-32C "check" value
+    const char * data = "123456789";
+
+    // Act & Assert
+    CU_ASSERT_EQUAL(crc32c(data, 9, 0), 0xE3069283u);
+    CU_ASSERT_EQUAL(crc32c(data, 0, 0), 0u);
+}
+
+static void crc32c__for_chained_chunks__should_equal_single_call() {
+    // Arrange
+    uint8_t * data = stream_test_data(1000);
+
+    // Act
+    uint32_t crc = 0;
+    for (size_t off = 0; off < 1000; off += 37) {
+        crc = crc32c(data + off, 1000 - off < 37 ? 1000 - off : 37, crc);
+    }
+
+    // Assert
+    CU_ASSERT_EQUAL(crc, crc32c(data, 1000, 0));
+    free(data);
+}
+
+static void crchash64__for_pinned_inputs__should_match_on_every_platform() {
+    // Arrange - digests are the same with SSE4.2, ARMv8 CRC or the portable table
+    const char * fox = "The quick brown fox jumps over the lazy dog";
+
+    // Act & Assert
+    CU_ASSERT_EQUAL(crchash64("", 0, 0), 0x70E5E91EC8D7B13FULL);
+    CU_ASSERT_EQUAL(crchash64("a", 1, 0), 0x2F92605605F720F8ULL);
+    CU_ASSERT_EQUAL(crchash64(HELLO, HELLO_LEN, 0), 0xD693137F61E7F0B2ULL);
+    CU_ASSERT_EQUAL(crchash64(TEST_DATA_16, 16, 0), 0x548613969153C5F2ULL);
+    CU_ASSERT_EQUAL(crchash64(fox, strlen(fox), 0), 0xDA7CA04ABDD83E6FULL);
+    CU_ASSERT_EQUAL(crchash64(HELLO, HELLO_LEN, 42), 0x84F12C90533736F6ULL);
+}
+
+static void crchash64__for_trailing_zero_byte__should_differ() {
+    // Arrange
+    const char data[2] = {'a', '\0'};
+
+    // Act & Assert - the zero-padded tail word is the same, the length is not
+    CU_ASSERT_NOT_EQUAL(crchash64(data, 1, 0), crchash64(data, 2, 0));
+}
+
+static void crchash64__for_sequential_keys__should_fill_buckets_evenly() {
+    // Arrange - 16-byte keys differing in one counter word
+    size_t buckets[64] = {0};
+    uint64_t key[2] = {0, 0x0123456789ABCDEFULL};
+
+    // Act
+    for (uint64_t i = 0; i < 64 * 256; i++) {
+        key[0] = i;
+        buckets[crchash64(key, sizeof(key), 0) & 63]++;
+    }
+
+    // Assert - each bucket expects 256
+    for (size_t b = 0; b < 64; b++) {
+        CU_ASSERT(buckets[b] > 128 && buckets[b] < 384);
+    }
+}
+
 // =====================================================================================================================
 // Test suite registration
 // =====================================================================================================================
@@ -1374,6 +1633,41 @@ int main() {
     ADD_TEST(suite_xxhash64, xxhash64__for_sequential_keys__should_produce__varied_hashes);
     ADD_TEST(suite_xxhash64, xxhash64__should_differ_from_murmur64__for_same_input);
     ADD_TEST(suite_xxhash64, xxhash64_and_murmur64__should_be_deterministic_independently);
+    ADD_TEST(suite_xxhash64, xxhash64__for_reference_inputs__should_match_published_digests);
+    ADD_TEST(suite_xxhash64, murmur128__for_reference_inputs__should_match_published_digests);
+
+    // Streaming suite
+    CU_pSuite suite_stream = CU_add_suite("xxhash64/murmur128 streaming", nullptr, nullptr);
+    if (suite_stream == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_stream, xxhash64_stream__for_any_chunking__should_equal_one_shot);
+    ADD_TEST(suite_stream, xxhash64_stream__for_final_mid_stream__should_not_disturb_state);
+    ADD_TEST(suite_stream, xxhash64_stream__for_64k_reads__should_equal_one_shot);
+    ADD_TEST(suite_stream, murmur128_stream__for_any_chunking__should_equal_one_shot);
+
+    // Batch suite
+    CU_pSuite suite_batch = CU_add_suite("hash64_batch()/hash_mix_batch()", nullptr, nullptr);
+    if (suite_batch == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_batch, hash64_batch__for_mixed_lengths__should_equal_hash64_per_key);
+    ADD_TEST(suite_batch, hash_mix_batch__for_any_count__should_equal_hash_mix_per_key);
+    ADD_TEST(suite_batch, hash_mix_batch__for_in_place_output__should_hash_keys);
+
+    // crc32c()/crchash64() suite
+    CU_pSuite suite_crc = CU_add_suite("crc32c()/crchash64()", nullptr, nullptr);
+    if (suite_crc == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_crc, crc32c__for_check_string__should_match_standard_value);
+    ADD_TEST(suite_crc, crc32c__for_chained_chunks__should_equal_single_call);
+    ADD_TEST(suite_crc, crchash64__for_pinned_inputs__should_match_on_every_platform);
+    ADD_TEST(suite_crc, crchash64__for_trailing_zero_byte__should_differ);
+    ADD_TEST(suite_crc, crchash64__for_sequential_keys__should_fill_buckets_evenly);
 
     CU_basic_set_mode(CU_BRM_VERBOSE);
     CU_basic_run_tests();
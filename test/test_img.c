@@ -0,0 +1,598 @@
+/*
+ * img tests.
+ */
+
+// ReSharper disable CppDFATimeOver
+#include "../src/img.h"
+#include "../src/map.h"
+#include "../src/tree.h"
+#include "CUnit/Basic.h"
+#include "test.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define T int
+#include "../src/coll.h"
+#undef T
+
+#define T int
+#include "../src/tree.h"
+#undef T
+
+#define K int
+#define V int
+#include "../src/map.h"
+#undef K
+#undef V
+
+#define K img_ref
+#define V int
+#include "../src/map.h"
+#undef K
+#undef V
+
+// Element with a string stored by reference
+typedef struct {
+    img_ref name;
+    int age;
+} img_test_user;
+
+#define T img_test_user
+#include "../src/coll.h"
+#undef T
+
+static const char * IMG_TEST_PATH = "test_img.img";
+
+// Image bytes in an R_IMG_ALIGN-aligned buffer (free with img_test_free)
+typedef struct {
+    uint8_t * data;
+    size_t size;
+} img_test_buf;
+
+static img_test_buf img_test_write(const img_writer * w) {
+    FILE * f = tmpfile();
+    CU_ASSERT_PTR_NOT_NULL(f);
+    CU_ASSERT_TRUE(img_write(w, f));
+    const size_t size = (size_t)ftell(f);
+    rewind(f);
+    img_test_buf buf = {.data = aligned_alloc(R_IMG_ALIGN, R_IMG_ALIGN_UP(size)), .size = size};
+    CU_ASSERT_EQUAL(fread(buf.data, 1, size, f), size);
+    fclose(f);
+    return buf;
+}
+
+static void img_test_free(const img_test_buf buf) {
+    free(buf.data);
+}
+
+// =====================================================================================================================
+// img_add_list() / img_list() - List sections
+// =====================================================================================================================
+
+static void img_list__after_open__should_return_elements_and_strings(void) {
+    img_writer * w = img_writer_new();
+    CU_ASSERT_PTR_NOT_NULL(w);
+    LIST(img_test_user) users = {0};
+    list_add(&users, ((img_test_user){.name = img_add_str(w, "alice"), .age = 31}));
+    list_add(&users, ((img_test_user){.name = img_add_str(w, "bob"), .age = 27}));
+    CU_ASSERT_TRUE(img_add_list(w, "users", &users));
+
+    FILE * f = open_file_secure(IMG_TEST_PATH, "wb");
+    CU_ASSERT_PTR_NOT_NULL(f);
+    CU_ASSERT_TRUE(img_write(w, f));
+    fclose(f);
+    img_writer_free(w);
+    list_free(&users);
+
+    img * im = img_open(IMG_TEST_PATH);
+    CU_ASSERT_PTR_NOT_NULL(im);
+    CU_ASSERT_TRUE(img_verify(im));
+    size_t n = 0;
+    const img_test_user * got = img_list(img_test_user, im, "users", &n);
+    CU_ASSERT_EQUAL(n, 2);
+    CU_ASSERT_STRING_EQUAL(img_str(im, got[0].name), "alice");
+    CU_ASSERT_EQUAL(got[0].age, 31);
+    CU_ASSERT_STRING_EQUAL(img_str(im, got[1].name), "bob");
+    CU_ASSERT_EQUAL(got[1].age, 27);
+
+    // Placed strings answer str_len and str_hash from their header
+    const char * bob = img_str(im, got[1].name);
+    CU_ASSERT_TRUE(str_is(bob));
+    CU_ASSERT_EQUAL(str_len(bob), 3);
+    CU_ASSERT_EQUAL(str_hash(bob), str_hash(str_view("bob")));
+    // ... and str_utf8_valid, without writing to the read-only mapping
+    CU_ASSERT_TRUE(str_utf8_valid(bob));
+    CU_ASSERT_EQUAL(str_utf8_len(bob), 3);
+    img_close(im);
+    remove(IMG_TEST_PATH);
+    CU_ASSERT_FALSE(err_has());
+}
+
+static void img_list__for_missing_or_mismatched_section__should_fail(void) {
+    img_writer * w = img_writer_new();
+    LIST(int) lst = {0};
+    list_add(&lst, 1);
+    CU_ASSERT_TRUE(img_add_list(w, "ints", &lst));
+    const img_test_buf buf = img_test_write(w);
+    img_writer_free(w);
+    list_free(&lst);
+
+    img * im = img_from(buf.data, buf.size);
+    CU_ASSERT_PTR_NOT_NULL(im);
+    size_t n = 7;
+    CU_ASSERT_PTR_NULL(img_list(int, im, "missing", &n));
+    CU_ASSERT_EQUAL(n, 0);
+    CU_ASSERT_EQUAL(err_code(), R_ERR_NOT_FOUND);
+    err_clear();
+    CU_ASSERT_PTR_NULL(img_list(int64_t, im, "ints", &n));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_INVALID_ARGUMENT);
+    err_clear();
+    CU_ASSERT_PTR_NULL(img_tree(int, im, "ints", &n));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_INVALID_ARGUMENT);
+    err_clear();
+    img_close(im);
+    img_test_free(buf);
+}
+
+// =====================================================================================================================
+// img_add_rbt() / img_add_btree() / img_tree() - Ordered sections
+// =====================================================================================================================
+
+static void img_tree__from_rbt__should_be_sorted_and_searchable(void) {
+    RBT(int) t = rbt(int);
+    for (int i = 0; i < 1000; i++)
+        rbt_insert(&t, (i * 7919) % 1000 * 2);
+
+    img_writer * w = img_writer_new();
+    CU_ASSERT_TRUE(img_add_rbt(w, "evens", &t));
+    const img_test_buf buf = img_test_write(w);
+    img_writer_free(w);
+    rbt_free(&t);
+
+    img * im = img_from(buf.data, buf.size);
+    CU_ASSERT_PTR_NOT_NULL(im);
+    size_t n = 0;
+    const int * keys = img_tree(int, im, "evens", &n);
+    CU_ASSERT_EQUAL(n, 1000);
+    for (size_t i = 0; i < n; i++)
+        CU_ASSERT_EQUAL(keys[i], (int)i * 2);
+
+    const int * found = img_find(keys, n, 642);
+    CU_ASSERT_PTR_NOT_NULL(found);
+    CU_ASSERT_EQUAL(*found, 642);
+    CU_ASSERT_PTR_NULL(img_find(keys, n, 643));
+    CU_ASSERT_EQUAL(img_lower_bound(keys, n, 643), 322);
+    CU_ASSERT_EQUAL(img_lower_bound(keys, n, -1), 0);
+    CU_ASSERT_EQUAL(img_lower_bound(keys, n, 5000), n);
+    img_close(im);
+    img_test_free(buf);
+}
+
+static int img_test_cmp_desc(const int a, const int b) {
+    return (a < b) - (a > b);
+}
+
+static void img_tree__from_btree__should_be_sorted(void) {
+    BTREE(int) t = btree(int);
+    for (int i = 0; i < 20000; i++)
+        btree_insert(&t, i * 7919 % 20000);
+
+    img_writer * w = img_writer_new();
+    CU_ASSERT_TRUE(img_add_btree(w, "keys", &t));
+    const img_test_buf buf = img_test_write(w);
+    img_writer_free(w);
+    btree_free(&t);
+
+    img * im = img_from(buf.data, buf.size);
+    CU_ASSERT_PTR_NOT_NULL(im);
+    size_t n = 0;
+    const int * keys = img_tree(int, im, "keys", &n);
+    CU_ASSERT_EQUAL(n, 20000);
+    size_t misplaced = 0;
+    for (size_t i = 0; i < n; i++)
+        misplaced += keys[i] != (int)i;
+    CU_ASSERT_EQUAL(misplaced, 0);
+    img_close(im);
+    img_test_free(buf);
+}
+
+static void img_find__with_custom_comparator__should_follow_its_order(void) {
+    RBT(int) t = rbt(int);
+    for (int i = 0; i < 10; i++)
+        rbt_insert(&t, i, img_test_cmp_desc);
+
+    img_writer * w = img_writer_new();
+    CU_ASSERT_TRUE(img_add_rbt(w, "desc", &t));
+    const img_test_buf buf = img_test_write(w);
+    img_writer_free(w);
+    rbt_free(&t);
+
+    img * im = img_from(buf.data, buf.size);
+    size_t n = 0;
+    const int * keys = img_tree(int, im, "desc", &n);
+    CU_ASSERT_EQUAL(n, 10);
+    CU_ASSERT_EQUAL(keys[0], 9);
+    CU_ASSERT_EQUAL(keys[9], 0);
+    const int * found = img_find(keys, n, 3, img_test_cmp_desc);
+    CU_ASSERT_PTR_EQUAL(found, &keys[6]);
+    img_close(im);
+    img_test_free(buf);
+}
+
+static void img_tree__from_empty_trees__should_be_empty(void) {
+    RBT(int) r = rbt(int);
+    BTREE(int) b = btree(int);
+    img_writer * w = img_writer_new();
+    CU_ASSERT_TRUE(img_add_rbt(w, "rbt", &r));
+    CU_ASSERT_TRUE(img_add_btree(w, "btree", &b));
+    const img_test_buf buf = img_test_write(w);
+    img_writer_free(w);
+
+    img * im = img_from(buf.data, buf.size);
+    size_t n = 1;
+    CU_ASSERT_PTR_NOT_NULL(img_tree(int, im, "rbt", &n));
+    CU_ASSERT_EQUAL(n, 0);
+    n = 1;
+    CU_ASSERT_PTR_NOT_NULL(img_tree(int, im, "btree", &n));
+    CU_ASSERT_EQUAL(n, 0);
+    CU_ASSERT_EQUAL(img_lower_bound((const int *)nullptr, 0, 5), 0);
+    img_close(im);
+    img_test_free(buf);
+    CU_ASSERT_FALSE(err_has());
+}
+
+// =====================================================================================================================
+// img_add_map() / img_map() - Map sections
+// =====================================================================================================================
+
+static void img_map__with_tombstones__should_answer_like_the_original(void) {
+    MAP(int, int) m = map(int, int);
+    for (int i = 0; i < 5000; i++)
+        map_put(&m, i, i * 3);
+    for (int i = 0; i < 5000; i += 3)
+        map_remove(&m, i);
+
+    img_writer * w = img_writer_new();
+    CU_ASSERT_TRUE(img_add_map(w, "triple", &m));
+    const img_test_buf buf = img_test_write(w);
+    img_writer_free(w);
+
+    img * im = img_from(buf.data, buf.size);
+    CU_ASSERT_PTR_NOT_NULL(im);
+    MAP(int, int) loaded = img_map(int, int, im, "triple");
+    CU_ASSERT_EQUAL(map_size(&loaded), map_size(&m));
+    size_t wrong = 0;
+    for (int i = -10; i < 5010; i++) {
+        const int * want = map_get(&m, i);
+        const int * got = map_get(&loaded, i);
+        wrong += want == nullptr ? got != nullptr : got == nullptr || *got != *want;
+    }
+    CU_ASSERT_EQUAL(wrong, 0);
+    size_t seen = 0;
+    map_foreach(&loaded, entry) {
+        seen++;
+        CU_ASSERT_EQUAL(entry->val, entry->key * 3);
+    }
+    CU_ASSERT_EQUAL(seen, map_size(&m));
+    img_close(im);
+    img_test_free(buf);
+    map_free(&m);
+}
+
+static void img_map__with_string_refs__should_find_by_string(void) {
+    img_writer * w = img_writer_new();
+    MAP(img_ref, int) m = map(img_ref, int);
+    char name[32];
+    for (int i = 0; i < 300; i++) {
+        snprintf(name, sizeof(name), "name-%d", i);
+        map_put(&m, img_add_str(w, name), i);
+    }
+    CU_ASSERT_TRUE(img_add_map(w, "ids", &m));
+    const img_test_buf buf = img_test_write(w);
+    img_writer_free(w);
+    map_free(&m);
+
+    img * im = img_from(buf.data, buf.size);
+    CU_ASSERT_PTR_NOT_NULL(im);
+    MAP(img_ref, int) ids = img_map(img_ref, int, im, "ids");
+    for (int i = 0; i < 300; i++) {
+        snprintf(name, sizeof(name), "name-%d", i);
+        const img_ref ref = img_str_find(im, name);
+        CU_ASSERT_NOT_EQUAL(ref, 0);
+        CU_ASSERT_STRING_EQUAL(img_str(im, ref), name);
+        const int * id = map_get(&ids, ref);
+        CU_ASSERT_PTR_NOT_NULL(id);
+        CU_ASSERT_EQUAL(*id, i);
+    }
+    CU_ASSERT_EQUAL(img_str_find(im, "name-300"), 0);
+    CU_ASSERT_EQUAL(img_str_find(im, str_view("name-7")), img_str_find(im, "name-7"));
+    img_close(im);
+    img_test_free(buf);
+}
+
+static void img_map__for_empty_map__should_be_empty(void) {
+    MAP(int, int) m = map(int, int);
+    img_writer * w = img_writer_new();
+    CU_ASSERT_TRUE(img_add_map(w, "empty", &m));
+    const img_test_buf buf = img_test_write(w);
+    img_writer_free(w);
+
+    img * im = img_from(buf.data, buf.size);
+    MAP(int, int) loaded = img_map(int, int, im, "empty");
+    CU_ASSERT_EQUAL(map_size(&loaded), 0);
+    CU_ASSERT_PTR_NULL(map_get(&loaded, 1));
+    img_close(im);
+    img_test_free(buf);
+    CU_ASSERT_FALSE(err_has());
+}
+
+// =====================================================================================================================
+// img_add_str() / img_str() - String section
+// =====================================================================================================================
+
+static void img_add_str__for_equal_strings__should_share_one_copy(void) {
+    img_writer * w = img_writer_new();
+    const img_ref a = img_add_str(w, "same");
+    char * managed = str("same");
+    const img_ref b = img_add_str(w, managed);
+    const img_ref c = img_add_str(w, str_view("samesame", &(str_opt){.max_len = 4}));
+    const img_ref d = img_add_str(w, "");
+    CU_ASSERT_NOT_EQUAL(a, 0);
+    CU_ASSERT_EQUAL(a, b);
+    CU_ASSERT_EQUAL(a, c);
+    CU_ASSERT_NOT_EQUAL(d, 0);
+    CU_ASSERT_NOT_EQUAL(d, a);
+    str_free(managed);
+
+    const img_test_buf buf = img_test_write(w);
+    img_writer_free(w);
+    img * im = img_from(buf.data, buf.size);
+    CU_ASSERT_STRING_EQUAL(img_str(im, a), "same");
+    CU_ASSERT_STRING_EQUAL(img_str(im, d), "");
+    CU_ASSERT_EQUAL(img_str_find(im, ""), d);
+    CU_ASSERT_PTR_NULL(img_str(im, 0));
+    CU_ASSERT_PTR_NULL(img_str(im, (img_ref)buf.size));
+    img_close(im);
+    img_test_free(buf);
+}
+
+// =====================================================================================================================
+// img_writer / img_write() - Writer
+// =====================================================================================================================
+
+static void img_reserve__with_bad_names__should_fail(void) {
+    img_writer * w = img_writer_new();
+    LIST(int) lst = {0};
+    list_add(&lst, 1);
+    CU_ASSERT_TRUE(img_add_list(w, "a", &lst));
+    CU_ASSERT_FALSE(img_add_list(w, "a", &lst));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_INVALID_ARGUMENT);
+    err_clear();
+    CU_ASSERT_FALSE(img_add_list(w, "", &lst));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_INVALID_ARGUMENT);
+    err_clear();
+    CU_ASSERT_FALSE(img_add_list(w, "0123456789abcdef0123456789abcdef", &lst));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_LENGTH_EXCEEDED);
+    err_clear();
+    CU_ASSERT_TRUE(img_add_list(w, "0123456789abcdef0123456789abcde", &lst));
+    img_writer_free(w);
+    list_free(&lst);
+    img_writer_free(nullptr);
+}
+
+static void img_write__for_equal_contents__should_give_identical_images(void) {
+    img_test_buf bufs[2];
+    for (int k = 0; k < 2; k++) {
+        MAP(int, int) m = map(int, int);
+        for (int i = 0; i < 100; i++)
+            map_put(&m, i, -i);
+        map_remove(&m, 50);
+        img_writer * w = img_writer_new();
+        img_add_str(w, "x");
+        CU_ASSERT_TRUE(img_add_map(w, "m", &m));
+        bufs[k] = img_test_write(w);
+        img_writer_free(w);
+        map_free(&m);
+    }
+    CU_ASSERT_EQUAL(bufs[0].size, bufs[1].size);
+    CU_ASSERT_EQUAL(memcmp(bufs[0].data, bufs[1].data, bufs[0].size), 0);
+    CU_ASSERT_EQUAL(bufs[0].size % R_IMG_ALIGN, 0);
+    img_test_free(bufs[0]);
+    img_test_free(bufs[1]);
+}
+
+// =====================================================================================================================
+// img_from() / img_open() / img_verify() - Validation
+// =====================================================================================================================
+
+static void img_verify__after_corruption__should_fail(void) {
+    img_writer * w = img_writer_new();
+    LIST(int) lst = {0};
+    for (int i = 0; i < 100; i++)
+        list_add(&lst, i);
+    CU_ASSERT_TRUE(img_add_list(w, "ints", &lst));
+    const img_test_buf buf = img_test_write(w);
+    img_writer_free(w);
+    list_free(&lst);
+
+    img * im = img_from(buf.data, buf.size);
+    CU_ASSERT_TRUE(img_verify(im));
+    buf.data[buf.size - 5] ^= 0x40;
+    CU_ASSERT_FALSE(img_verify(im));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_PARSE_FAILED);
+    err_clear();
+    img_close(im);
+    img_test_free(buf);
+}
+
+static void img_str__for_corrupt_string_header__should_return_null(void) {
+    img_writer * w = img_writer_new();
+    const img_ref ref = img_add_str(w, "corrupt me");
+    const img_test_buf buf = img_test_write(w);
+    img_writer_free(w);
+
+    img * im = img_from(buf.data, buf.size);
+    const char * s = img_str(im, ref);
+    CU_ASSERT_PTR_NOT_NULL(s);
+    CU_ASSERT_PTR_NULL(img_str(im, 1));
+    CU_ASSERT_PTR_NULL(img_str(im, ref + 1));
+
+    // Stored length and capacity far past the end of the image
+    const size_t len = 10;
+    const size_t huge = (size_t)1 << 40;
+    size_t patched = 0;
+    for (uint8_t * p = (uint8_t *)s - 2 * sizeof(size_t); p >= (uint8_t *)s - 48; p--) {
+        if (memcmp(p, &len, sizeof(len)) == 0) {
+            memcpy(p, &huge, sizeof(huge));
+            patched++;
+        }
+    }
+    CU_ASSERT_EQUAL(patched, 2);
+    CU_ASSERT_PTR_NULL(img_str(im, ref));
+    CU_ASSERT_EQUAL(img_str_find(im, "corrupt me"), 0);
+    img_close(im);
+    img_test_free(buf);
+}
+
+static void img_str__for_tampered_utf8_state__should_return_null(void) {
+    img_writer * w = img_writer_new();
+    const img_ref ref = img_add_str(w, "hello");
+    img_test_buf buf = img_test_write(w);
+    img_writer_free(w);
+
+    // The header byte after the start marker holds the UTF-8 state, here ASCII (1) with the placed flag (0x80)
+    img * im = img_from(buf.data, buf.size);
+    const char * s = img_str(im, ref);
+    CU_ASSERT_PTR_NOT_NULL(s);
+    const size_t at = (size_t)((const uint8_t *)s - buf.data);
+    img_close(im);
+    size_t state_at = 0;
+    for (size_t i = at - 2 * sizeof(size_t); i >= at - 48; i--) {
+        if (buf.data[i] == 0x01 && buf.data[i + 1] == 0x81) {
+            CU_ASSERT_EQUAL(state_at, 0);
+            state_at = i + 1;
+        }
+    }
+    CU_ASSERT_NOT_EQUAL(state_at, 0);
+
+    // Unknown (would be cached into the read-only mapping), unflagged, or out of range
+    const uint8_t tampered[] = {0x00, 0x80, 0x01, 0x84};
+    for (size_t t = 0; t < sizeof(tampered); t++) {
+        buf.data[state_at] = tampered[t];
+        FILE * f = open_file_secure(IMG_TEST_PATH, "wb");
+        CU_ASSERT_PTR_NOT_NULL(f);
+        CU_ASSERT_EQUAL(fwrite(buf.data, 1, buf.size, f), buf.size);
+        fclose(f);
+        im = img_open(IMG_TEST_PATH);
+        CU_ASSERT_PTR_NOT_NULL(im);
+        s = img_str(im, ref);
+        CU_ASSERT_PTR_NULL(s);
+        if (s != nullptr)
+            CU_ASSERT_TRUE(str_utf8_valid(s));
+        img_close(im);
+    }
+    remove(IMG_TEST_PATH);
+    img_test_free(buf);
+}
+
+static void img_from__for_invalid_images__should_fail(void) {
+    img_writer * w = img_writer_new();
+    const img_test_buf buf = img_test_write(w);
+    img_writer_free(w);
+
+    img * im = img_from(buf.data, buf.size);
+    CU_ASSERT_PTR_NOT_NULL(im);
+    img_close(im);
+
+    // Truncated
+    CU_ASSERT_PTR_NULL(img_from(buf.data, buf.size - 1));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_PARSE_FAILED);
+    err_clear();
+
+    // Unaligned
+    CU_ASSERT_PTR_NULL(img_from(buf.data + 1, buf.size - 1));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_INVALID_ARGUMENT);
+    err_clear();
+
+    // Bad magic
+    buf.data[0] ^= 0xFF;
+    CU_ASSERT_PTR_NULL(img_from(buf.data, buf.size));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_PARSE_FAILED);
+    err_clear();
+    img_test_free(buf);
+
+    CU_ASSERT_PTR_NULL(img_open("test_img_missing.img"));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_NOT_FOUND);
+    err_clear();
+    img_close(nullptr);
+}
+
+int main(void) {
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // List sections suite
+    CU_pSuite suite_list = CU_add_suite("img_add_list() / img_list()", nullptr, nullptr);
+    if (suite_list == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_list, img_list__after_open__should_return_elements_and_strings);
+    ADD_TEST(suite_list, img_list__for_missing_or_mismatched_section__should_fail);
+
+    // Ordered sections suite
+    CU_pSuite suite_tree = CU_add_suite("img_add_rbt() / img_add_btree() / img_tree()", nullptr, nullptr);
+    if (suite_tree == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_tree, img_tree__from_rbt__should_be_sorted_and_searchable);
+    ADD_TEST(suite_tree, img_tree__from_btree__should_be_sorted);
+    ADD_TEST(suite_tree, img_find__with_custom_comparator__should_follow_its_order);
+    ADD_TEST(suite_tree, img_tree__from_empty_trees__should_be_empty);
+
+    // Map sections suite
+    CU_pSuite suite_map = CU_add_suite("img_add_map() / img_map()", nullptr, nullptr);
+    if (suite_map == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_map, img_map__with_tombstones__should_answer_like_the_original);
+    ADD_TEST(suite_map, img_map__with_string_refs__should_find_by_string);
+    ADD_TEST(suite_map, img_map__for_empty_map__should_be_empty);
+
+    // String section suite
+    CU_pSuite suite_str = CU_add_suite("img_add_str() / img_str()", nullptr, nullptr);
+    if (suite_str == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_str, img_add_str__for_equal_strings__should_share_one_copy);
+
+    // Writer suite
+    CU_pSuite suite_writer = CU_add_suite("img_writer / img_write()", nullptr, nullptr);
+    if (suite_writer == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_writer, img_reserve__with_bad_names__should_fail);
+    ADD_TEST(suite_writer, img_write__for_equal_contents__should_give_identical_images);
+
+    // Validation suite
+    CU_pSuite suite_valid = CU_add_suite("img_from() / img_open() / img_verify()", nullptr, nullptr);
+    if (suite_valid == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_valid, img_verify__after_corruption__should_fail);
+    ADD_TEST(suite_valid, img_str__for_corrupt_string_header__should_return_null);
+    ADD_TEST(suite_valid, img_str__for_tampered_utf8_state__should_return_null);
+    ADD_TEST(suite_valid, img_from__for_invalid_images__should_fail);
+
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,743 @@
+/*
+ * map tests.
+ */
+
+// ReSharper disable CppDFATimeOver
+#include "../src/map.h"
+#include "../src/task.h"
+#include "CUnit/Basic.h"
+#include "test.h"
+
+#include <stdint.h>
+
+// Define MAP(int, int) for testing
+#define K int
+#define V int
+#include "../src/map.h"
+#undef K
+#undef V
+
+// Define MAP(cstr, int) for string-keyed testing
+typedef const char * cstr;
+#define K cstr
+#define V int
+#include "../src/map.h"
+#undef K
+#undef V
+
+// Define MAP(point, int) for custom hash/equality testing
+typedef struct {
+    int x;
+    int y;
+} point;
+
+static uint64_t map_test_point_hash(const point p) {
+    return hash_combine(hash_mix((uint64_t)p.x), hash_mix((uint64_t)p.y));
+}
+
+static bool map_test_point_eq(const point a, const point b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+// map_put_all for this map hashes with the same pair the tests pass to every other operation
+#define K point
+#define V int
+#define K_HASH map_test_point_hash
+#define K_EQ map_test_point_eq
+#include "../src/map.h"
+#undef K_HASH
+#undef K_EQ
+#undef K
+#undef V
+
+// =====================================================================================================================
+// MAP helper functions
+// =====================================================================================================================
+
+// Constant hash to force every key onto the same probe sequence
+static uint64_t map_test_collide_hash(const int k) {
+    (void)k;
+    return 0x2A;
+}
+
+static bool map_test_int_eq(const int a, const int b) {
+    return a == b;
+}
+
+// Count control bytes in each state, verifying the bookkeeping fields
+static bool map_test_ctrl_consistent(const MAP(int, int) * m) {
+    size_t full = 0;
+    size_t deleted = 0;
+    for (size_t i = 0; i < m->capacity; i++) {
+        if (R_MAP_IS_FULL(m->ctrl[i])) {
+            full++;
+        } else if (m->ctrl[i] == R_MAP_DELETED) {
+            deleted++;
+        }
+    }
+    // The first group's control bytes are mirrored past the end of the table
+    const size_t mirrored = m->capacity < R_MAP_GROUP_WIDTH ? m->capacity : R_MAP_GROUP_WIDTH;
+    for (size_t i = 0; i < mirrored; i++) {
+        if (m->ctrl[m->capacity + i] != m->ctrl[i]) {
+            return false;
+        }
+    }
+    return full == m->size && deleted == m->tombstones;
+}
+
+// =====================================================================================================================
+// map() - Create empty map
+// =====================================================================================================================
+
+static void map__for_new_map__should_be_empty(void) {
+    MAP(int, int) m = map(int, int);
+    CU_ASSERT_EQUAL(map_size(&m), 0);
+    CU_ASSERT_EQUAL(map_capacity(&m), 0);
+    CU_ASSERT_TRUE(map_empty(&m));
+    CU_ASSERT_PTR_NULL(m.slots);
+    CU_ASSERT_PTR_NULL(m.ctrl);
+    map_free(&m);
+}
+
+static void map_get__on_empty_map__should_return_null(void) {
+    MAP(int, int) m = map(int, int);
+    CU_ASSERT_PTR_NULL(map_get(&m, 42));
+    CU_ASSERT_FALSE(map_contains(&m, 42));
+    CU_ASSERT_FALSE(err_has());
+    map_free(&m);
+}
+
+// =====================================================================================================================
+// map_put() - Insert or overwrite
+// =====================================================================================================================
+
+static void map_put__for_new_key__should_insert_and_return_true(void) {
+    MAP(int, int) m = map(int, int);
+    CU_ASSERT_TRUE(map_put(&m, 1, 100));
+    CU_ASSERT_EQUAL(map_size(&m), 1);
+    CU_ASSERT_EQUAL(map_capacity(&m), R_(map_capacity_for)(1));
+
+    const int * v = map_get(&m, 1);
+    CU_ASSERT_PTR_NOT_NULL(v);
+    CU_ASSERT_EQUAL(*v, 100);
+    map_free(&m);
+}
+
+static void map_put__for_existing_key__should_overwrite_and_return_false(void) {
+    MAP(int, int) m = map(int, int);
+    map_put(&m, 7, 1);
+    CU_ASSERT_FALSE(map_put(&m, 7, 2));
+    CU_ASSERT_EQUAL(map_size(&m), 1);
+    CU_ASSERT_EQUAL(*map_get(&m, 7), 2);
+    map_free(&m);
+}
+
+static void * map_test_fail_alloc(void * ctx, const size_t size) {
+    (void)ctx;
+    (void)size;
+    return nullptr;
+}
+
+static void map_put__when_table_allocation_fails__should_report_or_overfill(void) {
+    const allocator failing = {.alloc = map_test_fail_alloc};
+    MAP(int, int) m = map(int, int);
+    alloc_scope(failing) {
+        CU_ASSERT_FALSE(map_put(&m, 1, 10));
+    }
+    CU_ASSERT_EQUAL(err_code(), R_ERR_ALLOC_FAILED);
+    err_clear();
+    CU_ASSERT_EQUAL(map_size(&m), 0);
+    CU_ASSERT_PTR_NULL(map_get(&m, 1));
+
+    // A table at its max load that cannot grow still takes the key
+    int n = 0;
+    while (map_size(&m) < R_(map_max_load)(R_(map_capacity_for)(1))) {
+        map_put(&m, n, n);
+        n++;
+    }
+    const size_t capacity = map_capacity(&m);
+    alloc_scope(failing) {
+        CU_ASSERT_TRUE(map_put(&m, n, n));
+    }
+    err_clear();
+    CU_ASSERT_EQUAL(map_capacity(&m), capacity);
+    CU_ASSERT_EQUAL(*map_get(&m, n), n);
+    map_free(&m);
+}
+
+static void map_put__for_many_keys__should_grow_and_keep_all(void) {
+    MAP(int, int) m = map(int, int);
+    for (int i = 0; i < 10000; i++) {
+        map_put(&m, i, i * 3);
+    }
+    CU_ASSERT_EQUAL(map_size(&m), 10000);
+    CU_ASSERT(map_size(&m) <= R_(map_max_load)(map_capacity(&m)));
+    CU_ASSERT_EQUAL(map_capacity(&m) & (map_capacity(&m) - 1), 0); // power of two
+
+    bool all_found = true;
+    for (int i = 0; i < 10000; i++) {
+        const int * v = map_get(&m, i);
+        if (v == nullptr || *v != i * 3) {
+            all_found = false;
+        }
+    }
+    CU_ASSERT_TRUE(all_found);
+    CU_ASSERT_FALSE(map_contains(&m, 10000));
+    CU_ASSERT_FALSE(map_contains(&m, -1));
+    CU_ASSERT_TRUE(map_test_ctrl_consistent(&m));
+    map_free(&m);
+}
+
+static void map_put__for_colliding_hashes__should_probe_linearly(void) {
+    MAP(int, int) m = map(int, int);
+    for (int i = 0; i < 10; i++) {
+        map_put(&m, i, i, map_test_collide_hash, map_test_int_eq);
+    }
+    CU_ASSERT_EQUAL(map_size(&m), 10);
+    for (int i = 0; i < 10; i++) {
+        const int * v = map_get(&m, i, map_test_collide_hash, map_test_int_eq);
+        CU_ASSERT_PTR_NOT_NULL(v);
+        if (v != nullptr) {
+            CU_ASSERT_EQUAL(*v, i);
+        }
+    }
+    CU_ASSERT_FALSE(map_contains(&m, 10, map_test_collide_hash, map_test_int_eq));
+    map_free(&m);
+}
+
+// =====================================================================================================================
+// map_remove() - Remove key
+// =====================================================================================================================
+
+static void map_remove__for_existing_key__should_remove_and_return_true(void) {
+    MAP(int, int) m = map(int, int);
+    map_put(&m, 1, 10);
+    map_put(&m, 2, 20);
+
+    CU_ASSERT_TRUE(map_remove(&m, 1));
+    CU_ASSERT_EQUAL(map_size(&m), 1);
+    CU_ASSERT_FALSE(map_contains(&m, 1));
+    CU_ASSERT_EQUAL(*map_get(&m, 2), 20);
+    map_free(&m);
+}
+
+static void map_remove__for_missing_key__should_return_false(void) {
+    MAP(int, int) m = map(int, int);
+    CU_ASSERT_FALSE(map_remove(&m, 1));
+    map_put(&m, 2, 20);
+    CU_ASSERT_FALSE(map_remove(&m, 1));
+    CU_ASSERT_EQUAL(map_size(&m), 1);
+    CU_ASSERT_FALSE(err_has());
+    map_free(&m);
+}
+
+static void map_remove__in_collision_chain__should_keep_later_keys_reachable(void) {
+    MAP(int, int) m = map(int, int);
+    for (int i = 0; i < 5; i++) {
+        map_put(&m, i, i, map_test_collide_hash, map_test_int_eq);
+    }
+
+    // Removing from the middle of the chain must leave a tombstone
+    CU_ASSERT_TRUE(map_remove(&m, 1, map_test_collide_hash, map_test_int_eq));
+    CU_ASSERT_EQUAL(m.tombstones, 1);
+    for (int i = 2; i < 5; i++) {
+        CU_ASSERT_TRUE(map_contains(&m, i, map_test_collide_hash, map_test_int_eq));
+    }
+
+    // Removing the chain tail can free the slot outright
+    CU_ASSERT_TRUE(map_remove(&m, 4, map_test_collide_hash, map_test_int_eq));
+    CU_ASSERT_EQUAL(m.tombstones, 1);
+    CU_ASSERT_TRUE(map_test_ctrl_consistent(&m));
+
+    // Re-inserting reuses the tombstone
+    CU_ASSERT_TRUE(map_put(&m, 1, 11, map_test_collide_hash, map_test_int_eq));
+    CU_ASSERT_EQUAL(m.tombstones, 0);
+    CU_ASSERT_EQUAL(*map_get(&m, 1, map_test_collide_hash, map_test_int_eq), 11);
+    map_free(&m);
+}
+
+static void map_remove__for_churn__should_not_grow_unbounded(void) {
+    MAP(int, int) m = map(int, int);
+    for (int i = 0; i < 100000; i++) {
+        map_put(&m, i, i);
+        if (i >= 8) {
+            CU_ASSERT_TRUE(map_remove(&m, i - 8));
+        }
+    }
+    CU_ASSERT_EQUAL(map_size(&m), 8);
+    CU_ASSERT(map_capacity(&m) <= 4 * R_(map_capacity_for)(1));
+    CU_ASSERT_TRUE(map_test_ctrl_consistent(&m));
+    for (int i = 100000 - 8; i < 100000; i++) {
+        CU_ASSERT_TRUE(map_contains(&m, i));
+    }
+    map_free(&m);
+}
+
+// =====================================================================================================================
+// map_reserve() / map_clear() - Capacity management
+// =====================================================================================================================
+
+static void map_reserve__for_n_entries__should_avoid_rehash(void) {
+    MAP(int, int) m = map(int, int);
+    map_reserve(&m, 1000);
+    const size_t capacity = map_capacity(&m);
+    const void * slots = m.slots;
+    CU_ASSERT(R_(map_max_load)(capacity) >= 1000);
+
+    for (int i = 0; i < 1000; i++) {
+        map_put(&m, i, i);
+    }
+    CU_ASSERT_EQUAL(map_capacity(&m), capacity);
+    CU_ASSERT_PTR_EQUAL(m.slots, slots);
+    map_free(&m);
+}
+
+static void map_clear__on_populated_map__should_keep_capacity(void) {
+    MAP(int, int) m = map(int, int);
+    for (int i = 0; i < 100; i++) {
+        map_put(&m, i, i);
+    }
+    const size_t capacity = map_capacity(&m);
+    map_clear(&m);
+    CU_ASSERT_EQUAL(map_size(&m), 0);
+    CU_ASSERT_EQUAL(map_capacity(&m), capacity);
+    CU_ASSERT_FALSE(map_contains(&m, 5));
+    map_put(&m, 5, 50);
+    CU_ASSERT_EQUAL(*map_get(&m, 5), 50);
+    map_free(&m);
+}
+
+// =====================================================================================================================
+// map_foreach() - Iterate entries
+// =====================================================================================================================
+
+static void map_foreach__on_populated_map__should_visit_each_entry_once(void) {
+    MAP(int, int) m = map(int, int);
+    for (int i = 0; i < 200; i++) {
+        map_put(&m, i, 1);
+    }
+    map_remove(&m, 50);
+
+    int visits = 0;
+    int key_sum = 0;
+    map_foreach(&m, e) {
+        visits += e->val;
+        key_sum += e->key;
+    }
+    CU_ASSERT_EQUAL(visits, 199);
+    CU_ASSERT_EQUAL(key_sum, 199 * 200 / 2 - 50);
+    map_free(&m);
+}
+
+static void map_foreach__on_empty_map__should_not_iterate(void) {
+    MAP(int, int) m = map(int, int);
+    int visits = 0;
+    map_foreach(&m, e) {
+        (void)e;
+        visits++;
+    }
+    CU_ASSERT_EQUAL(visits, 0);
+    map_free(&m);
+}
+
+static void map_foreach__with_break__should_stop_iteration(void) {
+    MAP(int, int) m = map(int, int);
+    for (int i = 0; i < 50; i++) {
+        map_put(&m, i, i);
+    }
+    int visits = 0;
+    map_foreach(&m, e) {
+        (void)e;
+        if (++visits == 3) {
+            break;
+        }
+    }
+    CU_ASSERT_EQUAL(visits, 3);
+    map_free(&m);
+}
+
+// =====================================================================================================================
+// Key types - string and custom keys
+// =====================================================================================================================
+
+static void map__for_string_keys__should_compare_by_content(void) {
+    MAP(cstr, int) m = map(cstr, int);
+    char buf[] = "west";
+    map_put(&m, "east", 1);
+    map_put(&m, "west", 2);
+
+    // A different pointer with the same content finds the same entry
+    const int * v = map_get(&m, buf);
+    CU_ASSERT_PTR_NOT_NULL(v);
+    if (v != nullptr) {
+        CU_ASSERT_EQUAL(*v, 2);
+    }
+    CU_ASSERT_FALSE(map_put(&m, buf, 3));
+    CU_ASSERT_EQUAL(map_size(&m), 2);
+    CU_ASSERT_FALSE(map_contains(&m, "north"));
+    map_free(&m);
+}
+
+static void map__with_custom_hash_and_eq__should_use_them(void) {
+    MAP(point, int) m = map(point, int);
+    for (int i = 0; i < 100; i++) {
+        map_put(&m, ((point){.x = i, .y = -i}), i, map_test_point_hash, map_test_point_eq);
+    }
+    CU_ASSERT_EQUAL(map_size(&m), 100);
+    const int * v = map_get(&m, ((point){.x = 42, .y = -42}), map_test_point_hash, map_test_point_eq);
+    CU_ASSERT_PTR_NOT_NULL(v);
+    if (v != nullptr) {
+        CU_ASSERT_EQUAL(*v, 42);
+    }
+    CU_ASSERT_FALSE(map_contains(&m, ((point){.x = 42, .y = 42}), map_test_point_hash, map_test_point_eq));
+    map_free(&m);
+}
+
+// =====================================================================================================================
+// map_put_all() - Parallel bulk insert
+// =====================================================================================================================
+
+static void map_put_all__for_many_keys__should_match_map_put(void) {
+    task_pool * pool = task_pool(&(task_opt){.workers = 4});
+    static int keys[100000];
+    static int vals[100000];
+    for (int i = 0; i < 100000; i++) {
+        keys[i] = (int)((uint32_t)i * 2654435761u % 60000); // every key about 1.7 times
+        vals[i] = i;
+    }
+    MAP(int, int) m = map(int, int);
+    MAP(int, int) expected = map(int, int);
+    // Start from a used table: live entries, tombstones and overwritten keys
+    for (int i = 0; i < 2000; i++) {
+        map_put(&m, -i, i);
+        map_put(&m, i, -1);
+    }
+    for (int i = 0; i < 2000; i += 2) {
+        map_remove(&m, -i);
+    }
+    map_foreach(&m, e) {
+        map_put(&expected, e->key, e->val);
+    }
+
+    CU_ASSERT_TRUE(map_put_all(int, int, &m, pool, keys, vals, 100000));
+    for (int i = 0; i < 100000; i++) {
+        map_put(&expected, keys[i], vals[i]);
+    }
+    CU_ASSERT_EQUAL(map_size(&m), map_size(&expected));
+    CU_ASSERT_TRUE(map_test_ctrl_consistent(&m));
+    size_t same = 0;
+    map_foreach(&expected, e) {
+        const int * v = map_get(&m, e->key);
+        same += v != nullptr && *v == e->val;
+    }
+    CU_ASSERT_EQUAL(same, map_size(&expected));
+    CU_ASSERT_FALSE(err_has());
+
+    map_free(&expected);
+    map_free(&m);
+    task_pool_free(pool);
+}
+
+static void map_put_all__with_custom_hash_and_eq__should_use_them(void) {
+    task_pool * pool = task_pool(&(task_opt){.workers = 2});
+    static point keys[20000];
+    static int vals[20000];
+    for (int i = 0; i < 20000; i++) {
+        keys[i] = (point){.x = i % 150, .y = i / 150};
+        vals[i] = i;
+    }
+    MAP(point, int) m = map(point, int);
+    CU_ASSERT_TRUE(map_put_all(point, int, &m, pool, keys, vals, 20000));
+    CU_ASSERT_EQUAL(map_size(&m), 20000);
+    const int * v = map_get(&m, ((point){.x = 7, .y = 100}), map_test_point_hash, map_test_point_eq);
+    CU_ASSERT_PTR_NOT_NULL(v);
+    if (v != nullptr) {
+        CU_ASSERT_EQUAL(*v, 100 * 150 + 7);
+    }
+    map_free(&m);
+    task_pool_free(pool);
+}
+
+static void map_put_all__for_few_keys_or_null_pool__should_put_inline_or_fail(void) {
+    task_pool * pool = task_pool(&(task_opt){.workers = 2});
+    const int keys[] = {1, 2, 1};
+    const int vals[] = {10, 20, 30};
+    MAP(int, int) m = map(int, int);
+    CU_ASSERT_TRUE(map_put_all(int, int, &m, pool, keys, vals, 3));
+    CU_ASSERT_EQUAL(map_size(&m), 2);
+    const int * v = map_get(&m, 1);
+    CU_ASSERT_PTR_NOT_NULL(v);
+    if (v != nullptr) {
+        CU_ASSERT_EQUAL(*v, 30);
+    }
+
+    CU_ASSERT_FALSE(map_put_all(int, int, &m, nullptr, keys, vals, 3));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_NULL_POINTER);
+    err_clear();
+    map_free(&m);
+    task_pool_free(pool);
+}
+
+// =====================================================================================================================
+// pmap() - Progressive map
+// =====================================================================================================================
+
+// Put keys 0, 1, ... (value = key) until a put starts a migration out of a table of more than min entries
+static int pmap_test_fill(PMAP(int, int) * m, const int min) {
+    for (int n = 0;; n++) {
+        const bool was = pmap_migrating(m);
+        pmap_put(m, n, n);
+        if (n >= min && !was && pmap_migrating(m))
+            return n + 1;
+    }
+}
+
+static void pmap_put__for_many_keys__should_keep_all_reachable_while_migrating(void) {
+    PMAP(int, int) m = pmap(int, int);
+    bool migrated = false;
+    size_t missed = 0;
+    for (int i = 0; i < 20000; i++) {
+        CU_ASSERT_TRUE(pmap_put(&m, i, i * 2));
+        migrated |= pmap_migrating(&m);
+        // Early, middle and latest keys, wherever they currently live
+        for (int j = 0; j <= i; j += i / 4 + 1) {
+            const int * v = pmap_get(&m, j);
+            missed += v == nullptr || *v != j * 2;
+        }
+        missed += !pmap_contains(&m, i);
+    }
+    CU_ASSERT_EQUAL(missed, 0);
+    CU_ASSERT_TRUE(migrated);
+    CU_ASSERT_EQUAL(pmap_size(&m), 20000);
+    CU_ASSERT_FALSE(pmap_put(&m, 7, 70));
+    CU_ASSERT_EQUAL(*pmap_get(&m, 7), 70);
+    CU_ASSERT_EQUAL(pmap_size(&m), 20000);
+    pmap_free(&m);
+    CU_ASSERT_EQUAL(pmap_size(&m), 0);
+    CU_ASSERT_EQUAL(pmap_capacity(&m), 0);
+}
+
+static void pmap_put__when_table_allocation_fails__should_keep_the_map(void) {
+    const allocator failing = {.alloc = map_test_fail_alloc};
+    PMAP(int, int) m = pmap(int, int);
+    alloc_scope(failing) {
+        CU_ASSERT_FALSE(pmap_put(&m, 1, 10));
+    }
+    CU_ASSERT_EQUAL(err_code(), R_ERR_ALLOC_FAILED);
+    err_clear();
+    CU_ASSERT_EQUAL(pmap_size(&m), 0);
+    CU_ASSERT_PTR_NULL(pmap_get(&m, 1));
+
+    // A full table that cannot start a migration keeps its entries and refuses the new key
+    int n = 0;
+    while (pmap_size(&m) < R_(map_max_load)(R_(map_capacity_for)(1))) {
+        pmap_put(&m, n, n);
+        n++;
+    }
+    const size_t capacity = pmap_capacity(&m);
+    alloc_scope(failing) {
+        CU_ASSERT_FALSE(pmap_put(&m, n, n));
+    }
+    CU_ASSERT_EQUAL(err_code(), R_ERR_ALLOC_FAILED);
+    err_clear();
+    CU_ASSERT_FALSE(pmap_migrating(&m));
+    CU_ASSERT_EQUAL(pmap_capacity(&m), capacity);
+    CU_ASSERT_EQUAL(pmap_size(&m), (size_t)n);
+    CU_ASSERT_PTR_NULL(pmap_get(&m, n));
+    int missed = 0;
+    for (int i = 0; i < n; i++)
+        missed += pmap_get(&m, i) == nullptr || *pmap_get(&m, i) != i;
+    CU_ASSERT_EQUAL(missed, 0);
+    CU_ASSERT_TRUE(pmap_put(&m, n, n));
+    CU_ASSERT_EQUAL(*pmap_get(&m, n), n);
+    pmap_free(&m);
+}
+
+static void pmap_put__when_table_fills__should_move_a_bounded_number_of_slots(void) {
+    PMAP(int, int) m = pmap(int, int);
+    int i = pmap_test_fill(&m, 1000);
+    // The put that started the migration only inserted its own key into the new table
+    const size_t old_capacity = m.old.capacity;
+    CU_ASSERT_EQUAL(m.cur.size, 1);
+    CU_ASSERT_EQUAL(m.old.size, (size_t)i - 1);
+    CU_ASSERT_EQUAL(pmap_capacity(&m), old_capacity * 2);
+
+    // Every further write moves at most R_MAP_MIGRATE_STEP slots
+    pmap_put(&m, i, i);
+    i++;
+    CU_ASSERT(m.cursor <= R_MAP_MIGRATE_STEP);
+    const size_t writes = old_capacity / R_MAP_MIGRATE_STEP;
+    for (size_t w = 1; w < writes && pmap_migrating(&m); w++)
+        pmap_remove(&m, -1);
+    CU_ASSERT_FALSE(pmap_migrating(&m));
+    CU_ASSERT_EQUAL(m.cur.size, (size_t)i);
+    CU_ASSERT_PTR_NULL(m.old.slots);
+    pmap_free(&m);
+}
+
+static void pmap_remove__during_migration__should_remove_from_either_table(void) {
+    PMAP(int, int) m = pmap(int, int);
+    const int n = pmap_test_fill(&m, 1000);
+    // Keys at both ends: low slots are likely migrated by now, the others still old
+    for (int i = 0; i < n; i += 3)
+        CU_ASSERT_TRUE(pmap_remove(&m, i));
+    CU_ASSERT_FALSE(pmap_remove(&m, 0));
+    while (pmap_step(&m, 7)) {
+    }
+    size_t wrong = 0;
+    for (int i = 0; i < n; i++)
+        wrong += pmap_contains(&m, i) != (i % 3 != 0);
+    CU_ASSERT_EQUAL(wrong, 0);
+    CU_ASSERT_EQUAL(pmap_size(&m), (size_t)(n - (n + 2) / 3));
+    pmap_free(&m);
+}
+
+static void pmap_remove__for_churn__should_not_grow_unbounded(void) {
+    PMAP(int, int) m = pmap(int, int);
+    for (int i = 0; i < 100; i++)
+        pmap_put(&m, i, i);
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 100; i++)
+            pmap_remove(&m, round * 100 + i);
+        for (int i = 0; i < 100; i++)
+            pmap_put(&m, (round + 1) * 100 + i, i);
+    }
+    CU_ASSERT_EQUAL(pmap_size(&m), 100);
+    CU_ASSERT(pmap_capacity(&m) <= 512);
+    pmap_free(&m);
+}
+
+static void pmap_foreach__during_migration__should_visit_each_entry_once(void) {
+    PMAP(int, int) m = pmap(int, int);
+    int n = pmap_test_fill(&m, 1000);
+    pmap_put(&m, n++, 1);
+    CU_ASSERT_TRUE(pmap_migrating(&m));
+    int sum = 0;
+    size_t count = 0;
+    pmap_foreach(&m, e) {
+        sum += e->key;
+        count++;
+    }
+    CU_ASSERT_EQUAL(count, (size_t)n);
+    CU_ASSERT_EQUAL(sum, n * (n - 1) / 2);
+
+    pmap_clear(&m);
+    CU_ASSERT_FALSE(pmap_migrating(&m));
+    CU_ASSERT_TRUE(pmap_empty(&m));
+    count = 0;
+    pmap_foreach(&m, e) {
+        count++;
+    }
+    CU_ASSERT_EQUAL(count, 0);
+    pmap_free(&m);
+}
+
+static void pmap__with_custom_hash_and_eq__should_use_them(void) {
+    PMAP(point, int) m = pmap(point, int);
+    for (int i = 0; i < 1000; i++)
+        pmap_put(&m, ((point){i, -i}), i, map_test_point_hash, map_test_point_eq);
+    size_t missed = 0;
+    for (int i = 0; i < 1000; i++) {
+        const int * v = pmap_get(&m, ((point){i, -i}), map_test_point_hash, map_test_point_eq);
+        missed += v == nullptr || *v != i;
+    }
+    CU_ASSERT_EQUAL(missed, 0);
+    CU_ASSERT_TRUE(pmap_remove(&m, ((point){5, -5}), map_test_point_hash, map_test_point_eq));
+    while (pmap_step(&m, 64, map_test_point_hash, map_test_point_eq)) {
+    }
+    CU_ASSERT_FALSE(pmap_contains(&m, ((point){5, -5}), map_test_point_hash, map_test_point_eq));
+    CU_ASSERT_EQUAL(pmap_size(&m), 999);
+    pmap_free(&m);
+}
+
+// =====================================================================================================================
+// Test suite registration
+// =====================================================================================================================
+
+int main(void) {
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // map() suite
+    CU_pSuite suite_map = CU_add_suite("map()", nullptr, nullptr);
+    if (suite_map == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_map, map__for_new_map__should_be_empty);
+    ADD_TEST(suite_map, map_get__on_empty_map__should_return_null);
+    ADD_TEST(suite_map, map__for_string_keys__should_compare_by_content);
+    ADD_TEST(suite_map, map__with_custom_hash_and_eq__should_use_them);
+
+    // map_put() suite
+    CU_pSuite suite_map_put = CU_add_suite("map_put()", nullptr, nullptr);
+    if (suite_map_put == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_map_put, map_put__for_new_key__should_insert_and_return_true);
+    ADD_TEST(suite_map_put, map_put__for_existing_key__should_overwrite_and_return_false);
+    ADD_TEST(suite_map_put, map_put__when_table_allocation_fails__should_report_or_overfill);
+    ADD_TEST(suite_map_put, map_put__for_many_keys__should_grow_and_keep_all);
+    ADD_TEST(suite_map_put, map_put__for_colliding_hashes__should_probe_linearly);
+
+    // map_remove() suite
+    CU_pSuite suite_map_remove = CU_add_suite("map_remove()", nullptr, nullptr);
+    if (suite_map_remove == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_map_remove, map_remove__for_existing_key__should_remove_and_return_true);
+    ADD_TEST(suite_map_remove, map_remove__for_missing_key__should_return_false);
+    ADD_TEST(suite_map_remove, map_remove__in_collision_chain__should_keep_later_keys_reachable);
+    ADD_TEST(suite_map_remove, map_remove__for_churn__should_not_grow_unbounded);
+
+    // map_reserve() / map_clear() suite
+    CU_pSuite suite_map_capacity = CU_add_suite("map_reserve() / map_clear()", nullptr, nullptr);
+    if (suite_map_capacity == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_map_capacity, map_reserve__for_n_entries__should_avoid_rehash);
+    ADD_TEST(suite_map_capacity, map_clear__on_populated_map__should_keep_capacity);
+
+    // map_foreach() suite
+    CU_pSuite suite_map_foreach = CU_add_suite("map_foreach()", nullptr, nullptr);
+    if (suite_map_foreach == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_map_foreach, map_foreach__on_populated_map__should_visit_each_entry_once);
+    ADD_TEST(suite_map_foreach, map_foreach__on_empty_map__should_not_iterate);
+    ADD_TEST(suite_map_foreach, map_foreach__with_break__should_stop_iteration);
+
+    // map_put_all() suite
+    CU_pSuite suite_map_put_all = CU_add_suite("map_put_all()", nullptr, nullptr);
+    if (suite_map_put_all == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_map_put_all, map_put_all__for_many_keys__should_match_map_put);
+    ADD_TEST(suite_map_put_all, map_put_all__with_custom_hash_and_eq__should_use_them);
+    ADD_TEST(suite_map_put_all, map_put_all__for_few_keys_or_null_pool__should_put_inline_or_fail);
+
+    // pmap() suite
+    CU_pSuite suite_pmap = CU_add_suite("pmap()", nullptr, nullptr);
+    if (suite_pmap == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_pmap, pmap_put__for_many_keys__should_keep_all_reachable_while_migrating);
+    ADD_TEST(suite_pmap, pmap_put__when_table_allocation_fails__should_keep_the_map);
+    ADD_TEST(suite_pmap, pmap_put__when_table_fills__should_move_a_bounded_number_of_slots);
+    ADD_TEST(suite_pmap, pmap_remove__during_migration__should_remove_from_either_table);
+    ADD_TEST(suite_pmap, pmap_remove__for_churn__should_not_grow_unbounded);
+    ADD_TEST(suite_pmap, pmap_foreach__during_migration__should_visit_each_entry_once);
+    ADD_TEST(suite_pmap, pmap__with_custom_hash_and_eq__should_use_them);
+
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -2,6 +2,7 @@
  * str tests.
  */
 
+#include "../src/hash.h"
 #include "../src/str.h"
 #include "CUnit/Basic.h"
 
@@ -258,6 +259,157 @@ static void str_hash__unmanaged_strings() {
     CU_ASSERT_EQUAL(str_hash(s1), str_hash(s2));
 }
 
+static void str_hash__managed_matches_unmanaged() {
+    // Long enough to cover xxHash64's 32-byte stripes and its tail
+    const char * text = "The quick brown fox jumps over the lazy dog, twice: the quick brown fox";
+    const char * s = str(text);
+    CU_ASSERT_EQUAL(str_hash(s), str_hash(text));
+    if (R_STR_BLOCK_HASH) {
+        CU_ASSERT_EQUAL(str_hash(s), hash64(text, strlen(text)));
+    }
+    str_free(s);
+}
+
+// =====================================================================================================================
+// str_utf8_valid() / str_utf8_len() - UTF-8
+// =====================================================================================================================
+
+// Reference check: decode each sequence and test its value against the ranges its length may encode
+static bool utf8_reference_valid(const uint8_t * s, const size_t len) {
+    for (size_t i = 0; i < len;) {
+        const uint8_t b = s[i];
+        const size_t n = b < 0x80 ? 1 : b < 0xC0 ? 0 : b < 0xE0 ? 2 : b < 0xF0 ? 3 : b < 0xF8 ? 4 : 0;
+        if (n == 0 || i + n > len)
+            return false;
+        uint32_t cp = n == 1 ? b : b & (0x7F >> n);
+        for (size_t k = 1; k < n; k++) {
+            if ((s[i + k] & 0xC0) != 0x80)
+                return false;
+            cp = cp << 6 | (s[i + k] & 0x3F);
+        }
+        static const uint32_t min[] = {0, 0, 0x80, 0x800, 0x10000};
+        if (cp < min[n] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+            return false;
+        i += n;
+    }
+    return true;
+}
+
+static void str_utf8_valid__well_formed() {
+    CU_ASSERT_TRUE(str_utf8_valid("plain ascii"));
+    CU_ASSERT_TRUE(str_utf8_valid(""));
+    // U+0080, U+07FF, U+0800, U+FFFF, U+10000, U+10FFFF and the code points next to the surrogates
+    CU_ASSERT_TRUE(str_utf8_valid("\xC2\x80 \xDF\xBF \xE0\xA0\x80 \xEF\xBF\xBF \xF0\x90\x80\x80 \xF4\x8F\xBF\xBF"));
+    CU_ASSERT_TRUE(str_utf8_valid("\xED\x9F\xBF \xEE\x80\x80"));
+    // Long enough for several blocks, with sequences across block boundaries
+    const char * text = "Grüße aus Köln, 東京 und Zürich: 🎉 ünïcödé everywhere, and then some ASCII to close out.";
+    CU_ASSERT_TRUE(str_utf8_valid(text));
+    CU_ASSERT_FALSE(err_has());
+}
+
+static void str_utf8_valid__malformed() {
+    const char * bad[] = {
+        "\x80",             // lone continuation
+        "\xC0\x80",         // overlong NUL
+        "\xC1\xBF",         // overlong 2-byte
+        "\xE0\x9F\xBF",     // overlong 3-byte
+        "\xF0\x8F\xBF\xBF", // overlong 4-byte
+        "\xED\xA0\x80",     // surrogate U+D800
+        "\xED\xBF\xBF",     // surrogate U+DFFF
+        "\xF4\x90\x80\x80", // U+110000
+        "\xF5\x80\x80\x80", // lead byte past F4
+        "\xFF",             // never valid
+        "\xC3",             // truncated at the end
+        "\xE2\x82",         // truncated at the end
+        "\xC3(",            // lead byte followed by ASCII
+        "\xE2\x82\xAC\xAC", // one continuation too many
+    };
+    char buf[96];
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        // At every offset across the first block boundaries, followed by ASCII or by nothing
+        for (size_t at = 0; at < 40; at += 3) {
+            memset(buf, 'a', at);
+            strcpy(buf + at, bad[i]);
+            CU_ASSERT_FALSE(str_utf8_valid(buf));
+            CU_ASSERT_EQUAL(err_code(), R_ERR_INVALID_UTF8);
+            err_clear();
+            strcat(buf, "tail of plain ascii bytes");
+            CU_ASSERT_FALSE(str_utf8_valid(buf));
+            err_clear();
+        }
+    }
+}
+
+static void str_utf8_valid__matches_reference() {
+    // Every two-byte pair, then random bytes biased towards lead and continuation bytes, at shifting offsets
+    uint8_t buf[80];
+    size_t differ = 0;
+    for (uint32_t pair = 0; pair < 65536; pair++) {
+        memset(buf, 'x', sizeof(buf));
+        buf[31] = (uint8_t)(pair >> 8);
+        buf[32] = (uint8_t)pair;
+        differ += str_utf8_valid(str_view_n((const char *)buf, 40)) != utf8_reference_valid(buf, 40);
+    }
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for (int round = 0; round < 200000; round++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        const size_t len = 1 + x % (sizeof(buf) - 1);
+        memset(buf, 'x', len);
+        for (int k = 0; k < 6; k++) {
+            static const uint8_t picks[] = {0x80, 0x8F, 0x90, 0x9F, 0xA0, 0xBF, 0xC2, 0xDF, 0xE0, 0xED, 0xEF, 0xF0,
+                                            0xF4, 0xF5, 0xC0, 0x41};
+            buf[(x >> (8 + 8 * k)) % len] = picks[(x >> (4 * k)) & 15];
+        }
+        differ += str_utf8_valid(str_view_n((const char *)buf, len)) != utf8_reference_valid(buf, len);
+    }
+    CU_ASSERT_EQUAL(differ, 0);
+    err_clear();
+}
+
+static void str_utf8_valid__managed_cache_keyed_by_length() {
+    char * s = str("h\xC3\xA9llo");
+    CU_ASSERT_TRUE(str_utf8_valid(s));
+    CU_ASSERT_TRUE(str_utf8_valid(s));
+    // A view of a prefix does not see the cached state of the whole string
+    CU_ASSERT_FALSE(str_utf8_valid(str_view_n(s, 2)));
+    err_clear();
+    char * bad = str("ab\xFF");
+    CU_ASSERT_FALSE(str_utf8_valid(bad));
+    CU_ASSERT_FALSE(str_utf8_valid(bad));
+    err_clear();
+    str_free(s);
+    str_free(bad);
+}
+
+static void str_utf8_valid__null() {
+    CU_ASSERT_FALSE(str_utf8_valid(nullptr));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_NULL_POINTER);
+    err_clear();
+    CU_ASSERT_EQUAL(str_utf8_len(nullptr), 0);
+}
+
+static void str_utf8_len__counts_code_points() {
+    CU_ASSERT_EQUAL(str_utf8_len("hello"), 5);
+    CU_ASSERT_EQUAL(str_utf8_len("h\xC3\xA9llo"), 5);
+    CU_ASSERT_EQUAL(str_utf8_len("東京"), 2);
+    CU_ASSERT_EQUAL(str_utf8_len("🎉!"), 2);
+    CU_ASSERT_EQUAL(str_utf8_len(""), 0);
+    // Several blocks of mixed text: 40 two-byte and 40 ASCII code points
+    char * s = str_repeat("\xC3\xA9" "a", 40);
+    CU_ASSERT_EQUAL(str_utf8_len(s), 80);
+    CU_ASSERT_EQUAL(str_len(s), 120);
+    str_free(s);
+    CU_ASSERT_FALSE(err_has());
+}
+
+static void str_utf8_len__malformed() {
+    CU_ASSERT_EQUAL(str_utf8_len("ab\xC0\xAF"), SIZE_MAX);
+    CU_ASSERT_EQUAL(err_code(), R_ERR_INVALID_UTF8);
+    err_clear();
+}
+
 // =====================================================================================================================
 // str_cmp() - Compare strings
 // =====================================================================================================================
@@ -322,6 +474,35 @@ static void str_eq__null() {
     str_free(s);
 }
 
+static void str_eq__mixed_managed_unmanaged() {
+    const char * s = str("test");
+    CU_ASSERT_TRUE(str_eq(s, "test"));
+    CU_ASSERT_TRUE(str_eq("test", s));
+    CU_ASSERT_FALSE(str_eq(s, "tesT"));
+    str_free(s);
+}
+
+static void str_eq__built_strings() {
+    // Cached hashes of built strings must match those of the same content created directly
+    const char * direct = str("abcabc");
+    const char * cat = str_cat("abc", "abc", nullptr);
+    const char * repeat = str_repeat("abc", 2);
+    const char * parts[] = {"ab", "ab", nullptr};
+    const char * join = str_join("c", parts);
+    const char * joined = str("abcab");
+    CU_ASSERT_EQUAL(str_hash(cat), str_hash(direct));
+    CU_ASSERT_EQUAL(str_hash(repeat), str_hash(direct));
+    CU_ASSERT_EQUAL(str_hash(join), str_hash(joined));
+    CU_ASSERT_TRUE(str_eq(cat, direct));
+    CU_ASSERT_TRUE(str_eq(repeat, cat));
+    CU_ASSERT_TRUE(str_eq(join, joined));
+    str_free(direct);
+    str_free(cat);
+    str_free(repeat);
+    str_free(join);
+    str_free(joined);
+}
+
 // =====================================================================================================================
 // str_find() - Find substring
 // =====================================================================================================================
@@ -367,7 +548,7 @@ static void str_find__null() {
 }
 
 static void str_find__large_pattern() {
-    // Test heap allocation for lps array (pattern > R_STR_STACK_MAX = 8192)
+    // Pattern longer than R_STR_STACK_MAX (8192)
     const str_opt large_opt = {.max_len = 20000};
 
     // Create a large haystack
@@ -398,6 +579,74 @@ static void str_find__large_pattern() {
 // str_rfind() - Find last substring occurrence
 // =====================================================================================================================
 
+// Reference search: every candidate position, compared byte by byte
+static const char * str_test_naive_find(const char * h, const size_t h_len, const char * n, const size_t n_len,
+                                        const bool reverse) {
+    const char * found = nullptr;
+    for (size_t i = 0; i + n_len <= h_len; i++) {
+        if (memcmp(h + i, n, n_len) == 0) {
+            found = h + i;
+            if (!reverse)
+                break;
+        }
+    }
+    return found;
+}
+
+static void str_find__matches_naive_search() {
+    // Small alphabet so that first/last byte filters hit often, lengths crossing SIMD block boundaries
+    char h[200];
+    char n[40];
+    uint32_t seed = 12345;
+    for (int round = 0; round < 500; round++) {
+        const size_t h_len = (size_t)round % 97 + 1;
+        const size_t n_len = (size_t)round % 7 + 1 + (round % 5 == 0 ? 32 : 0);
+        for (size_t i = 0; i < h_len; i++) {
+            seed = seed * 1103515245u + 12345u;
+            h[i] = (char)('a' + (seed >> 16) % 3);
+        }
+        h[h_len] = '\0';
+        // Half the needles are cut from the haystack so that matches exist
+        for (size_t i = 0; i < n_len; i++) {
+            seed = seed * 1103515245u + 12345u;
+            n[i] = round % 2 == 0 && n_len <= h_len ? h[(h_len - n_len) / 2 + i] : (char)('a' + (seed >> 16) % 3);
+        }
+        n[n_len] = '\0';
+
+        const char * fwd = str_find(h, n);
+        const char * rev = str_rfind(h, n);
+        CU_ASSERT_PTR_EQUAL(fwd, str_test_naive_find(h, h_len, n, n_len, false));
+        CU_ASSERT_PTR_EQUAL(rev, str_test_naive_find(h, h_len, n, n_len, true));
+        err_clear();
+    }
+}
+
+static void str_rfind__single_byte() {
+    const char * s = "a/b/c/d/e/f/g/h/i/j/k/l/m/n/o/p/q/r/s/t";
+    CU_ASSERT_PTR_EQUAL(str_rfind(s, "/"), s + 37);
+    CU_ASSERT_PTR_EQUAL(str_find(s, "/"), s + 1);
+    CU_ASSERT_PTR_EQUAL(str_rfind(s, "a"), s);
+    CU_ASSERT_PTR_NULL(str_rfind(s, "z"));
+    err_clear();
+}
+
+static void str_find_quiet__hit_and_miss() {
+    const char * s = str("key=value;key=other");
+    CU_ASSERT_PTR_EQUAL(str_find_quiet(s, "key"), s);
+    CU_ASSERT_PTR_EQUAL(str_rfind_quiet(s, "key"), s + 10);
+    CU_ASSERT_PTR_EQUAL(str_find_quiet(str_view_n(s + 1, 18), "key"), s + 10);
+    CU_ASSERT_PTR_NULL(str_find_quiet(s, "xyz"));
+    CU_ASSERT_PTR_NULL(str_rfind_quiet(s, "xyz"));
+    CU_ASSERT_FALSE(err_has());
+    str_free(s);
+}
+
+static void str_find_quiet__null() {
+    CU_ASSERT_PTR_NULL(str_find_quiet(nullptr, "test"));
+    CU_ASSERT_PTR_NULL(str_rfind_quiet("test", (const char *)nullptr));
+    CU_ASSERT_FALSE(err_has());
+}
+
 static void str_rfind__basic() {
     const char * s = str("Hello World World");
     const char * result = str_rfind(s, "World");
@@ -426,7 +675,7 @@ static void str_rfind__empty_pattern() {
 }
 
 static void str_rfind__large_pattern() {
-    // Test heap allocation for lps array (pattern > R_STR_STACK_MAX = 8192)
+    // Pattern longer than R_STR_STACK_MAX (8192)
     const str_opt large_opt = {.max_len = 20000};
 
     // Create a large haystack with pattern at the end
@@ -675,6 +924,381 @@ static void str_split__null() {
     err_clear();
 }
 
+static void str_split__arena_scope() {
+    arena a = arena();
+    alloc_scope(arena_allocator(&a)) {
+        const char * s = str_cat("one", ",", "two", nullptr);
+        char ** result = str_split(s, ",");
+        CU_ASSERT_PTR_NOT_NULL(result);
+        CU_ASSERT_STRING_EQUAL(result[0], "one");
+        CU_ASSERT_STRING_EQUAL(result[1], "two");
+        CU_ASSERT_PTR_NULL(result[2]);
+    }
+    CU_ASSERT(arena_used(&a) > 0);
+    arena_free(&a);
+}
+
+// =====================================================================================================================
+// strview - Non-owning string views
+// =====================================================================================================================
+
+static void str_view__managed_and_literal() {
+    const char * s = str("hello");
+    const strview a = str_view(s);
+    const strview b = str_view("hello");
+    CU_ASSERT_PTR_EQUAL(a.data, s);
+    CU_ASSERT_EQUAL(a.len, 5);
+    CU_ASSERT_EQUAL(b.len, 5);
+    CU_ASSERT_EQUAL(str_view(nullptr).len, 0);
+    str_free(s);
+}
+
+static void str_view__compare() {
+    const char * s = str("hello world");
+    const strview hello = str_view_n(s, 5);
+    CU_ASSERT_TRUE(str_eq(hello, "hello"));
+    CU_ASSERT_TRUE(str_eq("hello", hello));
+    CU_ASSERT_FALSE(str_eq(hello, s));
+    CU_ASSERT_FALSE(str_eq(hello, "hell"));
+    CU_ASSERT_EQUAL(str_cmp(hello, "hello"), 0);
+    CU_ASSERT_TRUE(str_cmp(hello, "hellp") < 0);
+    CU_ASSERT_TRUE(str_cmp(hello, "hell") > 0);
+    CU_ASSERT_TRUE(str_cmp(hello, s) < 0);
+    CU_ASSERT_EQUAL(str_hash(hello), str_hash("hello"));
+    CU_ASSERT_EQUAL(str_hash(str_view(s)), str_hash(s));
+    str_free(s);
+}
+
+static void str_view__find() {
+    const char * s = "key=value;next";
+    const strview field = str_view_n(s, 9); // "key=value"
+    CU_ASSERT_PTR_EQUAL(str_find(field, "="), s + 3);
+    CU_ASSERT_PTR_EQUAL(str_rfind(s, str_view_n(";", 1)), s + 9);
+    CU_ASSERT_PTR_NULL(str_find(field, ";"));
+    CU_ASSERT_TRUE(err_has());
+    err_clear();
+}
+
+static void str_view__from_view() {
+    const char * line = "alpha beta";
+    char * s = str_from_view(str_view_n(line + 6, 4));
+    CU_ASSERT_STRING_EQUAL(s, "beta");
+    CU_ASSERT_TRUE(str_is(s));
+    CU_ASSERT_EQUAL(str_len(s), 4);
+    str_free(s);
+}
+
+static void str_split_iter__basic() {
+    str_split_iter it = str_split_iter(",a,,bc,d,", ",");
+    strview token;
+    CU_ASSERT_TRUE(str_split_next(&it, &token));
+    CU_ASSERT_TRUE(str_eq(token, "a"));
+    CU_ASSERT_TRUE(str_split_next(&it, &token));
+    CU_ASSERT_TRUE(str_eq(token, "bc"));
+    CU_ASSERT_TRUE(str_split_next(&it, &token));
+    CU_ASSERT_TRUE(str_eq(token, "d"));
+    CU_ASSERT_FALSE(str_split_next(&it, &token));
+    CU_ASSERT_FALSE(str_split_next(&it, &token));
+}
+
+static void str_split_iter__multi_char_delim_on_view() {
+    const char * line = "one::two::three trailing";
+    str_split_iter it = str_split_iter(str_view_n(line, 15), "::");
+    strview token;
+    size_t n = 0;
+    const char * expected[] = {"one", "two", "three"};
+    while (str_split_next(&it, &token)) {
+        CU_ASSERT(n < 3);
+        if (n < 3)
+            CU_ASSERT_TRUE(str_eq(token, expected[n]));
+        n++;
+    }
+    CU_ASSERT_EQUAL(n, 3);
+}
+
+static void str_split_iter__no_allocation() {
+    arena a = arena();
+    alloc_scope(arena_allocator(&a)) {
+        str_split_iter it = str_split_iter("a b c d e f", " ");
+        strview token;
+        size_t n = 0;
+        while (str_split_next(&it, &token))
+            n++;
+        CU_ASSERT_EQUAL(n, 6);
+    }
+    CU_ASSERT_EQUAL(arena_used(&a), 0);
+    arena_free(&a);
+}
+
+static void str_split_iter__invalid() {
+    str_split_iter it = str_split_iter("abc", "");
+    strview token;
+    CU_ASSERT_TRUE(err_has());
+    CU_ASSERT_FALSE(str_split_next(&it, &token));
+    err_clear();
+
+    it = str_split_iter(nullptr, ",");
+    CU_ASSERT_TRUE(err_has());
+    CU_ASSERT_FALSE(str_split_next(&it, &token));
+    err_clear();
+}
+
+// =====================================================================================================================
+// strbuf - String builder
+// =====================================================================================================================
+
+static const str_opt strbuf_test_opt = {.max_len = 1 << 20};
+
+static void strbuf__short_contents_stay_inline() {
+    alloc_trace t = alloc_trace();
+    alloc_scope(alloc_trace_allocator(&t)) {
+        strbuf b = strbuf();
+        CU_ASSERT_TRUE(strbuf_add(&b, "id-"));
+        CU_ASSERT_TRUE(strbuf_addc(&b, '4'));
+        CU_ASSERT_TRUE(strbuf_addf(&b, "%d", 2));
+        CU_ASSERT_EQUAL(strbuf_len(&b), 5);
+        CU_ASSERT_STRING_EQUAL(strbuf_cstr(&b), "id-42");
+        CU_ASSERT_EQUAL(t.allocs + t.reallocs, 0);
+        strbuf_free(&b);
+    }
+    CU_ASSERT_FALSE(err_has());
+}
+
+static void strbuf__grows_geometrically() {
+    alloc_trace t = alloc_trace();
+    char * s;
+    alloc_scope(alloc_trace_allocator(&t)) {
+        strbuf b = strbuf(&strbuf_test_opt);
+        for (int i = 0; i < 1000; i++)
+            strbuf_add(&b, "0123456789");
+        CU_ASSERT_EQUAL(strbuf_len(&b), 10000);
+        s = strbuf_finish(&b);
+    }
+    CU_ASSERT_FALSE(err_has());
+    // 64 bytes doubled up to 16384: one allocation plus eight reallocations
+    CU_ASSERT_EQUAL(t.allocs, 1);
+    CU_ASSERT_EQUAL(t.reallocs, 8);
+    CU_ASSERT_EQUAL(str_len(s, &strbuf_test_opt), 10000);
+    CU_ASSERT_EQUAL(strncmp(s + 9990, "0123456789", 10), 0);
+    str_free(s);
+}
+
+static void strbuf__finish_hands_over_buffer() {
+    strbuf b = strbuf();
+    strbuf_add(&b, "a string longer than the inline buffer");
+    const char * data = strbuf_cstr(&b);
+    char * s = strbuf_finish(&b);
+    CU_ASSERT_PTR_EQUAL(s, data);
+    CU_ASSERT_TRUE(str_is(s));
+    CU_ASSERT_EQUAL(str_len(s), 38);
+    CU_ASSERT_EQUAL(str_hash(s), str_hash(str_view_n("a string longer than the inline buffer", 38)));
+
+    // The builder is empty and reusable
+    CU_ASSERT_EQUAL(strbuf_len(&b), 0);
+    CU_ASSERT_STRING_EQUAL(strbuf_cstr(&b), "");
+    strbuf_add(&b, "again");
+    char * t = strbuf_finish(&b);
+    CU_ASSERT_STRING_EQUAL(t, "again");
+    str_free(s);
+    str_free(t);
+}
+
+static void strbuf__spilled_contents_read_as_plain_string() {
+    strbuf b = strbuf();
+    strbuf_add(&b, "thirty bytes of builder data..");
+    // Not a managed string until finished: length and hash come from the bytes
+    CU_ASSERT_FALSE(str_is(strbuf_cstr(&b)));
+    CU_ASSERT_EQUAL(str_len(strbuf_cstr(&b)), 30);
+    CU_ASSERT_TRUE(str_eq(strbuf_cstr(&b), "thirty bytes of builder data.."));
+    for (int i = 0; i < 8; i++)
+        strbuf_add(&b, "0123456789");
+    CU_ASSERT_EQUAL(str_len(strbuf_cstr(&b)), 110);
+    char * s = strbuf_finish(&b);
+    CU_ASSERT_TRUE(str_is(s));
+    CU_ASSERT_EQUAL(str_len(s), 110);
+    CU_ASSERT_EQUAL(str_hash(s), str_hash(str_view_n(s, 110)));
+    str_free(s);
+}
+
+static void strbuf__addf_spills() {
+    strbuf b = strbuf();
+    CU_ASSERT_TRUE(strbuf_addf(&b, "%s", "0123456789"));
+    CU_ASSERT_TRUE(strbuf_addf(&b, "[%s|%d]", "a longer formatted piece", 12345));
+    char * s = strbuf_finish(&b);
+    CU_ASSERT_STRING_EQUAL(s, "0123456789[a longer formatted piece|12345]");
+    CU_ASSERT_TRUE(str_eq(s, "0123456789[a longer formatted piece|12345]"));
+    str_free(s);
+}
+
+static void strbuf__self_append() {
+    strbuf b = strbuf();
+    strbuf_add(&b, "ab");
+    for (int i = 0; i < 6; i++)
+        strbuf_add(&b, strbuf_view(&b));
+    CU_ASSERT_EQUAL(strbuf_len(&b), 128);
+    const char * data = strbuf_cstr(&b);
+    bool same = true;
+    for (size_t i = 0; i < 128; i++)
+        same = same && data[i] == "ab"[i % 2];
+    CU_ASSERT_TRUE(same);
+    CU_ASSERT_EQUAL(data[128], NULLTERM);
+    strbuf_free(&b);
+}
+
+static void strbuf__max_len() {
+    strbuf b = strbuf(&(str_opt){.max_len = 8});
+    CU_ASSERT_TRUE(strbuf_add(&b, "12345"));
+    CU_ASSERT_FALSE(strbuf_add(&b, "6789"));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_LENGTH_EXCEEDED);
+    err_clear();
+    CU_ASSERT_FALSE(strbuf_addf(&b, "%d", 6789));
+    err_clear();
+    CU_ASSERT_FALSE(strbuf_reserve(&b, 9));
+    err_clear();
+    CU_ASSERT_STRING_EQUAL(strbuf_cstr(&b), "12345");
+    CU_ASSERT_TRUE(strbuf_add(&b, "678"));
+    CU_ASSERT_EQUAL(strbuf_len(&b), 8);
+    strbuf_free(&b);
+}
+
+static void strbuf__reserve_and_clear() {
+    alloc_trace t = alloc_trace();
+    alloc_scope(alloc_trace_allocator(&t)) {
+        strbuf b = strbuf(&strbuf_test_opt);
+        CU_ASSERT_TRUE(strbuf_reserve(&b, 1000));
+        for (int i = 0; i < 100; i++)
+            strbuf_add(&b, "0123456789");
+        strbuf_clear(&b);
+        CU_ASSERT_EQUAL(strbuf_len(&b), 0);
+        CU_ASSERT_STRING_EQUAL(strbuf_cstr(&b), "");
+        strbuf_add(&b, "reused");
+        CU_ASSERT_EQUAL(t.allocs + t.reallocs, 1);
+
+        // Finishing trims the unused reservation
+        char * s = strbuf_finish(&b);
+        char * exact = str("reused");
+        CU_ASSERT_EQUAL(str_size(s), str_size(exact));
+        CU_ASSERT_STRING_EQUAL(s, "reused");
+        str_free(s);
+        str_free(exact);
+    }
+    CU_ASSERT_EQUAL(alloc_trace_live(&t), 0);
+}
+
+static void strbuf__null() {
+    CU_ASSERT_FALSE(strbuf_add(nullptr, "x"));
+    CU_ASSERT_TRUE(err_has());
+    err_clear();
+
+    strbuf b = strbuf();
+    CU_ASSERT_FALSE(strbuf_add(&b, (const char *)nullptr));
+    CU_ASSERT_TRUE(err_has());
+    err_clear();
+    CU_ASSERT_FALSE(strbuf_addf(&b, nullptr));
+    CU_ASSERT_TRUE(err_has());
+    err_clear();
+    CU_ASSERT_PTR_NULL(strbuf_finish(nullptr));
+    err_clear();
+    strbuf_free(&b);
+    strbuf_free(nullptr);
+}
+
+// =====================================================================================================================
+// str_intern() - Interning pools
+// =====================================================================================================================
+
+static void str_intern__same_pointer() {
+    const char * a = str_intern("alpha");
+    const char * b = str_intern("alpha");
+    const char * c = str_intern("beta");
+    CU_ASSERT_PTR_NOT_NULL(a);
+    CU_ASSERT_PTR_EQUAL(a, b);
+    CU_ASSERT_PTR_NOT_EQUAL(a, c);
+    CU_ASSERT_STRING_EQUAL(a, "alpha");
+    CU_ASSERT_TRUE(str_is(a));
+    str_intern_free();
+}
+
+static void str_intern__managed_input() {
+    const char * s = str("gamma");
+    const char * a = str_intern(s);
+    const char * b = str_intern("gamma");
+    CU_ASSERT_PTR_NOT_EQUAL(a, s);
+    CU_ASSERT_PTR_EQUAL(a, b);
+    str_free(s);
+    str_intern_free();
+}
+
+static void str_intern__separate_pools() {
+    str_pool * p1 = str_pool_new();
+    str_pool * p2 = str_pool_new();
+    const char * a = str_pool_intern(p1, "delta");
+    const char * b = str_pool_intern(p2, "delta");
+    CU_ASSERT_PTR_NOT_EQUAL(a, b);
+    CU_ASSERT_TRUE(str_eq(a, b));
+    CU_ASSERT_PTR_EQUAL(str_pool_intern(p1, "delta"), a);
+    CU_ASSERT_EQUAL(str_pool_size(p1), 1);
+    str_pool_free(p1);
+    str_pool_free(p2);
+}
+
+static void str_intern__many() {
+    str_pool * pool = str_pool_new();
+    const char * first[100];
+    for (int i = 0; i < 100; i++) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "key-%d", i);
+        char * s = str(buf);
+        first[i] = str_pool_intern(pool, s);
+        str_free(s);
+    }
+    CU_ASSERT_EQUAL(str_pool_size(pool), 100);
+    for (int i = 0; i < 100; i++) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "key-%d", i);
+        CU_ASSERT_PTR_EQUAL(str_pool_intern(pool, buf), first[i]);
+    }
+    CU_ASSERT_EQUAL(str_pool_size(pool), 100);
+    str_pool_free(pool);
+}
+
+static void str_intern__max_len() {
+    str_pool * pool = str_pool_new();
+    const char * a = str_pool_intern(pool, "prefix-one", &(str_opt){.max_len = 6});
+    const char * b = str_pool_intern(pool, "prefix-two", &(str_opt){.max_len = 6});
+    CU_ASSERT_PTR_EQUAL(a, b);
+    CU_ASSERT_STRING_EQUAL(a, "prefix");
+    // A managed input is hashed over the shortened bytes too, not by its cached full-length hash
+    char * s = str("prefix-three");
+    CU_ASSERT_PTR_EQUAL(str_pool_intern(pool, s, &(str_opt){.max_len = 6}), a);
+    CU_ASSERT_EQUAL(str_pool_size(pool), 1);
+    str_free(s);
+    str_pool_free(pool);
+}
+
+static void str_intern__arena_pool() {
+    arena a = arena();
+    str_pool * pool = nullptr;
+    alloc_scope(arena_allocator(&a)) {
+        pool = str_pool_new();
+    }
+    // Strings come from the pool's arena even when interned outside the scope
+    const size_t used = arena_used(&a);
+    const char * s = str_pool_intern(pool, "epsilon");
+    CU_ASSERT_PTR_NOT_NULL(s);
+    CU_ASSERT(arena_used(&a) > used);
+    str_pool_free(pool);
+    arena_free(&a);
+}
+
+static void str_intern__null() {
+    CU_ASSERT_PTR_NULL(str_intern(nullptr));
+    CU_ASSERT_TRUE(err_has());
+    err_clear();
+    CU_ASSERT_EQUAL(str_pool_size(nullptr), 0);
+    str_pool_free(nullptr);
+}
+
 // =====================================================================================================================
 // Test suite registration
 // =====================================================================================================================
@@ -763,6 +1387,21 @@ int main() {
     ADD_TEST(suite_str_hash, str_hash__different_strings);
     ADD_TEST(suite_str_hash, str_hash__null);
     ADD_TEST(suite_str_hash, str_hash__unmanaged_strings);
+    ADD_TEST(suite_str_hash, str_hash__managed_matches_unmanaged);
+
+    // str_utf8_valid() / str_utf8_len() suite
+    CU_pSuite suite_str_utf8 = CU_add_suite("str_utf8_valid() / str_utf8_len()", nullptr, nullptr);
+    if (suite_str_utf8 == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_str_utf8, str_utf8_valid__well_formed);
+    ADD_TEST(suite_str_utf8, str_utf8_valid__malformed);
+    ADD_TEST(suite_str_utf8, str_utf8_valid__matches_reference);
+    ADD_TEST(suite_str_utf8, str_utf8_valid__managed_cache_keyed_by_length);
+    ADD_TEST(suite_str_utf8, str_utf8_valid__null);
+    ADD_TEST(suite_str_utf8, str_utf8_len__counts_code_points);
+    ADD_TEST(suite_str_utf8, str_utf8_len__malformed);
 
     // str_cmp() suite
     CU_pSuite suite_str_cmp = CU_add_suite("str_cmp()", nullptr, nullptr);
@@ -784,6 +1423,8 @@ int main() {
     ADD_TEST(suite_str_eq, str_eq__equal);
     ADD_TEST(suite_str_eq, str_eq__different);
     ADD_TEST(suite_str_eq, str_eq__null);
+    ADD_TEST(suite_str_eq, str_eq__mixed_managed_unmanaged);
+    ADD_TEST(suite_str_eq, str_eq__built_strings);
 
     // str_find() suite
     CU_pSuite suite_str_find = CU_add_suite("str_find()", nullptr, nullptr);
@@ -797,6 +1438,7 @@ int main() {
     ADD_TEST(suite_str_find, str_find__at_start);
     ADD_TEST(suite_str_find, str_find__null);
     ADD_TEST(suite_str_find, str_find__large_pattern);
+    ADD_TEST(suite_str_find, str_find__matches_naive_search);
 
     // str_rfind() suite
     CU_pSuite suite_str_rfind = CU_add_suite("str_rfind()", nullptr, nullptr);
@@ -808,6 +1450,9 @@ int main() {
     ADD_TEST(suite_str_rfind, str_rfind__not_found);
     ADD_TEST(suite_str_rfind, str_rfind__empty_pattern);
     ADD_TEST(suite_str_rfind, str_rfind__large_pattern);
+    ADD_TEST(suite_str_rfind, str_rfind__single_byte);
+    ADD_TEST(suite_str_rfind, str_find_quiet__hit_and_miss);
+    ADD_TEST(suite_str_rfind, str_find_quiet__null);
 
     // str_cat() suite
     CU_pSuite suite_str_cat = CU_add_suite("str_cat()", nullptr, nullptr);
@@ -865,6 +1510,52 @@ int main() {
     ADD_TEST(suite_str_split, str_split__single);
     ADD_TEST(suite_str_split, str_split__multi_char_delim);
     ADD_TEST(suite_str_split, str_split__null);
+    ADD_TEST(suite_str_split, str_split__arena_scope);
+
+    // strview suite
+    CU_pSuite suite_str_view = CU_add_suite("strview", nullptr, nullptr); // NOLINT(*-misplaced-const)
+    if (suite_str_view == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_str_view, str_view__managed_and_literal);
+    ADD_TEST(suite_str_view, str_view__compare);
+    ADD_TEST(suite_str_view, str_view__find);
+    ADD_TEST(suite_str_view, str_view__from_view);
+    ADD_TEST(suite_str_view, str_split_iter__basic);
+    ADD_TEST(suite_str_view, str_split_iter__multi_char_delim_on_view);
+    ADD_TEST(suite_str_view, str_split_iter__no_allocation);
+    ADD_TEST(suite_str_view, str_split_iter__invalid);
+
+    // strbuf suite
+    CU_pSuite suite_strbuf = CU_add_suite("strbuf", nullptr, nullptr); // NOLINT(*-misplaced-const)
+    if (suite_strbuf == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_strbuf, strbuf__short_contents_stay_inline);
+    ADD_TEST(suite_strbuf, strbuf__grows_geometrically);
+    ADD_TEST(suite_strbuf, strbuf__finish_hands_over_buffer);
+    ADD_TEST(suite_strbuf, strbuf__spilled_contents_read_as_plain_string);
+    ADD_TEST(suite_strbuf, strbuf__addf_spills);
+    ADD_TEST(suite_strbuf, strbuf__self_append);
+    ADD_TEST(suite_strbuf, strbuf__max_len);
+    ADD_TEST(suite_strbuf, strbuf__reserve_and_clear);
+    ADD_TEST(suite_strbuf, strbuf__null);
+
+    // str_intern() suite
+    CU_pSuite suite_str_intern = CU_add_suite("str_intern()", nullptr, nullptr); // NOLINT(*-misplaced-const)
+    if (suite_str_intern == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_str_intern, str_intern__same_pointer);
+    ADD_TEST(suite_str_intern, str_intern__managed_input);
+    ADD_TEST(suite_str_intern, str_intern__separate_pools);
+    ADD_TEST(suite_str_intern, str_intern__many);
+    ADD_TEST(suite_str_intern, str_intern__max_len);
+    ADD_TEST(suite_str_intern, str_intern__arena_pool);
+    ADD_TEST(suite_str_intern, str_intern__null);
 
     CU_basic_set_mode(CU_BRM_VERBOSE);
     CU_basic_run_tests();
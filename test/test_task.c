@@ -0,0 +1,286 @@
+/*
+ * task tests.
+ */
+
+// ReSharper disable CppDFATimeOver
+#include "../src/task.h"
+#include "CUnit/Basic.h"
+#include "test.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+static constexpr size_t TASK_TEST_WORKERS = 4;
+
+// =====================================================================================================================
+// task_pool() - Pool lifecycle
+// =====================================================================================================================
+
+static void task_pool__for_explicit_workers__should_start_that_many(void) {
+    task_pool * pool = task_pool(&(task_opt){.workers = 3});
+    CU_ASSERT_PTR_NOT_NULL(pool);
+    CU_ASSERT_EQUAL(task_pool_workers(pool), 3);
+    CU_ASSERT_EQUAL(task_worker_index(), SIZE_MAX);
+    task_pool_free(pool);
+    CU_ASSERT_FALSE(err_has());
+}
+
+static void task_pool__for_default_options__should_start_at_least_one_worker(void) {
+    task_pool * pool = task_pool();
+    CU_ASSERT_PTR_NOT_NULL(pool);
+    CU_ASSERT(task_pool_workers(pool) >= 1);
+    task_pool_free(pool);
+}
+
+static void task_pool_free__with_null__should_not_crash(void) {
+    task_pool_free(nullptr);
+    CU_ASSERT_EQUAL(task_pool_workers(nullptr), 0);
+}
+
+// =====================================================================================================================
+// task_spawn() / task_wait() - Groups
+// =====================================================================================================================
+
+static constexpr size_t TASK_TEST_COUNT = 10000;
+
+typedef struct {
+    atomic_int runs[TASK_TEST_COUNT];
+} task_test_runs;
+
+typedef struct {
+    task_test_runs * runs;
+    size_t index;
+} task_test_job;
+
+static void task_test_mark(void * arg) {
+    const task_test_job * job = arg;
+    atomic_fetch_add(&job->runs->runs[job->index], 1);
+}
+
+static void task_spawn__for_many_tasks__should_run_each_exactly_once(void) {
+    task_pool * pool = task_pool(&(task_opt){.workers = TASK_TEST_WORKERS});
+    static task_test_runs runs;
+    static task_test_job jobs[TASK_TEST_COUNT];
+    memset(&runs, 0, sizeof(runs));
+
+    // More tasks than the injection queue holds: the overflow runs on the spawning thread
+    task_group g = task_group(pool);
+    for (size_t i = 0; i < TASK_TEST_COUNT; i++) {
+        jobs[i] = (task_test_job){.runs = &runs, .index = i};
+        CU_ASSERT_TRUE(task_spawn(&g, task_test_mark, &jobs[i]));
+    }
+    CU_ASSERT_TRUE(task_wait(&g));
+    CU_ASSERT_EQUAL(atomic_load(&g.pending), 0);
+
+    size_t once = 0;
+    for (size_t i = 0; i < TASK_TEST_COUNT; i++) {
+        once += atomic_load(&runs.runs[i]) == 1;
+    }
+    CU_ASSERT_EQUAL(once, TASK_TEST_COUNT);
+    CU_ASSERT_FALSE(err_has());
+    task_pool_free(pool);
+}
+
+typedef struct {
+    task_group * group;
+    atomic_size_t * leaves;
+    int depth;
+} task_test_tree;
+
+// Binary tree of tasks: inner nodes spawn both children into the shared group (onto the worker's own deque)
+static void task_test_split(void * arg) {
+    task_test_tree * node = arg;
+    if (node->depth == 0) {
+        atomic_fetch_add(node->leaves, 1);
+        mem_free(node, sizeof(task_test_tree));
+        return;
+    }
+    for (int i = 0; i < 2; i++) {
+        task_test_tree * child = mem_alloc(sizeof(task_test_tree));
+        *child = (task_test_tree){.group = node->group, .leaves = node->leaves, .depth = node->depth - 1};
+        task_spawn(node->group, task_test_split, child);
+    }
+    mem_free(node, sizeof(task_test_tree));
+}
+
+static void task_spawn__from_tasks__should_run_nested_work(void) {
+    task_pool * pool = task_pool(&(task_opt){.workers = TASK_TEST_WORKERS});
+    atomic_size_t leaves = 0;
+    task_group g = task_group(pool);
+    task_test_tree * root = mem_alloc(sizeof(task_test_tree));
+    *root = (task_test_tree){.group = &g, .leaves = &leaves, .depth = 12};
+
+    task_spawn(&g, task_test_split, root);
+    CU_ASSERT_TRUE(task_wait(&g));
+    CU_ASSERT_EQUAL(atomic_load(&leaves), (size_t)1 << 12);
+    task_pool_free(pool);
+}
+
+static void task_test_fail(void * arg) {
+    (void)arg;
+    err_set(R_ERR_PARSE_FAILED, "bad record");
+}
+
+static void task_test_nothing(void * arg) {
+    (void)arg;
+}
+
+static void task_wait__for_failing_task__should_report_its_error(void) {
+    task_pool * pool = task_pool(&(task_opt){.workers = 2});
+    task_group g = task_group(pool);
+    for (int i = 0; i < 16; i++) {
+        task_spawn(&g, i == 7 ? task_test_fail : task_test_nothing, nullptr);
+    }
+    CU_ASSERT_FALSE(task_wait(&g));
+    CU_ASSERT_EQUAL(err_code(), R_ERR_PARSE_FAILED);
+    CU_ASSERT_EQUAL(err_depth(), 1);
+    err_clear();
+
+    // The group is reusable and starts clean
+    task_spawn(&g, task_test_nothing, nullptr);
+    CU_ASSERT_TRUE(task_wait(&g));
+    CU_ASSERT_FALSE(err_has());
+    task_pool_free(pool);
+}
+
+static void task_spawn__with_invalid_arguments__should_fail(void) {
+    task_pool * pool = task_pool(&(task_opt){.workers = 1});
+    task_group g = task_group(pool);
+    CU_ASSERT_FALSE(task_spawn(nullptr, task_test_nothing, nullptr));
+    err_clear();
+    CU_ASSERT_FALSE(task_spawn(&g, nullptr, nullptr));
+    err_clear();
+    task_group orphan = task_group(nullptr);
+    CU_ASSERT_FALSE(task_spawn(&orphan, task_test_nothing, nullptr));
+    CU_ASSERT_FALSE(task_wait(&orphan));
+    err_clear();
+    CU_ASSERT_TRUE(task_wait(&g));
+    task_pool_free(pool);
+}
+
+// =====================================================================================================================
+// task_for() - Parallel loops
+// =====================================================================================================================
+
+static void task_test_count_range(void * arg, const size_t begin, const size_t end) {
+    atomic_int * hits = arg;
+    for (size_t i = begin; i < end; i++) {
+        atomic_fetch_add_explicit(&hits[i], 1, memory_order_relaxed);
+    }
+}
+
+static void task_for__for_uneven_range__should_cover_each_index_once(void) {
+    task_pool * pool = task_pool(&(task_opt){.workers = TASK_TEST_WORKERS});
+    static atomic_int hits[100003];
+    memset(hits, 0, sizeof(hits));
+
+    CU_ASSERT_TRUE(task_for(pool, 100003, 1000, task_test_count_range, hits));
+    size_t once = 0;
+    for (size_t i = 0; i < 100003; i++) {
+        once += atomic_load(&hits[i]) == 1;
+    }
+    CU_ASSERT_EQUAL(once, 100003);
+    task_pool_free(pool);
+}
+
+static void task_for__with_automatic_grain__should_cover_each_index_once(void) {
+    task_pool * pool = task_pool(&(task_opt){.workers = TASK_TEST_WORKERS});
+    static atomic_int hits[777];
+    memset(hits, 0, sizeof(hits));
+
+    CU_ASSERT_TRUE(task_for(pool, 777, 0, task_test_count_range, hits));
+    size_t once = 0;
+    for (size_t i = 0; i < 777; i++) {
+        once += atomic_load(&hits[i]) == 1;
+    }
+    CU_ASSERT_EQUAL(once, 777);
+
+    // Empty range: nothing to run
+    CU_ASSERT_TRUE(task_for(pool, 0, 0, task_test_count_range, nullptr));
+    CU_ASSERT_FALSE(err_has());
+    task_pool_free(pool);
+}
+
+// =====================================================================================================================
+// Worker arenas
+// =====================================================================================================================
+
+typedef struct {
+    atomic_int on_workers;
+    atomic_int from_arena;
+} task_test_arena_stats;
+
+static void task_test_scratch(void * arg) {
+    task_test_arena_stats * stats = arg;
+    if (task_worker_index() == SIZE_MAX) {
+        return;
+    }
+    arena probe = arena();
+    const bool from_arena = alloc_current().alloc == arena_allocator(&probe).alloc;
+    char * scratch = mem_alloc(256);
+    memset(scratch, 0x5A, 256);
+    atomic_fetch_add(&stats->on_workers, 1);
+    atomic_fetch_add(&stats->from_arena, from_arena);
+}
+
+static void task_pool__with_worker_arenas__should_allocate_from_them(void) {
+    const task_opt opt = {.workers = 2, .arena_chunk = 16 * 1024};
+    task_pool * pool = task_pool(&opt);
+    task_test_arena_stats stats = {0};
+    for (int round = 0; round < 3; round++) {
+        task_group g = task_group(pool);
+        for (int i = 0; i < 200; i++) {
+            task_spawn(&g, task_test_scratch, &stats);
+        }
+        CU_ASSERT_TRUE(task_wait(&g));
+        task_pool_reset(pool);
+    }
+    CU_ASSERT_EQUAL(atomic_load(&stats.from_arena), atomic_load(&stats.on_workers));
+    task_pool_free(pool);
+}
+
+// =====================================================================================================================
+// Test runner
+// =====================================================================================================================
+
+int main(void) {
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // task_pool() suite
+    CU_pSuite suite_pool = CU_add_suite("task_pool()", nullptr, nullptr);
+    if (suite_pool == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_pool, task_pool__for_explicit_workers__should_start_that_many);
+    ADD_TEST(suite_pool, task_pool__for_default_options__should_start_at_least_one_worker);
+    ADD_TEST(suite_pool, task_pool_free__with_null__should_not_crash);
+    ADD_TEST(suite_pool, task_pool__with_worker_arenas__should_allocate_from_them);
+
+    // task_spawn() / task_wait() suite
+    CU_pSuite suite_group = CU_add_suite("task_spawn() / task_wait()", nullptr, nullptr);
+    if (suite_group == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_group, task_spawn__for_many_tasks__should_run_each_exactly_once);
+    ADD_TEST(suite_group, task_spawn__from_tasks__should_run_nested_work);
+    ADD_TEST(suite_group, task_wait__for_failing_task__should_report_its_error);
+    ADD_TEST(suite_group, task_spawn__with_invalid_arguments__should_fail);
+
+    // task_for() suite
+    CU_pSuite suite_for = CU_add_suite("task_for()", nullptr, nullptr);
+    if (suite_for == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_for, task_for__for_uneven_range__should_cover_each_index_once);
+    ADD_TEST(suite_for, task_for__with_automatic_grain__should_cover_each_index_once);
+
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
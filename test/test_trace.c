@@ -0,0 +1,276 @@
+/*
+ * trace counter tests (built with RCFG__TRACE).
+ */
+
+// ReSharper disable CppDFATimeOver
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/coll.h"
+#include "../src/str.h"
+#include "../src/tree.h"
+
+#define T int
+#include "../src/coll.h"
+#include "../src/tree.h"
+#undef T
+
+#define K int64_t
+#define V int64_t
+#include "../src/map.h"
+#undef K
+#undef V
+
+#include "CUnit/Basic.h"
+#include "test.h"
+
+static_assert(R_TRACE_COUNTERS == 19, "update the exporter tests for new counters");
+
+// =====================================================================================================================
+// Probes
+// =====================================================================================================================
+
+static void trace_count__after_allocations__should_count_calls_and_bytes(void) {
+    trace_reset();
+    void * p = mem_alloc(100);
+    p = mem_realloc(p, 100, 300);
+    void * q = mem_alloc_zero(50);
+    mem_free(p, 300);
+    mem_free(q, 50);
+    mem_free(nullptr, 0);
+    CU_ASSERT_EQUAL(trace_count(R_TRACE_ALLOCS), 2);
+    CU_ASSERT_EQUAL(trace_count(R_TRACE_REALLOCS), 1);
+    CU_ASSERT_EQUAL(trace_count(R_TRACE_FREES), 2);
+    CU_ASSERT_EQUAL(trace_count(R_TRACE_ALLOC_BYTES), 100 + 200 + 50);
+}
+
+static void trace_count__after_rbt_inserts__should_track_depth_and_rotations(void) {
+    RBT(int) t = rbt(int);
+    trace_reset();
+    // Ascending keys: every insert after the second rebalances the right spine
+    for (int i = 0; i < 1023; i++)
+        rbt_insert(&t, i);
+    rbt_insert(&t, 5); // already present
+    CU_ASSERT_EQUAL(trace_count(R_TRACE_RBT_INSERTS), 1023);
+    CU_ASSERT(trace_count(R_TRACE_RBT_ROTATIONS) > 900);
+    // A red-black tree of 1023 nodes is at most 2 * log2(1024) deep
+    const uint64_t max_depth = trace_count(R_TRACE_RBT_DEPTH_MAX);
+    CU_ASSERT(max_depth >= 9);
+    CU_ASSERT(max_depth <= 20);
+    CU_ASSERT(trace_count(R_TRACE_RBT_DEPTH) <= 1023 * max_depth);
+    rbt_free(&t);
+}
+
+static void trace_count__after_queue_overflow__should_count_full_and_empty(void) {
+    LFQ(int) q = lfq(int, 4);
+    trace_reset();
+    // One slot stays free: 3 fit
+    for (int i = 0; i < 5; i++)
+        lfq_push(&q, i);
+    int out[8];
+    CU_ASSERT_EQUAL(lfq_pop_n(&q, out, 8), 3);
+    lfq_pop(&q);
+    lfq_pop_n(&q, out, 8);
+    err_clear();
+    CU_ASSERT_EQUAL(trace_count(R_TRACE_LFQ_FULL), 2);
+    CU_ASSERT_EQUAL(trace_count(R_TRACE_LFQ_EMPTY), 2);
+    lfq_free(&q);
+
+    MPMC(int) m = mpmc(int, 2);
+    mpmc_push(&m, 1);
+    mpmc_push(&m, 2);
+    mpmc_push(&m, 3);
+    mpmc_pop(&m);
+    mpmc_pop(&m);
+    mpmc_pop(&m);
+    err_clear();
+    CU_ASSERT_EQUAL(trace_count(R_TRACE_MPMC_FULL), 1);
+    CU_ASSERT_EQUAL(trace_count(R_TRACE_MPMC_EMPTY), 1);
+    mpmc_free(&m);
+}
+
+static void trace_count__after_str_find__should_count_bytes_scanned(void) {
+    trace_reset();
+    const char * text = "the quick brown fox jumps over the lazy dog";
+    CU_ASSERT_PTR_NOT_NULL(str_find(text, "fox"));   // ends at 19
+    CU_ASSERT_PTR_NOT_NULL(str_rfind(text, "the"));  // starts at 31, 12 bytes from the end
+    CU_ASSERT_PTR_NULL(str_find_quiet(text, "cat")); // whole text
+    CU_ASSERT_EQUAL(trace_count(R_TRACE_STR_FINDS), 3);
+    CU_ASSERT_EQUAL(trace_count(R_TRACE_STR_FIND_BYTES), 19 + 12 + strlen(text));
+}
+
+static void trace_count__after_map_use__should_count_probes_and_rehashes(void) {
+    MAP(int64_t, int64_t) m = map(int64_t, int64_t);
+    trace_reset();
+    for (int64_t i = 0; i < 10000; i++)
+        map_put(&m, i, i);
+    const uint64_t rehashes = trace_count(R_TRACE_MAP_REHASHES);
+    CU_ASSERT(rehashes > 5);
+    for (int64_t i = 0; i < 10000; i++)
+        map_get(&m, i);
+    // Each put and get is one lookup of at least one group, except the first put into the empty table
+    CU_ASSERT_EQUAL(trace_count(R_TRACE_MAP_FINDS), 19999);
+    CU_ASSERT(trace_count(R_TRACE_MAP_PROBES) >= trace_count(R_TRACE_MAP_FINDS));
+    CU_ASSERT(trace_count(R_TRACE_MAP_PROBES_MAX) >= 1);
+    CU_ASSERT(trace_count(R_TRACE_MAP_REHASH_NS) > 0);
+    map_free(&m);
+}
+
+// =====================================================================================================================
+// Aggregation
+// =====================================================================================================================
+
+enum { TRACE_TEST_THREADS = 8, TRACE_TEST_ALLOCS = 1000 };
+
+static void * trace_test_worker(void * arg) {
+    (void)arg;
+    for (int i = 0; i < TRACE_TEST_ALLOCS; i++)
+        mem_free(mem_alloc(16), 16);
+    return nullptr;
+}
+
+static void trace_snapshot__after_threads_exit__should_keep_their_counts(void) {
+    trace_reset();
+    pthread_t threads[TRACE_TEST_THREADS];
+    for (int t = 0; t < TRACE_TEST_THREADS; t++)
+        pthread_create(&threads[t], nullptr, trace_test_worker, nullptr);
+    for (int t = 0; t < TRACE_TEST_THREADS; t++)
+        pthread_join(threads[t], nullptr);
+    trace_stats stats;
+    trace_snapshot(&stats);
+    CU_ASSERT_EQUAL(stats.counters[R_TRACE_ALLOCS], TRACE_TEST_THREADS * TRACE_TEST_ALLOCS);
+    CU_ASSERT_EQUAL(stats.counters[R_TRACE_FREES], TRACE_TEST_THREADS * TRACE_TEST_ALLOCS);
+    CU_ASSERT_EQUAL(stats.counters[R_TRACE_ALLOC_BYTES], TRACE_TEST_THREADS * TRACE_TEST_ALLOCS * 16);
+
+    // A reset also clears the blocks of exited threads
+    trace_reset();
+    trace_snapshot(&stats);
+    CU_ASSERT_EQUAL(stats.counters[R_TRACE_ALLOCS], 0);
+    CU_ASSERT_EQUAL(trace_count(R_TRACE_COUNTERS), 0);
+}
+
+static void * trace_test_block_worker(void * arg) {
+    (void)arg;
+    mem_free(mem_alloc(16), 16);
+    return r_trace_local;
+}
+
+static void trace_snapshot__after_threads_exit_one_by_one__should_reuse_their_block(void) {
+    trace_reset();
+    void * first = nullptr;
+    for (int t = 0; t < TRACE_TEST_ALLOCS; t++) {
+        pthread_t thread;
+        void * block = nullptr;
+        pthread_create(&thread, nullptr, trace_test_block_worker, nullptr);
+        pthread_join(thread, &block);
+        if (t == 0)
+            first = block;
+        // The same blocks are free before every start, so each thread takes over the same one
+        CU_ASSERT_PTR_EQUAL(block, first);
+    }
+    CU_ASSERT_PTR_NOT_NULL(first);
+    CU_ASSERT_EQUAL(trace_count(R_TRACE_ALLOCS), TRACE_TEST_ALLOCS);
+    CU_ASSERT_EQUAL(trace_count(R_TRACE_FREES), TRACE_TEST_ALLOCS);
+}
+
+// =====================================================================================================================
+// Exporters
+// =====================================================================================================================
+
+typedef struct {
+    size_t calls;
+    size_t gauges;
+    uint64_t frees;
+} trace_test_sink;
+
+static void trace_test_export(void * ctx, const trace_metric * metric) {
+    trace_test_sink * sink = ctx;
+    sink->calls++;
+    sink->gauges += metric->max;
+    if (strcmp(metric->name, "frees") == 0)
+        sink->frees = metric->value;
+}
+
+static void trace_export__with_callback__should_visit_every_counter(void) {
+    trace_reset();
+    mem_free(mem_alloc(8), 8);
+    trace_test_sink sink = {0};
+    trace_export(trace_test_export, &sink);
+    CU_ASSERT_EQUAL(sink.calls, R_TRACE_COUNTERS);
+    CU_ASSERT_EQUAL(sink.gauges, 2);
+    CU_ASSERT_EQUAL(sink.frees, 1);
+}
+
+static void trace_prometheus__should_write_help_type_and_value(void) {
+    trace_reset();
+    mem_free(mem_alloc(8), 8);
+    char buf[8192] = {0};
+    FILE * f = tmpfile();
+    trace_prometheus(f);
+    rewind(f);
+    const size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    CU_ASSERT(n > 0);
+    CU_ASSERT_PTR_NOT_NULL(strstr(buf, "# TYPE rune_allocs_total counter\nrune_allocs_total 1\n"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(buf, "# TYPE rune_rbt_depth_max gauge\nrune_rbt_depth_max 0\n"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(buf, "# HELP rune_lfq_full_total "));
+}
+
+static void trace_json__should_write_one_object(void) {
+    trace_reset();
+    mem_free(mem_alloc(8), 8);
+    char buf[4096] = {0};
+    FILE * f = tmpfile();
+    trace_json(f);
+    rewind(f);
+    const size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    CU_ASSERT(n > 0);
+    CU_ASSERT_EQUAL(buf[0], '{');
+    CU_ASSERT_PTR_NOT_NULL(strstr(buf, "\n  \"allocs\": 1,\n"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(buf, "\n  \"map_rehash_ns\": 0\n}\n"));
+}
+
+int main(void) {
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // Probe suite
+    CU_pSuite suite_probes = CU_add_suite("trace probes", nullptr, nullptr);
+    if (suite_probes == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_probes, trace_count__after_allocations__should_count_calls_and_bytes);
+    ADD_TEST(suite_probes, trace_count__after_rbt_inserts__should_track_depth_and_rotations);
+    ADD_TEST(suite_probes, trace_count__after_queue_overflow__should_count_full_and_empty);
+    ADD_TEST(suite_probes, trace_count__after_str_find__should_count_bytes_scanned);
+    ADD_TEST(suite_probes, trace_count__after_map_use__should_count_probes_and_rehashes);
+
+    // Aggregation suite
+    CU_pSuite suite_sum = CU_add_suite("trace_snapshot() / trace_reset()", nullptr, nullptr);
+    if (suite_sum == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_sum, trace_snapshot__after_threads_exit__should_keep_their_counts);
+    ADD_TEST(suite_sum, trace_snapshot__after_threads_exit_one_by_one__should_reuse_their_block);
+
+    // Exporter suite
+    CU_pSuite suite_export = CU_add_suite("trace_export() / trace_prometheus() / trace_json()", nullptr, nullptr);
+    if (suite_export == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_export, trace_export__with_callback__should_visit_every_counter);
+    ADD_TEST(suite_export, trace_prometheus__should_write_help_type_and_value);
+    ADD_TEST(suite_export, trace_json__should_write_one_object);
+
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
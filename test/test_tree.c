@@ -9,12 +9,24 @@
 #include "test.h"
 
 #include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
 
 // Define RBT(int) for testing
 #define T int
 #include "../src/tree.h"
 #undef T
 
+// Wide key type: one key per cache line pair forces the minimum B-tree degree, so small tests reach deep trees
+typedef struct {
+    int64_t id;
+    char pad[120];
+} btree_wide;
+
+#define T btree_wide
+#include "../src/tree.h"
+#undef T
+
 // =====================================================================================================================
 // RBT helper functions
 // =====================================================================================================================
@@ -100,6 +112,58 @@ static bool rbt_tree_check_bst(const struct RBT_NODE(int) * node, int min_val, i
     return rbt_tree_check_bst(node->left, min_val, node->data) && rbt_tree_check_bst(node->right, node->data, max_val);
 }
 
+// Check that every child points back at its parent
+static bool rbt_tree_check_parents(const struct RBT_NODE(int) * node, const struct RBT_NODE(int) * parent) {
+    if (node == nullptr) {
+        return true;
+    }
+    if (node->parent != parent) {
+        return false;
+    }
+    return rbt_tree_check_parents(node->left, node) && rbt_tree_check_parents(node->right, node);
+}
+
+// Check all red-black and linkage invariants at once
+static bool rbt_tree_check_all(const RBT(int) * tree) {
+    return (tree->root == nullptr || tree->root->color == R_(rbt_black)) && rbt_tree_check_no_red_red(tree->root) &&
+           rbt_tree_black_height(tree->root) != -1 && rbt_tree_check_bst(tree->root, INT_MIN, INT_MAX) &&
+           rbt_tree_check_parents(tree->root, nullptr) && rbt_tree_count_nodes(tree->root) == tree->size;
+}
+
+// Allocation counters for the rbt_clear() tests
+typedef struct {
+    size_t allocs;
+    size_t frees;
+    size_t bytes_allocated;
+    size_t bytes_freed;
+} rbt_tree_alloc_stats;
+
+static void * rbt_tree_count_alloc(void * ctx, const size_t size) {
+    rbt_tree_alloc_stats * stats = ctx;
+    stats->allocs++;
+    stats->bytes_allocated += size;
+    return malloc(size);
+}
+
+static void * rbt_tree_count_realloc(void * ctx, void * ptr, const size_t old_size, const size_t new_size) {
+    rbt_tree_alloc_stats * stats = ctx;
+    stats->bytes_allocated += new_size;
+    stats->bytes_freed += old_size;
+    return realloc(ptr, new_size);
+}
+
+static void rbt_tree_count_free(void * ctx, void * ptr, const size_t size) {
+    rbt_tree_alloc_stats * stats = ctx;
+    stats->frees++;
+    stats->bytes_freed += size;
+    free(ptr);
+}
+
+static allocator rbt_tree_counting_allocator(rbt_tree_alloc_stats * stats) {
+    return (allocator){
+        .alloc = rbt_tree_count_alloc, .realloc = rbt_tree_count_realloc, .free = rbt_tree_count_free, .ctx = stats};
+}
+
 // =====================================================================================================================
 // BST API tests
 // =====================================================================================================================
@@ -1225,6 +1289,61 @@ static void rbt_remove__for_stress_test_insert_remove_patterns__should_maintain_
     rbt_tree_free_tree(tree.root);
 }
 
+static void rbt_remove__for_red_node_with_black_successor__should_recolor_successor_child(void) {
+    // Arrange - Ascending inserts leave 3 red with children 2 and 4, and 4 has a red right child
+    RBT(int) tree = rbt(int);
+    for (int i = 0; i < 6; i++) {
+        rbt_insert(&tree, i);
+    }
+
+    // Act
+    rbt_remove(&tree, 3);
+
+    // Assert
+    CU_ASSERT_FALSE(rbt_contains(&tree, 3));
+    CU_ASSERT_TRUE(rbt_tree_check_all(&tree));
+
+    // Cleanup
+    rbt_free(&tree);
+}
+
+static void rbt_remove__for_slab_allocator_scope__should_recycle_nodes(void) {
+    // Arrange
+    slab s = slab();
+    RBT(int) tree = rbt(int);
+    struct RBT_NODE(int) * removed[13];
+    size_t n_removed = 0;
+
+    alloc_scope(slab_allocator(&s)) {
+        for (int i = 1; i <= 50; i++) {
+            rbt_insert(&tree, i);
+        }
+
+        // Act - Nodes freed by remove are handed back out by the next inserts
+        for (int i = 1; i <= 25; i += 2) {
+            removed[n_removed++] = bst_find(&tree, i);
+            rbt_remove(&tree, i);
+        }
+        for (int i = 51; i <= 63; i++) {
+            rbt_insert(&tree, i);
+        }
+    }
+
+    // Assert
+    CU_ASSERT_EQUAL(tree.size, 50);
+    for (size_t i = 0; i < n_removed; i++) {
+        bool reused = false;
+        for (int v = 51; v <= 63; v++) {
+            reused = reused || bst_find(&tree, v) == removed[i];
+        }
+        CU_ASSERT_TRUE(reused);
+    }
+    CU_ASSERT(rbt_tree_check_bst(tree.root, INT_MIN, INT_MAX));
+
+    // Cleanup - nodes go away with the slab
+    slab_free(&s);
+}
+
 // =====================================================================================================================
 // RBT SIZE FIELD TRACKING TESTS
 // =====================================================================================================================
@@ -1457,6 +1576,671 @@ static void rbt__with_custom_comparator__should_use_custom_comparison(void) {
     rbt_tree_free_tree(tree.root);
 }
 
+// =====================================================================================================================
+// rbt_build_sorted() / rbt_clear() tests
+// =====================================================================================================================
+
+static void rbt_build_sorted__for_empty_input__should_leave_tree_empty(void) {
+    // Arrange
+    RBT(int) tree = rbt(int);
+    rbt_insert(&tree, 1);
+
+    // Act
+    const bool ok = rbt_build_sorted(&tree, (int *)nullptr, 0);
+
+    // Assert
+    CU_ASSERT_TRUE(ok);
+    CU_ASSERT_PTR_NULL(tree.root);
+    CU_ASSERT_EQUAL(tree.size, 0);
+    CU_ASSERT_PTR_NULL(tree.block);
+}
+
+static void rbt_build_sorted__for_every_size_up_to_300__should_satisfy_invariants(void) {
+    int values[300];
+    for (int i = 0; i < 300; i++) {
+        values[i] = 3 * i - 200;
+    }
+
+    for (size_t n = 1; n <= 300; n++) {
+        // Arrange & Act
+        RBT(int) tree = rbt(int);
+        CU_ASSERT_TRUE(rbt_build_sorted(&tree, values, n));
+
+        // Assert
+        CU_ASSERT_EQUAL(tree.size, n);
+        CU_ASSERT_TRUE(rbt_tree_check_all(&tree));
+        bool found_all = true;
+        for (size_t i = 0; i < n; i++) {
+            found_all = found_all && rbt_contains(&tree, values[i]);
+        }
+        CU_ASSERT_TRUE(found_all);
+        CU_ASSERT_FALSE(rbt_contains(&tree, values[0] - 1));
+        CU_ASSERT_FALSE(rbt_contains(&tree, values[n - 1] + 1));
+
+        // Cleanup
+        rbt_free(&tree);
+    }
+}
+
+static void rbt_build_sorted__for_sorted_input__should_lay_out_nodes_in_key_order(void) {
+    // Arrange
+    int values[100];
+    for (int i = 0; i < 100; i++) {
+        values[i] = i * 2;
+    }
+    RBT(int) tree = rbt(int);
+
+    // Act
+    rbt_build_sorted(&tree, values, 100);
+
+    // Assert - One block, node i holds the i-th smallest key
+    CU_ASSERT_PTR_NOT_NULL(tree.block);
+    CU_ASSERT_EQUAL(tree.block_len, 100);
+    CU_ASSERT_PTR_EQUAL(bst_min(tree.root), &tree.block[0]);
+    for (int i = 0; i < 100; i++) {
+        CU_ASSERT_EQUAL(tree.block[i].data, values[i]);
+        CU_ASSERT_PTR_EQUAL(bst_find(&tree, values[i]), &tree.block[i]);
+    }
+
+    // Cleanup
+    rbt_free(&tree);
+}
+
+static void rbt_build_sorted__for_non_empty_tree__should_replace_contents(void) {
+    // Arrange
+    rbt_tree_alloc_stats stats = {0};
+    RBT(int) tree = rbt(int);
+    const int values[] = {100, 200, 300};
+
+    alloc_scope(rbt_tree_counting_allocator(&stats)) {
+        for (int i = 0; i < 20; i++) {
+            rbt_insert(&tree, i);
+        }
+
+        // Act
+        rbt_build_sorted(&tree, values, 3);
+
+        // Assert - Old nodes were released, only the block remains
+        CU_ASSERT_EQUAL(tree.size, 3);
+        CU_ASSERT_FALSE(rbt_contains(&tree, 5));
+        CU_ASSERT_TRUE(rbt_contains(&tree, 200));
+        CU_ASSERT_EQUAL(stats.allocs, 21);
+        CU_ASSERT_EQUAL(stats.frees, 20);
+        CU_ASSERT_TRUE(rbt_tree_check_all(&tree));
+
+        // Cleanup
+        rbt_free(&tree);
+    }
+}
+
+static void rbt_build_sorted__followed_by_insert_and_remove__should_maintain_invariants(void) {
+    // Arrange
+    int values[200];
+    for (int i = 0; i < 200; i++) {
+        values[i] = i * 2;
+    }
+    RBT(int) tree = rbt(int);
+    rbt_build_sorted(&tree, values, 200);
+
+    // Act - Odd keys go into freshly allocated nodes, every third even key is removed from the block
+    for (int i = 1; i < 400; i += 4) {
+        rbt_insert(&tree, i);
+    }
+    for (int i = 0; i < 400; i += 6) {
+        rbt_remove(&tree, i);
+    }
+
+    // Assert
+    CU_ASSERT_TRUE(rbt_tree_check_all(&tree));
+    CU_ASSERT_EQUAL(tree.size, 200 + 100 - 67);
+    CU_ASSERT_EQUAL(tree.block_live, 200 - 67);
+    CU_ASSERT_TRUE(rbt_contains(&tree, 5));
+    CU_ASSERT_TRUE(rbt_contains(&tree, 2));
+    CU_ASSERT_FALSE(rbt_contains(&tree, 6));
+
+    // Cleanup
+    rbt_free(&tree);
+}
+
+static void rbt_clear__for_built_tree__should_release_block_in_single_free(void) {
+    // Arrange
+    rbt_tree_alloc_stats stats = {0};
+    int values[1000];
+    for (int i = 0; i < 1000; i++) {
+        values[i] = i;
+    }
+    RBT(int) tree = rbt(int);
+
+    alloc_scope(rbt_tree_counting_allocator(&stats)) {
+        rbt_build_sorted(&tree, values, 1000);
+
+        // Act
+        rbt_clear(&tree);
+    }
+
+    // Assert
+    CU_ASSERT_EQUAL(stats.allocs, 1);
+    CU_ASSERT_EQUAL(stats.frees, 1);
+    CU_ASSERT_EQUAL(stats.bytes_freed, stats.bytes_allocated);
+    CU_ASSERT_PTR_NULL(tree.root);
+    CU_ASSERT_EQUAL(tree.size, 0);
+    CU_ASSERT_PTR_NULL(tree.block);
+}
+
+static void rbt_clear__for_mixed_tree__should_free_every_node(void) {
+    // Arrange
+    rbt_tree_alloc_stats stats = {0};
+    int values[64];
+    for (int i = 0; i < 64; i++) {
+        values[i] = i * 10;
+    }
+    RBT(int) tree = rbt(int);
+
+    alloc_scope(rbt_tree_counting_allocator(&stats)) {
+        rbt_build_sorted(&tree, values, 64);
+        for (int i = 5; i < 640; i += 20) {
+            rbt_insert(&tree, i);
+        }
+        rbt_remove(&tree, 100);
+        rbt_remove(&tree, 25);
+
+        // Act
+        rbt_clear(&tree);
+    }
+
+    // Assert - Every loose node freed individually, the block once
+    CU_ASSERT_EQUAL(stats.allocs, 1 + 32);
+    CU_ASSERT_EQUAL(stats.frees, stats.allocs);
+    CU_ASSERT_EQUAL(stats.bytes_freed, stats.bytes_allocated);
+    CU_ASSERT_PTR_NULL(tree.root);
+    CU_ASSERT_EQUAL(tree.size, 0);
+}
+
+static void rbt_free__for_inserted_tree__should_leave_reusable_tree(void) {
+    // Arrange
+    RBT(int) tree = rbt(int);
+    for (int i = 0; i < 100; i++) {
+        rbt_insert(&tree, i);
+    }
+
+    // Act
+    rbt_free(&tree);
+    rbt_insert(&tree, 7);
+
+    // Assert
+    CU_ASSERT_EQUAL(tree.size, 1);
+    CU_ASSERT_TRUE(rbt_contains(&tree, 7));
+    CU_ASSERT_FALSE(rbt_contains(&tree, 8));
+
+    // Cleanup
+    rbt_free(&tree);
+}
+
+// =====================================================================================================================
+// Iteration and range query tests
+// =====================================================================================================================
+
+static void bst_next__for_every_node__should_visit_values_in_ascending_order(void) {
+    // Arrange - Scrambled insert order so the links differ from a built tree
+    RBT(int) tree = rbt(int);
+    for (int i = 0; i < 97; i++) {
+        rbt_insert(&tree, (i * 37) % 97);
+    }
+
+    // Act
+    int expected = 0;
+    size_t visited = 0;
+    for (struct RBT_NODE(int) * node = rbt_first(&tree); node != nullptr; node = bst_next(node)) {
+        CU_ASSERT_EQUAL(node->data, expected);
+        expected++;
+        visited++;
+    }
+
+    // Assert
+    CU_ASSERT_EQUAL(visited, 97);
+    CU_ASSERT_EQUAL(rbt_first(&tree)->data, 0);
+    CU_ASSERT_EQUAL(rbt_last(&tree)->data, 96);
+
+    // Cleanup
+    rbt_free(&tree);
+}
+
+static void bst_prev__from_last_node__should_visit_values_in_descending_order(void) {
+    // Arrange
+    RBT(int) tree = rbt(int);
+    for (int i = 0; i < 50; i++) {
+        rbt_insert(&tree, 49 - i);
+    }
+
+    // Act
+    int expected = 49;
+    for (struct RBT_NODE(int) * node = rbt_last(&tree); node != nullptr; node = bst_prev(node)) {
+        CU_ASSERT_EQUAL(node->data, expected);
+        expected--;
+    }
+
+    // Assert
+    CU_ASSERT_EQUAL(expected, -1);
+
+    // Cleanup
+    rbt_free(&tree);
+}
+
+static void rbt_first__for_empty_tree__should_return_null(void) {
+    // Arrange
+    RBT(int) tree = rbt(int);
+
+    // Act & Assert
+    CU_ASSERT_PTR_NULL(rbt_first(&tree));
+    CU_ASSERT_PTR_NULL(rbt_last(&tree));
+    CU_ASSERT_PTR_NULL(rbt_lower_bound(&tree, 0));
+    CU_ASSERT_PTR_NULL(rbt_upper_bound(&tree, 0));
+    CU_ASSERT_PTR_NULL(bst_next(rbt_first(&tree)));
+}
+
+static void rbt_lower_bound__for_present_and_absent_values__should_return_first_not_less(void) {
+    // Arrange - Even values 0..98
+    int values[50];
+    for (int i = 0; i < 50; i++) {
+        values[i] = i * 2;
+    }
+    RBT(int) tree = rbt(int);
+    rbt_build_sorted(&tree, values, 50);
+
+    // Act & Assert
+    CU_ASSERT_EQUAL(rbt_lower_bound(&tree, 10)->data, 10);
+    CU_ASSERT_EQUAL(rbt_lower_bound(&tree, 11)->data, 12);
+    CU_ASSERT_EQUAL(rbt_lower_bound(&tree, -5)->data, 0);
+    CU_ASSERT_EQUAL(rbt_lower_bound(&tree, 98)->data, 98);
+    CU_ASSERT_PTR_NULL(rbt_lower_bound(&tree, 99));
+
+    // Cleanup
+    rbt_free(&tree);
+}
+
+static void rbt_upper_bound__for_present_and_absent_values__should_return_first_greater(void) {
+    // Arrange - Even values 0..98
+    int values[50];
+    for (int i = 0; i < 50; i++) {
+        values[i] = i * 2;
+    }
+    RBT(int) tree = rbt(int);
+    rbt_build_sorted(&tree, values, 50);
+
+    // Act & Assert
+    CU_ASSERT_EQUAL(rbt_upper_bound(&tree, 10)->data, 12);
+    CU_ASSERT_EQUAL(rbt_upper_bound(&tree, 11)->data, 12);
+    CU_ASSERT_EQUAL(rbt_upper_bound(&tree, -5)->data, 0);
+    CU_ASSERT_PTR_NULL(rbt_upper_bound(&tree, 98));
+
+    // Cleanup
+    rbt_free(&tree);
+}
+
+static void rbt_foreach__for_populated_tree__should_visit_each_value_once_in_order(void) {
+    // Arrange
+    RBT(int) tree = rbt(int);
+    for (int i = 0; i < 64; i++) {
+        rbt_insert(&tree, (i * 13) % 64);
+    }
+
+    // Act
+    int sum = 0;
+    int prev = -1;
+    bool ordered = true;
+    rbt_foreach(&tree, node) {
+        ordered = ordered && node->data > prev;
+        prev = node->data;
+        sum += node->data;
+    }
+
+    // Assert
+    CU_ASSERT_TRUE(ordered);
+    CU_ASSERT_EQUAL(sum, 63 * 64 / 2);
+
+    // Cleanup
+    rbt_free(&tree);
+}
+
+static void rbt_foreach_range__for_half_open_range__should_visit_only_values_in_range(void) {
+    // Arrange
+    RBT(int) tree = rbt(int);
+    for (int i = 0; i < 100; i += 3) {
+        rbt_insert(&tree, i);
+    }
+
+    // Act - [10, 30) holds 12, 15, 18, 21, 24, 27
+    int visited[16];
+    size_t n = 0;
+    rbt_foreach_range(&tree, 10, 30, node) {
+        visited[n++] = node->data;
+    }
+
+    // Assert
+    CU_ASSERT_EQUAL(n, 6);
+    for (size_t i = 0; i < n; i++) {
+        CU_ASSERT_EQUAL(visited[i], 12 + 3 * (int)i);
+    }
+
+    // Cleanup
+    rbt_free(&tree);
+}
+
+static void rbt_foreach_range__for_empty_or_inverted_range__should_visit_nothing(void) {
+    // Arrange
+    RBT(int) tree = rbt(int);
+    for (int i = 0; i < 20; i++) {
+        rbt_insert(&tree, i);
+    }
+
+    // Act
+    size_t n = 0;
+    rbt_foreach_range(&tree, 5, 5, node) {
+        n++;
+    }
+    rbt_foreach_range(&tree, 10, 3, node) {
+        n++;
+    }
+    rbt_foreach_range(&tree, 100, 200, node) {
+        n++;
+    }
+
+    // Assert
+    CU_ASSERT_EQUAL(n, 0);
+
+    // Cleanup
+    rbt_free(&tree);
+}
+
+static void rbt_foreach_range__with_custom_comparator__should_follow_comparator_order(void) {
+    // Arrange - Descending order: the range [20, 15) holds 20, 19, 18, 17, 16
+    RBT(int) tree = rbt(int);
+    for (int i = 0; i < 30; i++) {
+        rbt_insert(&tree, i, rbt_tree_cmp_reverse);
+    }
+
+    // Act
+    int expected = 20;
+    size_t n = 0;
+    rbt_foreach_range(&tree, 20, 15, node, rbt_tree_cmp_reverse) {
+        CU_ASSERT_EQUAL(node->data, expected);
+        expected--;
+        n++;
+    }
+
+    // Assert
+    CU_ASSERT_EQUAL(n, 5);
+    CU_ASSERT_EQUAL(rbt_lower_bound(&tree, 40, rbt_tree_cmp_reverse)->data, 29);
+    CU_ASSERT_PTR_NULL(rbt_upper_bound(&tree, 0, rbt_tree_cmp_reverse));
+
+    // Cleanup
+    rbt_free(&tree);
+}
+
+// =====================================================================================================================
+// BTREE() tests
+// =====================================================================================================================
+
+// Validate a B-tree subtree: ordering within (lo, hi), key counts per node and uniform leaf depth
+static bool btree_test_check_node(
+    const struct BTREE_NODE(int) * node, const long lo, const long hi, const size_t depth, size_t * leaf_depth,
+    size_t * count, const bool is_root
+) {
+    const size_t cap = sizeof(node->keys) / sizeof(node->keys[0]);
+    if (node->len > cap || (!is_root && node->len < (cap + 1) / 2 - 1) || node->len == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < node->len; i++) {
+        const long prev = i == 0 ? lo : node->keys[i - 1];
+        if (node->keys[i] <= prev || node->keys[i] >= hi) {
+            return false;
+        }
+    }
+    *count += node->len;
+    if (node->leaf) {
+        if (*leaf_depth == SIZE_MAX) {
+            *leaf_depth = depth;
+        }
+        return *leaf_depth == depth;
+    }
+    for (size_t i = 0; i <= node->len; i++) {
+        const long child_lo = i == 0 ? lo : node->keys[i - 1];
+        const long child_hi = i == node->len ? hi : node->keys[i];
+        if (!btree_test_check_node(node->children[i], child_lo, child_hi, depth + 1, leaf_depth, count, false)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool btree_test_check(const BTREE(int) * tree) {
+    if (tree->root == nullptr) {
+        return tree->size == 0;
+    }
+    size_t leaf_depth = SIZE_MAX;
+    size_t count = 0;
+    return btree_test_check_node(tree->root, LONG_MIN, LONG_MAX, 0, &leaf_depth, &count, true) && count == tree->size;
+}
+
+static int btree_test_wide_cmp(const btree_wide a, const btree_wide b) {
+    return (a.id > b.id) - (a.id < b.id);
+}
+
+static btree_wide btree_test_wide(const int64_t id) {
+    return (btree_wide){.id = id};
+}
+
+static void btree__for_new_tree__should_be_empty(void) {
+    // Arrange
+    BTREE(int) tree = btree(int);
+
+    // Act & Assert
+    CU_ASSERT_EQUAL(btree_size(&tree), 0);
+    CU_ASSERT_FALSE(btree_contains(&tree, 1));
+    CU_ASSERT_FALSE(btree_remove(&tree, 1));
+    CU_ASSERT_PTR_NULL(btree_find(&tree, 1));
+    btree_free(&tree);
+}
+
+static void btree_node__for_int_keys__should_fit_configured_node_bytes(void) {
+    // Arrange
+    BTREE(int) tree = btree(int);
+
+    // Act & Assert - A leaf is header plus keys within R_BTREE_NODE_BYTES, with an odd key capacity
+    CU_ASSERT_TRUE(sizeof(struct BTREE_NODE(int)) <= R_BTREE_NODE_BYTES);
+    CU_ASSERT_EQUAL(btree_node_cap(&tree), 2 * R_BTREE_DEGREE(int) - 1);
+    CU_ASSERT_EQUAL(btree_node_cap(&tree) % 2, 1);
+    CU_ASSERT_EQUAL(btree_node_cap((BTREE(btree_wide) *)nullptr), 3);
+}
+
+static void btree_insert__for_ascending_keys__should_keep_all_invariants(void) {
+    // Arrange
+    BTREE(int) tree = btree(int);
+
+    // Act
+    bool all_added = true;
+    for (int i = 0; i < 10000; i++) {
+        all_added = all_added && btree_insert(&tree, i);
+    }
+
+    // Assert
+    CU_ASSERT_TRUE(all_added);
+    CU_ASSERT_EQUAL(btree_size(&tree), 10000);
+    CU_ASSERT_TRUE(btree_test_check(&tree));
+    bool found_all = true;
+    for (int i = 0; i < 10000; i++) {
+        found_all = found_all && btree_contains(&tree, i);
+    }
+    CU_ASSERT_TRUE(found_all);
+    CU_ASSERT_FALSE(btree_contains(&tree, -1));
+    CU_ASSERT_FALSE(btree_contains(&tree, 10000));
+
+    // Cleanup
+    btree_free(&tree);
+}
+
+static void btree_insert__for_duplicate_key__should_return_false_and_keep_size(void) {
+    // Arrange
+    BTREE(int) tree = btree(int);
+    for (int i = 0; i < 500; i++) {
+        btree_insert(&tree, i * 2);
+    }
+
+    // Act
+    const bool added_again = btree_insert(&tree, 250);
+    const bool added_new = btree_insert(&tree, 251);
+
+    // Assert
+    CU_ASSERT_FALSE(added_again);
+    CU_ASSERT_TRUE(added_new);
+    CU_ASSERT_EQUAL(btree_size(&tree), 501);
+    CU_ASSERT_TRUE(btree_test_check(&tree));
+
+    // Cleanup
+    btree_free(&tree);
+}
+
+static void btree_find__for_present_key__should_return_pointer_to_stored_key(void) {
+    // Arrange
+    BTREE(int) tree = btree(int);
+    for (int i = 0; i < 200; i++) {
+        btree_insert(&tree, (i * 71) % 200);
+    }
+
+    // Act
+    const int * key = btree_find(&tree, 123);
+
+    // Assert
+    CU_ASSERT_PTR_NOT_NULL(key);
+    CU_ASSERT_EQUAL(*key, 123);
+    CU_ASSERT_PTR_NULL(btree_find(&tree, 200));
+
+    // Cleanup
+    btree_free(&tree);
+}
+
+static void btree_remove__for_random_operations__should_match_reference_set(void) {
+    // Arrange
+    BTREE(int) tree = btree(int);
+    static bool present[4096];
+    memset(present, 0, sizeof(present));
+    size_t expected = 0;
+    uint32_t x = 2463534242u;
+
+    // Act - Mixed inserts and removes over a small key space, so nodes split, borrow and merge constantly
+    bool consistent = true;
+    for (int op = 0; op < 100000; op++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        const int key = (int)(x % 4096);
+        if ((x >> 20) & 1) {
+            consistent = consistent && btree_insert(&tree, key) == !present[key];
+            expected += !present[key];
+            present[key] = true;
+        } else {
+            consistent = consistent && btree_remove(&tree, key) == present[key];
+            expected -= present[key];
+            present[key] = false;
+        }
+        if (op % 1000 == 0) {
+            consistent = consistent && btree_test_check(&tree);
+        }
+    }
+
+    // Assert
+    CU_ASSERT_TRUE(consistent);
+    CU_ASSERT_EQUAL(btree_size(&tree), expected);
+    CU_ASSERT_TRUE(btree_test_check(&tree));
+    bool matches = true;
+    for (int k = 0; k < 4096; k++) {
+        matches = matches && btree_contains(&tree, k) == present[k];
+    }
+    CU_ASSERT_TRUE(matches);
+
+    // Cleanup
+    btree_free(&tree);
+}
+
+static void btree_remove__for_every_key__should_release_every_node(void) {
+    // Arrange
+    rbt_tree_alloc_stats stats = {0};
+    BTREE(int) tree = btree(int);
+
+    alloc_scope(rbt_tree_counting_allocator(&stats)) {
+        for (int i = 0; i < 5000; i++) {
+            btree_insert(&tree, (i * 7919) % 5000);
+        }
+
+        // Act
+        bool all_removed = true;
+        for (int i = 0; i < 5000; i++) {
+            all_removed = all_removed && btree_remove(&tree, (i * 104729) % 5000);
+        }
+
+        // Assert
+        CU_ASSERT_TRUE(all_removed);
+    }
+    CU_ASSERT_EQUAL(btree_size(&tree), 0);
+    CU_ASSERT_PTR_NULL(tree.root);
+    CU_ASSERT_EQUAL(stats.frees, stats.allocs);
+    CU_ASSERT_EQUAL(stats.bytes_freed, stats.bytes_allocated);
+}
+
+static void btree_clear__for_populated_tree__should_free_all_nodes_and_stay_usable(void) {
+    // Arrange
+    rbt_tree_alloc_stats stats = {0};
+    BTREE(int) tree = btree(int);
+
+    alloc_scope(rbt_tree_counting_allocator(&stats)) {
+        for (int i = 0; i < 20000; i++) {
+            btree_insert(&tree, i);
+        }
+
+        // Act
+        btree_clear(&tree);
+    }
+
+    // Assert
+    CU_ASSERT_TRUE(stats.allocs > 1);
+    CU_ASSERT_EQUAL(stats.frees, stats.allocs);
+    CU_ASSERT_EQUAL(stats.bytes_freed, stats.bytes_allocated);
+    CU_ASSERT_EQUAL(btree_size(&tree), 0);
+    CU_ASSERT_TRUE(btree_insert(&tree, 42));
+    CU_ASSERT_TRUE(btree_contains(&tree, 42));
+
+    // Cleanup
+    btree_free(&tree);
+}
+
+static void btree__with_custom_comparator_and_minimum_degree__should_behave_as_set(void) {
+    // Arrange - Three keys per node, so a few hundred keys already give a tree several levels deep
+    BTREE(btree_wide) tree = btree(btree_wide);
+    for (int64_t i = 0; i < 600; i++) {
+        btree_insert(&tree, btree_test_wide((i * 37) % 600), btree_test_wide_cmp);
+    }
+
+    // Act - Drop every third key
+    for (int64_t i = 0; i < 600; i += 3) {
+        btree_remove(&tree, btree_test_wide(i), btree_test_wide_cmp);
+    }
+
+    // Assert
+    CU_ASSERT_EQUAL(btree_size(&tree), 400);
+    bool matches = true;
+    for (int64_t i = 0; i < 600; i++) {
+        matches = matches && btree_contains(&tree, btree_test_wide(i), btree_test_wide_cmp) == (i % 3 != 0);
+    }
+    CU_ASSERT_TRUE(matches);
+    CU_ASSERT_FALSE(btree_insert(&tree, btree_test_wide(1), btree_test_wide_cmp));
+    const btree_wide * found = btree_find(&tree, btree_test_wide(599), btree_test_wide_cmp);
+    CU_ASSERT_PTR_NOT_NULL(found);
+    CU_ASSERT_EQUAL(found->id, 599);
+
+    // Cleanup
+    btree_free(&tree);
+}
+
 // =====================================================================================================================
 // Test suite registration
 // =====================================================================================================================
@@ -1551,6 +2335,8 @@ int main(void) {
     ADD_TEST(suite_rbt_remove, rbt_remove__for_removing_every_other_element__should_maintain_balance);
     ADD_TEST(suite_rbt_remove, rbt_remove__for_deletion_of_root__should_promote_successor);
     ADD_TEST(suite_rbt_remove, rbt_remove__for_stress_test_insert_remove_patterns__should_maintain_invariants);
+    ADD_TEST(suite_rbt_remove, rbt_remove__for_red_node_with_black_successor__should_recolor_successor_child);
+    ADD_TEST(suite_rbt_remove, rbt_remove__for_slab_allocator_scope__should_recycle_nodes);
 
     // RBT() - size field tracking suite
     CU_pSuite suite_rbt_size = CU_add_suite("RBT() size tracking", nullptr, nullptr);
@@ -1576,6 +2362,53 @@ int main(void) {
     }
     ADD_TEST(suite_rbt_comparator, rbt__with_custom_comparator__should_use_custom_comparison);
 
+    // rbt_build_sorted() / rbt_clear() suite
+    CU_pSuite suite_rbt_build = CU_add_suite("rbt_build_sorted() / rbt_clear()", nullptr, nullptr);
+    if (suite_rbt_build == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_rbt_build, rbt_build_sorted__for_empty_input__should_leave_tree_empty);
+    ADD_TEST(suite_rbt_build, rbt_build_sorted__for_every_size_up_to_300__should_satisfy_invariants);
+    ADD_TEST(suite_rbt_build, rbt_build_sorted__for_sorted_input__should_lay_out_nodes_in_key_order);
+    ADD_TEST(suite_rbt_build, rbt_build_sorted__for_non_empty_tree__should_replace_contents);
+    ADD_TEST(suite_rbt_build, rbt_build_sorted__followed_by_insert_and_remove__should_maintain_invariants);
+    ADD_TEST(suite_rbt_build, rbt_clear__for_built_tree__should_release_block_in_single_free);
+    ADD_TEST(suite_rbt_build, rbt_clear__for_mixed_tree__should_free_every_node);
+    ADD_TEST(suite_rbt_build, rbt_free__for_inserted_tree__should_leave_reusable_tree);
+
+    // Iteration and range query suite
+    CU_pSuite suite_rbt_iter = CU_add_suite("RBT() iteration and range queries", nullptr, nullptr);
+    if (suite_rbt_iter == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_rbt_iter, bst_next__for_every_node__should_visit_values_in_ascending_order);
+    ADD_TEST(suite_rbt_iter, bst_prev__from_last_node__should_visit_values_in_descending_order);
+    ADD_TEST(suite_rbt_iter, rbt_first__for_empty_tree__should_return_null);
+    ADD_TEST(suite_rbt_iter, rbt_lower_bound__for_present_and_absent_values__should_return_first_not_less);
+    ADD_TEST(suite_rbt_iter, rbt_upper_bound__for_present_and_absent_values__should_return_first_greater);
+    ADD_TEST(suite_rbt_iter, rbt_foreach__for_populated_tree__should_visit_each_value_once_in_order);
+    ADD_TEST(suite_rbt_iter, rbt_foreach_range__for_half_open_range__should_visit_only_values_in_range);
+    ADD_TEST(suite_rbt_iter, rbt_foreach_range__for_empty_or_inverted_range__should_visit_nothing);
+    ADD_TEST(suite_rbt_iter, rbt_foreach_range__with_custom_comparator__should_follow_comparator_order);
+
+    // BTREE() suite
+    CU_pSuite suite_btree = CU_add_suite("BTREE()", nullptr, nullptr);
+    if (suite_btree == nullptr) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    ADD_TEST(suite_btree, btree__for_new_tree__should_be_empty);
+    ADD_TEST(suite_btree, btree_node__for_int_keys__should_fit_configured_node_bytes);
+    ADD_TEST(suite_btree, btree_insert__for_ascending_keys__should_keep_all_invariants);
+    ADD_TEST(suite_btree, btree_insert__for_duplicate_key__should_return_false_and_keep_size);
+    ADD_TEST(suite_btree, btree_find__for_present_key__should_return_pointer_to_stored_key);
+    ADD_TEST(suite_btree, btree_remove__for_random_operations__should_match_reference_set);
+    ADD_TEST(suite_btree, btree_remove__for_every_key__should_release_every_node);
+    ADD_TEST(suite_btree, btree_clear__for_populated_tree__should_free_all_nodes_and_stay_usable);
+    ADD_TEST(suite_btree, btree__with_custom_comparator_and_minimum_degree__should_behave_as_set);
+
     CU_basic_set_mode(CU_BRM_VERBOSE);
     CU_basic_run_tests();
     CU_cleanup_registry();